@@ -25,16 +25,16 @@ namespace ts
 
 		type peek()
 		{
-			unique_lock<mutex> lk(m_mutex);
+			std::unique_lock<std::mutex> lk(m_mutex);
 
 			//while (m_queue.empty())
 			//	m_notifier.wait(lk);
 			if (m_queue.empty())
 				return type();
 
-			type val(move(m_queue.front()));
+			type val(std::move(m_queue.front()));
 			m_queue.pop();
-			return move(val);
+			return val;
 		}
 
 		type pop()
@@ -46,7 +46,7 @@ namespace ts
 
 			type val(std::move(m_queue.front()));
 			m_queue.pop();
-			return std::move(val);
+			return val;
 		}
 
 		void push(const type& val)
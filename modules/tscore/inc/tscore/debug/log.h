@@ -90,7 +90,7 @@ namespace ts
 #define _tslogwrite(logger, message, level, ...) \
 	logger(										  \
 	SLogMessage(								  \
-		ts::format(message, __VA_ARGS__).c_str(), \
+		ts::format(message, ##__VA_ARGS__).c_str(), \
 		__FILE__,                                 \
 		__FUNCTION__,                             \
 		__LINE__,                                 \
@@ -98,10 +98,10 @@ namespace ts
 	)\
   )
 
-#define tsinfo(message, ...) _tslogwrite(::ts::global::getLogger(), message, ::ts::eLevelInfo, __VA_ARGS__)
-#define tswarn(message, ...)  _tslogwrite(::ts::global::getLogger(), message, ::ts::eLevelWarn, __VA_ARGS__)
-#define tserror(message, ...) _tslogwrite(::ts::global::getLogger(), message, ::ts::eLevelError, __VA_ARGS__)
-#define tsprofile(message, ...) _tslogwrite(::ts::global::getLogger(), message, ::ts::eLevelProfile, __VA_ARGS__)
+#define tsinfo(message, ...) _tslogwrite(::ts::global::getLogger(), message, ::ts::eLevelInfo, ##__VA_ARGS__)
+#define tswarn(message, ...)  _tslogwrite(::ts::global::getLogger(), message, ::ts::eLevelWarn, ##__VA_ARGS__)
+#define tserror(message, ...) _tslogwrite(::ts::global::getLogger(), message, ::ts::eLevelError, ##__VA_ARGS__)
+#define tsprofile(message, ...) _tslogwrite(::ts::global::getLogger(), message, ::ts::eLevelProfile, ##__VA_ARGS__)
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
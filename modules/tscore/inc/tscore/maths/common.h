@@ -11,13 +11,19 @@
 #include <cmath>
 
 #ifndef VECTOR_CALL
+#ifdef MSVC
 #define VECTOR_CALL __vectorcall
+#else
+#define VECTOR_CALL
+#endif
 #endif
 
 #ifdef VECTOR_NO_INLINE
 #define VECTOR_INLINE
-#else
+#elif defined(MSVC)
 #define VECTOR_INLINE __forceinline
+#else
+#define VECTOR_INLINE inline __attribute__((always_inline))
 #endif
 
 namespace ts
@@ -11,7 +11,7 @@
 
 namespace ts
 {
-	ALIGN(16) class Matrix :
+	class ALIGN(16) Matrix :
 		public Aligned<16>
 	{
 	public:
@@ -10,7 +10,7 @@
 
 namespace ts
 {
-	ALIGN(16) class Quaternion :
+	class ALIGN(16) Quaternion :
 		public Aligned<16>
 	{
 	protected:
@@ -12,7 +12,7 @@ namespace ts
 	class Matrix;
 	class Quaternion;
 
-	ALIGN(16) class Vector :
+	class ALIGN(16) Vector :
 		public Aligned<16>
 	{
 	protected:
@@ -0,0 +1,265 @@
+/*
+	Radix sort header -
+
+		contains an LSD radix sort for arrays of elements with unsigned 64 bit keys,
+		intended for sorting large arrays of key/payload pairs such as render queue sort keys.
+
+		The sort is stable and runs one counting pass plus one scatter pass per key byte,
+		passes over key bytes which are the same for every element are skipped.
+
+	example:
+
+		struct Item { uint64 key; void* data; };
+
+		std::vector<Item> items, scratch(items.size());
+		radixSort(items.data(), items.data() + items.size(), scratch.data(), [](const Item& i) { return i.key; });
+*/
+
+#pragma once
+
+#include <tscore/types.h>
+#include <tscore/system/thread.h>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace ts
+{
+	namespace internal
+	{
+		///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+		enum { RADIX_BYTES = 8, RADIX_BUCKETS = 256 };
+
+		//Bucket counts for each byte of a 64 bit key
+		struct RadixHistogram
+		{
+			size_t counts[RADIX_BYTES][RADIX_BUCKETS];
+		};
+
+		//Write offsets of one chunk for the current pass
+		struct RadixChunkOffsets
+		{
+			size_t offsets[RADIX_BUCKETS];
+		};
+
+		inline uint32 radixDigit(uint64 key, uint32 byteIndex)
+		{
+			return (uint32)(key >> (byteIndex * 8)) & 0xff;
+		}
+
+		//Count every byte of every key in a range
+		template<typename type_t, typename key_func_t>
+		void radixCountAll(const type_t* first, const type_t* last, RadixHistogram& h, key_func_t& getKey)
+		{
+			memset(&h, 0, sizeof(RadixHistogram));
+
+			for (const type_t* i = first; i != last; i++)
+			{
+				const uint64 key = getKey(*i);
+
+				for (uint32 b = 0; b < RADIX_BYTES; b++)
+					h.counts[b][radixDigit(key, b)]++;
+			}
+		}
+
+		//Count a single byte of every key in a range
+		template<typename type_t, typename key_func_t>
+		void radixCount(const type_t* first, const type_t* last, uint32 byteIndex, size_t(&counts)[RADIX_BUCKETS], key_func_t& getKey)
+		{
+			memset(counts, 0, sizeof(counts));
+
+			for (const type_t* i = first; i != last; i++)
+				counts[radixDigit(getKey(*i), byteIndex)]++;
+		}
+
+		//Move each element of a range to the next free slot of it's bucket
+		template<typename type_t, typename key_func_t>
+		void radixScatter(const type_t* first, const type_t* last, type_t* dest, uint32 byteIndex, size_t(&offsets)[RADIX_BUCKETS], key_func_t& getKey)
+		{
+			for (const type_t* i = first; i != last; i++)
+				dest[offsets[radixDigit(getKey(*i), byteIndex)]++] = *i;
+		}
+
+		//A pass can be skipped if every key falls into the same bucket
+		inline bool radixPassTrivial(const size_t(&counts)[RADIX_BUCKETS], size_t count)
+		{
+			for (size_t c : counts)
+			{
+				if (c == count)
+					return true;
+				if (c != 0)
+					return false;
+			}
+
+			return true;
+		}
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////
+	}
+
+	/*
+		Per chunk counts of the parallel sort, reused between sorts so sorting doesn't allocate once they have grown
+	*/
+	struct RadixSortScratch
+	{
+		std::vector<internal::RadixHistogram> histograms;
+		std::vector<internal::RadixChunkOffsets> chunkOffsets;
+	};
+
+	/*
+		Sort a range of elements in ascending order of a 64 bit key:
+
+		- getKey must be callable as uint64(const type_t&).
+		- scratch must point to a buffer of at least (last - first) elements, it's contents are overwritten.
+		- Elements are moved with plain assignment so should be small and trivially copyable (eg. key + pointer).
+	*/
+	template<typename type_t, typename key_func_t>
+	void radixSort(type_t* first, type_t* last, type_t* scratch, key_func_t getKey)
+	{
+		static_assert(std::is_trivially_copyable<type_t>::value, "Radix sorted type must be trivially copyable");
+
+		using namespace internal;
+
+		const size_t count = (size_t)(last - first);
+
+		if (count < 2)
+			return;
+
+		RadixHistogram h;
+		radixCountAll(first, last, h, getKey);
+
+		type_t* src = first;
+		type_t* dst = scratch;
+
+		for (uint32 b = 0; b < RADIX_BYTES; b++)
+		{
+			if (radixPassTrivial(h.counts[b], count))
+				continue;
+
+			//Exclusive prefix sum of bucket counts gives the first slot of each bucket
+			size_t offsets[RADIX_BUCKETS];
+			size_t sum = 0;
+
+			for (uint32 d = 0; d < RADIX_BUCKETS; d++)
+			{
+				offsets[d] = sum;
+				sum += h.counts[b][d];
+			}
+
+			radixScatter(src, src + count, dst, b, offsets, getKey);
+			std::swap(src, dst);
+		}
+
+		//After an odd number of passes the result is in the scratch buffer
+		if (src != first)
+			memcpy(first, src, count * sizeof(type_t));
+	}
+
+	/*
+		Sort a range of elements in ascending order of a 64 bit key, using a thread pool:
+
+		- The range is split into one chunk per worker, chunks count and scatter their elements in parallel.
+		- Ranges with fewer than minPerTask elements per chunk fall back to the single threaded sort.
+		- Must not be called from a task running on the same pool.
+		- Chunk counts are kept in counts, which can be reused by later sorts.
+	*/
+	template<typename type_t, typename key_func_t>
+	void radixSort(ThreadPool& pool, RadixSortScratch& counts, type_t* first, type_t* last, type_t* scratch, key_func_t getKey, size_t minPerTask = 8192)
+	{
+		static_assert(std::is_trivially_copyable<type_t>::value, "Radix sorted type must be trivially copyable");
+
+		using namespace internal;
+
+		const size_t count = (size_t)(last - first);
+		//The calling thread also sorts a chunk
+		const size_t chunkCount = std::min(pool.size() + 1, count / std::max<size_t>(minPerTask, 1));
+
+		if (chunkCount < 2)
+		{
+			radixSort(first, last, scratch, getKey);
+			return;
+		}
+
+		const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+		auto chunkBegin = [=](size_t i) { return std::min(i * chunkSize, count); };
+		auto chunkEnd = [=](size_t i) { return std::min((i + 1) * chunkSize, count); };
+
+		//Count every key byte up front, so constant bytes can be found before any elements are moved
+		std::vector<RadixHistogram>& histograms = counts.histograms;
+		std::vector<RadixChunkOffsets>& chunkOffsets = counts.chunkOffsets;
+		histograms.resize(chunkCount);
+		chunkOffsets.resize(chunkCount);
+
+		parallel_for(pool, chunkCount, [&](size_t i) {
+			radixCountAll(first + chunkBegin(i), first + chunkEnd(i), histograms[i], getKey);
+		});
+
+		RadixHistogram total;
+		memset(&total, 0, sizeof(RadixHistogram));
+
+		for (const RadixHistogram& h : histograms)
+			for (uint32 b = 0; b < RADIX_BYTES; b++)
+				for (uint32 d = 0; d < RADIX_BUCKETS; d++)
+					total.counts[b][d] += h.counts[b][d];
+
+		type_t* src = first;
+		type_t* dst = scratch;
+		bool moved = false;
+
+		for (uint32 b = 0; b < RADIX_BYTES; b++)
+		{
+			if (radixPassTrivial(total.counts[b], count))
+				continue;
+
+			//Chunk counts of the original order are only valid until the first scatter
+			if (moved)
+			{
+				parallel_for(pool, chunkCount, [&](size_t i) {
+					radixCount(src + chunkBegin(i), src + chunkEnd(i), b, chunkOffsets[i].offsets, getKey);
+				});
+			}
+			else
+			{
+				for (size_t i = 0; i < chunkCount; i++)
+					memcpy(chunkOffsets[i].offsets, histograms[i].counts[b], sizeof(RadixChunkOffsets));
+			}
+
+			//Each chunk writes it's elements of a bucket after those of the preceding chunks, which keeps the sort stable
+			size_t sum = 0;
+
+			for (uint32 d = 0; d < RADIX_BUCKETS; d++)
+			{
+				for (size_t i = 0; i < chunkCount; i++)
+				{
+					const size_t c = chunkOffsets[i].offsets[d];
+					chunkOffsets[i].offsets[d] = sum;
+					sum += c;
+				}
+			}
+
+			parallel_for(pool, chunkCount, [&](size_t i) {
+				radixScatter(src + chunkBegin(i), src + chunkEnd(i), dst, b, chunkOffsets[i].offsets, getKey);
+			});
+
+			std::swap(src, dst);
+			moved = true;
+		}
+
+		if (src != first)
+			memcpy(first, src, count * sizeof(type_t));
+	}
+
+	/*
+		Sort a range of elements in ascending order of a 64 bit key, using a thread pool and temporary chunk counts
+	*/
+	template<typename type_t, typename key_func_t>
+	void radixSort(ThreadPool& pool, type_t* first, type_t* last, type_t* scratch, key_func_t getKey, size_t minPerTask = 8192)
+	{
+		RadixSortScratch counts;
+		radixSort(pool, counts, first, last, scratch, getKey, minPerTask);
+	}
+}
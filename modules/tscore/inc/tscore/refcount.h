@@ -0,0 +1,347 @@
+/*
+	Reference counting header -
+
+		contains the RefCounted base class, the IntrusivePtr<> smart pointer and the WeakRef<> handle.
+
+		Unlike std::shared_ptr the reference count is stored inside the object itself,
+		so there is no separate control block allocation and copying a pointer to a single threaded object
+		does not touch any atomics.
+
+	example:
+
+		class Texture : public RefCounted<RefCountAtomic>
+		{
+			...
+		};
+
+		IntrusivePtr<Texture> tex = makeIntrusive<Texture>(...);
+		WeakRef<Texture> weak(tex);
+
+		if (IntrusivePtr<Texture> t = weak.lock())
+		{
+			//object is still alive
+		}
+*/
+
+#pragma once
+
+#include <tscore/abi.h>
+#include <tscore/types.h>
+#include <tscore/delegate.h>
+
+#include <atomic>
+#include <utility>
+
+namespace ts
+{
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Counting policies
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Plain integer counter - objects must only be shared within a single thread
+	*/
+	struct RefCountSingleThreaded
+	{
+		typedef uint32 Counter;
+
+		static uint32 increment(Counter& c) { return ++c; }
+		static uint32 decrement(Counter& c) { return --c; }
+		static uint32 load(const Counter& c) { return c; }
+
+		//Increment the counter only if it is not zero
+		static bool tryIncrement(Counter& c)
+		{
+			if (c == 0)
+				return false;
+
+			++c;
+			return true;
+		}
+	};
+
+	/*
+		Atomic counter - objects can be shared between threads
+	*/
+	struct RefCountAtomic
+	{
+		typedef std::atomic<uint32> Counter;
+
+		static uint32 increment(Counter& c) { return c.fetch_add(1, std::memory_order_relaxed) + 1; }
+		static uint32 decrement(Counter& c) { return c.fetch_sub(1, std::memory_order_acq_rel) - 1; }
+		static uint32 load(const Counter& c) { return c.load(std::memory_order_acquire); }
+
+		//Increment the counter only if it is not zero
+		static bool tryIncrement(Counter& c)
+		{
+			uint32 cur = c.load(std::memory_order_relaxed);
+
+			while (cur != 0)
+			{
+				if (c.compare_exchange_weak(cur, cur + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+					return true;
+			}
+
+			return false;
+		}
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Base classes
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Common root of all reference counted objects.
+
+		- Owns the weak reference slot of the object.
+		- Owns the release hook which is invoked once the last strong reference is released.
+		  By default the object is deleted immediately, a hook can instead defer destruction
+		  (eg. until the GPU has finished with a resource), the hook is then responsible for calling destroyObject().
+	*/
+	class RefCountedObject
+	{
+	public:
+
+		typedef Delegate<void(RefCountedObject*)> ReleaseHook;
+
+		RefCountedObject() {}
+		RefCountedObject(const RefCountedObject&) {}
+		RefCountedObject& operator=(const RefCountedObject&) { return *this; }
+
+		//Objects destroyed without being released (eg. on the stack) expire their weak references here
+		virtual ~RefCountedObject()
+		{
+			if (m_weakHandle != 0)
+			{
+				expireWeakHandle(m_weakHandle);
+			}
+		}
+
+		//Set the hook called when the last strong reference is released
+		void setReleaseHook(ReleaseHook hook) { m_releaseHook = hook; }
+		ReleaseHook getReleaseHook() const { return m_releaseHook; }
+
+		//Delete an object which has no strong references left
+		static void destroyObject(RefCountedObject* object) { delete object; }
+
+		//Get the weak reference handle of this object - a handle is allocated on first use
+		TSCORE_API uint32 weakHandle() const;
+
+		//Attempt to acquire a strong reference from a weak handle, returns null if the object has expired
+		TSCORE_API static RefCountedObject* lockWeakHandle(uint32 handle);
+
+	protected:
+
+		//Increment the reference count if the object is still alive
+		virtual bool tryAddRef() const = 0;
+
+		void onLastRelease() const
+		{
+			RefCountedObject* self = const_cast<RefCountedObject*>(this);
+
+			//Weak references expire before destruction starts, so a concurrent lock never reaches a partly destroyed object
+			if (m_weakHandle != 0)
+			{
+				expireWeakHandle(m_weakHandle);
+				m_weakHandle = 0;
+			}
+
+			if (m_releaseHook != nullptr)
+				m_releaseHook(self);
+			else
+				destroyObject(self);
+		}
+
+	private:
+
+		TSCORE_API static void expireWeakHandle(uint32 handle);
+
+		ReleaseHook m_releaseHook;
+		mutable uint32 m_weakHandle = 0;
+	};
+
+	/*
+		Reference counted base class, the counting policy determines if references can be shared across threads
+	*/
+	template<typename Policy = RefCountSingleThreaded>
+	class RefCounted : public RefCountedObject
+	{
+	public:
+
+		typedef Policy RefPolicy;
+
+		RefCounted() : m_refs(0) {}
+
+		//Copying an object does not copy its references
+		RefCounted(const RefCounted&) : RefCountedObject(), m_refs(0) {}
+		RefCounted& operator=(const RefCounted&) { return *this; }
+
+		uint32 addRef() const
+		{
+			return Policy::increment(m_refs);
+		}
+
+		uint32 release() const
+		{
+			uint32 refs = Policy::decrement(m_refs);
+
+			if (refs == 0)
+			{
+				onLastRelease();
+			}
+
+			return refs;
+		}
+
+		uint32 refCount() const
+		{
+			return Policy::load(m_refs);
+		}
+
+	protected:
+
+		bool tryAddRef() const override
+		{
+			return Policy::tryIncrement(m_refs);
+		}
+
+	private:
+
+		mutable typename Policy::Counter m_refs;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Smart pointers
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Strong reference to a RefCounted object
+	*/
+	template<typename type_t>
+	class IntrusivePtr
+	{
+	private:
+
+		type_t* m_ptr;
+
+		template<typename other_t> friend class IntrusivePtr;
+
+	public:
+
+		IntrusivePtr() : m_ptr(nullptr) {}
+		IntrusivePtr(std::nullptr_t) : m_ptr(nullptr) {}
+
+		explicit IntrusivePtr(type_t* ptr, bool addRef = true) : m_ptr(ptr)
+		{
+			if (m_ptr && addRef)
+				m_ptr->addRef();
+		}
+
+		IntrusivePtr(const IntrusivePtr& rhs) : IntrusivePtr(rhs.m_ptr) {}
+
+		IntrusivePtr(IntrusivePtr&& rhs) : m_ptr(rhs.m_ptr)
+		{
+			rhs.m_ptr = nullptr;
+		}
+
+		//Conversion from pointer to derived type
+		template<typename other_t, typename = typename std::enable_if<std::is_convertible<other_t*, type_t*>::value>::type>
+		IntrusivePtr(const IntrusivePtr<other_t>& rhs) : IntrusivePtr(rhs.m_ptr) {}
+
+		template<typename other_t, typename = typename std::enable_if<std::is_convertible<other_t*, type_t*>::value>::type>
+		IntrusivePtr(IntrusivePtr<other_t>&& rhs) : m_ptr(rhs.m_ptr)
+		{
+			rhs.m_ptr = nullptr;
+		}
+
+		~IntrusivePtr()
+		{
+			if (m_ptr)
+				m_ptr->release();
+		}
+
+		IntrusivePtr& operator=(IntrusivePtr rhs)
+		{
+			swap(rhs);
+			return *this;
+		}
+
+		void swap(IntrusivePtr& rhs)
+		{
+			std::swap(m_ptr, rhs.m_ptr);
+		}
+
+		void reset(type_t* ptr = nullptr)
+		{
+			IntrusivePtr(ptr).swap(*this);
+		}
+
+		//Release ownership of the pointer without decrementing the reference count
+		type_t* detach()
+		{
+			type_t* ptr = m_ptr;
+			m_ptr = nullptr;
+			return ptr;
+		}
+
+		type_t* get() const { return m_ptr; }
+		type_t* operator->() const { return m_ptr; }
+		type_t& operator*() const { return *m_ptr; }
+
+		bool null() const { return m_ptr == nullptr; }
+		explicit operator bool() const { return m_ptr != nullptr; }
+
+		bool operator==(const IntrusivePtr& rhs) const { return m_ptr == rhs.m_ptr; }
+		bool operator!=(const IntrusivePtr& rhs) const { return m_ptr != rhs.m_ptr; }
+		bool operator==(std::nullptr_t) const { return m_ptr == nullptr; }
+		bool operator!=(std::nullptr_t) const { return m_ptr != nullptr; }
+	};
+
+	template<typename type_t, typename ... args_t>
+	inline IntrusivePtr<type_t> makeIntrusive(args_t&& ... args)
+	{
+		return IntrusivePtr<type_t>(new type_t(std::forward<args_t>(args)...));
+	}
+
+	/*
+		Weak reference to a RefCounted object
+
+		Stores a generational handle into the weak reference table rather than a pointer,
+		so the reference can safely outlive the object.
+	*/
+	template<typename type_t>
+	class WeakRef
+	{
+	private:
+
+		uint32 m_handle = 0;
+
+	public:
+
+		WeakRef() {}
+
+		WeakRef(const type_t* object) :
+			m_handle((object != nullptr) ? object->weakHandle() : 0)
+		{}
+
+		WeakRef(const IntrusivePtr<type_t>& ptr) : WeakRef(ptr.get()) {}
+
+		//Acquire a strong reference, returns null if the object has been released
+		IntrusivePtr<type_t> lock() const
+		{
+			if (m_handle == 0)
+				return IntrusivePtr<type_t>();
+
+			//Reference count has already been incremented
+			return IntrusivePtr<type_t>(static_cast<type_t*>(RefCountedObject::lockWeakHandle(m_handle)), false);
+		}
+
+		bool expired() const { return lock().null(); }
+
+		void reset() { m_handle = 0; }
+
+		uint32 handle() const { return m_handle; }
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+}
@@ -19,14 +19,14 @@ namespace ts
 
 		//Connect a signal to a callback
 		template<typename FunctionType>
-		void connect(FunctionType& callback)
+		void connect(const FunctionType& callback)
 		{
 			m_callbacks.push_back(callback);
 		}
 
 		//Alias for connect()
 		template<typename FunctionType>
-		void operator+=(FunctionType& callback)
+		void operator+=(const FunctionType& callback)
 		{
 			connect(callback);
 		}
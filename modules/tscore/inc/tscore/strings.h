@@ -6,6 +6,7 @@
 
 #include <tscore/abi.h>
 
+#include <cstring>
 #include <sstream>
 #include <vector>
 #include <algorithm>
@@ -314,8 +315,10 @@ namespace ts
 		inline void set(const char* str, size_t offset = 0)
 		{
 			using namespace std;
-			size_t len = strlen(str);
-			strncpy_s(m_chars + offset, n - offset, str, min(len, n - offset));
+			//Truncates to the capacity and always leaves the string terminated
+			size_t len = min(strlen(str), n - offset - 1);
+			memcpy(m_chars + offset, str, len);
+			m_chars[offset + len] = 0;
 		}
 
 		inline const char* str() const
@@ -4,11 +4,21 @@
 
 #pragma once
 
+#include <tsconfig.h>
 #include <tscore/types.h>
+
+#include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
+#ifdef MSVC
+#include <malloc.h>
 #define ALIGN(x) __declspec(align(x))
+#else
+#define ALIGN(x) alignas(x)
+#endif
 
 namespace ts
 {
@@ -19,8 +29,17 @@ namespace ts
 	{
 	public:
 			
+#ifdef MSVC
 		void* operator new(std::size_t n){ return _aligned_malloc(n, X); }
 		void operator delete(void * p) throw() { _aligned_free(p); }
+#else
+		void* operator new(std::size_t n)
+		{
+			void* p = nullptr;
+			return (posix_memalign(&p, X, n) == 0) ? p : nullptr;
+		}
+		void operator delete(void * p) throw() { free(p); }
+#endif
 	};
 
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -99,7 +118,7 @@ namespace ts
 			m_start = new byte[size];
 			m_end = m_start + size;
 
-			memcpy_s(m_start, this->size(), data, size);
+			memcpy(m_start, data, size);
 		}
 
 		explicit MemoryBuffer(const MemoryBuffer& copy)
@@ -111,7 +130,7 @@ namespace ts
 				m_end = m_start + copy.size();
 			}
 
-			memcpy_s(this->begin(), this->size(), copy.begin(), copy.size());
+			memcpy(this->begin(), copy.begin(), copy.size());
 		}
 
 		MemoryBuffer(MemoryBuffer&& other)
@@ -130,6 +149,7 @@ namespace ts
 		MemoryBuffer& operator=(const MemoryBuffer& copy)
 		{
 			*this = MemoryBuffer(copy);
+			return *this;
 		}
 
 		~MemoryBuffer() { reset(); }
@@ -144,17 +164,17 @@ namespace ts
 		}
 
 
-		template<typename Type, typename = std::enable_if<std::is_pod<Type>::value>::type>
+		template<typename Type, typename = typename std::enable_if<std::is_pod<Type>::value>::type>
 		static MemoryBuffer from(const Type& t)
 		{
 			return MemoryBuffer((const byte*)&t, sizeof(Type));
 
 		}
 
-		template<typename Type, typename = std::enable_if<std::is_pod<Type>::value>::type>
+		template<typename Type, typename = typename std::enable_if<std::is_pod<Type>::value>::type>
 		static MemoryBuffer fromVector(const std::vector<Type>& v)
 		{
-			return MemoryBuffer((const byte*)&v[0], v.size() * sizeof(T));
+			return MemoryBuffer((const byte*)&v[0], v.size() * sizeof(Type));
 		}
 	};
 
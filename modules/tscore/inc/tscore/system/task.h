@@ -0,0 +1,485 @@
+/*
+	Coroutine task header -
+
+		contains the Task<T> coroutine type and the awaitables used to suspend a task until
+		work on the thread pool has completed, an asynchronous event (eg. an I/O completion) has been signalled,
+		or the next frame has started.
+
+		Requires C++20 coroutine support (configure with TS_USE_CPP20).
+
+	example:
+
+		Task<Model> loadModel(ThreadPool& pool, Path file)
+		{
+			//Continue on a worker thread
+			co_await switchTo(pool);
+
+			std::vector<byte> data = co_await readFileOnPool(pool, file);
+			...
+			co_return model;
+		}
+*/
+
+#pragma once
+
+#include <tsconfig.h>
+
+#if defined(__cpp_impl_coroutine) || defined(__cpp_coroutines)
+
+#include <coroutine>
+#include <exception>
+#include <fstream>
+#include <vector>
+#include <optional>
+
+#include <tscore/types.h>
+#include <tscore/system/thread.h>
+
+namespace ts
+{
+	template<typename type_t = void>
+	class Task;
+
+	namespace internal
+	{
+		///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+		/*
+			Resumes the awaiting coroutine once a task has finished
+		*/
+		struct TaskFinalAwaiter
+		{
+			bool await_ready() const noexcept { return false; }
+
+			template<typename promise_t>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_t> h) noexcept
+			{
+				auto& promise = h.promise();
+
+				if (promise.continuation)
+					return promise.continuation;
+
+				return std::noop_coroutine();
+			}
+
+			void await_resume() noexcept {}
+		};
+
+		/*
+			State shared by all task promises
+		*/
+		struct TaskPromiseBase
+		{
+			std::coroutine_handle<> continuation;
+			std::exception_ptr exception;
+
+			//Tasks are lazy - they do not start until awaited or started
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			TaskFinalAwaiter final_suspend() noexcept { return {}; }
+
+			void unhandled_exception() { exception = std::current_exception(); }
+
+			void rethrow()
+			{
+				if (exception)
+					std::rethrow_exception(exception);
+			}
+		};
+
+		template<typename type_t>
+		struct TaskPromise : public TaskPromiseBase
+		{
+			std::optional<type_t> value;
+
+			Task<type_t> get_return_object();
+
+			template<typename value_t>
+			void return_value(value_t&& v) { value.emplace(std::forward<value_t>(v)); }
+
+			type_t result()
+			{
+				rethrow();
+				return std::move(*value);
+			}
+		};
+
+		template<>
+		struct TaskPromise<void> : public TaskPromiseBase
+		{
+			Task<void> get_return_object();
+
+			void return_void() {}
+
+			void result() { rethrow(); }
+		};
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////
+	}
+
+	/*
+		Task class:
+
+		A lazily started coroutine which produces a value of a given type.
+		Awaiting a task starts it and resumes the awaiting coroutine when it completes,
+		on whichever thread the task completed on.
+	*/
+	template<typename type_t>
+	class Task
+	{
+	public:
+
+		using promise_type = internal::TaskPromise<type_t>;
+		using Handle = std::coroutine_handle<promise_type>;
+
+		Task() {}
+		explicit Task(Handle h) : m_handle(h) {}
+
+		Task(Task&& rhs) noexcept : m_handle(rhs.m_handle) { rhs.m_handle = nullptr; }
+
+		Task& operator=(Task&& rhs) noexcept
+		{
+			std::swap(m_handle, rhs.m_handle);
+			return *this;
+		}
+
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		~Task()
+		{
+			if (m_handle)
+				m_handle.destroy();
+		}
+
+		bool valid() const { return (bool)m_handle; }
+		bool done() const { return !m_handle || m_handle.done(); }
+
+		//Start the task on the calling thread without waiting for it
+		void start()
+		{
+			if (m_handle && !m_handle.done())
+				m_handle.resume();
+		}
+
+		//Get the result of a completed task
+		type_t result() { return m_handle.promise().result(); }
+
+		/*
+			Awaiter
+		*/
+		struct Awaiter
+		{
+			Handle handle;
+
+			bool await_ready() const noexcept { return !handle || handle.done(); }
+
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+			{
+				handle.promise().continuation = awaiting;
+				//Symmetric transfer into the task
+				return handle;
+			}
+
+			type_t await_resume() { return handle.promise().result(); }
+		};
+
+		Awaiter operator co_await() const noexcept { return Awaiter{ m_handle }; }
+
+		/*
+			Awaiter which waits for the task to complete without taking it's result (or rethrowing it's exception),
+			the result is then taken with result()
+		*/
+		struct ReadyAwaiter : public Awaiter
+		{
+			void await_resume() noexcept {}
+		};
+
+		ReadyAwaiter whenReady() const noexcept { return ReadyAwaiter{ { m_handle } }; }
+
+	private:
+
+		Handle m_handle = nullptr;
+	};
+
+	namespace internal
+	{
+		template<typename type_t>
+		inline Task<type_t> TaskPromise<type_t>::get_return_object()
+		{
+			return Task<type_t>(std::coroutine_handle<TaskPromise<type_t>>::from_promise(*this));
+		}
+
+		inline Task<void> TaskPromise<void>::get_return_object()
+		{
+			return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Thread pool awaitables
+	///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Suspends the current coroutine and resumes it on a worker thread of the given pool
+	*/
+	class SwitchToPool : public ThreadPool::ITask
+	{
+	private:
+
+		ThreadPool* m_pool;
+		std::coroutine_handle<> m_handle;
+
+	public:
+
+		SwitchToPool(ThreadPool& pool) : m_pool(&pool) {}
+
+		bool await_ready() const noexcept { return false; }
+
+		void await_suspend(std::coroutine_handle<> h)
+		{
+			//The awaiter lives in the coroutine frame so it stays valid until execute() is called
+			m_handle = h;
+			m_pool->add_task(*this);
+		}
+
+		void await_resume() noexcept {}
+
+		void execute() override { m_handle.resume(); }
+	};
+
+	inline SwitchToPool switchTo(ThreadPool& pool) { return SwitchToPool(pool); }
+
+	/*
+		Run a function on the thread pool and resume the awaiting coroutine with it's result on the worker thread
+	*/
+	template<typename function_t>
+	inline auto runAsync(ThreadPool& pool, function_t func) -> Task<decltype(func())>
+	{
+		co_await switchTo(pool);
+		co_return func();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Asynchronous events
+	///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Single shot event which can be awaited by a single coroutine:
+
+		- Used for completion of asynchronous operations (eg. I/O callbacks).
+		- The awaiting coroutine is resumed on the thread which calls set().
+	*/
+	template<typename type_t>
+	class AsyncEvent
+	{
+	private:
+
+		//Sentinel states of the waiter pointer
+		static void* notSet() { return nullptr; }
+		void* isSet() const { return (void*)this; }
+
+		std::atomic<void*> m_state;
+		std::optional<type_t> m_value;
+
+	public:
+
+		AsyncEvent() : m_state(notSet()) {}
+		AsyncEvent(const AsyncEvent&) = delete;
+
+		//Signal the event and resume any waiting coroutine
+		void set(type_t value)
+		{
+			m_value.emplace(std::move(value));
+
+			void* waiter = m_state.exchange(isSet(), std::memory_order_acq_rel);
+
+			if (waiter != notSet() && waiter != isSet())
+			{
+				std::coroutine_handle<>::from_address(waiter).resume();
+			}
+		}
+
+		bool ready() const { return m_state.load(std::memory_order_acquire) == isSet(); }
+
+		bool await_ready() const noexcept { return ready(); }
+
+		bool await_suspend(std::coroutine_handle<> h) noexcept
+		{
+			void* expected = notSet();
+			//If the event was signalled in the meantime do not suspend
+			return m_state.compare_exchange_strong(expected, h.address(), std::memory_order_acq_rel);
+		}
+
+		type_t await_resume() { return std::move(*m_value); }
+	};
+
+	/*
+		Read an entire file on the thread pool, resumes on the worker thread which completed the read.
+		The read is a blocking read which occupies the worker until it completes, it is not overlapped I/O
+	*/
+	inline Task<std::vector<byte>> readFileOnPool(ThreadPool& pool, std::string filePath)
+	{
+		co_await switchTo(pool);
+
+		std::vector<byte> data;
+		std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+
+		if (file)
+		{
+			data.resize((size_t)file.tellg());
+			file.seekg(0);
+			file.read((char*)data.data(), (std::streamsize)data.size());
+		}
+
+		co_return data;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Frame scheduling
+	///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Frame scheduler:
+
+		Coroutines awaiting nextFrame() are queued and resumed when advance() is called,
+		advance() should be called once per frame by the thread which owns the frame loop.
+	*/
+	class FrameScheduler
+	{
+	private:
+
+		std::mutex m_lock;
+		std::vector<std::coroutine_handle<>> m_waiting;
+		std::vector<std::coroutine_handle<>> m_resuming;
+		uint64 m_frame = 0;
+
+	public:
+
+		struct Awaiter
+		{
+			FrameScheduler* scheduler;
+
+			bool await_ready() const noexcept { return false; }
+
+			void await_suspend(std::coroutine_handle<> h)
+			{
+				std::lock_guard<std::mutex> lk(scheduler->m_lock);
+				scheduler->m_waiting.push_back(h);
+			}
+
+			void await_resume() noexcept {}
+		};
+
+		FrameScheduler() {}
+		FrameScheduler(const FrameScheduler&) = delete;
+
+		//Suspend until the next frame boundary
+		Awaiter nextFrame() { return Awaiter{ this }; }
+
+		//Resume all coroutines waiting on the current frame boundary
+		void advance()
+		{
+			{
+				std::lock_guard<std::mutex> lk(m_lock);
+				std::swap(m_waiting, m_resuming);
+				m_frame++;
+			}
+
+			//Coroutines which await the next frame again are queued for the following call
+			for (auto h : m_resuming)
+				h.resume();
+
+			m_resuming.clear();
+		}
+
+		uint64 frame() const { return m_frame; }
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Blocking wait
+	///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	namespace internal
+	{
+		struct SyncWaitState
+		{
+			std::mutex lock;
+			std::condition_variable cv;
+			bool done = false;
+		};
+
+		/*
+			Coroutine which signals the waiting thread once it has been suspended for the last time,
+			so the waiting thread can safely destroy it
+		*/
+		struct SyncWaitNotifier
+		{
+			struct promise_type
+			{
+				SyncWaitState* state = nullptr;
+
+				SyncWaitNotifier get_return_object() { return SyncWaitNotifier{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+
+				std::suspend_always initial_suspend() noexcept { return {}; }
+
+				auto final_suspend() noexcept
+				{
+					struct Notify
+					{
+						bool await_ready() const noexcept { return false; }
+
+						void await_suspend(std::coroutine_handle<promise_type> h) noexcept
+						{
+							SyncWaitState* state = h.promise().state;
+							std::lock_guard<std::mutex> lk(state->lock);
+							state->done = true;
+							state->cv.notify_all();
+						}
+
+						void await_resume() noexcept {}
+					};
+
+					return Notify();
+				}
+
+				void return_void() {}
+				void unhandled_exception() {}
+			};
+
+			std::coroutine_handle<promise_type> handle;
+		};
+
+		template<typename type_t>
+		SyncWaitNotifier syncWaitNotify(Task<type_t>& task)
+		{
+			//The result and any exception are kept in the awaited task
+			co_await task.whenReady();
+		}
+	}
+
+	/*
+		Block the calling thread until a task has completed and return it's result,
+		should only be used at the top level (eg. the main thread or tests)
+	*/
+	template<typename type_t>
+	type_t syncWait(Task<type_t>& task)
+	{
+		internal::SyncWaitState state;
+		internal::SyncWaitNotifier waiter = internal::syncWaitNotify(task);
+		waiter.handle.promise().state = &state;
+		waiter.handle.resume();
+
+		{
+			std::unique_lock<std::mutex> lk(state.lock);
+			state.cv.wait(lk, [&]() { return state.done; });
+		}
+
+		waiter.handle.destroy();
+
+		return task.result();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////
+}
+
+#endif
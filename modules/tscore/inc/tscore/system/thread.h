@@ -11,6 +11,7 @@
 #include <thread>
 #include <atomic>
 #include <queue>
+#include <vector>
 
 #include <tscore/containers/threadqueue.h>
 
@@ -125,6 +126,11 @@ namespace ts
 			return add_task(task);
 		}
 
+		size_t size() const
+		{
+			return m_threads.size();
+		}
+
 	private:
 
 		typedef std::pair<bool, ITask*> package_t;
@@ -161,7 +167,7 @@ namespace ts
 
 		void execute()
 		{
-			f();
+			m_f();
 		}
 	};
 
@@ -172,4 +178,85 @@ namespace ts
 	}
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Counter which lets a thread wait until a group of tasks have finished
+	*/
+	class TaskGroup
+	{
+	private:
+
+		mutex m_lock;
+		condition_variable m_cv;
+		size_t m_pending = 0;
+
+	public:
+
+		TaskGroup() {}
+		TaskGroup(const TaskGroup&) = delete;
+
+		void add(size_t count = 1)
+		{
+			lock_guard<mutex> lk(m_lock);
+			m_pending += count;
+		}
+
+		void done()
+		{
+			lock_guard<mutex> lk(m_lock);
+
+			if (--m_pending == 0)
+				m_cv.notify_all();
+		}
+
+		void wait()
+		{
+			unique_lock<mutex> lk(m_lock);
+			m_cv.wait(lk, [this]() { return m_pending == 0; });
+		}
+	};
+
+	/*
+		Call f(i) for each i in [0, count) on a thread pool and wait for every call to return.
+
+		The calling thread runs the first index itself, so it must not be a worker of the same pool.
+	*/
+	template<typename fnc_t>
+	void parallel_for(ThreadPool& pool, size_t count, fnc_t f)
+	{
+		struct Task : public ThreadPool::ITask
+		{
+			fnc_t* f = nullptr;
+			TaskGroup* group = nullptr;
+			size_t index = 0;
+
+			void execute() override
+			{
+				(*f)(index);
+				group->done();
+			}
+		};
+
+		if (count == 0)
+			return;
+
+		TaskGroup group;
+		std::vector<Task> tasks(count);
+
+		group.add(count - 1);
+
+		for (size_t i = 1; i < count; i++)
+		{
+			tasks[i].f = &f;
+			tasks[i].group = &group;
+			tasks[i].index = i;
+			pool.add_task(tasks[i]);
+		}
+
+		f(0);
+
+		group.wait();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////
 }
\ No newline at end of file
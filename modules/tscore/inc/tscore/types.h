@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace ts
@@ -26,7 +27,7 @@ namespace ts
 
 	typedef intptr_t intptr;
 	typedef uintptr_t uintptr;
-	typedef ptrdiff_t ptrdiff;
+	typedef std::ptrdiff_t ptrdiff;
 
 	typedef uint32 uint;
 }
\ No newline at end of file
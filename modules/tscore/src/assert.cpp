@@ -5,8 +5,15 @@
 #include <tscore/debug/assert.h>
 #include <tscore/debug/log.h>
 
+#ifdef WIN32
 #include <windows.h>
+#else
+#include <cerrno>
+#endif
+
+#include <cstdlib>
 #include <sstream>
+#include <stdexcept>
 
 namespace ts
 {
@@ -31,14 +38,20 @@ namespace ts
 					<< "file = '" << file << "'\n"
 					<< "expression = '" << expr << "'\n"
 					<< "line = " << line << "\n"
+#ifdef WIN32
 					<< "lasterr = 0x" << hex << GetLastError() << "\n";
+#else
+					<< "errno = " << errno << "\n";
+#endif
 
 				tserror(s.str());
 
+#ifdef WIN32
 				if (MessageBoxA(0, s.str().c_str(), "Assert", MB_ICONERROR | MB_OKCANCEL) == IDCANCEL)
 				{
-					throw exception(s.str().c_str());
+					throw runtime_error(s.str());
 				}
+#endif
 
 				exit(EXIT_FAILURE);
 			}
@@ -5,7 +5,6 @@
 #include <tscore/debug/log.h>
 #include <iostream>
 #include <sstream>
-#include <windows.h>
 
 #include <tscore/system/thread.h>
 
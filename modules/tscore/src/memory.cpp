@@ -4,6 +4,8 @@
 
 #include <tscore/system/memory.h>
 
+#include <cstdlib>
+
 using namespace ts;
 
 ///////////////////////////////////////////////////////////////////////////////////////////
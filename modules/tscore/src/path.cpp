@@ -9,9 +9,6 @@
 
 #include <tscore/path.h>
 
-#define NOMINMAX
-#include <Windows.h>
-
 #include <algorithm>
 
 using namespace ts;
@@ -48,15 +45,17 @@ void Path::composePath(const char* pathstr)
 		}
 	}
 
-	//The first and last characters in the path must not be path splitters
+	//The first and last characters in the path must not be path splitters, except the root of an absolute path outside of Windows
 
 	ptrdiff offset = 0;
+#ifdef WIN32
 	if (strbuf[0] == '\\' || strbuf[0] == '/')
 	{
 		//If the first character is a path splitter then copy strbuf with an offset of one
 		//to ensure that the first character isn't copied
 		offset = 1;
 	}
+#endif
 
 	if (length > 0)
 	{
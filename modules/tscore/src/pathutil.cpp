@@ -4,24 +4,34 @@
 
 #include <tscore/pathutil.h>
 
+#ifdef WIN32
 #include <Windows.h>
 #include <Shlwapi.h>
 #include <Shlobj.h>
 
+#pragma comment(lib, "Shlwapi.lib")
+#pragma comment(lib, "Shell32.lib")
+#else
+#include <cerrno>
+#include <glob.h>
+#include <sys/stat.h>
+#endif
+
 #include <fstream>
 
 using namespace std;
 
-#pragma comment(lib, "Shlwapi.lib")
-#pragma comment(lib, "Shell32.lib")
-
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 namespace ts
 {
 	bool isAbsolutePath(const Path& path)
 	{
+#ifdef WIN32
 		return (::PathIsRelativeA(path.str()) == FALSE);
+#else
+		return path.str()[0] == '/';
+#endif
 	}
 
 	bool isFile(const Path& path)
@@ -31,7 +41,12 @@ namespace ts
 
 	bool isDirectory(const Path& path)
 	{
+#ifdef WIN32
 		return (::GetFileAttributesA(path.str()) == FILE_ATTRIBUTE_DIRECTORY);
+#else
+		struct stat info;
+		return (::stat(path.str(), &info) == 0) && S_ISDIR(info.st_mode);
+#endif
 	}
 
 	bool resolveFile(const Path& inpath, Path& foundpath, const Path* searchPathArray, size_t searchPathArraySize)
@@ -64,6 +79,7 @@ namespace ts
 	{
 		if (!isDirectory(name))
 		{
+#ifdef WIN32
 			string sbuf(name.getParent().str());
 			for (char& c : sbuf)
 			{
@@ -77,8 +93,27 @@ namespace ts
 
 			if (err == ERROR_ALREADY_EXISTS || err == ERROR_SUCCESS)
 			{
-				return fstream(name.str(), flags);
+				return fstream(name.str(), (ios_base::openmode)flags);
 			}
+#else
+			//Create each directory of the parent path in turn
+			string sbuf(name.getParent().str());
+			bool created = true;
+
+			for (size_t i = 1; i <= sbuf.size() && created; i++)
+			{
+				if (i == sbuf.size() || sbuf[i] == '/')
+				{
+					const string dir(sbuf, 0, i);
+					created = (::mkdir(dir.c_str(), 0755) == 0) || (errno == EEXIST);
+				}
+			}
+
+			if (created)
+			{
+				return fstream(name.str(), (ios_base::openmode)flags);
+			}
+#endif
 		}
 
 		return fstream();
@@ -86,6 +121,7 @@ namespace ts
 
 	bool findPaths(const Path& path, std::vector<Path>& paths)
 	{
+#ifdef WIN32
 		WIN32_FIND_DATA findInfo;
 
 		HANDLE hFind = FindFirstFileA(path.str(), &findInfo);
@@ -109,6 +145,26 @@ namespace ts
 		FindClose(hFind);
 
 		return true;
+#else
+		glob_t found;
+
+		if (::glob(path.str(), 0, nullptr, &found) != 0)
+		{
+			globfree(&found);
+			return false;
+		}
+
+		//Only the names of the matches are returned, the same as FindFirstFile()
+		for (size_t i = 0; i < found.gl_pathc; i++)
+		{
+			const char* name = strrchr(found.gl_pathv[i], '/');
+			paths.push_back((name != nullptr) ? name + 1 : found.gl_pathv[i]);
+		}
+
+		globfree(&found);
+
+		return true;
+#endif
 	}
 }
 
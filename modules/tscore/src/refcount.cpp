@@ -0,0 +1,117 @@
+/*
+	Reference counting source
+
+	Implements the weak reference table shared by all RefCounted objects
+*/
+
+#include <tscore/refcount.h>
+#include <tscore/table.h>
+
+#include <mutex>
+#include <vector>
+
+using namespace ts;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/*
+		Weak reference table:
+
+		Maps generational handles to live objects, when an object is destroyed it's handle
+		is freed which increments the generation so any outstanding handles become invalid.
+	*/
+	class WeakRefTable
+	{
+	private:
+
+		std::mutex m_lock;
+		HandleAllocator<uint32> m_handles;
+		std::vector<RefCountedObject*> m_objects;
+
+		uint32 index(uint32 h) const { return HandleInfo<uint32>(h).index; }
+
+	public:
+
+		WeakRefTable()
+		{
+			//Reserve the first handle so that 0 is never a valid handle
+			uint32 h = 0;
+			m_handles.alloc(h);
+			m_objects.push_back(nullptr);
+		}
+
+		static WeakRefTable& instance()
+		{
+			static WeakRefTable table;
+			return table;
+		}
+
+		uint32 add(RefCountedObject* object, uint32& slot)
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+
+			//Another thread may have already allocated a handle for this object
+			if (slot != 0)
+				return slot;
+
+			uint32 h = 0;
+			m_handles.alloc(h);
+
+			if (m_objects.size() <= index(h))
+				m_objects.resize((size_t)index(h) + 1);
+
+			m_objects[index(h)] = object;
+			slot = h;
+
+			return h;
+		}
+
+		void remove(uint32 h)
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+
+			if (m_handles.exists(h))
+			{
+				m_objects[index(h)] = nullptr;
+				m_handles.free(h);
+			}
+		}
+
+		template<typename function_t>
+		RefCountedObject* find(uint32 h, function_t tryAcquire)
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+
+			if (!m_handles.exists(h))
+				return nullptr;
+
+			RefCountedObject* object = m_objects[index(h)];
+
+			//Object may be pending release but not destroyed yet
+			return (object != nullptr && tryAcquire(object)) ? object : nullptr;
+		}
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Weak handle methods
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32 RefCountedObject::weakHandle() const
+{
+	return WeakRefTable::instance().add(const_cast<RefCountedObject*>(this), m_weakHandle);
+}
+
+RefCountedObject* RefCountedObject::lockWeakHandle(uint32 handle)
+{
+	return WeakRefTable::instance().find(handle, [](RefCountedObject* o) { return o->tryAddRef(); });
+}
+
+void RefCountedObject::expireWeakHandle(uint32 handle)
+{
+	WeakRefTable::instance().remove(handle);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////
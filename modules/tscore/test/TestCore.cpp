@@ -0,0 +1,528 @@
+/*
+	Core module tests
+
+	-	Tests the reference counting, sorting and task utilities of the core module.
+*/
+
+#include <tscore/refcount.h>
+#include <tscore/system/task.h>
+#include <tscore/radixsort.h>
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace ts;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Assertion helper
+void _assert(const char* func, const char* expr, bool eval)
+{
+	if (!eval)
+	{
+		cerr << "[" << func << "] Assertion failed: " << expr << endl;
+		exit(-1);
+	}
+}
+
+#define assert(expr) _assert(__FUNCTION__, #expr, (expr))
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reference counting
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename Policy>
+struct Counted : public RefCounted<Policy>
+{
+	static atomic<int> live;
+
+	//Cleared on destruction so a reference to a destroyed object is detected
+	atomic<uint32> value;
+
+	Counted() : value(42) { live++; }
+	virtual ~Counted() { value = 0; live--; }
+
+	virtual uint32 get() const { return value; }
+};
+
+template<typename Policy>
+atomic<int> Counted<Policy>::live(0);
+
+struct DerivedCounted : public Counted<RefCountSingleThreaded>
+{
+	uint32 get() const override { return value + 1; }
+};
+
+using Object = Counted<RefCountSingleThreaded>;
+using SharedObject = Counted<RefCountAtomic>;
+
+//Release hook which keeps released objects alive until they are destroyed by the test
+struct ReleaseRecorder
+{
+	vector<RefCountedObject*> released;
+
+	void operator()(RefCountedObject* object) { released.push_back(object); }
+};
+
+void testIntrusivePtr()
+{
+	{
+		IntrusivePtr<Object> a = makeIntrusive<Object>();
+		assert(a->refCount() == 1);
+		assert(Object::live == 1);
+
+		//Copies share the object, moves transfer the reference
+		IntrusivePtr<Object> b = a;
+		assert(a->refCount() == 2);
+		assert(b == a);
+
+		IntrusivePtr<Object> c = move(b);
+		assert(b.null());
+		assert(a->refCount() == 2);
+
+		c.reset();
+		assert(a->refCount() == 1);
+
+		//Detached pointers keep their reference until adopted again
+		Object* raw = a.detach();
+		assert(a.null());
+		assert(raw->refCount() == 1);
+
+		IntrusivePtr<Object> adopted(raw, false);
+		assert(adopted->refCount() == 1);
+		assert(Object::live == 1);
+	}
+
+	assert(Object::live == 0);
+
+	{
+		//Pointers to derived types convert to pointers to their base
+		IntrusivePtr<DerivedCounted> derived = makeIntrusive<DerivedCounted>();
+		IntrusivePtr<Object> base = derived;
+		assert(base->refCount() == 2);
+		assert(base->get() == 43);
+	}
+
+	assert(Object::live == 0);
+
+	{
+		//A release hook takes over destruction of the object
+		ReleaseRecorder recorder;
+		IntrusivePtr<Object> a = makeIntrusive<Object>();
+		WeakRef<Object> weak(a);
+
+		a->setReleaseHook(RefCountedObject::ReleaseHook(recorder));
+		a.reset();
+		assert(recorder.released.size() == 1);
+		assert(Object::live == 1);
+
+		//Weak references expire when the object is released, not when it is destroyed
+		assert(weak.expired());
+
+		RefCountedObject::destroyObject(recorder.released.back());
+		assert(Object::live == 0);
+	}
+}
+
+void testWeakRef()
+{
+	WeakRef<Object> empty;
+	assert(empty.expired());
+	assert(empty.lock().null());
+
+	IntrusivePtr<Object> a = makeIntrusive<Object>();
+	WeakRef<Object> weak(a);
+	WeakRef<Object> weak2(a);
+
+	//Every weak reference of an object shares it's handle
+	assert(weak.handle() != 0);
+	assert(weak.handle() == weak2.handle());
+
+	{
+		IntrusivePtr<Object> locked = weak.lock();
+		assert(locked == a);
+		assert(a->refCount() == 2);
+	}
+
+	assert(a->refCount() == 1);
+
+	a.reset();
+	assert(Object::live == 0);
+	assert(weak.expired());
+	assert(weak2.lock().null());
+
+	//Handles of destroyed objects are not reused by new objects
+	IntrusivePtr<Object> b = makeIntrusive<Object>();
+	WeakRef<Object> weakB(b);
+	assert(weakB.handle() != weak.handle());
+	assert(weak.expired());
+	assert(weakB.lock() == b);
+
+	//Objects which are destroyed without being released expire when destroyed
+	{
+		Object stack;
+		stack.addRef();
+		WeakRef<Object> weakStack(&stack);
+		assert(!weakStack.expired());
+		weak = weakStack;
+	}
+
+	assert(weak.expired());
+}
+
+void testWeakRefConcurrentRelease()
+{
+	const int iterations = 500;
+	const int threads = 4;
+
+	for (int i = 0; i < iterations; i++)
+	{
+		IntrusivePtr<SharedObject> object = makeIntrusive<SharedObject>();
+		WeakRef<SharedObject> weak(object);
+
+		atomic<bool> start(false);
+		atomic<int> failures(0);
+		vector<thread> lockers;
+
+		//Lock until the object expires, every lock must reach a fully constructed object
+		for (int t = 0; t < threads; t++)
+		{
+			lockers.emplace_back([&]() {
+				while (!start) {}
+
+				while (IntrusivePtr<SharedObject> locked = weak.lock())
+				{
+					if (locked->get() != 42)
+						failures++;
+				}
+			});
+		}
+
+		start = true;
+		object.reset();
+
+		for (thread& t : lockers)
+			t.join();
+
+		assert(failures == 0);
+		assert(weak.expired());
+	}
+
+	assert(SharedObject::live == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Radix sort
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct KeyItem
+{
+	uint64 key;
+	uint32 index;
+};
+
+//Items with random keys, masked so only some key bytes vary, indexed in their original order
+static vector<KeyItem> makeItems(size_t count, uint64 mask, uint32 seed)
+{
+	mt19937_64 rng(seed);
+	vector<KeyItem> items(count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		items[i].key = rng() & mask;
+		items[i].index = (uint32)i;
+	}
+
+	return items;
+}
+
+//Reference result, a stable sort preserves the original order of equal keys
+static vector<KeyItem> stableSorted(vector<KeyItem> items)
+{
+	stable_sort(items.begin(), items.end(), [](const KeyItem& a, const KeyItem& b) { return a.key < b.key; });
+	return items;
+}
+
+static bool sameOrder(const vector<KeyItem>& a, const vector<KeyItem>& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (a[i].key != b[i].key || a[i].index != b[i].index)
+			return false;
+	}
+
+	return true;
+}
+
+void testRadixSortStable()
+{
+	//Few distinct keys so many elements share a key, with an odd and even number of varying bytes
+	const uint64 masks[] = { 0x0f, 0x0f0f, 0xff00000000000000ull, 0x00ff00ff00ff0000ull, ~0ull };
+
+	for (uint64 mask : masks)
+	{
+		vector<KeyItem> items = makeItems(5000, mask, (uint32)mask);
+		vector<KeyItem> expected = stableSorted(items);
+		vector<KeyItem> scratch(items.size());
+
+		radixSort(items.data(), items.data() + items.size(), scratch.data(), [](const KeyItem& i) { return i.key; });
+		assert(sameOrder(items, expected));
+	}
+
+	//Empty and single element ranges are left alone
+	vector<KeyItem> one = makeItems(1, ~0ull, 1);
+	const KeyItem before = one[0];
+	radixSort(one.data(), one.data(), (KeyItem*)nullptr, [](const KeyItem& i) { return i.key; });
+	radixSort(one.data(), one.data() + 1, (KeyItem*)nullptr, [](const KeyItem& i) { return i.key; });
+	assert(one[0].key == before.key && one[0].index == before.index);
+}
+
+void testRadixSortSkipsConstantBytes()
+{
+	struct Case
+	{
+		uint64 mask;
+		//Number of bytes which vary
+		uint32 passes;
+	};
+
+	const Case cases[] = {
+		{ 0, 0 },
+		{ 0xff, 1 },
+		{ 0xff000000ff00ull, 2 },
+		{ 0x0001000000000000ull, 1 },
+		{ ~0ull, 8 }
+	};
+
+	const size_t count = 1000;
+
+	for (const Case& c : cases)
+	{
+		//Set bits outside of the mask are the same for every key
+		vector<KeyItem> items = makeItems(count, c.mask, 7);
+		for (KeyItem& i : items)
+			i.key |= 0x1020304050607080ull & ~c.mask;
+
+		vector<KeyItem> expected = stableSorted(items);
+		vector<KeyItem> scratch(count);
+
+		//Keys are read once when counting and once per pass which is not skipped
+		size_t reads = 0;
+		radixSort(items.data(), items.data() + count, scratch.data(), [&](const KeyItem& i) { reads++; return i.key; });
+
+		assert(sameOrder(items, expected));
+		assert(reads == count * (1 + c.passes));
+	}
+}
+
+void testRadixSortParallel()
+{
+	ThreadPool pool(3);
+	RadixSortScratch counts;
+
+	const uint64 masks[] = { 0xffff, 0xff0000ff00ull, ~0ull };
+
+	for (uint64 mask : masks)
+	{
+		//Enough elements for one chunk per worker and one for the calling thread
+		vector<KeyItem> items = makeItems(40000, mask, 11);
+		vector<KeyItem> expected = stableSorted(items);
+		vector<KeyItem> scratch(items.size());
+
+		radixSort(pool, counts, items.data(), items.data() + items.size(), scratch.data(), [](const KeyItem& i) { return i.key; }, 1000);
+		assert(sameOrder(items, expected));
+		assert(counts.histograms.size() == 4);
+	}
+
+	//Counts are reused by smaller sorts
+	vector<KeyItem> items = makeItems(2500, ~0ull, 13);
+	vector<KeyItem> expected = stableSorted(items);
+	vector<KeyItem> scratch(items.size());
+
+	radixSort(pool, counts, items.data(), items.data() + items.size(), scratch.data(), [](const KeyItem& i) { return i.key; }, 1000);
+	assert(sameOrder(items, expected));
+	assert(counts.histograms.size() == 2);
+	assert(counts.histograms.capacity() >= 4);
+
+	//Ranges too small to split use the single threaded sort
+	items = makeItems(500, ~0ull, 17);
+	expected = stableSorted(items);
+
+	radixSort(pool, items.data(), items.data() + items.size(), scratch.data(), [](const KeyItem& i) { return i.key; }, 1000);
+	assert(sameOrder(items, expected));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Coroutine tasks
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Tasks require C++20, configure with TS_USE_CPP20 to build these tests
+#if defined(__cpp_impl_coroutine) || defined(__cpp_coroutines)
+
+Task<int> addAsync(ThreadPool& pool, int a, int b)
+{
+	int x = co_await runAsync(pool, [a]() { return a * 10; });
+	co_return x + b;
+}
+
+Task<thread::id> workerThreadAsync(ThreadPool& pool)
+{
+	co_await switchTo(pool);
+	co_return this_thread::get_id();
+}
+
+Task<int> throwAsync(ThreadPool& pool)
+{
+	co_await switchTo(pool);
+	throw runtime_error("task failed");
+	co_return 0;
+}
+
+Task<int> awaitEvent(AsyncEvent<int>& event)
+{
+	int v = co_await event;
+	co_return v + 1;
+}
+
+Task<void> countFrames(FrameScheduler& frames, int count, int& counter)
+{
+	for (int i = 0; i < count; i++)
+	{
+		co_await frames.nextFrame();
+		counter++;
+	}
+}
+
+void testTaskResult()
+{
+	ThreadPool pool(2);
+
+	//Tasks are lazy and awaited tasks are resumed with their result
+	Task<int> task = addAsync(pool, 4, 2);
+	assert(task.valid());
+	assert(!task.done());
+	assert(syncWait(task) == 42);
+	assert(task.done());
+
+	//Awaiting a pool switch resumes on a worker thread
+	Task<thread::id> worker = workerThreadAsync(pool);
+	assert(syncWait(worker) != this_thread::get_id());
+
+	//Exceptions are rethrown by the result
+	Task<int> failed = throwAsync(pool);
+	bool caught = false;
+
+	try { syncWait(failed); }
+	catch (const runtime_error&) { caught = true; }
+
+	assert(caught);
+}
+
+void testTaskEvents()
+{
+	//Events set before the await don't suspend
+	AsyncEvent<int> early;
+	early.set(1);
+
+	Task<int> a = awaitEvent(early);
+	a.start();
+	assert(a.done());
+	assert(a.result() == 2);
+
+	//Events set after the await resume the waiting task on the setting thread
+	AsyncEvent<int> late;
+	Task<int> b = awaitEvent(late);
+	b.start();
+	assert(!b.done());
+
+	thread setter([&]() { late.set(9); });
+	setter.join();
+
+	assert(b.done());
+	assert(b.result() == 10);
+}
+
+void testTaskFrames()
+{
+	FrameScheduler frames;
+	int counter = 0;
+
+	Task<void> task = countFrames(frames, 3, counter);
+	task.start();
+	assert(counter == 0);
+
+	//Each frame boundary resumes the task once
+	for (int i = 1; i <= 3; i++)
+	{
+		frames.advance();
+		assert(counter == i);
+	}
+
+	assert(task.done());
+	assert(frames.frame() == 3);
+
+	frames.advance();
+	assert(counter == 3);
+}
+
+void testTaskReadFile()
+{
+	const char* path = "TestCore_readFileOnPool.bin";
+	const char contents[] = "task file contents";
+
+	FILE* f = fopen(path, "wb");
+	assert(f != nullptr);
+	fwrite(contents, 1, sizeof(contents), f);
+	fclose(f);
+
+	ThreadPool pool(1);
+	Task<vector<ts::byte>> read = readFileOnPool(pool, path);
+	vector<ts::byte> data = syncWait(read);
+	remove(path);
+
+	assert(data.size() == sizeof(contents));
+	assert(memcmp(data.data(), contents, sizeof(contents)) == 0);
+
+	//Missing files read as empty
+	Task<vector<ts::byte>> missing = readFileOnPool(pool, path);
+	assert(syncWait(missing).empty());
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+	//Execute test cases
+	testIntrusivePtr();
+	testWeakRef();
+	testWeakRefConcurrentRelease();
+	testRadixSortStable();
+	testRadixSortSkipsConstantBytes();
+	testRadixSortParallel();
+
+#if defined(__cpp_impl_coroutine) || defined(__cpp_coroutines)
+	testTaskResult();
+	testTaskEvents();
+	testTaskFrames();
+	testTaskReadFile();
+#endif
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
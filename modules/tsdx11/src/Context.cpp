@@ -9,6 +9,10 @@
 #include "Helpers.h"
 #include "HandleResource.h"
 #include "HandleTarget.h"
+#include "HandleResourceSet.h"
+#include "HandlePipeline.h"
+
+#include <algorithm>
 
 using namespace std;
 using namespace ts;
@@ -22,6 +26,23 @@ Dx11Context::Dx11Context(Dx11* driver) :
 {
 	tsassert(m_driver);
 	tsassert(SUCCEEDED(m_driver->getDevice()->CreateDeferredContext(0, m_context.GetAddressOf())));
+
+	//Binding and updating ranges of constant buffers requires D3D11.1
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+
+	if (SUCCEEDED(m_context.As(&m_context1)) &&
+		SUCCEEDED(m_driver->getDevice()->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+	{
+		m_supportsConstantOffsets = (options.ConstantBufferOffsetting != FALSE);
+		m_supportsConstantRanges = (options.ConstantBufferPartialUpdate != FALSE);
+	}
+
+	D3D11_FEATURE_DATA_THREADING threading = {};
+
+	if (SUCCEEDED(m_driver->getDevice()->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading))))
+	{
+		m_driverCommandLists = (threading.DriverCommandLists != FALSE);
+	}
 }
 
 Dx11Context::~Dx11Context()
@@ -31,10 +52,17 @@ Dx11Context::~Dx11Context()
 
 void Dx11Context::finish()
 {
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
 	m_contextCommandList.Reset();
 
 	//Store current state in a command list
 	m_context->FinishCommandList(false, m_contextCommandList.GetAddressOf());
+
+	//State is cleared by finishing the command list
+	m_boundSet = nullptr;
+	m_boundPipeline = nullptr;
+	m_boundOffset = INVALID_OFFSET;
 }
 
 void Dx11Context::resetCommandList()
@@ -48,6 +76,8 @@ void Dx11Context::resetCommandList()
 
 void Dx11Context::clearColourTarget(TargetHandle h, uint32 colour)
 {
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
 	if (DxTarget* target = DxTarget::upcast(h))
 	{
 		target->clearRenderTargets(m_context.Get(), RGBA(colour));
@@ -56,6 +86,8 @@ void Dx11Context::clearColourTarget(TargetHandle h, uint32 colour)
 
 void Dx11Context::clearDepthTarget(TargetHandle h, float depth)
 {
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
 	if (DxTarget* target = DxTarget::upcast(h))
 	{
 		target->clearDepthStencil(m_context.Get(), depth);
@@ -66,11 +98,19 @@ void Dx11Context::clearDepthTarget(TargetHandle h, float depth)
 
 void Dx11Context::resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index)
 {
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
 	DxResource* pRsc = DxResource::upcast(rsc);
 
 	if (pRsc)
 	{
+		unstage(pRsc);
 		m_context->UpdateSubresource(pRsc->asResource(), index, nullptr, memory, 0, 0);
+
+		if (pRsc->isBuffer())
+			countUpdate(RenderStatsCounter::BUFFER_UPDATES, RenderStatsCounter::BUFFER_UPDATE_BYTES, pRsc->getUpdateSize(index));
+		else
+			countUpdate(RenderStatsCounter::IMAGE_UPDATES, RenderStatsCounter::IMAGE_UPDATE_BYTES, pRsc->getUpdateSize(index));
 	}
 	else
 	{
@@ -78,8 +118,67 @@ void Dx11Context::resourceUpdate(ResourceHandle rsc, const void* memory, uint32
 	}
 }
 
+void Dx11Context::resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size)
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
+	DxResource* pRsc = DxResource::upcast(rsc);
+
+	if (pRsc && pRsc->isBuffer())
+	{
+		D3D11_BOX box;
+		box.left = offset;
+		box.right = offset + size;
+		box.top = 0;
+		box.bottom = 1;
+		box.front = 0;
+		box.back = 1;
+
+		D3D11_BUFFER_DESC desc;
+		pRsc->asBuffer()->GetDesc(&desc);
+
+		unstage(pRsc);
+
+		if ((desc.BindFlags & D3D11_BIND_CONSTANT_BUFFER) == 0)
+		{
+			/*
+				When command lists are emulated, UpdateSubresource() on a deferred context applies the box to the source data as well,
+				the documented workaround is to offset the source pointer back by the box's position
+			*/
+			const uint8* src = (const uint8*)memory;
+
+			if (!m_driverCommandLists)
+				src -= offset;
+
+			m_context->UpdateSubresource(pRsc->asResource(), 0, &box, src, 0, 0);
+		}
+		//A box can't be given for a constant buffer before D3D11.1
+		else if (m_supportsConstantRanges)
+		{
+			m_context1->UpdateSubresource1(pRsc->asResource(), 0, &box, memory, 0, 0, 0);
+		}
+		else if (offset == 0 && size == desc.ByteWidth)
+		{
+			m_context->UpdateSubresource(pRsc->asResource(), 0, nullptr, memory, 0, 0);
+		}
+		else
+		{
+			tswarn("unable to update a range of a constant buffer, the whole buffer must be updated");
+			return;
+		}
+
+		countUpdate(RenderStatsCounter::BUFFER_UPDATES, RenderStatsCounter::BUFFER_UPDATE_BYTES, size);
+	}
+	else
+	{
+		tswarn("unable to update buffer range");
+	}
+}
+
 void Dx11Context::resourceCopy(ResourceHandle src, ResourceHandle dest)
 {
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
 	auto pSrc = DxResource::upcast(src);
 	auto pDest = DxResource::upcast(dest);
 
@@ -95,6 +194,8 @@ void Dx11Context::resourceCopy(ResourceHandle src, ResourceHandle dest)
 
 void Dx11Context::imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index)
 {
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
 	auto pSrc = DxResource::upcast(src);
 	auto pDest = DxResource::upcast(dest);
 
@@ -108,4 +209,315 @@ void Dx11Context::imageResolve(ResourceHandle src, ResourceHandle dest, uint32 i
 	}
 }
 
-/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//Update staging
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Dx11Context::beginStagedUpdates(const void* memory, uint32 size)
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
+	if (!m_supportsConstantOffsets)
+		return false;
+
+	//Grow staging buffer
+	if (size > m_stagingCapacity)
+	{
+		const uint32 capacity = (size > m_stagingCapacity * 2) ? size : m_stagingCapacity * 2;
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = capacity;
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		m_stagingBuffer.Reset();
+		m_stagingCapacity = 0;
+
+		if (FAILED(m_driver->getDevice()->CreateBuffer(&desc, nullptr, m_stagingBuffer.GetAddressOf())))
+		{
+			tswarn("unable to create staging buffer");
+			return false;
+		}
+
+		m_stagingCapacity = capacity;
+	}
+
+	//Upload the whole block
+	D3D11_MAPPED_SUBRESOURCE mapped;
+
+	if (FAILED(m_context->Map(m_stagingBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+	{
+		tswarn("unable to map staging buffer");
+		return false;
+	}
+
+	memcpy(mapped.pData, memory, size);
+	m_context->Unmap(m_stagingBuffer.Get(), 0);
+
+	m_stagingMemory = (const uint8*)memory;
+	m_stagedRanges.clear();
+
+	return true;
+}
+
+void Dx11Context::resourceUpdateStaged(ResourceHandle rsc, uint32 offset, uint32 size)
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
+	DxResource* pRsc = DxResource::upcast(rsc);
+
+	if (pRsc == nullptr || !pRsc->isBuffer())
+	{
+		tswarn("unable to update buffer");
+		return;
+	}
+
+	countUpdate(RenderStatsCounter::BUFFER_UPDATES, RenderStatsCounter::BUFFER_UPDATE_BYTES, size);
+
+	D3D11_BUFFER_DESC desc;
+	pRsc->asBuffer()->GetDesc(&desc);
+
+	//Only constant buffers can be bound as a range of the staging buffer
+	if ((desc.BindFlags & D3D11_BIND_CONSTANT_BUFFER) == 0)
+	{
+		unstage(pRsc);
+		m_context->UpdateSubresource(pRsc->asResource(), 0, nullptr, m_stagingMemory + offset, 0, 0);
+		return;
+	}
+
+	auto it = std::find_if(m_stagedRanges.begin(), m_stagedRanges.end(), [=](const StagedRange& r) { return r.rsc == pRsc; });
+
+	if (it == m_stagedRanges.end())
+	{
+		m_stagedRanges.push_back({ pRsc, offset, size });
+	}
+	else
+	{
+		it->offset = offset;
+		it->size = size;
+	}
+
+	if (m_boundSet != nullptr)
+	{
+		bindStagedRanges(m_boundSet);
+	}
+}
+
+void Dx11Context::endStagedUpdates()
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
+	//Write the final contents of each buffer back, so they are correct after staging ends
+	for (const StagedRange& range : m_stagedRanges)
+	{
+		m_context->UpdateSubresource(range.rsc->asResource(), 0, nullptr, m_stagingMemory + range.offset, 0, 0);
+	}
+
+	const bool rebind = !m_stagedRanges.empty();
+
+	m_stagedRanges.clear();
+	m_stagingMemory = nullptr;
+
+	if (rebind && m_boundSet != nullptr)
+	{
+		m_boundSet->bind(m_context.Get());
+		m_boundOffset = INVALID_OFFSET;
+	}
+}
+
+//Bind the staged ranges of any constant buffers used by a resource set
+void Dx11Context::bindStagedRanges(DxResourceSet* set)
+{
+	UINT slot = 0;
+
+	for (const DxResourceSet::CBV& cbv : set->getConstantBuffers())
+	{
+		auto it = std::find_if(m_stagedRanges.begin(), m_stagedRanges.end(), [=](const StagedRange& r) { return r.rsc == cbv; });
+
+		if (it != m_stagedRanges.end())
+		{
+			//Offsets and sizes are in 16 byte constants, ranges are a multiple of 256 bytes
+			const UINT first = it->offset / 16;
+			const UINT count = ((it->size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1)) / 16;
+
+			ID3D11Buffer* buf = m_stagingBuffer.Get();
+
+			//The runtime may ignore a new offset if the same buffer is already bound to a slot, so the slot is cleared first
+			ID3D11Buffer* null = nullptr;
+			m_context1->VSSetConstantBuffers(slot, 1, &null);
+			m_context1->GSSetConstantBuffers(slot, 1, &null);
+			m_context1->DSSetConstantBuffers(slot, 1, &null);
+			m_context1->HSSetConstantBuffers(slot, 1, &null);
+			m_context1->PSSetConstantBuffers(slot, 1, &null);
+
+			m_context1->VSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+			m_context1->GSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+			m_context1->DSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+			m_context1->HSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+			m_context1->PSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+		}
+
+		slot++;
+	}
+}
+
+//Bind the dynamic constant buffers of a resource set at an offset
+void Dx11Context::bindConstantOffset(DxResourceSet* set, uint32 offset)
+{
+	if (!m_supportsConstantOffsets)
+	{
+		if (offset != 0)
+			tswarn("constant buffer offsets are not supported");
+		return;
+	}
+
+	UINT slot = 0;
+
+	for (const DxResourceSet::CBV& cbv : set->getConstantBuffers())
+	{
+		if ((set->getDynamicConstants() & (1u << slot)) != 0 && cbv != nullptr)
+		{
+			ID3D11Buffer* buf = cbv->asBuffer();
+
+			D3D11_BUFFER_DESC desc;
+			buf->GetDesc(&desc);
+
+			if (offset >= desc.ByteWidth)
+			{
+				tswarn("constant offset % is outside of the buffer", offset);
+				slot++;
+				continue;
+			}
+
+			//Offsets and sizes are in 16 byte constants, ranges are a multiple of 256 bytes and at most 4096 constants
+			const UINT size = std::min<UINT>(desc.ByteWidth - offset, 4096 * 16);
+			const UINT first = offset / 16;
+			const UINT count = ((size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1)) / 16;
+
+			//The runtime may ignore a new offset if the same buffer is already bound to a slot, so the slot is cleared first
+			ID3D11Buffer* null = nullptr;
+			m_context1->VSSetConstantBuffers(slot, 1, &null);
+			m_context1->GSSetConstantBuffers(slot, 1, &null);
+			m_context1->DSSetConstantBuffers(slot, 1, &null);
+			m_context1->HSSetConstantBuffers(slot, 1, &null);
+			m_context1->PSSetConstantBuffers(slot, 1, &null);
+
+			m_context1->VSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+			m_context1->GSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+			m_context1->DSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+			m_context1->HSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+			m_context1->PSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+		}
+
+		slot++;
+	}
+}
+
+//Bind the constant buffers of a resource set to the compute stage, staged ranges and dynamic offsets are bound as for draws
+void Dx11Context::bindComputeConstants(DxResourceSet* set, uint32 offset)
+{
+	if (!m_supportsConstantOffsets)
+	{
+		if (offset != 0 && set->getDynamicConstants() != 0)
+			tswarn("constant buffer offsets are not supported");
+		return;
+	}
+
+	UINT slot = 0;
+
+	for (const DxResourceSet::CBV& cbv : set->getConstantBuffers())
+	{
+		auto it = std::find_if(m_stagedRanges.begin(), m_stagedRanges.end(), [=](const StagedRange& r) { return r.rsc == cbv; });
+
+		ID3D11Buffer* buf = nullptr;
+		UINT first = 0;
+		UINT count = 0;
+
+		if (cbv != nullptr && it != m_stagedRanges.end())
+		{
+			buf = m_stagingBuffer.Get();
+			first = it->offset / 16;
+			count = ((it->size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1)) / 16;
+		}
+		else if (cbv != nullptr && (set->getDynamicConstants() & (1u << slot)) != 0 && offset != 0)
+		{
+			buf = cbv->asBuffer();
+
+			D3D11_BUFFER_DESC desc;
+			buf->GetDesc(&desc);
+
+			if (offset >= desc.ByteWidth)
+			{
+				tswarn("constant offset % is outside of the buffer", offset);
+				slot++;
+				continue;
+			}
+
+			const UINT size = std::min<UINT>(desc.ByteWidth - offset, 4096 * 16);
+			first = offset / 16;
+			count = ((size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1)) / 16;
+		}
+
+		if (buf != nullptr)
+		{
+			//The runtime may ignore a new offset if the same buffer is already bound to a slot, so the slot is cleared first
+			ID3D11Buffer* null = nullptr;
+			m_context1->CSSetConstantBuffers(slot, 1, &null);
+			m_context1->CSSetConstantBuffers1(slot, 1, &buf, &first, &count);
+		}
+
+		slot++;
+	}
+}
+
+void Dx11Context::dispatchBegin(DxPipeline* pipeline, DxResourceSet* set, uint32 constantOffset)
+{
+	pipeline->bindCompute(m_context.Get());
+	set->bindCompute(m_context.Get());
+	bindComputeConstants(set, constantOffset);
+}
+
+void Dx11Context::dispatchEnd(DxResourceSet* set)
+{
+	set->unbindCompute(m_context.Get());
+
+	//Binding a UAV unbinds any view of the same resource from the graphics stages, so the draw state is bound again
+	if (m_boundSet != nullptr)
+	{
+		m_boundSet->bind(m_context.Get());
+
+		if (!m_stagedRanges.empty())
+			bindStagedRanges(m_boundSet);
+
+		m_boundOffset = INVALID_OFFSET;
+	}
+}
+
+void Dx11Context::countUpdate(RenderStatsCounter calls, RenderStatsCounter bytes, uint64 size)
+{
+	m_driver->getRenderStats().add(calls);
+	m_driver->getRenderStats().add(bytes, size);
+}
+
+//Stop binding a buffer as a range of the staging buffer
+void Dx11Context::unstage(DxResource* rsc)
+{
+	auto it = std::find_if(m_stagedRanges.begin(), m_stagedRanges.end(), [=](const StagedRange& r) { return r.rsc == rsc; });
+
+	if (it != m_stagedRanges.end())
+	{
+		m_stagedRanges.erase(it);
+
+		if (m_boundSet != nullptr)
+		{
+			m_boundSet->bind(m_context.Get());
+			bindStagedRanges(m_boundSet);
+			m_boundOffset = INVALID_OFFSET;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "Base.h"
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -13,6 +15,9 @@
 namespace ts
 {
 	class Dx11;
+	class DxResource;
+	class DxResourceSet;
+	class DxPipeline;
 
 	class Dx11Context : public RenderContext
 	{
@@ -20,8 +25,47 @@ namespace ts
 
 		Dx11* m_driver;
 		ComPtr<ID3D11DeviceContext> m_context;
+		ComPtr<ID3D11DeviceContext1> m_context1;
 		ComPtr<ID3D11CommandList> m_contextCommandList;
 
+		/*
+			Update staging:
+			Staged updates are uploaded into one dynamic constant buffer,
+			constant buffers which were updated are bound as ranges of it until the staging ends.
+		*/
+		struct StagedRange
+		{
+			DxResource* rsc;
+			uint32 offset;
+			uint32 size;
+		};
+
+		bool m_supportsConstantOffsets = false;
+		bool m_supportsConstantRanges = false;
+
+		//Command lists are emulated by the runtime if the driver doesn't support them
+		bool m_driverCommandLists = false;
+		ComPtr<ID3D11Buffer> m_stagingBuffer;
+		uint32 m_stagingCapacity = 0;
+		const uint8* m_stagingMemory = nullptr;
+		std::vector<StagedRange> m_stagedRanges;
+
+		//Resource set and pipeline that are currently bound
+		DxResourceSet* m_boundSet = nullptr;
+		DxPipeline* m_boundPipeline = nullptr;
+
+		//Offset the bound set's dynamic constant buffers are bound at, invalid after the set is bound again
+		enum { INVALID_OFFSET = ~0u };
+		uint32 m_boundOffset = INVALID_OFFSET;
+
+		void bindStagedRanges(DxResourceSet* set);
+		void bindConstantOffset(DxResourceSet* set, uint32 offset);
+		void bindComputeConstants(DxResourceSet* set, uint32 offset);
+		void dispatchBegin(DxPipeline* pipeline, DxResourceSet* set, uint32 constantOffset);
+		void dispatchEnd(DxResourceSet* set);
+		void unstage(DxResource* rsc);
+		void countUpdate(RenderStatsCounter calls, RenderStatsCounter bytes, uint64 size);
+
 	public:
 		
 		Dx11Context() {}
@@ -29,6 +73,7 @@ namespace ts
 		~Dx11Context();
 
 		void resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index) override;
+		void resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size) override;
 		void resourceCopy(ResourceHandle src, ResourceHandle dest) override;
 		void imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index) override;
 
@@ -37,6 +82,19 @@ namespace ts
 
 		void draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params) override;
 
+		void bindTarget(TargetHandle outputs) override;
+		void bindPipeline(PipelineHandle pipeline) override;
+		void bindResourceSet(ResourceSetHandle inputs) override;
+		void drawBound(const DrawParams& params) override;
+		void multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed) override;
+
+		void dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params) override;
+		void dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset) override;
+
+		bool beginStagedUpdates(const void* memory, uint32 size) override;
+		void resourceUpdateStaged(ResourceHandle rsc, uint32 offset, uint32 size) override;
+		void endStagedUpdates() override;
+
 		void finish() override;
 
 		void resetCommandList();
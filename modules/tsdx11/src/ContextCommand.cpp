@@ -4,6 +4,7 @@
 	Draw command methods
 */
 
+#include "Render.h"
 #include "Context.h"
 
 #include "HandleTarget.h"
@@ -52,19 +53,150 @@ DrawCaller drawFunctions(DrawMode mode)
 
 void Dx11Context::draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params)
 {
-	auto ctx = m_context.Get();
-
 	//Bind input/output resources and pipeline state
-	DxPipeline::upcast(pipeline)->bind(ctx);
-	DxTarget::upcast(outputs)->bind(ctx);
-	DxResourceSet::upcast(inputs)->bind(ctx);
+	bindPipeline(pipeline);
+	bindTarget(outputs);
+	bindResourceSet(inputs);
+
+	drawBound(params);
+}
+
+void Dx11Context::bindTarget(TargetHandle outputs)
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+	m_driver->getRenderStats().add(RenderStatsCounter::TARGET_BINDS);
+
+	DxTarget::upcast(outputs)->bind(m_context.Get());
+}
+
+void Dx11Context::bindPipeline(PipelineHandle pipeline)
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+	m_driver->getRenderStats().add(RenderStatsCounter::PIPELINE_BINDS);
+
+	m_boundPipeline = DxPipeline::upcast(pipeline);
+	m_boundPipeline->bind(m_context.Get());
+}
+
+void Dx11Context::bindResourceSet(ResourceSetHandle inputs)
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+	m_driver->getRenderStats().add(RenderStatsCounter::RESOURCE_SET_BINDS);
+
+	DxResourceSet* set = DxResourceSet::upcast(inputs);
+	set->bind(m_context.Get());
+
+	//Constant buffers with staged updates are bound as ranges of the staging buffer
+	if (!m_stagedRanges.empty())
+	{
+		bindStagedRanges(set);
+	}
+
+	m_boundSet = set;
+	m_boundOffset = INVALID_OFFSET;
+}
+
+void Dx11Context::drawBound(const DrawParams& params)
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
+	//Dynamic constant buffers are bound at the offset of the draw
+	if (m_boundSet != nullptr && m_boundSet->getDynamicConstants() != 0 && params.constantOffset != m_boundOffset)
+	{
+		bindConstantOffset(m_boundSet, params.constantOffset);
+		m_boundOffset = params.constantOffset;
+	}
 
 	//Lookup draw call function in table
 	//And call it
-	drawFunctions(params.mode)(ctx, params);
+	drawFunctions(params.mode)(m_context.Get(), params);
+
+	//Draws with no pipeline bound have no known topology and count no triangles
+	m_driver->getRenderStats().countDraw((m_boundPipeline != nullptr) ? m_boundPipeline->getTopology() : VertexTopology::POINTLIST, params);
+}
+
+void Dx11Context::multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed)
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
+	DxResource* pArgs = DxResource::upcast(args);
+
+	if (pArgs == nullptr || !pArgs->isBuffer())
+	{
+		tswarn("unable to draw indirectly with an invalid argument buffer");
+		return;
+	}
+
+	//Dynamic constant buffers of indirect draws are bound at offset 0
+	if (m_boundSet != nullptr && m_boundSet->getDynamicConstants() != 0 && m_boundOffset != 0)
+	{
+		bindConstantOffset(m_boundSet, 0);
+		m_boundOffset = 0;
+	}
+
+	//D3D11 has no multi-draw so each argument is drawn with a separate indirect call
+	const uint32 stride = indexed ? sizeof(DrawIndexedIndirectArgs) : sizeof(DrawIndirectArgs);
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		if (indexed)
+			m_context->DrawIndexedInstancedIndirect(pArgs->asBuffer(), offset + i * stride);
+		else
+			m_context->DrawInstancedIndirect(pArgs->asBuffer(), offset + i * stride);
+	}
+
+	//Arguments are only known to the GPU so triangles and instances aren't counted
+	m_driver->getRenderStats().add(RenderStatsCounter::DRAWCALLS, count);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Dx11Context::dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params)
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
+	DxPipeline* pPipeline = DxPipeline::upcast(pipeline);
+	DxResourceSet* pSet = DxResourceSet::upcast(inputs);
+
+	if (pPipeline == nullptr || pSet == nullptr || !pPipeline->isCompute())
+	{
+		tswarn("unable to dispatch with an invalid compute pipeline or resource set");
+		return;
+	}
+
+	dispatchBegin(pPipeline, pSet, params.constantOffset);
+	m_context->Dispatch(params.groupsX, params.groupsY, params.groupsZ);
+	dispatchEnd(pSet);
+
+	m_driver->getRenderStats().add(RenderStatsCounter::DISPATCHES);
+}
+
+void Dx11Context::dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset)
+{
+	RenderStatsTimer timer(m_driver->getRenderStats());
+
+	DxPipeline* pPipeline = DxPipeline::upcast(pipeline);
+	DxResourceSet* pSet = DxResourceSet::upcast(inputs);
+	DxResource* pArgs = DxResource::upcast(args);
+
+	if (pPipeline == nullptr || pSet == nullptr || !pPipeline->isCompute())
+	{
+		tswarn("unable to dispatch with an invalid compute pipeline or resource set");
+		return;
+	}
+
+	if (pArgs == nullptr || !pArgs->isBuffer())
+	{
+		tswarn("unable to dispatch indirectly with an invalid argument buffer");
+		return;
+	}
+
+	//Dynamic constant buffers of indirect dispatches are bound at offset 0
+	dispatchBegin(pPipeline, pSet, 0);
+	m_context->DispatchIndirect(pArgs->asBuffer(), offset);
+	dispatchEnd(pSet);
 
-	//For debugging
-	m_driver->incrementDrawCallCounter();
+	m_driver->getRenderStats().add(RenderStatsCounter::DISPATCHES);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
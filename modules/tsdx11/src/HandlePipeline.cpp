@@ -13,6 +13,7 @@ using namespace ts;
 
 RPtr<PipelineHandle> Dx11::createPipeline(ShaderHandle program, const PipelineCreateInfo& info)
 {
+	m_renderStats.add(RenderStatsCounter::PIPELINES_CREATED);
 	return RPtr<PipelineHandle>(this, DxPipeline::downcast(new DxPipeline(m_stateManager, program, info)));
 }
 
@@ -20,6 +21,7 @@ void Dx11::destroy(PipelineHandle hpipe)
 {
 	if (auto p = DxPipeline::upcast(hpipe))
 	{
+		m_renderStats.add(RenderStatsCounter::PIPELINES_DESTROYED);
 		delete p;
 	}
 }
@@ -49,6 +51,8 @@ DxPipeline::DxPipeline(DxStateManager& states, ShaderHandle program, const Pipel
 	}
 
 	//Get primitive topology
+	m_vertexTopology = info.topology;
+
 	switch (info.topology)
 	{
 		case (VertexTopology::TRIANGLELIST): { m_topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST; break; }
@@ -86,4 +90,10 @@ void DxPipeline::bind(ID3D11DeviceContext* context)
 	context->IASetPrimitiveTopology(m_topology);
 }
 
+void DxPipeline::bindCompute(ID3D11DeviceContext* context)
+{
+	context->CSSetShader(m_program->compute.Get(), nullptr, 0);
+	context->CSSetSamplers(0, (UINT)m_samplers.size(), (ID3D11SamplerState**)m_samplers.data());
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -23,6 +23,12 @@ namespace ts
 		~DxPipeline() {}
 		
 		void bind(ID3D11DeviceContext* context);
+		//Bind the compute shader and samplers, graphics state is unchanged
+		void bindCompute(ID3D11DeviceContext* context);
+
+		bool isCompute() const { return m_program->compute.Get() != nullptr; }
+
+		VertexTopology getTopology() const { return m_vertexTopology; }
 
 	private:
 
@@ -36,6 +42,7 @@ namespace ts
 		ComPtr<ID3D11InputLayout> m_inputLayout;
 
 		D3D11_PRIMITIVE_TOPOLOGY m_topology;
+		VertexTopology m_vertexTopology;
 
 	};
 }
\ No newline at end of file
@@ -15,6 +15,78 @@
 using namespace ts;
 using namespace std;
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Resource memory
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Bytes per pixel of an image format
+static uint32 getFormatSize(ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::BYTE: return 1;
+	case ImageFormat::RGB: return 4; //Padded to 4 bytes
+	case ImageFormat::RGBA: return 4;
+	case ImageFormat::ARGB: return 4;
+	case ImageFormat::FLOAT1: return 4;
+	case ImageFormat::FLOAT2: return 8;
+	case ImageFormat::FLOAT3: return 12;
+	case ImageFormat::FLOAT4: return 16;
+	case ImageFormat::DEPTH16: return 2;
+	case ImageFormat::DEPTH32: return 4;
+	default: return 0;
+	}
+}
+
+static uint32 getMipCount(const ImageResourceInfo& info)
+{
+	return (info.useMips) ? getNumMipLevels(info.width, info.height) : 1;
+}
+
+//Bytes of memory used by one mip level of one array layer of an image
+static uint64 getMipSize(const ImageResourceInfo& info, uint32 mip)
+{
+	const uint64 w = max<uint64>(info.width >> mip, 1);
+	const uint64 h = max<uint64>(info.height >> mip, 1);
+	const uint64 d = (info.type == ImageType::_3D) ? max<uint64>(info.length >> mip, 1) : 1;
+
+	return w * h * d * getFormatSize(info.format) * max(info.msLevels, 1u);
+}
+
+//Bytes of memory used by an image
+static uint64 getImageSize(const ImageResourceInfo& info)
+{
+	const uint32 mips = getMipCount(info);
+	const uint64 layers = (info.type == ImageType::_3D) ? 1 : max(info.length, 1u);
+
+	uint64 size = 0;
+
+	for (uint32 mip = 0; mip < mips; mip++)
+	{
+		size += getMipSize(info, mip);
+	}
+
+	return size * layers;
+}
+
+uint64 DxResource::getUpdateSize(uint32 index) const
+{
+	if (isBuffer())
+	{
+		return m_memorySize;
+	}
+
+	//Subresources are ordered by mip level within each array layer
+	return getMipSize(m_imageInfo, index % getMipCount(m_imageInfo));
+}
+
+void Dx11::trackMemory(DxResource* rsc, RenderStatsCounter counter, uint64 size)
+{
+	m_renderStats.subtract(rsc->getMemoryCounter(), rsc->getMemorySize());
+	rsc->setMemory(counter, size);
+	m_renderStats.add(counter, size);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Empty resource allocation
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -24,6 +96,7 @@ RPtr<ResourceHandle> Dx11::createEmptyResource(ResourceHandle recycle)
 	if (recycle != (ResourceHandle)0)
 	{
 		auto rsc = DxResource::upcast(recycle);
+		trackMemory(rsc, RenderStatsCounter::IMAGE_MEMORY, 0);
 		rsc->reset();
 		return RPtr<ResourceHandle>(this, recycle);
 	}
@@ -39,11 +112,20 @@ RPtr<ResourceHandle> Dx11::createEmptyResource(ResourceHandle recycle)
 
 RPtr<ResourceHandle> Dx11::createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle)
 {
-	UPtr<DxResource> rsc(DxResource::upcast(recycle));
+	//A recycled handle is owned by the caller, only a resource allocated here is freed if creation fails
+	UPtr<DxResource> created;
+	DxResource* rsc = DxResource::upcast(recycle);
+
 	if (rsc == nullptr)
-		rsc.reset(new DxResource(nullptr));
+	{
+		created.reset(new DxResource(nullptr));
+		rsc = created.get();
+	}
 	else
+	{
+		trackMemory(rsc, RenderStatsCounter::IMAGE_MEMORY, 0);
 		rsc->reset();
+	}
 
 	DXGI_FORMAT format = ImageFormatToDXGIFormat(info.format);
 	D3D11_USAGE usage = D3D11_USAGE::D3D11_USAGE_DEFAULT;
@@ -117,6 +199,10 @@ RPtr<ResourceHandle> Dx11::createResourceImage(const ResourceData* data, const I
 	{
 		bindFlags |= D3D11_BIND_RENDER_TARGET;
 	}
+	if ((info.usage & ImageUsage::UAV) != 0)
+	{
+		bindFlags |= D3D11_BIND_UNORDERED_ACCESS;
+	}
 	if ((info.usage & ImageUsage::DSV) != 0)
 	{
 		if (bindFlags & D3D11_BIND_RENDER_TARGET)
@@ -248,7 +334,13 @@ RPtr<ResourceHandle> Dx11::createResourceImage(const ResourceData* data, const I
 	}
 
 	rsc->init(resource);
-	return RPtr<ResourceHandle>(this, DxResource::downcast(rsc.release()));
+	rsc->setImageInfo(info);
+
+	trackMemory(rsc, RenderStatsCollector::getMemoryCounter(info.usage), getImageSize(info));
+	m_renderStats.add(RenderStatsCounter::IMAGES_CREATED);
+
+	created.release();
+	return RPtr<ResourceHandle>(this, DxResource::downcast(rsc));
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -273,6 +365,8 @@ RPtr<ResourceHandle> Dx11::createResourceBuffer(const ResourceData& data, const
 	case BufferType::VERTEX: { subdesc.BindFlags = D3D11_BIND_VERTEX_BUFFER; break; }
 	case BufferType::INDEX: { subdesc.BindFlags = D3D11_BIND_INDEX_BUFFER; break; }
 	case BufferType::CONSTANTS: { subdesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER; break; }
+	case BufferType::INDIRECT: { subdesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS; break; }
+	case BufferType::STORAGE: { subdesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS; break; }
 	}
 
 	//Only dynamic resources are allowed direct access to buffer memory
@@ -281,7 +375,12 @@ RPtr<ResourceHandle> Dx11::createResourceBuffer(const ResourceData& data, const
 		subdesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 	}
 
-	subdesc.MiscFlags = 0;
+	//Buffers written by compute shaders are viewed as raw 32 bit words
+	if (info.type == BufferType::INDIRECT)
+		subdesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+	else if (info.type == BufferType::STORAGE)
+		subdesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+
 	subdesc.ByteWidth = info.size;
 
 	subdata.pSysMem = data.memory;
@@ -296,16 +395,24 @@ RPtr<ResourceHandle> Dx11::createResourceBuffer(const ResourceData& data, const
 	}
 	else
 	{
+		DxResource* rsc = nullptr;
+
 		if (recycle != (ResourceHandle)0)
 		{
-			auto rsc = DxResource::upcast(recycle);
+			rsc = DxResource::upcast(recycle);
+			trackMemory(rsc, RenderStatsCounter::IMAGE_MEMORY, 0);
 			rsc->reset();
-			return RPtr<ResourceHandle>(this, DxResource::downcast(new(rsc) DxResource(buffer)));
+			rsc = new(rsc) DxResource(buffer);
 		}
 		else
 		{
-			return RPtr<ResourceHandle>(this, DxResource::downcast(new DxResource(buffer)));
+			rsc = new DxResource(buffer);
 		}
+
+		trackMemory(rsc, RenderStatsCollector::getMemoryCounter(info.type), info.size);
+		m_renderStats.add(RenderStatsCounter::BUFFERS_CREATED);
+
+		return RPtr<ResourceHandle>(this, DxResource::downcast(rsc));
 	}
 }
 
@@ -315,6 +422,13 @@ void Dx11::destroy(ResourceHandle hrsc)
 
 	if (rsc)
 	{
+		//Empty resources have no memory and aren't counted as buffers or images
+		if (rsc->asResource() != nullptr)
+		{
+			m_renderStats.add(rsc->isBuffer() ? RenderStatsCounter::BUFFERS_DESTROYED : RenderStatsCounter::IMAGES_DESTROYED);
+		}
+
+		trackMemory(rsc, RenderStatsCounter::IMAGE_MEMORY, 0);
 		delete rsc;
 	}
 }
@@ -551,4 +665,67 @@ ID3D11DepthStencilView* DxResource::getDSV(uint32 arrayIndex)
 	}
 }
 
+ID3D11UnorderedAccessView* DxResource::getUAV(uint32 arrayIndex)
+{
+	if (m_rsc.Get() == nullptr) return nullptr;
+
+	ComPtr<ID3D11Device> device;
+	m_rsc->GetDevice(device.GetAddressOf());
+
+	auto it = m_uavCache.find(arrayIndex);
+
+	//Cache hit
+	if (it != m_uavCache.end())
+	{
+		return it->second.Get();
+	}
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC viewdesc;
+	ZeroMemory(&viewdesc, sizeof(viewdesc));
+
+	if (isBuffer())
+	{
+		D3D11_BUFFER_DESC desc;
+		asBuffer()->GetDesc(&desc);
+
+		if ((desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS) == 0)
+			return nullptr;
+
+		//Buffers are viewed as raw 32 bit words
+		viewdesc.Format = DXGI_FORMAT_R32_TYPELESS;
+		viewdesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		viewdesc.Buffer.FirstElement = 0;
+		viewdesc.Buffer.NumElements = desc.ByteWidth / 4;
+		viewdesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+	}
+	else if (getType() == D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+	{
+		D3D11_TEXTURE2D_DESC desc;
+		static_cast<ID3D11Texture2D*>(m_rsc.Get())->GetDesc(&desc);
+
+		if ((desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS) == 0)
+			return nullptr;
+
+		//Top mip of one array element
+		viewdesc.Format = desc.Format;
+		viewdesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2DARRAY;
+		viewdesc.Texture2DArray.FirstArraySlice = arrayIndex;
+		viewdesc.Texture2DArray.ArraySize = 1;
+		viewdesc.Texture2DArray.MipSlice = 0;
+	}
+	else
+	{
+		return nullptr;
+	}
+
+	ComPtr<ID3D11UnorderedAccessView> uav;
+	if (FAILED(device->CreateUnorderedAccessView(m_rsc.Get(), &viewdesc, uav.GetAddressOf())))
+	{
+		return nullptr;
+	}
+
+	m_uavCache.insert(make_pair(arrayIndex, uav));
+	return uav.Get();
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
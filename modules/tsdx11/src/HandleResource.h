@@ -13,6 +13,8 @@
 #include "Base.h"
 #include "Handle.h"
 
+#include <tsgraphics/DriverStats.h>
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 namespace ts
@@ -52,6 +54,15 @@ namespace ts
 		Cache<SRVKey, ID3D11ShaderResourceView, SRVKey> m_srvCache;
 		Cache<uint32, ID3D11RenderTargetView> m_rtvCache;
 		Cache<uint32, ID3D11DepthStencilView> m_dsvCache;
+		Cache<uint32, ID3D11UnorderedAccessView> m_uavCache;
+
+		/*
+			Memory the resource is counted for in the device stats,
+			images keep their description so the size of a subresource update is known
+		*/
+		uint64 m_memorySize = 0;
+		RenderStatsCounter m_memoryCounter = RenderStatsCounter::IMAGE_MEMORY;
+		ImageResourceInfo m_imageInfo;
 
 	public:
 
@@ -69,6 +80,16 @@ namespace ts
 		ID3D11ShaderResourceView* getSRV(uint32 arrayIndex, uint32 arrayCount, ImageType type);
 		ID3D11RenderTargetView* getRTV(uint32 arrayIndex);
 		ID3D11DepthStencilView* getDSV(uint32 arrayIndex);
+		//Raw view of a buffer, or the top mip of one element of a 2D image
+		ID3D11UnorderedAccessView* getUAV(uint32 arrayIndex);
+
+		uint64 getMemorySize() const { return m_memorySize; }
+		RenderStatsCounter getMemoryCounter() const { return m_memoryCounter; }
+		void setMemory(RenderStatsCounter counter, uint64 size) { m_memoryCounter = counter; m_memorySize = size; }
+		void setImageInfo(const ImageResourceInfo& info) { m_imageInfo = info; }
+
+		//Bytes written by an update of a subresource
+		uint64 getUpdateSize(uint32 index) const;
 
 		void init(ComPtr<ID3D11Resource> rsc)
 		{
@@ -86,6 +107,7 @@ namespace ts
 			m_srvCache.clear();
 			m_rtvCache.clear();
 			m_dsvCache.clear();
+			m_uavCache.clear();
 			//clear resourc
 			m_rsc.Reset();
 		}
@@ -23,6 +23,7 @@ RPtr<ResourceSetHandle> Dx11::createResourceSet(const ResourceSetCreateInfo& inf
 		return RPtr<ResourceSetHandle>();
 	}
 
+	m_renderStats.add(RenderStatsCounter::RESOURCE_SETS_CREATED);
 	return RPtr<ResourceSetHandle>(this, DxResourceSet::downcast(set));
 }
 
@@ -30,6 +31,7 @@ void Dx11::destroy(ResourceSetHandle handle)
 {
 	if (auto t = DxResourceSet::upcast(handle))
 	{
+		m_renderStats.add(RenderStatsCounter::RESOURCE_SETS_DESTROYED);
 		delete t;
 	}
 }
@@ -61,7 +63,25 @@ HRESULT DxResourceSet::create(const ResourceSetCreateInfo& info)
 		m_srvs.push_back(SRV(info.resources[i]));
 	}
 
+	//Get unordered access views
+	m_uavs.reserve(info.storageBufferCount + info.storageImageCount);
+	for (size_t i = 0; i < info.storageBufferCount; i++)
+	{
+		m_uavs.push_back(UAV(DxResource::upcast(info.storageBuffers[i]), 0));
+	}
+	for (size_t i = 0; i < info.storageImageCount; i++)
+	{
+		m_uavs.push_back(UAV(DxResource::upcast(info.storageImages[i].image), info.storageImages[i].index));
+	}
+
+	if (m_uavs.size() > D3D11_PS_CS_UAV_REGISTER_COUNT)
+	{
+		tswarn("resource set has more storage bindings than can be bound (%)", m_uavs.size());
+		return E_INVALIDARG;
+	}
+
 	m_indexBuffer = DxResource::upcast(info.indexBuffer);
+	m_dynamicConstants = info.dynamicConstants;
 
 	return S_OK;
 }
@@ -105,4 +125,44 @@ void DxResourceSet::bind(ID3D11DeviceContext* context)
 	context->IASetIndexBuffer(ib, DXGI_FORMAT_R32_UINT, 0);
 }
 
+void DxResourceSet::bindCompute(ID3D11DeviceContext* context)
+{
+	//Bind SRV
+	UINT i = 0;
+	for (const SRV& srv : m_srvs)
+	{
+		auto s = srv.getView();
+		context->CSSetShaderResources(i, 1, &s);
+		i++;
+	}
+
+	//Bind constant buffers
+	i = 0;
+	for (const CBV& cbv : m_constantBuffers)
+	{
+		ID3D11Buffer* buf = (cbv == nullptr) ? nullptr : cbv->asBuffer();
+		context->CSSetConstantBuffers(i, 1, &buf);
+		i++;
+	}
+
+	//Bind UAV
+	i = 0;
+	for (const UAV& uav : m_uavs)
+	{
+		auto u = uav.getView();
+		context->CSSetUnorderedAccessViews(i, 1, &u, nullptr);
+		i++;
+	}
+}
+
+void DxResourceSet::unbindCompute(ID3D11DeviceContext* context)
+{
+	ID3D11UnorderedAccessView* null = nullptr;
+
+	for (UINT i = 0; i < (UINT)m_uavs.size(); i++)
+	{
+		context->CSSetUnorderedAccessViews(i, 1, &null, nullptr);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -59,18 +59,44 @@ namespace ts
 			ID3D11Buffer* getBuffer() const { return (buffer == nullptr) ? nullptr : buffer->asBuffer(); }
 		};
 
+		//unordered access view, of a storage buffer or one element of a storage image
+		struct UAV
+		{
+			DxResource* rsc;
+			uint32 index;
+
+			UAV() : rsc(nullptr), index(0) {}
+			UAV(DxResource* rsc, uint32 index) : rsc(rsc), index(index) {}
+
+			ID3D11UnorderedAccessView* getView() const
+			{
+				return (rsc == nullptr) ? nullptr : rsc->getUAV(index);
+			}
+		};
+
 		using CBV = DxResource*;
 
 		HRESULT create(const ResourceSetCreateInfo& info);
 
 		void bind(ID3D11DeviceContext* context);
 
+		//Bind resources to the compute stage, storage buffers take the first UAV slots and storage images the slots after
+		void bindCompute(ID3D11DeviceContext* context);
+		//Unbind the UAVs so the resources they view can be read by other stages
+		void unbindCompute(ID3D11DeviceContext* context);
+
+		const std::vector<CBV>& getConstantBuffers() const { return m_constantBuffers; }
+		//Constant buffer slots bound at the offset of each draw
+		uint32 getDynamicConstants() const { return m_dynamicConstants; }
+
 		void reset()
 		{
 			m_srvs.clear();
 			m_constantBuffers.clear();
 			m_vertexBuffers.clear();
+			m_uavs.clear();
 			m_indexBuffer = nullptr;
+			m_dynamicConstants = 0;
 		}
 
 	private:
@@ -78,6 +104,8 @@ namespace ts
 		std::vector<SRV> m_srvs;
 		std::vector<CBV> m_constantBuffers;
 		std::vector<VBV> m_vertexBuffers;
+		std::vector<UAV> m_uavs;
 		DxResource* m_indexBuffer;
+		uint32 m_dynamicConstants = 0;
 	};
 }
\ No newline at end of file
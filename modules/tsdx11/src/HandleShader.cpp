@@ -83,6 +83,7 @@ RPtr<ShaderHandle> Dx11::createShader(const ShaderCreateInfo& info)
 	if (stageCount > 0)
 	{
 		//Return new program
+		m_renderStats.add(RenderStatsCounter::SHADERS_CREATED);
 		return RPtr<ShaderHandle>(this, DxShader::downcast(program.release()));
 	}
 
@@ -94,6 +95,7 @@ void Dx11::destroy(ShaderHandle shader)
 {
 	if (auto s = DxShader::upcast(shader))
 	{
+		m_renderStats.add(RenderStatsCounter::SHADERS_DESTROYED);
 		delete s;
 	}
 }
@@ -43,6 +43,7 @@ RPtr<TargetHandle> Dx11::createTarget(const TargetCreateInfo& info, TargetHandle
 	//Prewarm the view cache
 	target->warm();
 
+	m_renderStats.add(RenderStatsCounter::TARGETS_CREATED);
 	return RPtr<TargetHandle>(this, DxTarget::downcast(target));
 }
 
@@ -50,6 +51,7 @@ void Dx11::destroy(TargetHandle target)
 {
 	if (DxTarget* t = DxTarget::upcast(target))
 	{
+		m_renderStats.add(RenderStatsCounter::TARGETS_DESTROYED);
 		delete t;
 	}
 }
@@ -8,6 +8,9 @@
 
 #include <vector>
 #include <atomic>
+#include <memory>
+
+#include <tsgraphics/DriverStats.h>
 
 #include "Base.h"
 #include "Context.h"
@@ -35,6 +38,10 @@ namespace ts
 		RenderContext* context() override { return &m_context; }
 		void commit() override;
 
+		//Parallel recording
+		uint32 acquireContexts(RenderContext** contexts, uint32 count) override;
+		void submitContexts(RenderContext* const* contexts, uint32 count) override;
+
 		//Display methods
 		void setDisplayConfiguration(const DisplayConfig& displayCfg) override;
 		void getDisplayConfiguration(DisplayConfig& displayCfg) override;
@@ -65,8 +72,8 @@ namespace ts
 
 		//Internal methods
 		ComPtr<ID3D11Device> getDevice() const { return m_device; }
-		
-		void incrementDrawCallCounter() { m_drawCallCounter++; }
+
+		RenderStatsCollector& getRenderStats() { return m_renderStats; }
 
 	private:
 
@@ -83,6 +90,12 @@ namespace ts
 
 		Dx11Context m_context;
 
+		//Deferred contexts used by worker threads, the first m_acquiredContexts are in use this frame
+		std::vector<std::unique_ptr<Dx11Context>> m_workerContexts;
+		uint32 m_acquiredContexts = 0;
+
+		void executeCommandList(Dx11Context& context);
+
 		DxResource m_displayResourceProxy;
 		DxStateManager m_stateManager;
 
@@ -91,8 +104,11 @@ namespace ts
 		HRESULT translateSwapChainDesc(const DisplayConfig& displayCfg, DXGI_SWAP_CHAIN_DESC& scDesc);
 		void updateDisplayResource();
 
-		//Number of drawcalls per frame - for debugging
-		std::atomic<uint32> m_drawCallCounter;
+		//Counters reported by queryStats(), updated by the main and worker contexts
+		RenderStatsCollector m_renderStats;
+
+		//Move the memory a resource is counted for to another counter and size
+		void trackMemory(DxResource* rsc, RenderStatsCounter counter, uint64 size);
 
 		bool getMultisampleQuality(DXGI_SAMPLE_DESC& sampledesc);
 	};
@@ -193,23 +193,76 @@ Dx11::~Dx11()
 
 void Dx11::commit()
 {	
-	if (ID3D11CommandList* cmdlist = m_context.getCommandList())
+	executeCommandList(m_context);
+
+	//Command lists of workers which weren't submitted are dropped
+	for (uint32 i = 0; i < m_acquiredContexts; i++)
 	{
-		m_immediateContext->ExecuteCommandList(cmdlist, false);
-		m_context.resetCommandList(); //Every command list must be released every frame
+		m_workerContexts[i]->resetCommandList();
 	}
 
+	m_acquiredContexts = 0;
+
 	//Send queued commands to the GPU and present swapchain backbuffer
 	m_dxgiSwapchain->Present(0, 0);
-	//Reset draw call counter each frame
-	m_drawCallCounter = 0;
+	//Reset frame counters each frame
+	m_renderStats.nextFrame();
+}
+
+void Dx11::executeCommandList(Dx11Context& context)
+{
+	if (ID3D11CommandList* cmdlist = context.getCommandList())
+	{
+		m_immediateContext->ExecuteCommandList(cmdlist, false);
+		context.resetCommandList(); //Every command list must be released every frame
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Parallel recording
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32 Dx11::acquireContexts(RenderContext** contexts, uint32 count)
+{
+	//Each worker is a deferred context of it's own, they are kept between frames
+	for (uint32 i = 0; i < count; i++)
+	{
+		if (m_acquiredContexts == m_workerContexts.size())
+		{
+			m_workerContexts.push_back(std::unique_ptr<Dx11Context>(new Dx11Context(this)));
+		}
+
+		contexts[i] = m_workerContexts[m_acquiredContexts++].get();
+	}
+
+	return count;
+}
+
+void Dx11::submitContexts(RenderContext* const* contexts, uint32 count)
+{
+	//Commands recorded on the main context so far are executed first
+	m_context.finish();
+	executeCommandList(m_context);
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		Dx11Context* context = static_cast<Dx11Context*>(contexts[i]);
+
+		if (context->getCommandList() == nullptr)
+		{
+			tswarn("worker context submitted before it was finished");
+			continue;
+		}
+
+		executeCommandList(*context);
+	}
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Dx11::queryStats(RenderStats& stats)
 {
-	stats.drawcalls = m_drawCallCounter.load();
+	m_renderStats.query(stats);
 }
 
 void Dx11::queryInfo(RenderDeviceInfo& info)
@@ -222,6 +275,12 @@ void Dx11::queryInfo(RenderDeviceInfo& info)
 	info.gpuVideoMemory = desc.DedicatedVideoMemory;
 	info.gpuSystemMemory = desc.DedicatedSystemMemory;
 	info.sharedSystemMemory = desc.SharedSystemMemory;
+
+	//Updating ranges of constant buffers requires D3D11.1
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	info.constantBufferRanges =
+		SUCCEEDED(m_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+		(options.ConstantBufferPartialUpdate != FALSE);
 }
 
 //helper function
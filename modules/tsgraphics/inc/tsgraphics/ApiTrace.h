@@ -0,0 +1,227 @@
+/*
+	API Trace:
+
+	Records every call made to a device and it's context into a compact binary trace,
+	so CPU side driver overhead can be diagnosed offline.
+
+	- TraceDevice wraps another device, each call is forwarded and recorded with a timestamp,
+	  the time spent in the wrapped call and it's arguments.
+	- Memory passed to calls (buffer contents, create infos) is not stored, only a hash of it,
+	  which is enough to find repeated identical updates and duplicate objects.
+	- Records are written to the output stream at the end of each frame (commit()).
+	- Calls are recorded from a single thread, so the device acquires no worker contexts.
+	- TraceReader loads a trace and summarizes it, the apitrace tool prints the summary.
+
+	example:
+
+		TraceDevice trace(device, "frames.tstrace");
+		...
+		queue.flush(trace.context());
+		trace.commit();
+
+		TraceReader reader;
+		reader.load("frames.tstrace");
+		TraceReader::Summary summary = reader.summarize();
+*/
+
+#pragma once
+
+#include <tsgraphics/abi.h>
+
+#include <tscore/ptr.h>
+#include <tscore/path.h>
+
+#include "Driver.h"
+
+#include <iosfwd>
+#include <vector>
+
+namespace ts
+{
+	enum class TraceCall : uint8
+	{
+		//Device calls
+		COMMIT,
+		SET_DISPLAY,
+		CREATE_EMPTY_RESOURCE,
+		CREATE_BUFFER,
+		CREATE_IMAGE,
+		CREATE_RESOURCE_SET,
+		CREATE_SHADER,
+		CREATE_PIPELINE,
+		CREATE_TARGET,
+		DESTROY_RESOURCE,
+		DESTROY_RESOURCE_SET,
+		DESTROY_SHADER,
+		DESTROY_PIPELINE,
+		DESTROY_TARGET,
+
+		//Context calls
+		UPDATE,
+		UPDATE_RANGE,
+		UPDATE_STAGED,
+		BEGIN_STAGED,
+		END_STAGED,
+		COPY,
+		RESOLVE,
+		CLEAR_COLOUR,
+		CLEAR_DEPTH,
+		DRAW,
+		BIND_TARGET,
+		BIND_PIPELINE,
+		BIND_RESOURCES,
+		DRAW_BOUND,
+		BATCH_MARKER,
+		FINISH,
+		DRAW_INDIRECT,
+		DRAW_INDEXED_INDIRECT,
+		DISPATCH,
+		DISPATCH_INDIRECT,
+
+		MAX_CALLS
+	};
+
+	/*
+		A recorded call
+	*/
+	struct TraceRecord
+	{
+		TraceCall call = TraceCall::MAX_CALLS;
+
+		//Frame the call was made in, frames end with commit()
+		uint32 frame = 0;
+
+		//Nanoseconds since the trace began and nanoseconds spent in the wrapped call
+		uint64 time = 0;
+		uint64 duration = 0;
+
+		/*
+			Arguments:
+
+			object    - handle the call acts on (the created handle for create calls)
+			other     - second handle (copy/resolve destination, pipeline shader, recycled handle, dispatch resource set)
+			value0/1  - call specific values (update index/offset/size, draw count/instances, indirect argument offset/draw count,
+			            dispatch group count/constant offset, indirect dispatch argument offset/buffer, clear colour, sort key)
+			hash      - hash of the memory passed to the call, 0 if there is none
+		*/
+		uint64 object = 0;
+		uint64 other = 0;
+		uint64 value0 = 0;
+		uint64 value1 = 0;
+		uint64 hash = 0;
+	};
+
+	/*
+		Device which records every call made to it and it's context
+	*/
+	class TraceDevice : public RenderDevice
+	{
+	private:
+
+		struct State;
+		OpaquePtr<State> pState;
+
+	public:
+
+		OPAQUE_PTR(TraceDevice, pState)
+
+		//Trace to a stream, the stream must outlive the device
+		TSGRAPHICS_API TraceDevice(RenderDevice* device, std::ostream& out);
+		//Trace to a file
+		TSGRAPHICS_API TraceDevice(RenderDevice* device, const Path& file);
+		TSGRAPHICS_API ~TraceDevice();
+
+		//Device that calls are forwarded to
+		TSGRAPHICS_API RenderDevice* getDevice() const;
+
+		//Returns false if the trace could not be opened
+		TSGRAPHICS_API bool isOpen() const;
+
+		//Write recorded calls to the output, called by commit()
+		TSGRAPHICS_API void flush();
+
+		/*
+			Device methods
+		*/
+
+		TSGRAPHICS_API RenderContext* context() override;
+		TSGRAPHICS_API void commit() override;
+
+		TSGRAPHICS_API void setDisplayConfiguration(const DisplayConfig& displayCfg) override;
+		TSGRAPHICS_API void getDisplayConfiguration(DisplayConfig& displayCfg) override;
+		TSGRAPHICS_API ResourceHandle getDisplayTarget() override;
+
+		TSGRAPHICS_API void queryStats(RenderStats& stats) override;
+		TSGRAPHICS_API void queryInfo(RenderDeviceInfo& info) override;
+
+		TSGRAPHICS_API RPtr<ResourceHandle> createEmptyResource(ResourceHandle recycle) override;
+		TSGRAPHICS_API RPtr<ResourceHandle> createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle) override;
+		TSGRAPHICS_API RPtr<ResourceHandle> createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle) override;
+		TSGRAPHICS_API RPtr<ResourceSetHandle> createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle) override;
+		TSGRAPHICS_API RPtr<ShaderHandle> createShader(const ShaderCreateInfo& info) override;
+		TSGRAPHICS_API RPtr<PipelineHandle> createPipeline(ShaderHandle program, const PipelineCreateInfo& info) override;
+		TSGRAPHICS_API RPtr<TargetHandle> createTarget(const TargetCreateInfo& info, TargetHandle recycle) override;
+
+		TSGRAPHICS_API void destroy(ResourceHandle rsc) override;
+		TSGRAPHICS_API void destroy(ResourceSetHandle set) override;
+		TSGRAPHICS_API void destroy(ShaderHandle shader) override;
+		TSGRAPHICS_API void destroy(PipelineHandle state) override;
+		TSGRAPHICS_API void destroy(TargetHandle pass) override;
+	};
+
+	/*
+		Loads and summarizes a trace
+	*/
+	class TraceReader
+	{
+	public:
+
+		struct CallStats
+		{
+			uint64 count = 0;
+			uint64 totalTime = 0; //ns
+			uint64 maxTime = 0;   //ns
+		};
+
+		struct FrameStats
+		{
+			uint32 calls = 0;
+			uint32 draws = 0;
+			uint32 dispatches = 0;
+			uint64 callTime = 0; //ns spent in the wrapped device
+			uint64 wallTime = 0; //ns between the first call of the frame and it's commit
+		};
+
+		struct Summary
+		{
+			CallStats calls[(size_t)TraceCall::MAX_CALLS];
+			std::vector<FrameStats> frames;
+
+			//Objects created with the same description as a live object of the same type
+			uint32 duplicatePipelines = 0;
+			uint32 duplicateShaders = 0;
+			uint32 duplicateResourceSets = 0;
+
+			//Updates which wrote the same contents a resource already had
+			uint32 repeatedUpdates = 0;
+			uint64 repeatedUpdateBytes = 0;
+
+			//Binds of the state that was already bound
+			uint32 redundantBinds = 0;
+		};
+
+		//Load a trace, returns false if it is not a valid trace
+		TSGRAPHICS_API bool load(std::istream& in);
+		TSGRAPHICS_API bool load(const Path& file);
+
+		const std::vector<TraceRecord>& records() const { return m_records; }
+
+		TSGRAPHICS_API Summary summarize() const;
+
+		TSGRAPHICS_API static const char* callName(TraceCall call);
+
+	private:
+
+		std::vector<TraceRecord> m_records;
+	};
+}
@@ -7,34 +7,42 @@
 #include <unordered_map>
 
 #include <tscore/path.h>
+#include <tscore/refcount.h>
 
 namespace ts
 {
     /*
         Generic asset caches
+
+		Assets are stored as intrusive reference counted objects,
+		so they can outlive the cache and are never moved once loaded.
     */
     template<class Derived, class AssetType>
     class AssetCache
     {
-        using InternalCache = std::unordered_map<Path, AssetType>;
+        using InternalCache = std::unordered_map<Path, IntrusivePtr<AssetType>>;
 
     public:
 
         AssetType& get(const Path& filePath)
         {
-			using std::make_pair;
+			return *getRef(filePath);
+        }
 
+		//Get a shared reference to an asset
+		IntrusivePtr<AssetType> getRef(const Path& filePath)
+		{
             auto it = m_cache.find(filePath);
 
             if (it == m_cache.end())
             {
 				Derived* d = static_cast<Derived*>(this);
-				return m_cache.emplace(filePath, d->load(filePath)).first->second;
-				//return m_cache.find(filePath)->second;
+				IntrusivePtr<AssetType> asset(new AssetType(d->load(filePath)));
+				return m_cache.emplace(filePath, asset).first->second;
             }
 
 			return it->second;
-        }
+		}
 
     private:
 
@@ -0,0 +1,86 @@
+/*
+	Asynchronous resource creation:
+
+	Creates buffers and images on a worker thread so loading many resources doesn't block the calling thread.
+
+	- Handles are reserved with createEmptyResource() and returned immediately,
+	  the worker then creates each resource in place of it's reserved handle.
+	- Each submission returns a fence value, the memory passed to it must stay valid
+	  and it's handles must not be used by a context or released until the fence is complete.
+	- Fences complete in the order they were submitted.
+	- A resource which can't be created is counted as a failure and it's reserved handle is left empty.
+	  Images which use generated mips can't be created asynchronously, they need the device's immediate context.
+	- The device must allow objects to be created from other threads,
+	  a CaptureDevice doesn't so it shouldn't be used while capturing is enabled.
+
+	example:
+
+		AsyncResourceCreator creator(device);
+
+		RPtr<ResourceHandle> buffers[2];
+		uint64 fence = creator.createResourceBuffers(data, info, 2, buffers);
+		...
+		creator.wait(fence);
+*/
+
+#pragma once
+
+#include <tsgraphics/abi.h>
+
+#include <tscore/ptr.h>
+
+#include "Driver.h"
+
+namespace ts
+{
+	class AsyncResourceCreator
+	{
+	private:
+
+		struct State;
+		OpaquePtr<State> pState;
+
+	public:
+
+		OPAQUE_PTR(AsyncResourceCreator, pState)
+
+		TSGRAPHICS_API AsyncResourceCreator(RenderDevice* device);
+		//Waits for every submission to complete
+		TSGRAPHICS_API ~AsyncResourceCreator();
+
+		TSGRAPHICS_API RenderDevice* getDevice() const;
+
+		/*
+			Submit resources to be created, returns the fence of the submission.
+			Descriptors are copied, the memory they point to is not.
+		*/
+		TSGRAPHICS_API uint64 createResourceBuffers(const ResourceData* data, const BufferResourceInfo* info, uint32 count, RPtr<ResourceHandle>* out);
+		TSGRAPHICS_API uint64 createResourceImages(const ResourceData* const* data, const ImageResourceInfo* info, uint32 count, RPtr<ResourceHandle>* out);
+
+		uint64 createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, RPtr<ResourceHandle>& out)
+		{
+			return createResourceBuffers(&data, &info, 1, &out);
+		}
+
+		uint64 createResourceImage(const ResourceData* data, const ImageResourceInfo& info, RPtr<ResourceHandle>& out)
+		{
+			return createResourceImages(&data, &info, 1, &out);
+		}
+
+		/*
+			Completion
+		*/
+
+		//Fence of the last completed submission
+		TSGRAPHICS_API uint64 getCompletedFence() const;
+		bool isComplete(uint64 fence) const { return getCompletedFence() >= fence; }
+
+		//Block until a submission has completed
+		TSGRAPHICS_API void wait(uint64 fence);
+		//Block until every submission has completed
+		TSGRAPHICS_API void waitAll();
+
+		//Number of resources which could not be created
+		TSGRAPHICS_API uint32 getFailedCount() const;
+	};
+}
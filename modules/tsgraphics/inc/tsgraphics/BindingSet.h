@@ -81,7 +81,7 @@ namespace ts
 
 		const Type* data() const { return m_values.data(); }
 		size_t count() const { return m_values.size(); }
-		void clear() { m_slots.clear(); }
+		void clear() { m_values.clear(); }
         
     private:
 
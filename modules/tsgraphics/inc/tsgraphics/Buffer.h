@@ -37,6 +37,14 @@ namespace ts
 			((Base&)*this) = dev->createEmptyResource();
 		}
 		
+		/*
+			Take ownership of a created buffer
+		*/
+		explicit Buffer(RPtr<ResourceHandle>&& rsc)
+		{
+			((Base&)*this) = std::move(rsc);
+		}
+
 		/*
 			Construct a buffer
 		*/
@@ -0,0 +1,232 @@
+/*
+	Cached Render Context:
+
+	Render context which sits in front of another context and filters out redundant state changes.
+	The last bound target, pipeline and resource set are tracked and are only rebound when they change,
+	so consecutive draws which share state only bind the state that differs.
+
+	Works against the abstract context interface so it applies to every backend.
+*/
+
+#pragma once
+
+#include <tsgraphics/abi.h>
+#include <tsgraphics/Driver.h>
+
+namespace ts
+{
+	class CachedRenderContext : public RenderContext
+	{
+	public:
+
+		/*
+			Bind counters
+		*/
+		struct Stats
+		{
+			uint32 draws = 0;
+			uint32 dispatches = 0;
+
+			uint32 targetBinds = 0;
+			uint32 pipelineBinds = 0;
+			uint32 resourceSetBinds = 0;
+
+			//Binds which were skipped because the state was already bound
+			uint32 targetBindsElided = 0;
+			uint32 pipelineBindsElided = 0;
+			uint32 resourceSetBindsElided = 0;
+
+			uint32 elided() const { return targetBindsElided + pipelineBindsElided + resourceSetBindsElided; }
+		};
+
+		CachedRenderContext() {}
+		CachedRenderContext(RenderContext* context) : m_context(context) {}
+
+		CachedRenderContext(const CachedRenderContext&) = delete;
+		CachedRenderContext& operator=(const CachedRenderContext&) = delete;
+
+		//Set the context that commands are forwarded to, this invalidates the bound state
+		void setContext(RenderContext* context)
+		{
+			m_context = context;
+			invalidate();
+		}
+
+		RenderContext* getContext() const { return m_context; }
+
+		/*
+			Forget the bound state, the next draw binds everything.
+			Must be called if the underlying context state is changed without going through this context,
+			or if handles may have been recreated (eg. a target was recycled with a new viewport).
+		*/
+		void invalidate()
+		{
+			m_target = TargetHandle();
+			m_pipeline = PipelineHandle();
+			m_inputs = ResourceSetHandle();
+		}
+
+		const Stats& getStats() const { return m_stats; }
+		void resetStats() { m_stats = Stats(); }
+
+		//////////////////////////////////////////////////////////////////////////////////////////////////////////
+		//	Context methods
+		//////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+		void resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index = 0) override
+		{
+			m_context->resourceUpdate(rsc, memory, index);
+		}
+
+		void resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size) override
+		{
+			m_context->resourceUpdateRange(rsc, memory, offset, size);
+		}
+
+		void resourceCopy(ResourceHandle src, ResourceHandle dest) override
+		{
+			m_context->resourceCopy(src, dest);
+		}
+
+		void imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index = 0) override
+		{
+			m_context->imageResolve(src, dest, index);
+		}
+
+		void clearColourTarget(TargetHandle pass, uint32 colour) override
+		{
+			m_context->clearColourTarget(pass, colour);
+		}
+
+		void clearDepthTarget(TargetHandle pass, float depth) override
+		{
+			m_context->clearDepthTarget(pass, depth);
+		}
+
+		void draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params) override
+		{
+			bindTarget(outputs);
+			bindPipeline(pipeline);
+			bindResourceSet(inputs);
+			drawBound(params);
+		}
+
+		void bindTarget(TargetHandle outputs) override
+		{
+			if (outputs == m_target)
+			{
+				m_stats.targetBindsElided++;
+				return;
+			}
+
+			m_context->bindTarget(outputs);
+			m_target = outputs;
+			m_stats.targetBinds++;
+
+			//A backend may unbind resources which alias the new target's outputs (eg. a shadow map),
+			//so resources must be bound again
+			m_inputs = ResourceSetHandle();
+		}
+
+		void bindPipeline(PipelineHandle pipeline) override
+		{
+			if (pipeline == m_pipeline)
+			{
+				m_stats.pipelineBindsElided++;
+				return;
+			}
+
+			m_context->bindPipeline(pipeline);
+			m_pipeline = pipeline;
+			m_stats.pipelineBinds++;
+		}
+
+		void bindResourceSet(ResourceSetHandle inputs) override
+		{
+			if (inputs == m_inputs)
+			{
+				m_stats.resourceSetBindsElided++;
+				return;
+			}
+
+			m_context->bindResourceSet(inputs);
+			m_inputs = inputs;
+			m_stats.resourceSetBinds++;
+		}
+
+		void drawBound(const DrawParams& params) override
+		{
+			m_context->drawBound(params);
+			m_stats.draws++;
+		}
+
+		void multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed) override
+		{
+			m_context->multiDrawIndirect(args, offset, count, indexed);
+			m_stats.draws += count;
+		}
+
+		/*
+			A dispatch can disturb the state bound for draws, eg. on D3D11 binding a resource for writing
+			unbinds it's views from the draw stages, so the pipeline and resources are bound again by the next draw
+		*/
+		void dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params) override
+		{
+			m_context->dispatch(pipeline, inputs, params);
+			m_stats.dispatches++;
+
+			invalidateDrawInputs();
+		}
+
+		void dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset) override
+		{
+			m_context->dispatchIndirect(pipeline, inputs, args, offset);
+			m_stats.dispatches++;
+
+			invalidateDrawInputs();
+		}
+
+		void batchMarker(uint64 sortKey) override
+		{
+			m_context->batchMarker(sortKey);
+		}
+
+		bool beginStagedUpdates(const void* memory, uint32 size) override
+		{
+			return m_context->beginStagedUpdates(memory, size);
+		}
+
+		void resourceUpdateStaged(ResourceHandle rsc, uint32 offset, uint32 size) override
+		{
+			m_context->resourceUpdateStaged(rsc, offset, size);
+		}
+
+		void endStagedUpdates() override
+		{
+			m_context->endStagedUpdates();
+		}
+
+		void finish() override
+		{
+			m_context->finish();
+			invalidate();
+		}
+
+	private:
+
+		void invalidateDrawInputs()
+		{
+			m_pipeline = PipelineHandle();
+			m_inputs = ResourceSetHandle();
+		}
+
+		RenderContext* m_context = nullptr;
+
+		//Currently bound state
+		TargetHandle m_target = TargetHandle();
+		PipelineHandle m_pipeline = PipelineHandle();
+		ResourceSetHandle m_inputs = ResourceSetHandle();
+
+		Stats m_stats;
+	};
+}
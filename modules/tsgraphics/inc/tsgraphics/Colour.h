@@ -4,14 +4,165 @@
 
 #pragma once
 
-#include <DirectXColors.h>
 #include <tscore/maths.h>
 
 namespace ts
 {
+	/*
+		A colour constant stored as 4 floats, converts to a Vector or a pointer to it's components
+	*/
+	struct ColourF32
+	{
+		float f[4];
+
+		operator const float*() const { return f; }
+		operator Vector() const { return Vector(f[0], f[1], f[2], f[3]); }
+	};
+
+	//Named colours, the same set and values as the standard web/.NET colour names
 	namespace colours
 	{
-		using namespace DirectX::Colors;
+		const ColourF32 AliceBlue = { 0.941176f, 0.972549f, 1.0f, 1.0f };
+		const ColourF32 AntiqueWhite = { 0.980392f, 0.921569f, 0.843137f, 1.0f };
+		const ColourF32 Aqua = { 0.0f, 1.0f, 1.0f, 1.0f };
+		const ColourF32 Aquamarine = { 0.498039f, 1.0f, 0.831373f, 1.0f };
+		const ColourF32 Azure = { 0.941176f, 1.0f, 1.0f, 1.0f };
+		const ColourF32 Beige = { 0.960784f, 0.960784f, 0.862745f, 1.0f };
+		const ColourF32 Bisque = { 1.0f, 0.894118f, 0.768627f, 1.0f };
+		const ColourF32 Black = { 0.0f, 0.0f, 0.0f, 1.0f };
+		const ColourF32 BlanchedAlmond = { 1.0f, 0.921569f, 0.803922f, 1.0f };
+		const ColourF32 Blue = { 0.0f, 0.0f, 1.0f, 1.0f };
+		const ColourF32 BlueViolet = { 0.541176f, 0.168627f, 0.886275f, 1.0f };
+		const ColourF32 Brown = { 0.647059f, 0.164706f, 0.164706f, 1.0f };
+		const ColourF32 BurlyWood = { 0.870588f, 0.721569f, 0.529412f, 1.0f };
+		const ColourF32 CadetBlue = { 0.372549f, 0.619608f, 0.627451f, 1.0f };
+		const ColourF32 Chartreuse = { 0.498039f, 1.0f, 0.0f, 1.0f };
+		const ColourF32 Chocolate = { 0.823529f, 0.411765f, 0.117647f, 1.0f };
+		const ColourF32 Coral = { 1.0f, 0.498039f, 0.313725f, 1.0f };
+		const ColourF32 CornflowerBlue = { 0.392157f, 0.584314f, 0.929412f, 1.0f };
+		const ColourF32 Cornsilk = { 1.0f, 0.972549f, 0.862745f, 1.0f };
+		const ColourF32 Crimson = { 0.862745f, 0.078431f, 0.235294f, 1.0f };
+		const ColourF32 Cyan = { 0.0f, 1.0f, 1.0f, 1.0f };
+		const ColourF32 DarkBlue = { 0.0f, 0.0f, 0.545098f, 1.0f };
+		const ColourF32 DarkCyan = { 0.0f, 0.545098f, 0.545098f, 1.0f };
+		const ColourF32 DarkGoldenrod = { 0.721569f, 0.52549f, 0.043137f, 1.0f };
+		const ColourF32 DarkGray = { 0.662745f, 0.662745f, 0.662745f, 1.0f };
+		const ColourF32 DarkGreen = { 0.0f, 0.392157f, 0.0f, 1.0f };
+		const ColourF32 DarkKhaki = { 0.741176f, 0.717647f, 0.419608f, 1.0f };
+		const ColourF32 DarkMagenta = { 0.545098f, 0.0f, 0.545098f, 1.0f };
+		const ColourF32 DarkOliveGreen = { 0.333333f, 0.419608f, 0.184314f, 1.0f };
+		const ColourF32 DarkOrange = { 1.0f, 0.54902f, 0.0f, 1.0f };
+		const ColourF32 DarkOrchid = { 0.6f, 0.196078f, 0.8f, 1.0f };
+		const ColourF32 DarkRed = { 0.545098f, 0.0f, 0.0f, 1.0f };
+		const ColourF32 DarkSalmon = { 0.913725f, 0.588235f, 0.478431f, 1.0f };
+		const ColourF32 DarkSeaGreen = { 0.560784f, 0.737255f, 0.560784f, 1.0f };
+		const ColourF32 DarkSlateBlue = { 0.282353f, 0.239216f, 0.545098f, 1.0f };
+		const ColourF32 DarkSlateGray = { 0.184314f, 0.309804f, 0.309804f, 1.0f };
+		const ColourF32 DarkTurquoise = { 0.0f, 0.807843f, 0.819608f, 1.0f };
+		const ColourF32 DarkViolet = { 0.580392f, 0.0f, 0.827451f, 1.0f };
+		const ColourF32 DeepPink = { 1.0f, 0.078431f, 0.576471f, 1.0f };
+		const ColourF32 DeepSkyBlue = { 0.0f, 0.74902f, 1.0f, 1.0f };
+		const ColourF32 DimGray = { 0.411765f, 0.411765f, 0.411765f, 1.0f };
+		const ColourF32 DodgerBlue = { 0.117647f, 0.564706f, 1.0f, 1.0f };
+		const ColourF32 Firebrick = { 0.698039f, 0.133333f, 0.133333f, 1.0f };
+		const ColourF32 FloralWhite = { 1.0f, 0.980392f, 0.941176f, 1.0f };
+		const ColourF32 ForestGreen = { 0.133333f, 0.545098f, 0.133333f, 1.0f };
+		const ColourF32 Fuchsia = { 1.0f, 0.0f, 1.0f, 1.0f };
+		const ColourF32 Gainsboro = { 0.862745f, 0.862745f, 0.862745f, 1.0f };
+		const ColourF32 GhostWhite = { 0.972549f, 0.972549f, 1.0f, 1.0f };
+		const ColourF32 Gold = { 1.0f, 0.843137f, 0.0f, 1.0f };
+		const ColourF32 Goldenrod = { 0.854902f, 0.647059f, 0.12549f, 1.0f };
+		const ColourF32 Gray = { 0.501961f, 0.501961f, 0.501961f, 1.0f };
+		const ColourF32 Green = { 0.0f, 0.501961f, 0.0f, 1.0f };
+		const ColourF32 GreenYellow = { 0.678431f, 1.0f, 0.184314f, 1.0f };
+		const ColourF32 Honeydew = { 0.941176f, 1.0f, 0.941176f, 1.0f };
+		const ColourF32 HotPink = { 1.0f, 0.411765f, 0.705882f, 1.0f };
+		const ColourF32 IndianRed = { 0.803922f, 0.360784f, 0.360784f, 1.0f };
+		const ColourF32 Indigo = { 0.294118f, 0.0f, 0.509804f, 1.0f };
+		const ColourF32 Ivory = { 1.0f, 1.0f, 0.941176f, 1.0f };
+		const ColourF32 Khaki = { 0.941176f, 0.901961f, 0.54902f, 1.0f };
+		const ColourF32 Lavender = { 0.901961f, 0.901961f, 0.980392f, 1.0f };
+		const ColourF32 LavenderBlush = { 1.0f, 0.941176f, 0.960784f, 1.0f };
+		const ColourF32 LawnGreen = { 0.486275f, 0.988235f, 0.0f, 1.0f };
+		const ColourF32 LemonChiffon = { 1.0f, 0.980392f, 0.803922f, 1.0f };
+		const ColourF32 LightBlue = { 0.678431f, 0.847059f, 0.901961f, 1.0f };
+		const ColourF32 LightCoral = { 0.941176f, 0.501961f, 0.501961f, 1.0f };
+		const ColourF32 LightCyan = { 0.878431f, 1.0f, 1.0f, 1.0f };
+		const ColourF32 LightGoldenrodYellow = { 0.980392f, 0.980392f, 0.823529f, 1.0f };
+		const ColourF32 LightGray = { 0.827451f, 0.827451f, 0.827451f, 1.0f };
+		const ColourF32 LightGreen = { 0.564706f, 0.933333f, 0.564706f, 1.0f };
+		const ColourF32 LightPink = { 1.0f, 0.713725f, 0.756863f, 1.0f };
+		const ColourF32 LightSalmon = { 1.0f, 0.627451f, 0.478431f, 1.0f };
+		const ColourF32 LightSeaGreen = { 0.12549f, 0.698039f, 0.666667f, 1.0f };
+		const ColourF32 LightSkyBlue = { 0.529412f, 0.807843f, 0.980392f, 1.0f };
+		const ColourF32 LightSlateGray = { 0.466667f, 0.533333f, 0.6f, 1.0f };
+		const ColourF32 LightSteelBlue = { 0.690196f, 0.768627f, 0.870588f, 1.0f };
+		const ColourF32 LightYellow = { 1.0f, 1.0f, 0.878431f, 1.0f };
+		const ColourF32 Lime = { 0.0f, 1.0f, 0.0f, 1.0f };
+		const ColourF32 LimeGreen = { 0.196078f, 0.803922f, 0.196078f, 1.0f };
+		const ColourF32 Linen = { 0.980392f, 0.941176f, 0.901961f, 1.0f };
+		const ColourF32 Magenta = { 1.0f, 0.0f, 1.0f, 1.0f };
+		const ColourF32 Maroon = { 0.501961f, 0.0f, 0.0f, 1.0f };
+		const ColourF32 MediumAquamarine = { 0.4f, 0.803922f, 0.666667f, 1.0f };
+		const ColourF32 MediumBlue = { 0.0f, 0.0f, 0.803922f, 1.0f };
+		const ColourF32 MediumOrchid = { 0.729412f, 0.333333f, 0.827451f, 1.0f };
+		const ColourF32 MediumPurple = { 0.576471f, 0.439216f, 0.858824f, 1.0f };
+		const ColourF32 MediumSeaGreen = { 0.235294f, 0.701961f, 0.443137f, 1.0f };
+		const ColourF32 MediumSlateBlue = { 0.482353f, 0.407843f, 0.933333f, 1.0f };
+		const ColourF32 MediumSpringGreen = { 0.0f, 0.980392f, 0.603922f, 1.0f };
+		const ColourF32 MediumTurquoise = { 0.282353f, 0.819608f, 0.8f, 1.0f };
+		const ColourF32 MediumVioletRed = { 0.780392f, 0.082353f, 0.521569f, 1.0f };
+		const ColourF32 MidnightBlue = { 0.098039f, 0.098039f, 0.439216f, 1.0f };
+		const ColourF32 MintCream = { 0.960784f, 1.0f, 0.980392f, 1.0f };
+		const ColourF32 MistyRose = { 1.0f, 0.894118f, 0.882353f, 1.0f };
+		const ColourF32 Moccasin = { 1.0f, 0.894118f, 0.709804f, 1.0f };
+		const ColourF32 NavajoWhite = { 1.0f, 0.870588f, 0.678431f, 1.0f };
+		const ColourF32 Navy = { 0.0f, 0.0f, 0.501961f, 1.0f };
+		const ColourF32 OldLace = { 0.992157f, 0.960784f, 0.901961f, 1.0f };
+		const ColourF32 Olive = { 0.501961f, 0.501961f, 0.0f, 1.0f };
+		const ColourF32 OliveDrab = { 0.419608f, 0.556863f, 0.137255f, 1.0f };
+		const ColourF32 Orange = { 1.0f, 0.647059f, 0.0f, 1.0f };
+		const ColourF32 OrangeRed = { 1.0f, 0.270588f, 0.0f, 1.0f };
+		const ColourF32 Orchid = { 0.854902f, 0.439216f, 0.839216f, 1.0f };
+		const ColourF32 PaleGoldenrod = { 0.933333f, 0.909804f, 0.666667f, 1.0f };
+		const ColourF32 PaleGreen = { 0.596078f, 0.984314f, 0.596078f, 1.0f };
+		const ColourF32 PaleTurquoise = { 0.686275f, 0.933333f, 0.933333f, 1.0f };
+		const ColourF32 PaleVioletRed = { 0.858824f, 0.439216f, 0.576471f, 1.0f };
+		const ColourF32 PapayaWhip = { 1.0f, 0.937255f, 0.835294f, 1.0f };
+		const ColourF32 PeachPuff = { 1.0f, 0.854902f, 0.72549f, 1.0f };
+		const ColourF32 Peru = { 0.803922f, 0.521569f, 0.247059f, 1.0f };
+		const ColourF32 Pink = { 1.0f, 0.752941f, 0.796078f, 1.0f };
+		const ColourF32 Plum = { 0.866667f, 0.627451f, 0.866667f, 1.0f };
+		const ColourF32 PowderBlue = { 0.690196f, 0.878431f, 0.901961f, 1.0f };
+		const ColourF32 Purple = { 0.501961f, 0.0f, 0.501961f, 1.0f };
+		const ColourF32 Red = { 1.0f, 0.0f, 0.0f, 1.0f };
+		const ColourF32 RosyBrown = { 0.737255f, 0.560784f, 0.560784f, 1.0f };
+		const ColourF32 RoyalBlue = { 0.254902f, 0.411765f, 0.882353f, 1.0f };
+		const ColourF32 SaddleBrown = { 0.545098f, 0.270588f, 0.07451f, 1.0f };
+		const ColourF32 Salmon = { 0.980392f, 0.501961f, 0.447059f, 1.0f };
+		const ColourF32 SandyBrown = { 0.956863f, 0.643137f, 0.376471f, 1.0f };
+		const ColourF32 SeaGreen = { 0.180392f, 0.545098f, 0.341176f, 1.0f };
+		const ColourF32 SeaShell = { 1.0f, 0.960784f, 0.933333f, 1.0f };
+		const ColourF32 Sienna = { 0.627451f, 0.321569f, 0.176471f, 1.0f };
+		const ColourF32 Silver = { 0.752941f, 0.752941f, 0.752941f, 1.0f };
+		const ColourF32 SkyBlue = { 0.529412f, 0.807843f, 0.921569f, 1.0f };
+		const ColourF32 SlateBlue = { 0.415686f, 0.352941f, 0.803922f, 1.0f };
+		const ColourF32 SlateGray = { 0.439216f, 0.501961f, 0.564706f, 1.0f };
+		const ColourF32 Snow = { 1.0f, 0.980392f, 0.980392f, 1.0f };
+		const ColourF32 SpringGreen = { 0.0f, 1.0f, 0.498039f, 1.0f };
+		const ColourF32 SteelBlue = { 0.27451f, 0.509804f, 0.705882f, 1.0f };
+		const ColourF32 Tan = { 0.823529f, 0.705882f, 0.54902f, 1.0f };
+		const ColourF32 Teal = { 0.0f, 0.501961f, 0.501961f, 1.0f };
+		const ColourF32 Thistle = { 0.847059f, 0.74902f, 0.847059f, 1.0f };
+		const ColourF32 Tomato = { 1.0f, 0.388235f, 0.278431f, 1.0f };
+		const ColourF32 Turquoise = { 0.25098f, 0.878431f, 0.815686f, 1.0f };
+		const ColourF32 Violet = { 0.933333f, 0.509804f, 0.933333f, 1.0f };
+		const ColourF32 Wheat = { 0.960784f, 0.870588f, 0.701961f, 1.0f };
+		const ColourF32 White = { 1.0f, 1.0f, 1.0f, 1.0f };
+		const ColourF32 WhiteSmoke = { 0.960784f, 0.960784f, 0.960784f, 1.0f };
+		const ColourF32 Yellow = { 1.0f, 1.0f, 0.0f, 1.0f };
+		const ColourF32 YellowGreen = { 0.603922f, 0.803922f, 0.196078f, 1.0f };
+		const ColourF32 Transparent = { 0.0f, 0.0f, 0.0f, 0.0f };
 	}
 
 	class RGBA
@@ -15,55 +15,102 @@
 #include <tscore/ptr.h>
 #include <tscore/delegate.h>
 
+#include <typeinfo>
+#include <utility>
+
 #include "Driver.h"
+#include "CachedContext.h"
 
 namespace ts
 {
 	struct Command;
 	struct CommandBatch;
+	class CommandShard;
+
+	class ThreadPool;
 
 	typedef const void* CommandPtr;
-	typedef Delegate<void(RenderContext*, CommandPtr)> CommandDelegate;
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	/*
-		Command Queue class
+		Command types:
+
+		Each dispatcher type is assigned an id the first time it is recorded,
+		commands store this id and are executed through a table of dispatch functions indexed by it.
+		Any dispatcher type can be recorded, new command types do not need to be declared anywhere else.
+
+		Ids are allocated by tsgraphics using the name of the dispatcher type,
+		so a command type has the same id in every module which records it.
+	*/
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	typedef uint16 CommandTypeID;
+
+	//Size of the command table, the number of command types which can be registered including the invalid type 0
+	enum { MAX_COMMAND_TYPES = 1024 };
+	typedef void(*CommandDispatchFunc)(RenderContext* context, void* dispatcher, CommandPtr extra);
+
+	//Add a dispatch function to the command table, returns the id of the command type if it has already been registered
+	TSGRAPHICS_API CommandTypeID registerCommandType(const char* name, CommandDispatchFunc func);
+
+	template<typename dispatcher_t>
+	struct CommandType
+	{
+		static void dispatch(RenderContext* context, void* dispatcher, CommandPtr extra)
+		{
+			reinterpret_cast<dispatcher_t*>(dispatcher)->dispatch(context, extra);
+		}
+
+		//Get the id of this command type, registering it if necessary
+		static CommandTypeID id()
+		{
+			static const CommandTypeID s_id = registerCommandType(typeid(dispatcher_t).name(), &CommandType::dispatch);
+			return s_id;
+		}
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/*
+		Command Recorder class:
+
+		Records Command Batches into a private block of memory.
+		A recorder must only be used by one thread at a time, but separate recorders of a queue can be used concurrently.
 	*/
-	class CommandQueue
+	class CommandRecorder
 	{
 	private:
-		
-		//Implementation
-		class Queue;
-		OpaquePtr<Queue> pQueue;
+
+		//Memory that commands are recorded into - owned by a CommandQueue
+		CommandShard* m_shard = nullptr;
 
 		//Internal command management methods
 		TSGRAPHICS_API Command* commandAlloc(size_t dispatchSize, size_t extraSize);
 		TSGRAPHICS_API void commandAttach(CommandBatch* pBatch, Command* pCmd);
 		TSGRAPHICS_API void* storeCommandDispatcher(Command* pCmd, const void* pDispatchSrc);
-		TSGRAPHICS_API void storeCommandDispatcherFunc(Command* pCmd, CommandDelegate dispatcherFunc);
+		TSGRAPHICS_API void storeCommandType(Command* pCmd, CommandTypeID type);
 		TSGRAPHICS_API void storeCommandExtra(Command* pCmd, const void* pExtraSrc);
 
 		/*
-			Asserts that comand dispatcher(and extra parameter) is a POD type
+			Asserts that comand dispatcher(and extra parameter) is a POD type that fits the command block alignment
 		*/
 		template<typename dispatcher_t, typename param_t = dispatcher_t>
 		struct VerifyDispatcher
 		{
 			static_assert(std::is_pod<dispatcher_t>::value, "Command Dispatcher must be a POD type");
 			static_assert(std::is_pod<param_t>::value, "Command Parameter must be a POD type");
+			static_assert(alignof(dispatcher_t) <= 16, "Command Dispatcher alignment exceeds the command block alignment");
 		};
 
-	public:
+	protected:
 
-		OPAQUE_PTR(CommandQueue, pQueue)
+		void swapShard(CommandRecorder& rhs) { std::swap(m_shard, rhs.m_shard); }
+
+	public:
 
 		typedef uint64 SortKey;
 
-		//Ctor/dtor
-		CommandQueue() {}
-		TSGRAPHICS_API CommandQueue(uint32 numBatches);
-		TSGRAPHICS_API ~CommandQueue();
+		CommandRecorder() {}
+		explicit CommandRecorder(CommandShard* shard) : m_shard(shard) {}
 
 		//Create new command batch for queueing.
 		TSGRAPHICS_API CommandBatch* createBatch();
@@ -87,10 +134,9 @@ namespace ts
 			Command* pCmd = commandAlloc(sizeof(dispatcher_t), extraSize);
 
 			//Set command dispatcher
-			//Return value is address of dispatcher copy
-			void* pDisp = storeCommandDispatcher(pCmd, &disp);
-			//Set dispatcher function - it is called using pDisp as an argument
-			storeCommandDispatcherFunc(pCmd, CommandDelegate::fromMethod<dispatcher_t, &dispatcher_t::dispatch>((dispatcher_t*)pDisp));
+			storeCommandDispatcher(pCmd, &disp);
+			//Set dispatcher type - it's dispatch function is called with the stored dispatcher as an argument
+			storeCommandType(pCmd, CommandType<dispatcher_t>::id());
 			//Set any extra parameters
 			storeCommandExtra(pCmd, extraData);
 
@@ -119,13 +165,262 @@ namespace ts
 		{
 			this->addCommand(batch, disp, (const void*)param, sizeof(param_t) * paramCount);
 		}
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/*
+		Static Command Batch class:
+
+		A persistent block of command batches which is recorded and sorted once, then reused every frame.
+		Content which does not change between frames (eg. static scene geometry) can be recorded into a static batch
+		instead of being re-recorded and re-sorted into the queue each frame.
+
+		Submitting a static batch to a queue only stores a reference to it,
+		when the queue is flushed the pre-sorted keys are merged in order with the queue's own keys.
+		The batch must not be modified or destroyed until the queue it was submitted to has been flushed.
+
+		The handles referenced by the recorded commands can be declared as dependencies,
+		the batch is then only invalidated when one of those objects changes.
+		The batch isn't notified of changes, the owner of the batch must call invalidate() when a dependency is
+		recreated or released, and should hold references to the objects so their handles stay alive while the batch is valid.
+
+		example:
+
+			if (!batch.isValid())
+			{
+				batch.begin();
+				CommandBatch* b = batch.createBatch();
+				...
+				batch.submitBatch(key, b);
+				batch.addDependency(target);
+				batch.end();
+			}
+
+			queue.submitStatic(&batch);
+			queue.sort();
+			queue.flush(context);
+	*/
+	class StaticCommandBatch : public CommandRecorder
+	{
+	private:
+
+		friend class CommandQueue;
+
+		//Implementation
+		class Batch;
+		OpaquePtr<Batch> pBatch;
+
+	public:
+
+		StaticCommandBatch(const StaticCommandBatch&) = delete;
+		StaticCommandBatch& operator=(const StaticCommandBatch&) = delete;
+
+		StaticCommandBatch(StaticCommandBatch&& rhs)
+		{
+			std::swap(pBatch, rhs.pBatch);
+			swapShard(rhs);
+		}
+
+		StaticCommandBatch& operator=(StaticCommandBatch&& rhs)
+		{
+			std::swap(pBatch, rhs.pBatch);
+			swapShard(rhs);
+			return *this;
+		}
+
+		operator bool() const { return pBatch != nullptr; }
+
+		//Ctor/dtor
+		StaticCommandBatch() {}
+		TSGRAPHICS_API StaticCommandBatch(uint32 numBatches);
+		TSGRAPHICS_API ~StaticCommandBatch();
+
+		//Discard the recorded batches and start recording
+		TSGRAPHICS_API void begin();
+		//Sort the recorded batches, the static batch can then be submitted to queues
+		TSGRAPHICS_API void end();
+
+		//Declare a handle the recorded commands depend on
+		TSGRAPHICS_API void addDependency(ResourceHandle rsc);
+		TSGRAPHICS_API void addDependency(ResourceSetHandle set);
+		TSGRAPHICS_API void addDependency(PipelineHandle pipeline);
+		TSGRAPHICS_API void addDependency(TargetHandle target);
+
+		/*
+			Invalidate the batch if it depends on a given handle,
+			returns true if the batch was invalidated.
+		*/
+		TSGRAPHICS_API bool invalidate(ResourceHandle rsc);
+		TSGRAPHICS_API bool invalidate(ResourceSetHandle set);
+		TSGRAPHICS_API bool invalidate(PipelineHandle pipeline);
+		TSGRAPHICS_API bool invalidate(TargetHandle target);
+
+		//Invalidate the batch unconditionally
+		TSGRAPHICS_API void invalidate();
+
+		//A batch is valid once it has been recorded and until it is invalidated
+		TSGRAPHICS_API bool isValid() const;
+
+		//Number of recorded batches
+		TSGRAPHICS_API uint32 getBatchCount() const;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/*
+		Command Queue class:
+
+		The queue can be recorded into directly from a single thread,
+		additional recorders allow batches to be recorded on several threads at once (eg. one per render pass).
+		Batches from every recorder are merged into a single sorted list when the queue is sorted.
+
+		example:
+
+			CommandQueue queue(batchesPerRecorder, 2);
+
+			parallel_for(pool, 2, [&](size_t i) {
+				CommandRecorder* rec = queue.getRecorder((uint32)i);
+				CommandBatch* batch = rec->createBatch();
+				...
+				rec->submitBatch(key, batch);
+			});
+
+			queue.sort();
+			queue.flush(context);
+	*/
+	class CommandQueue : public CommandRecorder
+	{
+	private:
+		
+		//Implementation
+		class Queue;
+		OpaquePtr<Queue> pQueue;
+
+	public:
+
+		//The base recorder refers to memory owned by the implementation, so it is swapped along with it
+		CommandQueue(const CommandQueue&) = delete;
+		CommandQueue& operator=(const CommandQueue&) = delete;
+
+		CommandQueue(CommandQueue&& rhs)
+		{
+			std::swap(pQueue, rhs.pQueue);
+			swapShard(rhs);
+		}
+
+		CommandQueue& operator=(CommandQueue&& rhs)
+		{
+			std::swap(pQueue, rhs.pQueue);
+			swapShard(rhs);
+			return *this;
+		}
+
+		operator bool() const { return pQueue != nullptr; }
+
+		//Ctor/dtor
+		CommandQueue() {}
+		TSGRAPHICS_API CommandQueue(uint32 numBatches, uint32 numRecorders = 0);
+		TSGRAPHICS_API ~CommandQueue();
+
+		//Get an additional recorder, each recorder has capacity for numBatches batches
+		TSGRAPHICS_API CommandRecorder* getRecorder(uint32 index);
+		TSGRAPHICS_API uint32 getRecorderCount() const;
 
 		//////////////////////////////////////////////////////////////////////////////////
 
 		//Sort queued command batches based on their keys
 		TSGRAPHICS_API void sort();
-		//Execute queued command batches on a given context
+		//Sort queued command batches based on their keys, large queues are sorted in parallel on a given thread pool
+		TSGRAPHICS_API void sort(ThreadPool& pool);
+		//Execute queued command batches on a given context, redundant state changes between batches are skipped
 		TSGRAPHICS_API void flush(RenderContext* context);
+
+		/*
+			Submit a static batch for the next flush only.
+			If the queue is sorted, the static batch's keys are merged in order with the queue's keys,
+			otherwise the static batch is executed after the queue's batches.
+		*/
+		TSGRAPHICS_API void submitStatic(const StaticCommandBatch* batch);
+
+		//Get the state binds made and elided by the last flush
+		TSGRAPHICS_API CachedRenderContext::Stats getStateStats() const;
+
+		/*
+			Draw merging:
+			Runs of consecutive batches which each contain a single CommandDrawInstance with the same state
+			are executed as one instanced draw, up to a maximum number of draws per run.
+		*/
+		struct MergeStats
+		{
+			uint32 runs = 0;			//Instanced draws issued for merged runs
+			uint32 mergedDraws = 0;		//Draws which were folded into a run
+		};
+
+		//Set the maximum number of draws merged into one instanced draw, 0 or 1 disables merging
+		TSGRAPHICS_API void setMaxMergeRun(uint32 maxRun);
+		TSGRAPHICS_API uint32 getMaxMergeRun() const;
+
+		//Get the merge counts of the last flush
+		TSGRAPHICS_API MergeStats getMergeStats() const;
+
+		/*
+			Update staging:
+			The contents of every CommandBufferUpdate in the queue are gathered into one aligned block when flushing,
+			the block is uploaded with a single copy and each update refers to it's range of the block.
+		*/
+		struct StagingStats
+		{
+			uint32 updates = 0;			//Buffer updates applied from the staging block
+			uint32 size = 0;			//Size of the staging block in bytes
+		};
+
+		//Enable or disable update staging, staging is enabled by default
+		TSGRAPHICS_API void setUpdateStaging(bool enable);
+		TSGRAPHICS_API bool getUpdateStaging() const;
+
+		//Get the staging counts of the last flush, all zero if the context did not stage updates
+		TSGRAPHICS_API StagingStats getStagingStats() const;
+
+		/*
+			Queue statistics:
+			Collected by every flush, the sort time is of the sort which preceded the flush.
+			Statistics can be summed over several queues or frames and averaged.
+		*/
+		struct Stats
+		{
+			uint32 batches = 0;						//Batches executed, including batches of static batches
+			uint32 staticBatches = 0;				//Batches executed from static batches
+			uint32 commands = 0;					//Commands executed
+
+			//Commands executed of each type indexed by CommandTypeID
+			uint32 commandsByType[MAX_COMMAND_TYPES] = {};
+
+			uint64 allocatedBytes = 0;				//Recorder memory used by the flushed batches
+			uint64 allocatedPeak = 0;				//Most recorder memory used by any flush of the queue
+			uint64 allocatorCapacity = 0;			//Recorder memory available to the queue
+
+			MergeStats merge;						//Draw merging counts
+
+			uint32 updates = 0;						//Buffer updates executed
+			uint64 uploadBytes = 0;					//Bytes of buffer contents uploaded by updates
+
+			double sortTime = 0.0;					//Milliseconds spent sorting
+			double executeTime = 0.0;				//Milliseconds spent flushing
+
+			//Number of commands executed of a given type
+			template<typename dispatcher_t>
+			uint32 getCommandCount() const
+			{
+				return commandsByType[CommandType<dispatcher_t>::id()];
+			}
+
+			//Accumulate statistics
+			TSGRAPHICS_API Stats& operator+=(const Stats& rhs);
+			//Divide accumulated statistics by a number of samples, counts are rounded to the nearest integer
+			TSGRAPHICS_API Stats& operator/=(uint32 samples);
+		};
+
+		//Get the statistics of the last flush
+		TSGRAPHICS_API Stats getStats() const;
 	};
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -147,7 +442,85 @@ namespace ts
 		TSGRAPHICS_API void dispatch(RenderContext* context, CommandPtr extra);
 	};
 
-	//Updates a buffer resource on a given context
+	/*
+		Executes a draw call with a single instance on a given context:
+
+		The extra data is the per-instance data of the draw, it is written to the start of the instance buffer.
+		When the queue is flushed consecutive draws which differ only in their per-instance data
+		are merged into a single instanced draw.
+	*/
+	struct CommandDrawInstance
+	{
+		TargetHandle outputs;
+		PipelineHandle pipeline;
+		ResourceSetHandle inputs;
+		DrawParams params;
+
+		//Vertex buffer which holds per-instance data, it must be bound by the resource set
+		ResourceHandle instanceBuffer;
+		//Size of the per-instance data
+		uint32 instanceStride;
+		//Number of instances the instance buffer can hold
+		uint32 instanceCapacity;
+
+		CommandDrawInstance() {}
+
+		TSGRAPHICS_API void dispatch(RenderContext* context, CommandPtr extra);
+
+		//Draw a number of instances whose data is laid out contiguously
+		TSGRAPHICS_API void dispatchInstances(RenderContext* context, CommandPtr instances, uint32 count) const;
+	};
+
+	//Executes a number of indirect draws on a given context, see RenderContext::multiDrawIndirect()
+	struct CommandDrawIndirect
+	{
+		TargetHandle outputs;
+		PipelineHandle pipeline;
+		ResourceSetHandle inputs;
+
+		//Argument buffer, byte offset of the first draw's arguments and the number of draws
+		ResourceHandle args;
+		uint32 offset = 0;
+		uint32 count = 0;
+		bool indexed = false;
+
+		CommandDrawIndirect() {}
+
+		TSGRAPHICS_API void dispatch(RenderContext* context, CommandPtr extra);
+	};
+
+	//Executes a compute dispatch on a given context, see RenderContext::dispatch()
+	struct CommandDispatch
+	{
+		PipelineHandle pipeline;
+		ResourceSetHandle inputs;
+		DispatchParams params;
+
+		CommandDispatch() {}
+
+		TSGRAPHICS_API void dispatch(RenderContext* context, CommandPtr extra);
+	};
+
+	//Executes a compute dispatch with arguments read from an argument buffer at a byte offset
+	struct CommandDispatchIndirect
+	{
+		PipelineHandle pipeline;
+		ResourceSetHandle inputs;
+
+		ResourceHandle args;
+		uint32 offset = 0;
+
+		CommandDispatchIndirect() {}
+
+		TSGRAPHICS_API void dispatch(RenderContext* context, CommandPtr extra);
+	};
+
+	/*
+		Updates a buffer resource on a given context:
+
+		The extra data is the new contents of the buffer.
+		When the queue is flushed the contents of every buffer update are staged together if the context supports it.
+	*/
 	struct CommandBufferUpdate
 	{
 		ResourceHandle hBuf;
@@ -0,0 +1,102 @@
+/*
+	Deferred Destruction:
+
+	Defers the destruction of device objects until the frames which may reference them have completed.
+
+	- DeferredDestroyDevice wraps another device, objects destroyed through it are queued
+	  with the frame they were released in.
+	- Objects released in frame N are destroyed in bulk after frame N + latency has been committed,
+	  so objects can be released while queued commands still reference them and the cost of
+	  destroying them is moved out of the middle of the frame.
+	- flush() destroys every queued object immediately, the destructor flushes.
+
+	example:
+
+		DeferredDestroyDevice deferred(device, 2);
+
+		RPtr<ResourceHandle> buffer = deferred.createResourceBuffer(...);
+		...
+		buffer.reset(); //queued
+		deferred.commit(); //destroys objects released 3 frames ago
+*/
+
+#pragma once
+
+#include <tsgraphics/abi.h>
+
+#include <tscore/ptr.h>
+
+#include "Driver.h"
+
+namespace ts
+{
+	struct DeferredDestroyStats
+	{
+		//Objects waiting to be destroyed and the memory held by resources among them
+		uint32 pendingCount = 0;
+		uint64 pendingBytes = 0;
+
+		//Objects destroyed by the last commit and in total
+		uint32 destroyedLastFrame = 0;
+		uint64 destroyedTotal = 0;
+	};
+
+	/*
+		Device which queues the destruction of it's objects
+	*/
+	class DeferredDestroyDevice : public RenderDevice
+	{
+	private:
+
+		struct State;
+		OpaquePtr<State> pState;
+
+	public:
+
+		OPAQUE_PTR(DeferredDestroyDevice, pState)
+
+		//Objects are destroyed after latency more frames have been committed
+		TSGRAPHICS_API DeferredDestroyDevice(RenderDevice* device, uint32 latency = 2);
+		TSGRAPHICS_API ~DeferredDestroyDevice();
+
+		//Device that calls are forwarded to
+		TSGRAPHICS_API RenderDevice* getDevice() const;
+
+		TSGRAPHICS_API uint32 getLatency() const;
+
+		//Destroy all queued objects now
+		TSGRAPHICS_API void flush();
+
+		TSGRAPHICS_API DeferredDestroyStats getStats() const;
+
+		/*
+			Device methods
+		*/
+
+		TSGRAPHICS_API RenderContext* context() override;
+		TSGRAPHICS_API void commit() override;
+		TSGRAPHICS_API uint32 acquireContexts(RenderContext** contexts, uint32 count) override;
+		TSGRAPHICS_API void submitContexts(RenderContext* const* contexts, uint32 count) override;
+
+		TSGRAPHICS_API void setDisplayConfiguration(const DisplayConfig& displayCfg) override;
+		TSGRAPHICS_API void getDisplayConfiguration(DisplayConfig& displayCfg) override;
+		TSGRAPHICS_API ResourceHandle getDisplayTarget() override;
+
+		TSGRAPHICS_API void queryStats(RenderStats& stats) override;
+		TSGRAPHICS_API void queryInfo(RenderDeviceInfo& info) override;
+
+		TSGRAPHICS_API RPtr<ResourceHandle> createEmptyResource(ResourceHandle recycle) override;
+		TSGRAPHICS_API RPtr<ResourceHandle> createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle) override;
+		TSGRAPHICS_API RPtr<ResourceHandle> createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle) override;
+		TSGRAPHICS_API RPtr<ResourceSetHandle> createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle) override;
+		TSGRAPHICS_API RPtr<ShaderHandle> createShader(const ShaderCreateInfo& info) override;
+		TSGRAPHICS_API RPtr<PipelineHandle> createPipeline(ShaderHandle program, const PipelineCreateInfo& info) override;
+		TSGRAPHICS_API RPtr<TargetHandle> createTarget(const TargetCreateInfo& info, TargetHandle recycle) override;
+
+		TSGRAPHICS_API void destroy(ResourceHandle rsc) override;
+		TSGRAPHICS_API void destroy(ResourceSetHandle set) override;
+		TSGRAPHICS_API void destroy(ShaderHandle shader) override;
+		TSGRAPHICS_API void destroy(PipelineHandle state) override;
+		TSGRAPHICS_API void destroy(TargetHandle pass) override;
+	};
+}
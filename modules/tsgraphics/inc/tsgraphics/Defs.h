@@ -31,7 +31,9 @@ namespace ts
 	enum class RenderDriverID
 	{
 		NONE,
-		DX11
+		DX11,
+		NULLDEVICE, //Headless device which does no GPU work
+		SOFTWARE,   //CPU rasteriser, see tssoft.h
 	};
 
 	struct DisplayConfig
@@ -56,9 +58,55 @@ namespace ts
 		uint8 flags = 0;
 	};
 
+	/*
+		Device statistics, see DriverStats.h
+
+		Frame counters count the calls made since the last commit, memory counters describe the objects currently alive.
+	*/
 	struct RenderStats
 	{
-		uint32 drawcalls = 0;
+		//Draws, triangles are counted for each instance
+		uint64 drawcalls = 0;
+		uint64 triangles = 0;
+		uint64 instances = 0;
+
+		//Compute dispatches, direct and indirect
+		uint64 dispatches = 0;
+
+		//State binds, draw() binds each of it's objects
+		uint64 pipelineBinds = 0;
+		uint64 resourceSetBinds = 0;
+		uint64 targetBinds = 0;
+
+		//Update calls and the bytes they upload
+		uint64 bufferUpdates = 0;
+		uint64 bufferUpdateBytes = 0;
+		uint64 imageUpdates = 0;
+		uint64 imageUpdateBytes = 0;
+
+		//Objects created and destroyed, recreating an object counts as a creation
+		uint64 buffersCreated = 0;
+		uint64 buffersDestroyed = 0;
+		uint64 imagesCreated = 0;
+		uint64 imagesDestroyed = 0;
+		uint64 resourceSetsCreated = 0;
+		uint64 resourceSetsDestroyed = 0;
+		uint64 shadersCreated = 0;
+		uint64 shadersDestroyed = 0;
+		uint64 pipelinesCreated = 0;
+		uint64 pipelinesDestroyed = 0;
+		uint64 targetsCreated = 0;
+		uint64 targetsDestroyed = 0;
+
+		//CPU time spent inside context calls in nanoseconds
+		uint64 contextTime = 0;
+
+		//Bytes of memory used by live resources, images which can be render or depth targets are counted as target memory
+		uint64 vertexBufferMemory = 0;
+		uint64 indexBufferMemory = 0;
+		uint64 constantBufferMemory = 0;
+		uint64 imageMemory = 0;
+		uint64 targetMemory = 0;
 	};
 
 	struct RenderDeviceInfo
@@ -67,6 +115,7 @@ namespace ts
 		uint64 gpuVideoMemory;		//GPU accessible video memory capacity
 		uint64 gpuSystemMemory;		//GPU accessible system memory capacity
 		uint64 sharedSystemMemory;	//GPU/CPU accessible system memory capacity
+		bool constantBufferRanges = true;	//Ranges of constant buffers can be updated, otherwise they must be updated whole
 	};
 
 	struct Viewport
@@ -86,7 +135,9 @@ namespace ts
 		UNKNOWN,
 		VERTEX,
 		INDEX,
-		CONSTANTS
+		CONSTANTS,
+		INDIRECT, //Arguments of indirect draws and dispatches, can be written by compute shaders
+		STORAGE   //Read-write buffer of compute shaders
 	};
 
 	enum class ImageFormat
@@ -113,7 +164,8 @@ namespace ts
 	{
 		SRV = 1 << 0, //shader resource
 		RTV = 1 << 1, //render target
-		DSV = 1 << 2  //depth target
+		DSV = 1 << 2, //depth target
+		UAV = 1 << 3  //read-write compute resource
 	};
 
 	inline ImageUsage operator&(ImageUsage lhs, ImageUsage rhs) { return (ImageUsage)((uint8)lhs & (uint8)rhs); }
@@ -364,6 +416,19 @@ namespace ts
         uint32 vertexBufferCount = 0;
         
         ResourceHandle indexBuffer = ResourceHandle();
+
+		//Mask of constant buffer slots which are bound at each draw's DrawParams::constantOffset
+		uint32 dynamicConstants = 0;
+
+		/*
+			Read-write resources of compute shaders, storage buffers take the first slots and storage images the slots after them.
+			Buffers must be STORAGE or INDIRECT buffers, images must be created with ImageUsage::UAV.
+		*/
+		const ResourceHandle* storageBuffers = nullptr;
+		uint32 storageBufferCount = 0;
+
+		const ImageView* storageImages = nullptr;
+		uint32 storageImageCount = 0;
 	};
 
 	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -385,6 +450,92 @@ namespace ts
 		int32 vbase = 0;  //vertex base
 		uint32 instances = 1;
 
+		//Byte offset of the dynamic constant buffers of the resource set, a multiple of CONSTANT_OFFSET_ALIGNMENT
+		uint32 constantOffset = 0;
+
 		DrawMode mode = DrawMode::VERTEX;
+
+		enum { CONSTANT_OFFSET_ALIGNMENT = 256 };
 	};
+
+	/*
+		Arguments of an indirect draw, laid out as they are in an argument buffer.
+		Indirect draws are always instanced, the start instance offsets the elements of per-instance vertex buffers.
+	*/
+	struct DrawIndirectArgs
+	{
+		uint32 count = 0;         //vertex count
+		uint32 instances = 1;
+		uint32 start = 0;         //vertex start
+		uint32 startInstance = 0;
+
+		DrawParams params() const
+		{
+			DrawParams p;
+			p.count = count;
+			p.instances = instances;
+			p.start = start;
+			p.mode = DrawMode::INSTANCED;
+			return p;
+		}
+	};
+
+	struct DrawIndexedIndirectArgs
+	{
+		uint32 count = 0;         //index count
+		uint32 instances = 1;
+		uint32 start = 0;         //index start
+		int32 vbase = 0;          //vertex base
+		uint32 startInstance = 0;
+
+		DrawParams params() const
+		{
+			DrawParams p;
+			p.count = count;
+			p.instances = instances;
+			p.start = start;
+			p.vbase = vbase;
+			p.mode = DrawMode::INDEXEDINSTANCED;
+			return p;
+		}
+	};
+
+	static_assert(sizeof(DrawIndirectArgs) == 16, "indirect draw arguments must be tightly packed");
+	static_assert(sizeof(DrawIndexedIndirectArgs) == 20, "indirect draw arguments must be tightly packed");
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//  Dispatch command
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	struct DispatchParams
+	{
+		//Number of thread groups in each dimension
+		uint32 groupsX = 1;
+		uint32 groupsY = 1;
+		uint32 groupsZ = 1;
+
+		//Byte offset of the dynamic constant buffers of the resource set, a multiple of DrawParams::CONSTANT_OFFSET_ALIGNMENT
+		uint32 constantOffset = 0;
+
+		enum { MAX_GROUPS = 65535 };
+	};
+
+	//Arguments of an indirect dispatch, laid out as they are in an argument buffer
+	struct DispatchIndirectArgs
+	{
+		uint32 groupsX = 1;
+		uint32 groupsY = 1;
+		uint32 groupsZ = 1;
+
+		DispatchParams params() const
+		{
+			DispatchParams p;
+			p.groupsX = groupsX;
+			p.groupsY = groupsY;
+			p.groupsZ = groupsZ;
+			return p;
+		}
+	};
+
+	static_assert(sizeof(DispatchIndirectArgs) == 12, "indirect dispatch arguments must be tightly packed");
 }
@@ -45,6 +45,9 @@ namespace ts
 			std::swap(m_h, rhs.m_h);
 		}
 
+		//Swapping with a temporary destroys the previous resource along with it
+		void swap(RPtr<Handle>&& rhs) { swap(rhs); }
+
 		void reset(RenderDevice* d = nullptr, Handle h = Handle())
 		{
 			if (!null())
@@ -83,6 +86,21 @@ namespace ts
 		virtual RenderContext* context() = 0;
 		virtual void commit() = 0;
 
+		/*
+			Parallel recording:
+
+			acquireContexts() gets worker contexts for the current frame, each can record commands on it's own thread
+			while the main context and other workers record. A worker is finished by the thread which recorded it.
+			submitContexts() then executes the commands of the finished workers in the order of the array,
+			after the commands already recorded on the main context and before any recorded on it later.
+			Submission resets the state bound on the main context.
+			Workers are returned to the device when the frame is committed, both methods are called from the thread which owns the main context.
+
+			Devices which can't record in parallel acquire no contexts, commands are then recorded on the main context.
+		*/
+		virtual uint32 acquireContexts(RenderContext** contexts, uint32 count) { return 0; }
+		virtual void submitContexts(RenderContext* const* contexts, uint32 count) {}
+
         //Display methods
 		virtual void setDisplayConfiguration(const DisplayConfig& displayCfg) = 0;
 		virtual void getDisplayConfiguration(DisplayConfig& displayCfg) = 0;
@@ -104,6 +122,31 @@ namespace ts
 		//Output target
         virtual RPtr<TargetHandle> createTarget(const TargetCreateInfo& info, TargetHandle recycle = (TargetHandle)0) = 0;
 
+		/*
+			Batch creation:
+
+			Creates count objects from arrays of descriptors, out[i] is null if object i could not be created.
+			Image data is an array of per image subresource data pointers, data or any element of it may be null.
+			Devices which can create objects more cheaply together override these.
+		*/
+		virtual void createResourceBuffers(const ResourceData* data, const BufferResourceInfo* info, uint32 count, RPtr<ResourceHandle>* out)
+		{
+			for (uint32 i = 0; i < count; i++)
+				out[i] = createResourceBuffer(data[i], info[i]);
+		}
+
+		virtual void createResourceImages(const ResourceData* const* data, const ImageResourceInfo* info, uint32 count, RPtr<ResourceHandle>* out)
+		{
+			for (uint32 i = 0; i < count; i++)
+				out[i] = createResourceImage((data != nullptr) ? data[i] : nullptr, info[i]);
+		}
+
+		virtual void createResourceSets(const ResourceSetCreateInfo* info, uint32 count, RPtr<ResourceSetHandle>* out)
+		{
+			for (uint32 i = 0; i < count; i++)
+				out[i] = createResourceSet(info[i]);
+		}
+
         //Destroy device objects
 		virtual void destroy(ResourceHandle rsc) = 0;
 		virtual void destroy(ResourceSetHandle set) = 0;
@@ -120,6 +163,8 @@ namespace ts
     struct RenderContext
     {
 		virtual void resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index = 0) = 0;
+		//Update a range of bytes of a buffer resource, see RenderDeviceInfo::constantBufferRanges for constant buffers
+		virtual void resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size) = 0;
 		virtual void resourceCopy(ResourceHandle src, ResourceHandle dest) = 0;
 		virtual void imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index = 0) = 0;
 		
@@ -128,6 +173,61 @@ namespace ts
 		
 		virtual void draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params) = 0;
 
+		/*
+			Granular state binding:
+			State stays bound for any following drawBound() calls, draw() binds all of it's state itself.
+			Binding a target includes it's viewport and scissor rect.
+		*/
+		virtual void bindTarget(TargetHandle outputs) = 0;
+		virtual void bindPipeline(PipelineHandle pipeline) = 0;
+		virtual void bindResourceSet(ResourceSetHandle inputs) = 0;
+
+		//Draw using the currently bound state
+		virtual void drawBound(const DrawParams& params) = 0;
+
+		/*
+			Indirect drawing:
+
+			Draws using the currently bound state with arguments read from a BufferType::INDIRECT buffer.
+			multiDrawIndirect() draws count times with consecutive arguments beginning at a byte offset, a multiple of 4.
+			The arguments are DrawIndexedIndirectArgs for indexed draws and DrawIndirectArgs otherwise.
+			Dynamic constant buffers are bound at offset 0.
+			Devices without native indirect draws read the arguments on the CPU and draw each one.
+		*/
+		virtual void multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed) = 0;
+
+		void drawIndirect(ResourceHandle args, uint32 offset, bool indexed) { multiDrawIndirect(args, offset, 1, indexed); }
+
+		/*
+			Compute:
+
+			Pipelines created from a shader with a compute stage are compute pipelines, only their samplers are used.
+			dispatch() runs groupsX * groupsY * groupsZ thread groups of the pipeline's compute shader with a resource set,
+			dispatchIndirect() reads DispatchIndirectArgs from a BufferType::INDIRECT buffer at a byte offset, a multiple of 4.
+			Dispatches may unbind the resources bound for draws (eg. D3D11 unbinds views of a resource bound for writing),
+			so the pipeline and resource set should be bound again before drawBound(), their writes are seen by the commands which follow them.
+		*/
+		virtual void dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params) = 0;
+		virtual void dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset) = 0;
+
+		//Marks the start of a command batch with it's sort key, used by tools that record the command stream
+		virtual void batchMarker(uint64 sortKey) {}
+
+		/*
+			Staged buffer updates:
+
+			beginStagedUpdates() uploads a block of buffer contents with a single copy,
+			resourceUpdateStaged() then updates a buffer with a range of that block, ranges begin on a STAGING_ALIGNMENT boundary.
+			endStagedUpdates() ends the staging, the block must stay valid until then.
+
+			Contexts which can't stage updates return false from beginStagedUpdates(), buffers are then updated individually.
+		*/
+		enum { STAGING_ALIGNMENT = 256 };
+
+		virtual bool beginStagedUpdates(const void* memory, uint32 size) { return false; }
+		virtual void resourceUpdateStaged(ResourceHandle rsc, uint32 offset, uint32 size) {}
+		virtual void endStagedUpdates() {}
+
 		virtual void finish() = 0;
     };
 }
@@ -0,0 +1,310 @@
+/*
+	Driver Stats:
+
+	Enumerates the counters of RenderStats, and helps devices collect them and users compare them between frames.
+
+	- RenderStatsCounter names every counter so counters can be iterated, printed and compared generically.
+	- RenderStatsDelta is the signed frame-over-frame change of each counter, so regressions
+	  (more binds, more bytes uploaded, memory which keeps growing) can be tested for.
+	- RenderStatsBudget holds upper limits of counters and reports which counters are over budget.
+	- RenderStatsCollector is used by device implementations, it's counters are atomic so worker contexts count in parallel.
+	  RenderStatsTimer adds the time spent in a context call to the context time counter.
+	- Devices report the frame in progress, so stats are queried before the frame is committed.
+
+	example:
+
+		RenderStats last, current;
+
+		device->queryStats(current);
+		device->commit();
+
+		RenderStatsDelta delta(last, current);
+		if (delta[RenderStatsCounter::PIPELINE_BINDS] > 0) ...
+
+		last = current;
+*/
+
+#pragma once
+
+#include <tscore/types.h>
+
+#include "Defs.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace ts
+{
+	enum class RenderStatsCounter : uint32
+	{
+		//Frame counters
+		DRAWCALLS,
+		TRIANGLES,
+		INSTANCES,
+		DISPATCHES,
+		PIPELINE_BINDS,
+		RESOURCE_SET_BINDS,
+		TARGET_BINDS,
+		BUFFER_UPDATES,
+		BUFFER_UPDATE_BYTES,
+		IMAGE_UPDATES,
+		IMAGE_UPDATE_BYTES,
+		BUFFERS_CREATED,
+		BUFFERS_DESTROYED,
+		IMAGES_CREATED,
+		IMAGES_DESTROYED,
+		RESOURCE_SETS_CREATED,
+		RESOURCE_SETS_DESTROYED,
+		SHADERS_CREATED,
+		SHADERS_DESTROYED,
+		PIPELINES_CREATED,
+		PIPELINES_DESTROYED,
+		TARGETS_CREATED,
+		TARGETS_DESTROYED,
+		CONTEXT_TIME,
+
+		//Memory counters
+		VERTEX_BUFFER_MEMORY,
+		INDEX_BUFFER_MEMORY,
+		CONSTANT_BUFFER_MEMORY,
+		IMAGE_MEMORY,
+		TARGET_MEMORY,
+
+		COUNT
+	};
+
+	struct RenderStatsCounterInfo
+	{
+		const char* name;
+		uint64 RenderStats::* member;
+	};
+
+	inline const RenderStatsCounterInfo& getRenderStatsCounterInfo(RenderStatsCounter counter)
+	{
+		static const RenderStatsCounterInfo info[] =
+		{
+			{ "drawcalls", &RenderStats::drawcalls },
+			{ "triangles", &RenderStats::triangles },
+			{ "instances", &RenderStats::instances },
+			{ "dispatches", &RenderStats::dispatches },
+			{ "pipelineBinds", &RenderStats::pipelineBinds },
+			{ "resourceSetBinds", &RenderStats::resourceSetBinds },
+			{ "targetBinds", &RenderStats::targetBinds },
+			{ "bufferUpdates", &RenderStats::bufferUpdates },
+			{ "bufferUpdateBytes", &RenderStats::bufferUpdateBytes },
+			{ "imageUpdates", &RenderStats::imageUpdates },
+			{ "imageUpdateBytes", &RenderStats::imageUpdateBytes },
+			{ "buffersCreated", &RenderStats::buffersCreated },
+			{ "buffersDestroyed", &RenderStats::buffersDestroyed },
+			{ "imagesCreated", &RenderStats::imagesCreated },
+			{ "imagesDestroyed", &RenderStats::imagesDestroyed },
+			{ "resourceSetsCreated", &RenderStats::resourceSetsCreated },
+			{ "resourceSetsDestroyed", &RenderStats::resourceSetsDestroyed },
+			{ "shadersCreated", &RenderStats::shadersCreated },
+			{ "shadersDestroyed", &RenderStats::shadersDestroyed },
+			{ "pipelinesCreated", &RenderStats::pipelinesCreated },
+			{ "pipelinesDestroyed", &RenderStats::pipelinesDestroyed },
+			{ "targetsCreated", &RenderStats::targetsCreated },
+			{ "targetsDestroyed", &RenderStats::targetsDestroyed },
+			{ "contextTime", &RenderStats::contextTime },
+			{ "vertexBufferMemory", &RenderStats::vertexBufferMemory },
+			{ "indexBufferMemory", &RenderStats::indexBufferMemory },
+			{ "constantBufferMemory", &RenderStats::constantBufferMemory },
+			{ "imageMemory", &RenderStats::imageMemory },
+			{ "targetMemory", &RenderStats::targetMemory },
+		};
+
+		static_assert(sizeof(info) / sizeof(info[0]) == (size_t)RenderStatsCounter::COUNT, "every counter must be named");
+
+		return info[(size_t)counter];
+	}
+
+	inline const char* getRenderStatsCounterName(RenderStatsCounter counter) { return getRenderStatsCounterInfo(counter).name; }
+	inline uint64 getRenderStatsCounter(const RenderStats& stats, RenderStatsCounter counter) { return stats.*getRenderStatsCounterInfo(counter).member; }
+
+	//Frame counters are reset each frame, memory counters are not
+	inline bool isRenderStatsFrameCounter(RenderStatsCounter counter) { return counter < RenderStatsCounter::VERTEX_BUFFER_MEMORY; }
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Comparison
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Change of each counter from one frame to another
+	*/
+	struct RenderStatsDelta
+	{
+		int64 values[(size_t)RenderStatsCounter::COUNT] = {};
+
+		RenderStatsDelta() {}
+
+		RenderStatsDelta(const RenderStats& previous, const RenderStats& current)
+		{
+			for (uint32 i = 0; i < (uint32)RenderStatsCounter::COUNT; i++)
+			{
+				const RenderStatsCounter c = (RenderStatsCounter)i;
+				values[i] = (int64)getRenderStatsCounter(current, c) - (int64)getRenderStatsCounter(previous, c);
+			}
+		}
+
+		int64 operator[](RenderStatsCounter counter) const { return values[(size_t)counter]; }
+
+		//True if no counter changed
+		bool empty() const
+		{
+			for (int64 v : values)
+			{
+				if (v != 0)
+					return false;
+			}
+
+			return true;
+		}
+	};
+
+	/*
+		Upper limits of counters, a limit of zero is no limit
+	*/
+	struct RenderStatsBudget
+	{
+		uint64 limits[(size_t)RenderStatsCounter::COUNT] = {};
+
+		void set(RenderStatsCounter counter, uint64 limit) { limits[(size_t)counter] = limit; }
+		uint64 get(RenderStatsCounter counter) const { return limits[(size_t)counter]; }
+
+		/*
+			Find the counters which are over budget, up to maxCount of them are written to over.
+			Returns the number of counters over budget.
+		*/
+		uint32 check(const RenderStats& stats, RenderStatsCounter* over = nullptr, uint32 maxCount = 0) const
+		{
+			uint32 n = 0;
+
+			for (uint32 i = 0; i < (uint32)RenderStatsCounter::COUNT; i++)
+			{
+				const RenderStatsCounter c = (RenderStatsCounter)i;
+
+				if (limits[i] > 0 && getRenderStatsCounter(stats, c) > limits[i])
+				{
+					if (over != nullptr && n < maxCount)
+						over[n] = c;
+
+					n++;
+				}
+			}
+
+			return n;
+		}
+	};
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Collection
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Counters of a device, updated by the device and all of it's contexts
+	*/
+	class RenderStatsCollector
+	{
+	private:
+
+		std::atomic<uint64> m_counters[(size_t)RenderStatsCounter::COUNT];
+
+	public:
+
+		RenderStatsCollector()
+		{
+			for (auto& c : m_counters)
+				c.store(0);
+		}
+
+		RenderStatsCollector(const RenderStatsCollector&) = delete;
+
+		void add(RenderStatsCounter counter, uint64 n = 1) { m_counters[(size_t)counter].fetch_add(n, std::memory_order_relaxed); }
+		void subtract(RenderStatsCounter counter, uint64 n) { m_counters[(size_t)counter].fetch_sub(n, std::memory_order_relaxed); }
+
+		uint64 get(RenderStatsCounter counter) const { return m_counters[(size_t)counter].load(std::memory_order_relaxed); }
+
+		void countDraw(VertexTopology topology, const DrawParams& params)
+		{
+			const bool instanced = (params.mode == DrawMode::INSTANCED || params.mode == DrawMode::INDEXEDINSTANCED);
+			const uint64 instances = instanced ? params.instances : 1;
+
+			add(RenderStatsCounter::DRAWCALLS);
+			add(RenderStatsCounter::INSTANCES, instances);
+			add(RenderStatsCounter::TRIANGLES, instances * getTriangleCount(topology, params.count));
+		}
+
+		//Reset the frame counters
+		void nextFrame()
+		{
+			for (uint32 i = 0; i < (uint32)RenderStatsCounter::COUNT; i++)
+			{
+				if (isRenderStatsFrameCounter((RenderStatsCounter)i))
+					m_counters[i].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		void query(RenderStats& stats) const
+		{
+			for (uint32 i = 0; i < (uint32)RenderStatsCounter::COUNT; i++)
+			{
+				stats.*getRenderStatsCounterInfo((RenderStatsCounter)i).member = m_counters[i].load(std::memory_order_relaxed);
+			}
+		}
+
+		//Triangles drawn from a number of vertices or indices
+		static uint64 getTriangleCount(VertexTopology topology, uint32 count)
+		{
+			switch (topology)
+			{
+			case VertexTopology::TRIANGLELIST: return count / 3;
+			case VertexTopology::TRIANGLESTRIP: return (count > 2) ? count - 2 : 0;
+			default: return 0;
+			}
+		}
+
+		//Memory counter of a buffer, buffers of an unknown type are counted as vertex buffers
+		static RenderStatsCounter getMemoryCounter(BufferType type)
+		{
+			switch (type)
+			{
+			case BufferType::INDEX: return RenderStatsCounter::INDEX_BUFFER_MEMORY;
+			case BufferType::CONSTANTS: return RenderStatsCounter::CONSTANT_BUFFER_MEMORY;
+			default: return RenderStatsCounter::VERTEX_BUFFER_MEMORY;
+			}
+		}
+
+		//Memory counter of an image
+		static RenderStatsCounter getMemoryCounter(ImageUsage usage)
+		{
+			return ((usage & (ImageUsage::RTV | ImageUsage::DSV)) != 0) ? RenderStatsCounter::TARGET_MEMORY : RenderStatsCounter::IMAGE_MEMORY;
+		}
+	};
+
+	/*
+		Measures the time spent in a context call, calls which call other counted methods are not timed themselves
+	*/
+	class RenderStatsTimer
+	{
+	private:
+
+		RenderStatsCollector& m_stats;
+		std::chrono::high_resolution_clock::time_point m_start;
+
+	public:
+
+		RenderStatsTimer(RenderStatsCollector& stats) :
+			m_stats(stats),
+			m_start(std::chrono::high_resolution_clock::now())
+		{}
+
+		~RenderStatsTimer()
+		{
+			const auto elapsed = std::chrono::high_resolution_clock::now() - m_start;
+			m_stats.add(RenderStatsCounter::CONTEXT_TIME, (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+		}
+
+		RenderStatsTimer(const RenderStatsTimer&) = delete;
+	};
+}
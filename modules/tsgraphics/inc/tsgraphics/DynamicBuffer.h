@@ -0,0 +1,113 @@
+/*
+	Dynamic Buffer Ring:
+
+	Sub-allocates per-frame data (draw constants, generated vertices and indices) from one large buffer.
+
+	- The buffer is split into a region for each frame in flight, allocations are taken linearly from the region
+	  of the current frame so data written for a draw is never overwritten while an earlier frame may still use it.
+	- Contents are written to CPU memory and uploaded with a single update of the range allocated since the last upload,
+	  constant buffers are updated whole on devices which can't update ranges of them (RenderDeviceInfo::constantBufferRanges).
+	- Constant allocations are aligned to DrawParams::CONSTANT_OFFSET_ALIGNMENT, the allocation's offset is
+	  used as the DrawParams::constantOffset of a draw whose resource set binds the buffer as a dynamic constant buffer.
+	- Vertex and index allocations are aligned to their element size, offset / element size is the
+	  start or vertex base of a draw.
+	- The handle of the buffer doesn't change, so resource sets which bind it are created once.
+	- A ring is used from a single thread.
+
+	example:
+
+		DynamicBufferRing ring(device, BufferType::CONSTANTS, 64 * 1024);
+
+		DynamicAllocation a = ring.write(constants);
+		params.constantOffset = a.offset;
+		...
+		ring.upload(context);
+		//Execute draws
+		ring.nextFrame();
+*/
+
+#pragma once
+
+#include <tsgraphics/abi.h>
+
+#include <tscore/ptr.h>
+
+#include "Driver.h"
+
+namespace ts
+{
+	struct DynamicAllocation
+	{
+		ResourceHandle buffer = ResourceHandle();
+
+		//Byte offset from the start of the buffer
+		uint32 offset = 0;
+		uint32 size = 0;
+
+		//Memory the contents are written to, valid until the ring is uploaded
+		void* memory = nullptr;
+
+		bool valid() const { return buffer != ResourceHandle(); }
+	};
+
+	class DynamicBufferRing
+	{
+	private:
+
+		struct State;
+		OpaquePtr<State> pState;
+
+	public:
+
+		struct Stats
+		{
+			//Allocations and bytes allocated in the current frame
+			uint32 allocations = 0;
+			uint32 bytes = 0;
+
+			//Most bytes allocated in a single frame
+			uint32 peakBytes = 0;
+
+			//Allocations which didn't fit in the region of their frame
+			uint32 overflows = 0;
+		};
+
+		OPAQUE_PTR(DynamicBufferRing, pState)
+
+		DynamicBufferRing() {}
+		TSGRAPHICS_API DynamicBufferRing(RenderDevice* device, BufferType type, uint32 frameSize, uint32 frames = 2);
+		TSGRAPHICS_API ~DynamicBufferRing();
+
+		TSGRAPHICS_API RenderDevice* getDevice() const;
+
+		TSGRAPHICS_API ResourceHandle getBuffer() const;
+		TSGRAPHICS_API BufferType getType() const;
+
+		//Size of the region of each frame and the number of frames in flight
+		TSGRAPHICS_API uint32 getFrameSize() const;
+		TSGRAPHICS_API uint32 getFrameCount() const;
+
+		/*
+			Allocate a range of the current frame's region, alignment defaults to the alignment of the buffer type.
+			Returns an invalid allocation if the region is full.
+		*/
+		TSGRAPHICS_API DynamicAllocation allocate(uint32 size, uint32 alignment = 0);
+
+		//Allocate a range and copy data to it
+		TSGRAPHICS_API DynamicAllocation write(const void* data, uint32 size, uint32 alignment = 0);
+
+		template<typename type_t>
+		DynamicAllocation write(const type_t& data, uint32 alignment = 0)
+		{
+			return write(&data, (uint32)sizeof(type_t), alignment);
+		}
+
+		//Upload the contents of ranges allocated since the last upload
+		TSGRAPHICS_API void upload(RenderContext* context);
+
+		//Begin the next frame, the region of the oldest frame is reused
+		TSGRAPHICS_API void nextFrame();
+
+		TSGRAPHICS_API Stats getStats() const;
+	};
+}
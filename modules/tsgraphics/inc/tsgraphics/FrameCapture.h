@@ -0,0 +1,144 @@
+/*
+	Frame Capture:
+
+	Records the device objects and context calls of a frame so it can be reproduced offline.
+
+	- CaptureDevice wraps another device and keeps a description of every object created through it.
+	- Between beginCapture() and endCapture() every call made to the device's context is recorded,
+	  command queues mark the start of each batch with it's sort key.
+	- Worker contexts aren't recorded, so the device acquires none and commands are recorded on the main context.
+	- Captures are written as FrameCapture.schema resources.
+	- FrameReplay recreates the captured objects on any device and re-executes the recorded calls.
+
+	example:
+
+		CaptureDevice capture(device);
+
+		capture.beginCapture();
+		queue.flush(capture.context());
+		capture.context()->finish();
+		capture.endCapture("frame.tsfc");
+
+		FrameReplay replay;
+		replay.load("frame.tsfc");
+		replay.create(otherDevice);
+		replay.execute(otherDevice->context());
+*/
+
+#pragma once
+
+#include <tsgraphics/abi.h>
+
+#include <tscore/ptr.h>
+#include <tscore/path.h>
+
+#include "Driver.h"
+
+#include <iosfwd>
+
+namespace ts
+{
+	/*
+		Device which records descriptions of the objects it creates and the calls made to it's context
+	*/
+	class CaptureDevice : public RenderDevice
+	{
+	private:
+
+		struct State;
+		OpaquePtr<State> pState;
+
+	public:
+
+		OPAQUE_PTR(CaptureDevice, pState)
+
+		TSGRAPHICS_API CaptureDevice(RenderDevice* device);
+		TSGRAPHICS_API ~CaptureDevice();
+
+		//Device that calls are forwarded to
+		TSGRAPHICS_API RenderDevice* getDevice() const;
+
+		/*
+			Capture
+		*/
+
+		//Start recording context calls
+		TSGRAPHICS_API void beginCapture();
+		//Stop recording context calls and write the capture
+		TSGRAPHICS_API bool endCapture(std::ostream& out);
+		TSGRAPHICS_API bool endCapture(const Path& file);
+
+		TSGRAPHICS_API bool isCapturing() const;
+
+		/*
+			Device methods
+		*/
+
+		TSGRAPHICS_API RenderContext* context() override;
+		TSGRAPHICS_API void commit() override;
+
+		TSGRAPHICS_API void setDisplayConfiguration(const DisplayConfig& displayCfg) override;
+		TSGRAPHICS_API void getDisplayConfiguration(DisplayConfig& displayCfg) override;
+		TSGRAPHICS_API ResourceHandle getDisplayTarget() override;
+
+		TSGRAPHICS_API void queryStats(RenderStats& stats) override;
+		TSGRAPHICS_API void queryInfo(RenderDeviceInfo& info) override;
+
+		TSGRAPHICS_API RPtr<ResourceHandle> createEmptyResource(ResourceHandle recycle) override;
+		TSGRAPHICS_API RPtr<ResourceHandle> createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle) override;
+		TSGRAPHICS_API RPtr<ResourceHandle> createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle) override;
+		TSGRAPHICS_API RPtr<ResourceSetHandle> createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle) override;
+		TSGRAPHICS_API RPtr<ShaderHandle> createShader(const ShaderCreateInfo& info) override;
+		TSGRAPHICS_API RPtr<PipelineHandle> createPipeline(ShaderHandle program, const PipelineCreateInfo& info) override;
+		TSGRAPHICS_API RPtr<TargetHandle> createTarget(const TargetCreateInfo& info, TargetHandle recycle) override;
+
+		TSGRAPHICS_API void destroy(ResourceHandle rsc) override;
+		TSGRAPHICS_API void destroy(ResourceSetHandle set) override;
+		TSGRAPHICS_API void destroy(ShaderHandle shader) override;
+		TSGRAPHICS_API void destroy(PipelineHandle state) override;
+		TSGRAPHICS_API void destroy(TargetHandle pass) override;
+	};
+
+	/*
+		Replays a frame capture against a device
+	*/
+	class FrameReplay
+	{
+	private:
+
+		struct Replay;
+		OpaquePtr<Replay> pReplay;
+
+	public:
+
+		struct Stats
+		{
+			uint32 batches = 0;
+			uint32 calls = 0;
+			uint32 draws = 0;
+			uint32 dispatches = 0;
+			uint32 objects = 0;
+			uint64 payloadSize = 0;
+		};
+
+		OPAQUE_PTR(FrameReplay, pReplay)
+
+		TSGRAPHICS_API FrameReplay();
+		TSGRAPHICS_API ~FrameReplay();
+
+		//Load a capture
+		TSGRAPHICS_API bool load(std::istream& in);
+		TSGRAPHICS_API bool load(const Path& file);
+
+		//Recreate the captured objects on a device, objects of a previous device are released
+		TSGRAPHICS_API bool create(RenderDevice* device);
+
+		//Execute the captured calls on a context of the device the objects were created on
+		TSGRAPHICS_API void execute(RenderContext* context);
+
+		//Release the created objects
+		TSGRAPHICS_API void release();
+
+		TSGRAPHICS_API Stats getStats() const;
+	};
+}
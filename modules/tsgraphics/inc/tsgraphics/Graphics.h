@@ -15,6 +15,10 @@
 
 #include "Driver.h"
 #include "CommandQueue.h"
+#include "FrameCapture.h"
+#include "DeferredDestroy.h"
+#include "PipelineCache.h"
+#include "ResourceSetCache.h"
 #include "Surface.h"
 #include "RenderTargetPool.h"
 #include "Image.h"
@@ -53,7 +57,7 @@ namespace ts
 	*/
 	struct GraphicsConfig
 	{
-		//Handle to drawing surface
+		//Handle to drawing surface, may be null if the driver is headless (eg. NULLDEVICE)
 		ISurface* surface = nullptr;
 
 		//Display settings
@@ -64,6 +68,16 @@ namespace ts
 
 		//Root asset loading path for textures/shaders/models
 		Path rootpath;
+
+		//Track device objects so frames can be captured with GraphicsSystem::captureFrame()
+		bool enableCapture = false;
+
+		//Number of frames command queue statistics are averaged over
+		uint32 statsFrames = 60;
+
+		//Queue device objects released through GraphicsSystem::device() until destroyLatency more frames have been committed
+		bool deferDestruction = true;
+		uint32 destroyLatency = 2;
 	};
 
 	/*
@@ -86,7 +100,8 @@ namespace ts
 		TSGRAPHICS_API GraphicsSystem(const GraphicsConfig&);
 		TSGRAPHICS_API ~GraphicsSystem();
 
-		RenderDevice* device() const { return pDevice.get(); }
+		//Device used for rendering, this is a CaptureDevice if capturing is enabled or a DeferredDestroyDevice if destruction is deferred
+		TSGRAPHICS_API RenderDevice* device() const;
 
 		/*
 			Get/set graphics system properties
@@ -107,6 +122,11 @@ namespace ts
 		TSGRAPHICS_API ImageTargetPool* getDisplayTargetPool() const;
 		Viewport getDisplayViewport() const { return getDisplayTargetPool()->getViewport(); }
 
+		//Pipelines shared between equal descriptors
+		TSGRAPHICS_API PipelineCache* getPipelineCache() const;
+		//Resource sets shared between equal bindings
+		TSGRAPHICS_API ResourceSetCache* getResourceSetCache() const;
+
 		/*
 			Load resources
 		*/
@@ -125,6 +145,21 @@ namespace ts
 		//Signal draw end
 		TSGRAPHICS_API void end();
 
+		//Capture the next frame to a file, capturing must be enabled in the GraphicsConfig
+		TSGRAPHICS_API bool captureFrame(const Path& file);
+
+		/*
+			Statistics
+		*/
+
+		//Statistics of every command queue executed in the last frame
+		TSGRAPHICS_API CommandQueue::Stats getQueueStats() const;
+		//Statistics of the command queues executed per frame, averaged over recent frames
+		TSGRAPHICS_API CommandQueue::Stats getQueueStatsAverage() const;
+
+		//Objects waiting to be destroyed, empty if destruction is not deferred
+		TSGRAPHICS_API DeferredDestroyStats getDestroyStats() const;
+
 		/*
 			Events
 		*/
@@ -9,7 +9,7 @@
 
 namespace ts
 {
-    class Image
+    class Image : public RefCounted<>
     {
     public:
         
@@ -0,0 +1,83 @@
+/*
+	Indirect Draw Builder:
+
+	Turns a sequence of draws into indirect argument batches, so many objects are drawn with few context calls.
+
+	- Consecutive draws which share their target, pipeline, resource set and index mode are merged into a batch,
+	  each batch is drawn with a single multiDrawIndirect() call. Draw order is kept.
+	- Arguments of every batch are written to one block which is uploaded to the argument buffer with a single update.
+	  The argument buffer is owned by the builder and grows when it is too small.
+	- Indirect draws bind dynamic constant buffers at offset 0, so draws with a constant offset are drawn directly.
+	- A builder is used from a single thread.
+
+	example:
+
+		IndirectDrawBuilder builder(device);
+
+		for (const CommandDraw& draw : draws)
+			builder.add(draw);
+
+		builder.submit(context);
+		builder.clear();
+*/
+
+#pragma once
+
+#include <tsgraphics/abi.h>
+
+#include <tscore/ptr.h>
+
+#include "Driver.h"
+#include "CommandQueue.h"
+
+namespace ts
+{
+	class IndirectDrawBuilder
+	{
+	private:
+
+		struct State;
+		OpaquePtr<State> pState;
+
+	public:
+
+		struct Stats
+		{
+			//Draws added since the builder was cleared
+			uint32 draws = 0;
+
+			//Indirect batches and draws which couldn't be drawn indirectly
+			uint32 batches = 0;
+			uint32 directDraws = 0;
+
+			//Bytes of arguments built
+			uint32 argumentBytes = 0;
+		};
+
+		OPAQUE_PTR(IndirectDrawBuilder, pState)
+
+		IndirectDrawBuilder() {}
+		TSGRAPHICS_API IndirectDrawBuilder(RenderDevice* device);
+		TSGRAPHICS_API ~IndirectDrawBuilder();
+
+		TSGRAPHICS_API RenderDevice* getDevice() const;
+
+		//Argument buffer, null until the builder is first submitted
+		TSGRAPHICS_API ResourceHandle getBuffer() const;
+
+		//Add draws after the draws already added
+		TSGRAPHICS_API void add(const CommandDraw& draw);
+		TSGRAPHICS_API void add(const CommandDraw* draws, uint32 count);
+
+		/*
+			Upload the arguments and draw every batch.
+			The draws stay in the builder so an unchanged sequence can be submitted again.
+		*/
+		TSGRAPHICS_API void submit(RenderContext* context);
+
+		//Remove all draws
+		TSGRAPHICS_API void clear();
+
+		TSGRAPHICS_API Stats getStats() const;
+	};
+}
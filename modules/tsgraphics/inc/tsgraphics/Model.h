@@ -42,7 +42,7 @@ namespace ts
 		DrawParams getParams() const;
 	};
 
-	class Model
+	class Model : public RefCounted<>
 	{
 	public:
 
@@ -0,0 +1,101 @@
+/*
+	Pipeline Cache:
+
+	Shares pipelines between users which create them with equal descriptors.
+
+	- The full pipeline descriptor (shader, raster, depth and blend state, topology, samplers
+	  and vertex attributes) is encoded as a key, pipelines are looked up by the hash of the key.
+	- Pipelines are returned as reference counted CachedPipelines, the pipeline is destroyed
+	  when the last reference is released. The cache only holds weak references.
+	- The cache can be used from multiple threads.
+
+	example:
+
+		PipelineCache cache(device);
+
+		PipelineRef a = cache.get(shader, info);
+		PipelineRef b = cache.get(shader, info);
+
+		a->handle() == b->handle()
+*/
+
+#pragma once
+
+#include <tsgraphics/abi.h>
+
+#include <tscore/ptr.h>
+#include <tscore/refcount.h>
+
+#include "Driver.h"
+
+namespace ts
+{
+	/*
+		Shared pipeline
+	*/
+	class CachedPipeline : public RefCounted<RefCountAtomic>
+	{
+	private:
+
+		RPtr<PipelineHandle> m_pipeline;
+		uint64 m_hash;
+
+	public:
+
+		CachedPipeline(RPtr<PipelineHandle>&& pipeline, uint64 hash) :
+			m_pipeline(std::move(pipeline)),
+			m_hash(hash)
+		{}
+
+		PipelineHandle handle() const { return m_pipeline.handle(); }
+
+		//Hash of the pipeline's descriptor
+		uint64 hash() const { return m_hash; }
+	};
+
+	typedef IntrusivePtr<CachedPipeline> PipelineRef;
+
+	/*
+		Pipeline cache
+	*/
+	class PipelineCache
+	{
+	private:
+
+		struct State;
+		OpaquePtr<State> pState;
+
+	public:
+
+		struct Stats
+		{
+			uint64 lookups = 0;
+			uint64 hits = 0;
+
+			//Pipelines created by the cache and how many are alive
+			uint32 created = 0;
+			uint32 live = 0;
+
+			//Size of the descriptors of pipelines which were shared rather than created again
+			uint64 savedBytes = 0;
+
+			double hitRate() const { return (lookups > 0) ? (double)hits / lookups : 0.0; }
+		};
+
+		OPAQUE_PTR(PipelineCache, pState)
+
+		PipelineCache() {}
+		TSGRAPHICS_API PipelineCache(RenderDevice* device);
+		TSGRAPHICS_API ~PipelineCache();
+
+		TSGRAPHICS_API RenderDevice* getDevice() const;
+
+		//Get a pipeline with the given descriptor, it is created if there is no live pipeline with an equal descriptor
+		TSGRAPHICS_API PipelineRef get(ShaderHandle program, const PipelineCreateInfo& info);
+
+		TSGRAPHICS_API Stats getStats() const;
+
+		//Hash of a pipeline descriptor
+		TSGRAPHICS_API static uint64 hash(ShaderHandle program, const PipelineCreateInfo& info);
+	};
+}
@@ -0,0 +1,233 @@
+/*
+	Resource Set Cache:
+
+	Shares resource sets between users which bind the same resources, and rebinds individual slots of a set in place.
+
+	- The set descriptor (resource views, constant buffers, vertex buffers, index buffer and storage bindings) is encoded as a key,
+	  sets are looked up by the hash of the key.
+	- Sets are returned as reference counted CachedResourceSets, the set is destroyed
+	  when the last reference is released. The cache only holds weak references.
+	- update() patches slots of a set. If the patched bindings match a live set that set is shared,
+	  otherwise a set which isn't shared is rebound in place (it's handle is kept) and a shared set is copied.
+	- Sets rebound in place take effect the next time they are bound, so they shouldn't be updated
+	  while commands which use them are being recorded.
+	- The cache can be used from multiple threads.
+
+	example:
+
+		ResourceSetCache cache(device);
+
+		ResourceSetRef a = cache.get(info);
+		ResourceSetRef b = cache.get(info);
+
+		a->handle() == b->handle()
+
+		ResourceSetUpdate u = ResourceSetUpdate::makeResource(2, shadowMap);
+		cache.update(a, &u, 1);
+*/
+
+#pragma once
+
+#include <tsgraphics/abi.h>
+
+#include <tscore/ptr.h>
+#include <tscore/refcount.h>
+
+#include <vector>
+
+#include "Driver.h"
+
+namespace ts
+{
+	enum class ResourceSetSlot : uint8
+	{
+		RESOURCE,
+		CONSTANT_BUFFER,
+		VERTEX_BUFFER,
+		INDEX_BUFFER,
+		STORAGE_BUFFER,
+		STORAGE_IMAGE
+	};
+
+	/*
+		Change to a single bound slot of a resource set
+	*/
+	struct ResourceSetUpdate
+	{
+		ResourceSetSlot type = ResourceSetSlot::RESOURCE;
+		uint32 slot = 0;
+
+		ImageView resource;                         //RESOURCE or STORAGE_IMAGE
+		ResourceHandle buffer = ResourceHandle();   //CONSTANT_BUFFER, INDEX_BUFFER or STORAGE_BUFFER
+		bool dynamic = false;                       //CONSTANT_BUFFER bound at each draw's constant offset
+		VertexBufferView vertexBuffer;              //VERTEX_BUFFER
+
+		static ResourceSetUpdate makeResource(uint32 slot, const ImageView& view)
+		{
+			ResourceSetUpdate u;
+			u.type = ResourceSetSlot::RESOURCE;
+			u.slot = slot;
+			u.resource = view;
+			return u;
+		}
+
+		static ResourceSetUpdate makeConstantBuffer(uint32 slot, ResourceHandle buffer, bool dynamic = false)
+		{
+			ResourceSetUpdate u;
+			u.type = ResourceSetSlot::CONSTANT_BUFFER;
+			u.slot = slot;
+			u.buffer = buffer;
+			u.dynamic = dynamic;
+			return u;
+		}
+
+		static ResourceSetUpdate makeVertexBuffer(uint32 slot, const VertexBufferView& view)
+		{
+			ResourceSetUpdate u;
+			u.type = ResourceSetSlot::VERTEX_BUFFER;
+			u.slot = slot;
+			u.vertexBuffer = view;
+			return u;
+		}
+
+		static ResourceSetUpdate makeIndexBuffer(ResourceHandle buffer)
+		{
+			ResourceSetUpdate u;
+			u.type = ResourceSetSlot::INDEX_BUFFER;
+			u.buffer = buffer;
+			return u;
+		}
+
+		static ResourceSetUpdate makeStorageBuffer(uint32 slot, ResourceHandle buffer)
+		{
+			ResourceSetUpdate u;
+			u.type = ResourceSetSlot::STORAGE_BUFFER;
+			u.slot = slot;
+			u.buffer = buffer;
+			return u;
+		}
+
+		static ResourceSetUpdate makeStorageImage(uint32 slot, const ImageView& view)
+		{
+			ResourceSetUpdate u;
+			u.type = ResourceSetSlot::STORAGE_IMAGE;
+			u.slot = slot;
+			u.resource = view;
+			return u;
+		}
+	};
+
+	/*
+		Shared resource set
+	*/
+	class CachedResourceSet : public RefCounted<RefCountAtomic>
+	{
+	private:
+
+		friend class ResourceSetCache;
+
+		RPtr<ResourceSetHandle> m_set;
+		uint64 m_hash = 0;
+
+		//Bindings of the set
+		std::vector<ImageView> m_resources;
+		std::vector<ResourceHandle> m_constantBuffers;
+		std::vector<VertexBufferView> m_vertexBuffers;
+		ResourceHandle m_indexBuffer = ResourceHandle();
+		uint32 m_dynamicConstants = 0;
+		std::vector<ResourceHandle> m_storageBuffers;
+		std::vector<ImageView> m_storageImages;
+
+	public:
+
+		CachedResourceSet(RPtr<ResourceSetHandle>&& set, uint64 hash, const ResourceSetCreateInfo& info) :
+			m_set(std::move(set)),
+			m_hash(hash),
+			m_resources(info.resources, info.resources + info.resourceCount),
+			m_constantBuffers(info.constantBuffers, info.constantBuffers + info.constantBuffersCount),
+			m_vertexBuffers(info.vertexBuffers, info.vertexBuffers + info.vertexBufferCount),
+			m_indexBuffer(info.indexBuffer),
+			m_dynamicConstants(info.dynamicConstants),
+			m_storageBuffers(info.storageBuffers, info.storageBuffers + info.storageBufferCount),
+			m_storageImages(info.storageImages, info.storageImages + info.storageImageCount)
+		{}
+
+		ResourceSetHandle handle() const { return m_set.handle(); }
+
+		//Hash of the set's bindings
+		uint64 hash() const { return m_hash; }
+
+		//Descriptor of the set's bindings, valid until the set is updated
+		ResourceSetCreateInfo info() const
+		{
+			ResourceSetCreateInfo info;
+			info.resources = m_resources.data();
+			info.resourceCount = (uint32)m_resources.size();
+			info.constantBuffers = m_constantBuffers.data();
+			info.constantBuffersCount = (uint32)m_constantBuffers.size();
+			info.vertexBuffers = m_vertexBuffers.data();
+			info.vertexBufferCount = (uint32)m_vertexBuffers.size();
+			info.indexBuffer = m_indexBuffer;
+			info.dynamicConstants = m_dynamicConstants;
+			info.storageBuffers = m_storageBuffers.data();
+			info.storageBufferCount = (uint32)m_storageBuffers.size();
+			info.storageImages = m_storageImages.data();
+			info.storageImageCount = (uint32)m_storageImages.size();
+			return info;
+		}
+	};
+
+	typedef IntrusivePtr<CachedResourceSet> ResourceSetRef;
+
+	/*
+		Resource set cache
+	*/
+	class ResourceSetCache
+	{
+	private:
+
+		struct State;
+		OpaquePtr<State> pState;
+
+	public:
+
+		struct Stats
+		{
+			uint64 lookups = 0;
+			uint64 hits = 0;
+
+			//Sets created by the cache and how many are alive
+			uint32 created = 0;
+			uint32 live = 0;
+
+			//Updated sets, and how many were rebound in place rather than shared or copied
+			uint64 updates = 0;
+			uint64 rebinds = 0;
+
+			double hitRate() const { return (lookups > 0) ? (double)hits / lookups : 0.0; }
+		};
+
+		OPAQUE_PTR(ResourceSetCache, pState)
+
+		ResourceSetCache() {}
+		TSGRAPHICS_API ResourceSetCache(RenderDevice* device);
+		TSGRAPHICS_API ~ResourceSetCache();
+
+		TSGRAPHICS_API RenderDevice* getDevice() const;
+
+		//Get a set with the given bindings, it is created if there is no live set with equal bindings
+		TSGRAPHICS_API ResourceSetRef get(const ResourceSetCreateInfo& info);
+
+		/*
+			Change bound slots of a set, set then refers to a set with the new bindings.
+			Slots past the end of the set are added, slots in between are left unbound.
+			Returns false if the set couldn't be updated, set is unchanged.
+		*/
+		TSGRAPHICS_API bool update(ResourceSetRef& set, const ResourceSetUpdate* updates, uint32 count);
+
+		TSGRAPHICS_API Stats getStats() const;
+
+		//Hash of a set descriptor
+		TSGRAPHICS_API static uint64 hash(const ResourceSetCreateInfo& info);
+	};
+}
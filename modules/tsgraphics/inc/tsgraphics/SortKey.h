@@ -0,0 +1,226 @@
+/*
+	Sort key header:
+
+	Builds the 64 bit keys that Command Batches are sorted by.
+
+	A key layout is declared as a list of fields from the most significant bits to the least significant bits,
+	so batches are ordered by the first field, then the second field etc.
+	Fields are packed against the top of the key, layouts which begin with the same fields can be mixed in a single queue.
+
+	example:
+
+		struct KeyPass : public SortKeyField<4> {};
+		struct KeyPipeline : public SortKeyField<16> {};
+		struct KeyDepth : public SortKeyField<24> {};
+
+		typedef SortKeyLayout<KeyPass, KeyPipeline, KeyDepth> MyLayout;
+
+		SortKeyBuilder<MyLayout> key;
+		key.set<KeyPass>(1);
+		key.set<KeyPipeline>(sortKeyId(pipeline));
+		key.setDepth<KeyDepth>(viewDepth, zNear, zFar, DepthOrder::FRONT_TO_BACK);
+
+		queue.submitBatch(key, batch);
+*/
+
+#pragma once
+
+#include <tsgraphics/abi.h>
+
+#include <tscore/types.h>
+
+#include <type_traits>
+
+namespace ts
+{
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Sort key field - a named range of bits, declare fields by deriving from this type
+	*/
+	template<uint32 width_v>
+	struct SortKeyField
+	{
+		static_assert(width_v > 0 && width_v <= 64, "Sort key field width must be between 1 and 64 bits");
+
+		static const uint32 width = width_v;
+		static const uint64 maxValue = (width_v == 64) ? ~0ull : ((1ull << width_v) - 1);
+	};
+
+	namespace internal
+	{
+		//Sum of field widths
+		template<typename ... fields_t>
+		struct SortKeyWidth;
+
+		template<>
+		struct SortKeyWidth<>
+		{
+			static const uint32 value = 0;
+		};
+
+		template<typename field_t, typename ... fields_t>
+		struct SortKeyWidth<field_t, fields_t...>
+		{
+			static const uint32 value = field_t::width + SortKeyWidth<fields_t...>::value;
+		};
+
+		//Bit offset of a field, given the total width of the fields that precede it
+		template<uint32 preceding, typename field_t, typename ... fields_t>
+		struct SortKeyOffset
+		{
+			static_assert(sizeof(field_t) == 0, "Sort key field is not part of this layout");
+		};
+
+		template<uint32 preceding, typename field_t, typename ... fields_t>
+		struct SortKeyOffset<preceding, field_t, field_t, fields_t...>
+		{
+			static const uint32 value = 64 - preceding - field_t::width;
+		};
+
+		template<uint32 preceding, typename field_t, typename other_t, typename ... fields_t>
+		struct SortKeyOffset<preceding, field_t, other_t, fields_t...> : public SortKeyOffset<preceding + other_t::width, field_t, fields_t...>
+		{};
+	}
+
+	/*
+		Sort key layout - fields are listed from most significant to least significant
+	*/
+	template<typename ... fields_t>
+	struct SortKeyLayout
+	{
+		static const uint32 width = internal::SortKeyWidth<fields_t...>::value;
+
+		static_assert(width <= 64, "Sort key fields must fit in 64 bits");
+
+		template<typename field_t>
+		struct Offset : public internal::SortKeyOffset<0, field_t, fields_t...> {};
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	enum class DepthOrder
+	{
+		FRONT_TO_BACK,	//Nearest first - minimises overdraw of opaque geometry
+		BACK_TO_FRONT,	//Furthest first - required for blending translucent geometry
+	};
+
+	/*
+		Quantise a view space depth into an integer of a given number of bits
+	*/
+	inline uint64 quantizeDepth(float depth, float zNear, float zFar, uint32 bits, DepthOrder order)
+	{
+		//A float depth has no more than 24 bits of precision so wider fields gain nothing,
+		//clamping the width keeps the scaled value in the range of a uint64
+		bits = (bits > 32) ? 32 : bits;
+		const uint64 maxValue = (1ull << bits) - 1;
+
+		float t = (zFar > zNear) ? (depth - zNear) / (zFar - zNear) : 0.0f;
+		t = (t < 0.0f) ? 0.0f : ((t > 1.0f) ? 1.0f : t);
+
+		const uint64 q = (uint64)((double)t * (double)maxValue);
+
+		return (order == DepthOrder::FRONT_TO_BACK) ? q : (maxValue - q);
+	}
+
+	/*
+		Reduce a handle or id to a field value, equal values always produce equal ids
+	*/
+	template<typename type_t>
+	inline uint64 sortKeyId(type_t value)
+	{
+		uint64 x = (uint64)value;
+		//Mix the bits so the low bits of aligned pointers are not all the same
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdull;
+		x ^= x >> 33;
+		return x;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Sort key builder
+	*/
+	template<typename layout_t>
+	class SortKeyBuilder
+	{
+	private:
+
+		static_assert(layout_t::width <= 64, "Sort key fields must fit in 64 bits");
+
+		uint64 m_key = 0;
+
+		template<typename field_t>
+		static uint64 fieldMask() { return field_t::maxValue << layout_t::template Offset<field_t>::value; }
+
+	public:
+
+		typedef layout_t Layout;
+
+		SortKeyBuilder() {}
+		explicit SortKeyBuilder(uint64 key) : m_key(key) {}
+
+		//Set a field, values wider than the field are truncated
+		template<typename field_t>
+		SortKeyBuilder& set(uint64 value)
+		{
+			const uint32 offset = layout_t::template Offset<field_t>::value;
+
+			m_key = (m_key & ~fieldMask<field_t>()) | ((value & field_t::maxValue) << offset);
+			return *this;
+		}
+
+		//Set a field to a quantised view space depth
+		template<typename field_t>
+		SortKeyBuilder& setDepth(float depth, float zNear, float zFar, DepthOrder order)
+		{
+			return set<field_t>(quantizeDepth(depth, zNear, zFar, field_t::width, order));
+		}
+
+		template<typename field_t>
+		uint64 get() const
+		{
+			return (m_key & fieldMask<field_t>()) >> layout_t::template Offset<field_t>::value;
+		}
+
+		uint64 key() const { return m_key; }
+		operator uint64() const { return m_key; }
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Standard render key layouts
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	struct SortKeyPass : public SortKeyField<4> {};			//Render pass - passes are executed in order
+	struct SortKeyLayer : public SortKeyField<4> {};		//Layer within a pass (eg. world, overlay)
+	struct SortKeyTranslucent : public SortKeyField<1> {};	//Translucent geometry is drawn after opaque geometry
+	struct SortKeyPipeline : public SortKeyField<16> {};	//Pipeline state
+	struct SortKeyMaterial : public SortKeyField<16> {};	//Material resources
+	struct SortKeyDepth : public SortKeyField<23> {};		//Quantised view depth
+
+	//Opaque draws are grouped by state and then drawn front to back
+	typedef SortKeyLayout<
+		SortKeyPass,
+		SortKeyLayer,
+		SortKeyTranslucent,
+		SortKeyPipeline,
+		SortKeyMaterial,
+		SortKeyDepth
+	> OpaqueSortKeyLayout;
+
+	//Translucent draws are ordered back to front before state
+	typedef SortKeyLayout<
+		SortKeyPass,
+		SortKeyLayer,
+		SortKeyTranslucent,
+		SortKeyDepth,
+		SortKeyPipeline,
+		SortKeyMaterial
+	> TranslucentSortKeyLayout;
+
+	typedef SortKeyBuilder<OpaqueSortKeyLayout> OpaqueSortKey;
+	typedef SortKeyBuilder<TranslucentSortKeyLayout> TranslucentSortKey;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,1069 @@
+/*
+	API Trace source
+*/
+
+#include <tsgraphics/ApiTrace.h>
+
+#include <tscore/debug/assert.h>
+#include <tscore/debug/log.h>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include "CacheKey.h"
+
+using namespace ts;
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Helpers
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+enum
+{
+	TRACE_SIGNATURE = 0x52545354, //TSTR
+	TRACE_VERSION = 1
+};
+
+//Fields present in an encoded record
+enum TraceFields : uint8
+{
+	FIELD_OBJECT = 1 << 0,
+	FIELD_OTHER  = 1 << 1,
+	FIELD_VALUE0 = 1 << 2,
+	FIELD_VALUE1 = 1 << 3,
+	FIELD_HASH   = 1 << 4,
+};
+
+//Size in bytes of a pixel of a given format
+static uint32 imageFormatSize(ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::BYTE: return 1;
+	case ImageFormat::RGB: return 4;
+	case ImageFormat::RGBA: return 4;
+	case ImageFormat::ARGB: return 4;
+	case ImageFormat::FLOAT1: return 4;
+	case ImageFormat::FLOAT2: return 8;
+	case ImageFormat::FLOAT3: return 12;
+	case ImageFormat::FLOAT4: return 16;
+	case ImageFormat::DEPTH16: return 2;
+	case ImageFormat::DEPTH32: return 4;
+	default: return 0;
+	}
+}
+
+/*
+	FNV-1a hash, fields are hashed individually so struct padding isn't included
+*/
+class TraceHash
+{
+private:
+
+	uint64 m_hash = internal::FNV_OFFSET_BASIS;
+
+public:
+
+	TraceHash& bytes(const void* data, size_t size)
+	{
+		m_hash = internal::fnv1a(data, size, m_hash);
+		return *this;
+	}
+
+	template<typename type_t>
+	TraceHash& value(type_t v) { return bytes(&v, sizeof(v)); }
+
+	TraceHash& string(const char* s) { return (s != nullptr) ? bytes(s, strlen(s)) : value(0); }
+
+	TraceHash& view(const ImageView& v) { return value(v.image).value(v.index).value(v.count).value(v.type); }
+
+	//Never 0, which means no hash
+	uint64 get() const { return (m_hash != 0) ? m_hash : 1; }
+};
+
+static void writeVarint(std::vector<uint8>& out, uint64 v)
+{
+	while (v >= 0x80)
+	{
+		out.push_back((uint8)(v | 0x80));
+		v >>= 7;
+	}
+
+	out.push_back((uint8)v);
+}
+
+static bool readVarint(std::istream& in, uint64& v)
+{
+	v = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		const int c = in.get();
+
+		if (c == EOF)
+			return false;
+
+		v |= (uint64)(c & 0x7F) << shift;
+
+		if ((c & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Trace context
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TraceState;
+
+class TraceContext : public RenderContext
+{
+private:
+
+	TraceState* m_state;
+
+	//Block passed to beginStagedUpdates(), used to hash staged updates
+	const uint8* m_staging = nullptr;
+
+public:
+
+	TraceContext(TraceState* state) : m_state(state) {}
+
+	void resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index) override;
+	void resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size) override;
+	void resourceCopy(ResourceHandle src, ResourceHandle dest) override;
+	void imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index) override;
+
+	void clearColourTarget(TargetHandle pass, uint32 colour) override;
+	void clearDepthTarget(TargetHandle pass, float depth) override;
+
+	void draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params) override;
+
+	void bindTarget(TargetHandle outputs) override;
+	void bindPipeline(PipelineHandle pipeline) override;
+	void bindResourceSet(ResourceSetHandle inputs) override;
+	void drawBound(const DrawParams& params) override;
+	void multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed) override;
+
+	void dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params) override;
+	void dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset) override;
+
+	void batchMarker(uint64 sortKey) override;
+
+	bool beginStagedUpdates(const void* memory, uint32 size) override;
+	void resourceUpdateStaged(ResourceHandle rsc, uint32 offset, uint32 size) override;
+	void endStagedUpdates() override;
+
+	void finish() override;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TraceState
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	RenderDevice* device;
+	RenderContext* deviceContext;
+	TraceContext context;
+
+	std::ofstream file;
+	std::ostream* out;
+
+	Clock::time_point start;
+
+	//Encoded records which haven't been written, device calls may be made from any thread
+	std::mutex lock;
+	std::vector<uint8> encoded;
+	uint64 lastTime = 0;
+
+	//Bytes passed to resourceUpdate() for each resource
+	std::unordered_map<ResourceHandle, uint32> updateSizes;
+
+	TraceState(RenderDevice* device, std::ostream* out) :
+		device(device),
+		deviceContext(device->context()),
+		context(this),
+		out(out),
+		start(Clock::now())
+	{
+		writeHeader();
+	}
+
+	TraceState(RenderDevice* device, const Path& path) :
+		device(device),
+		deviceContext(device->context()),
+		context(this),
+		file(path.str(), std::ios::binary),
+		out(&file),
+		start(Clock::now())
+	{
+		if (!file)
+		{
+			tswarn("unable to open trace file \"%\"", path.str());
+		}
+
+		writeHeader();
+	}
+
+	void writeHeader()
+	{
+		const uint32 header[] = { TRACE_SIGNATURE, TRACE_VERSION };
+		out->write((const char*)header, sizeof(header));
+	}
+
+	uint64 now() const
+	{
+		return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+	}
+
+	/*
+		Records are encoded as the call, a mask of the fields present, varint time delta and duration,
+		then each present field as a varint (the hash is stored as 8 raw bytes)
+	*/
+	void write(const TraceRecord& r)
+	{
+		std::lock_guard<std::mutex> lk(lock);
+
+		uint8 fields = 0;
+		fields |= (r.object != 0) ? FIELD_OBJECT : 0;
+		fields |= (r.other != 0) ? FIELD_OTHER : 0;
+		fields |= (r.value0 != 0) ? FIELD_VALUE0 : 0;
+		fields |= (r.value1 != 0) ? FIELD_VALUE1 : 0;
+		fields |= (r.hash != 0) ? FIELD_HASH : 0;
+
+		encoded.push_back((uint8)r.call);
+		encoded.push_back(fields);
+
+		//Records from other threads may be written out of order
+		const uint64 time = (r.time > lastTime) ? r.time : lastTime;
+		writeVarint(encoded, time - lastTime);
+		writeVarint(encoded, r.duration);
+		lastTime = time;
+
+		if (fields & FIELD_OBJECT) writeVarint(encoded, r.object);
+		if (fields & FIELD_OTHER) writeVarint(encoded, r.other);
+		if (fields & FIELD_VALUE0) writeVarint(encoded, r.value0);
+		if (fields & FIELD_VALUE1) writeVarint(encoded, r.value1);
+
+		if (fields & FIELD_HASH)
+		{
+			encoded.insert(encoded.end(), (const uint8*)&r.hash, (const uint8*)&r.hash + sizeof(r.hash));
+		}
+	}
+
+	void flush()
+	{
+		std::lock_guard<std::mutex> lk(lock);
+
+		out->write((const char*)encoded.data(), encoded.size());
+		out->flush();
+		encoded.clear();
+	}
+
+	uint32 updateSize(ResourceHandle rsc)
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		auto it = updateSizes.find(rsc);
+		return (it != updateSizes.end()) ? it->second : 0;
+	}
+
+	void setUpdateSize(ResourceHandle rsc, uint32 size)
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		updateSizes[rsc] = size;
+	}
+
+	void eraseUpdateSize(ResourceHandle rsc)
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		updateSizes.erase(rsc);
+	}
+};
+
+struct TraceDevice::State : public TraceState
+{
+	State(RenderDevice* device, std::ostream* out) : TraceState(device, out) {}
+	State(RenderDevice* device, const Path& path) : TraceState(device, path) {}
+};
+
+/*
+	Times a call and records it when the scope ends
+*/
+class TraceScope
+{
+private:
+
+	TraceState* m_state;
+	TraceRecord m_record;
+
+public:
+
+	TraceScope(TraceState* state, TraceCall call) :
+		m_state(state)
+	{
+		m_record.call = call;
+		m_record.time = state->now();
+	}
+
+	~TraceScope()
+	{
+		m_record.duration = m_state->now() - m_record.time;
+		m_state->write(m_record);
+	}
+
+	TraceRecord* operator->() { return &m_record; }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Context calls
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceContext::resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index)
+{
+	TraceScope s(m_state, TraceCall::UPDATE);
+	s->object = (uintptr)rsc;
+	s->value0 = index;
+	s->value1 = m_state->updateSize(rsc);
+	s->hash = (memory != nullptr) ? TraceHash().bytes(memory, (size_t)s->value1).get() : 0;
+
+	m_state->deviceContext->resourceUpdate(rsc, memory, index);
+}
+
+void TraceContext::resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size)
+{
+	TraceScope s(m_state, TraceCall::UPDATE_RANGE);
+	s->object = (uintptr)rsc;
+	s->value0 = offset;
+	s->value1 = size;
+	s->hash = (memory != nullptr) ? TraceHash().bytes(memory, size).get() : 0;
+
+	m_state->deviceContext->resourceUpdateRange(rsc, memory, offset, size);
+}
+
+void TraceContext::resourceCopy(ResourceHandle src, ResourceHandle dest)
+{
+	TraceScope s(m_state, TraceCall::COPY);
+	s->object = (uintptr)src;
+	s->other = (uintptr)dest;
+
+	m_state->deviceContext->resourceCopy(src, dest);
+}
+
+void TraceContext::imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index)
+{
+	TraceScope s(m_state, TraceCall::RESOLVE);
+	s->object = (uintptr)src;
+	s->other = (uintptr)dest;
+	s->value0 = index;
+
+	m_state->deviceContext->imageResolve(src, dest, index);
+}
+
+void TraceContext::clearColourTarget(TargetHandle pass, uint32 colour)
+{
+	TraceScope s(m_state, TraceCall::CLEAR_COLOUR);
+	s->object = (uintptr)pass;
+	s->value0 = colour;
+
+	m_state->deviceContext->clearColourTarget(pass, colour);
+}
+
+void TraceContext::clearDepthTarget(TargetHandle pass, float depth)
+{
+	TraceScope s(m_state, TraceCall::CLEAR_DEPTH);
+	s->object = (uintptr)pass;
+	memcpy(&s->value0, &depth, sizeof(depth));
+
+	m_state->deviceContext->clearDepthTarget(pass, depth);
+}
+
+void TraceContext::draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params)
+{
+	//The draw state is recorded as: object = pipeline, other = resource set, hash = target
+	TraceScope s(m_state, TraceCall::DRAW);
+	s->object = (uintptr)pipeline;
+	s->other = (uintptr)inputs;
+	s->value0 = params.count;
+	s->value1 = params.instances;
+	s->hash = (uintptr)outputs;
+
+	m_state->deviceContext->draw(outputs, pipeline, inputs, params);
+}
+
+void TraceContext::bindTarget(TargetHandle outputs)
+{
+	TraceScope s(m_state, TraceCall::BIND_TARGET);
+	s->object = (uintptr)outputs;
+
+	m_state->deviceContext->bindTarget(outputs);
+}
+
+void TraceContext::bindPipeline(PipelineHandle pipeline)
+{
+	TraceScope s(m_state, TraceCall::BIND_PIPELINE);
+	s->object = (uintptr)pipeline;
+
+	m_state->deviceContext->bindPipeline(pipeline);
+}
+
+void TraceContext::bindResourceSet(ResourceSetHandle inputs)
+{
+	TraceScope s(m_state, TraceCall::BIND_RESOURCES);
+	s->object = (uintptr)inputs;
+
+	m_state->deviceContext->bindResourceSet(inputs);
+}
+
+void TraceContext::drawBound(const DrawParams& params)
+{
+	TraceScope s(m_state, TraceCall::DRAW_BOUND);
+	s->value0 = params.count;
+	s->value1 = params.instances;
+
+	m_state->deviceContext->drawBound(params);
+}
+
+void TraceContext::multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed)
+{
+	TraceScope s(m_state, indexed ? TraceCall::DRAW_INDEXED_INDIRECT : TraceCall::DRAW_INDIRECT);
+	s->object = (uintptr)args;
+	s->value0 = offset;
+	s->value1 = count;
+
+	m_state->deviceContext->multiDrawIndirect(args, offset, count, indexed);
+}
+
+void TraceContext::dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params)
+{
+	TraceScope s(m_state, TraceCall::DISPATCH);
+	s->object = (uintptr)pipeline;
+	s->other = (uintptr)inputs;
+	s->value0 = (uint64)params.groupsX * params.groupsY * params.groupsZ;
+	s->value1 = params.constantOffset;
+
+	m_state->deviceContext->dispatch(pipeline, inputs, params);
+}
+
+void TraceContext::dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset)
+{
+	TraceScope s(m_state, TraceCall::DISPATCH_INDIRECT);
+	s->object = (uintptr)pipeline;
+	s->other = (uintptr)inputs;
+	s->value0 = offset;
+	s->value1 = (uintptr)args;
+
+	m_state->deviceContext->dispatchIndirect(pipeline, inputs, args, offset);
+}
+
+void TraceContext::batchMarker(uint64 sortKey)
+{
+	TraceScope s(m_state, TraceCall::BATCH_MARKER);
+	s->value0 = sortKey;
+
+	m_state->deviceContext->batchMarker(sortKey);
+}
+
+bool TraceContext::beginStagedUpdates(const void* memory, uint32 size)
+{
+	TraceScope s(m_state, TraceCall::BEGIN_STAGED);
+	s->value0 = size;
+
+	const bool staged = m_state->deviceContext->beginStagedUpdates(memory, size);
+	s->value1 = staged ? 1 : 0;
+	m_staging = staged ? (const uint8*)memory : nullptr;
+
+	return staged;
+}
+
+void TraceContext::resourceUpdateStaged(ResourceHandle rsc, uint32 offset, uint32 size)
+{
+	TraceScope s(m_state, TraceCall::UPDATE_STAGED);
+	s->object = (uintptr)rsc;
+	s->value0 = offset;
+	s->value1 = size;
+	s->hash = (m_staging != nullptr) ? TraceHash().bytes(m_staging + offset, size).get() : 0;
+
+	m_state->deviceContext->resourceUpdateStaged(rsc, offset, size);
+}
+
+void TraceContext::endStagedUpdates()
+{
+	TraceScope s(m_state, TraceCall::END_STAGED);
+
+	m_state->deviceContext->endStagedUpdates();
+	m_staging = nullptr;
+}
+
+void TraceContext::finish()
+{
+	TraceScope s(m_state, TraceCall::FINISH);
+
+	m_state->deviceContext->finish();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Trace device
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+TraceDevice::TraceDevice(RenderDevice* device, std::ostream& out) :
+	pState(new State(device, &out))
+{
+	tsassert(device);
+}
+
+TraceDevice::TraceDevice(RenderDevice* device, const Path& file) :
+	pState(new State(device, file))
+{
+	tsassert(device);
+}
+
+TraceDevice::~TraceDevice()
+{
+	if (pState)
+	{
+		pState->flush();
+	}
+
+	pState.reset();
+}
+
+RenderDevice* TraceDevice::getDevice() const
+{
+	return pState->device;
+}
+
+bool TraceDevice::isOpen() const
+{
+	return pState->out->good();
+}
+
+void TraceDevice::flush()
+{
+	pState->flush();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+RenderContext* TraceDevice::context() { return &pState->context; }
+
+void TraceDevice::commit()
+{
+	{
+		TraceScope s(pState.get(), TraceCall::COMMIT);
+		pState->device->commit();
+	}
+
+	flush();
+}
+
+void TraceDevice::setDisplayConfiguration(const DisplayConfig& displayCfg)
+{
+	TraceScope s(pState.get(), TraceCall::SET_DISPLAY);
+	s->value0 = displayCfg.resolutionW;
+	s->value1 = displayCfg.resolutionH;
+
+	pState->device->setDisplayConfiguration(displayCfg);
+}
+
+void TraceDevice::getDisplayConfiguration(DisplayConfig& displayCfg) { pState->device->getDisplayConfiguration(displayCfg); }
+ResourceHandle TraceDevice::getDisplayTarget() { return pState->device->getDisplayTarget(); }
+
+void TraceDevice::queryStats(RenderStats& stats) { pState->device->queryStats(stats); }
+void TraceDevice::queryInfo(RenderDeviceInfo& info) { pState->device->queryInfo(info); }
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Create/destroy
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Objects are created on the wrapped device but owned through this device,
+	so destroy calls are recorded
+*/
+
+RPtr<ResourceHandle> TraceDevice::createEmptyResource(ResourceHandle recycle)
+{
+	TraceScope s(pState.get(), TraceCall::CREATE_EMPTY_RESOURCE);
+	s->other = (uintptr)recycle;
+
+	RPtr<ResourceHandle> rsc = pState->device->createEmptyResource(recycle);
+	s->object = (uintptr)rsc.handle();
+
+	return RPtr<ResourceHandle>(this, rsc.release());
+}
+
+RPtr<ResourceHandle> TraceDevice::createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle)
+{
+	TraceScope s(pState.get(), TraceCall::CREATE_BUFFER);
+	s->other = (uintptr)recycle;
+	s->value0 = info.size;
+	s->value1 = (uint64)info.type;
+
+	//The hash is of the initial contents, so a following update with the same contents is repeated
+	if (data.memory != nullptr)
+		s->hash = TraceHash().bytes(data.memory, info.size).get();
+
+	RPtr<ResourceHandle> rsc = pState->device->createResourceBuffer(data, info, recycle);
+	s->object = (uintptr)rsc.handle();
+
+	if (rsc)
+		pState->setUpdateSize(rsc.handle(), info.size);
+
+	return RPtr<ResourceHandle>(this, rsc.release());
+}
+
+RPtr<ResourceHandle> TraceDevice::createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle)
+{
+	TraceScope s(pState.get(), TraceCall::CREATE_IMAGE);
+	s->other = (uintptr)recycle;
+	s->value0 = ((uint64)info.width << 32) | info.height;
+	s->value1 = ((uint64)info.format << 32) | info.length;
+
+	RPtr<ResourceHandle> rsc = pState->device->createResourceImage(data, info, recycle);
+	s->object = (uintptr)rsc.handle();
+
+	if (rsc)
+		pState->setUpdateSize(rsc.handle(), info.width * info.height * imageFormatSize(info.format));
+
+	return RPtr<ResourceHandle>(this, rsc.release());
+}
+
+RPtr<ResourceSetHandle> TraceDevice::createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle)
+{
+	TraceScope s(pState.get(), TraceCall::CREATE_RESOURCE_SET);
+	s->other = (uintptr)recycle;
+
+	TraceHash h;
+	for (uint32 i = 0; i < info.resourceCount; i++)
+		h.view(info.resources[i]);
+	for (uint32 i = 0; i < info.constantBuffersCount; i++)
+		h.value(info.constantBuffers[i]);
+	for (uint32 i = 0; i < info.vertexBufferCount; i++)
+		h.value(info.vertexBuffers[i].buffer).value(info.vertexBuffers[i].stride).value(info.vertexBuffers[i].offset);
+	h.value(info.indexBuffer);
+	h.value(info.dynamicConstants);
+	for (uint32 i = 0; i < info.storageBufferCount; i++)
+		h.value(info.storageBuffers[i]);
+	for (uint32 i = 0; i < info.storageImageCount; i++)
+		h.view(info.storageImages[i]);
+	s->hash = h.get();
+
+	RPtr<ResourceSetHandle> set = pState->device->createResourceSet(info, recycle);
+	s->object = (uintptr)set.handle();
+
+	return RPtr<ResourceSetHandle>(this, set.release());
+}
+
+RPtr<ShaderHandle> TraceDevice::createShader(const ShaderCreateInfo& info)
+{
+	TraceScope s(pState.get(), TraceCall::CREATE_SHADER);
+
+	TraceHash h;
+	for (const ShaderBytecode& stage : info.stages)
+		h.value(stage.size).bytes(stage.bytecode, (stage.bytecode != nullptr) ? stage.size : 0);
+	s->hash = h.get();
+
+	RPtr<ShaderHandle> shader = pState->device->createShader(info);
+	s->object = (uintptr)shader.handle();
+
+	return RPtr<ShaderHandle>(this, shader.release());
+}
+
+RPtr<PipelineHandle> TraceDevice::createPipeline(ShaderHandle program, const PipelineCreateInfo& info)
+{
+	TraceScope s(pState.get(), TraceCall::CREATE_PIPELINE);
+	s->other = (uintptr)program;
+
+	TraceHash h;
+	h.value(program);
+	h.value(info.raster.enableScissor).value(info.raster.cullMode).value(info.raster.fillMode);
+	h.value(info.depth.enableDepth).value(info.depth.enableStencil);
+	h.value(info.blend.enable);
+	h.value(info.topology);
+
+	for (size_t i = 0; i < info.samplerCount; i++)
+	{
+		const SamplerState& ss = info.samplers[i];
+		h.value(ss.addressU).value(ss.addressV).value(ss.addressW).value(ss.filtering).value(ss.anisotropy);
+	}
+
+	for (size_t i = 0; i < info.vertexAttributeCount; i++)
+	{
+		const VertexAttribute& attrib = info.vertexAttributeList[i];
+		h.value(attrib.bufferSlot).string(attrib.semanticName).value(attrib.byteOffset).value(attrib.type).value(attrib.channel);
+	}
+
+	s->hash = h.get();
+
+	RPtr<PipelineHandle> pipeline = pState->device->createPipeline(program, info);
+	s->object = (uintptr)pipeline.handle();
+
+	return RPtr<PipelineHandle>(this, pipeline.release());
+}
+
+RPtr<TargetHandle> TraceDevice::createTarget(const TargetCreateInfo& info, TargetHandle recycle)
+{
+	TraceScope s(pState.get(), TraceCall::CREATE_TARGET);
+	s->other = (uintptr)recycle;
+
+	TraceHash h;
+	for (uint32 i = 0; i < info.attachmentCount; i++)
+		h.view(info.attachments[i]);
+	h.view(info.depth);
+	h.value(info.viewport.x).value(info.viewport.y).value(info.viewport.w).value(info.viewport.h);
+	h.value(info.scissor.x).value(info.scissor.y).value(info.scissor.w).value(info.scissor.h);
+	s->hash = h.get();
+
+	RPtr<TargetHandle> target = pState->device->createTarget(info, recycle);
+	s->object = (uintptr)target.handle();
+
+	return RPtr<TargetHandle>(this, target.release());
+}
+
+void TraceDevice::destroy(ResourceHandle rsc)
+{
+	TraceScope s(pState.get(), TraceCall::DESTROY_RESOURCE);
+	s->object = (uintptr)rsc;
+
+	pState->eraseUpdateSize(rsc);
+	pState->device->destroy(rsc);
+}
+
+void TraceDevice::destroy(ResourceSetHandle set)
+{
+	TraceScope s(pState.get(), TraceCall::DESTROY_RESOURCE_SET);
+	s->object = (uintptr)set;
+
+	pState->device->destroy(set);
+}
+
+void TraceDevice::destroy(ShaderHandle shader)
+{
+	TraceScope s(pState.get(), TraceCall::DESTROY_SHADER);
+	s->object = (uintptr)shader;
+
+	pState->device->destroy(shader);
+}
+
+void TraceDevice::destroy(PipelineHandle pipeline)
+{
+	TraceScope s(pState.get(), TraceCall::DESTROY_PIPELINE);
+	s->object = (uintptr)pipeline;
+
+	pState->device->destroy(pipeline);
+}
+
+void TraceDevice::destroy(TargetHandle target)
+{
+	TraceScope s(pState.get(), TraceCall::DESTROY_TARGET);
+	s->object = (uintptr)target;
+
+	pState->device->destroy(target);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Reader
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TraceReader::load(std::istream& in)
+{
+	m_records.clear();
+
+	uint32 header[2] = {};
+	in.read((char*)header, sizeof(header));
+
+	if (!in || header[0] != TRACE_SIGNATURE || header[1] != TRACE_VERSION)
+	{
+		tswarn("invalid trace header (version %)", header[1]);
+		return false;
+	}
+
+	uint64 time = 0;
+	uint32 frame = 0;
+
+	while (true)
+	{
+		const int call = in.get();
+		const int fields = in.get();
+
+		if (call == EOF)
+			break;
+
+		TraceRecord r;
+		uint64 delta = 0;
+
+		bool ok = (fields != EOF) && (call < (int)TraceCall::MAX_CALLS);
+		ok = ok && readVarint(in, delta) && readVarint(in, r.duration);
+		ok = ok && (!(fields & FIELD_OBJECT) || readVarint(in, r.object));
+		ok = ok && (!(fields & FIELD_OTHER) || readVarint(in, r.other));
+		ok = ok && (!(fields & FIELD_VALUE0) || readVarint(in, r.value0));
+		ok = ok && (!(fields & FIELD_VALUE1) || readVarint(in, r.value1));
+		ok = ok && (!(fields & FIELD_HASH) || in.read((char*)&r.hash, sizeof(r.hash)));
+
+		if (!ok)
+		{
+			tswarn("trace is truncated after % records", m_records.size());
+			return false;
+		}
+
+		time += delta;
+		r.call = (TraceCall)call;
+		r.time = time;
+		r.frame = frame;
+
+		if (r.call == TraceCall::COMMIT)
+			frame++;
+
+		m_records.push_back(r);
+	}
+
+	return true;
+}
+
+bool TraceReader::load(const Path& file)
+{
+	std::ifstream in(file.str(), std::ios::binary);
+
+	if (!in)
+	{
+		tswarn("unable to open trace file \"%\"", file.str());
+		return false;
+	}
+
+	return load(in);
+}
+
+TraceReader::Summary TraceReader::summarize() const
+{
+	Summary summary;
+
+	//Hashes of live objects and how many objects have each hash
+	std::unordered_map<uint64, uint64> objectHashes[(size_t)TraceCall::MAX_CALLS];
+	std::unordered_map<uint64, uint32> liveHashes[(size_t)TraceCall::MAX_CALLS];
+
+	//Last contents written to each (resource, subresource or offset)
+	std::map<std::pair<uint64, uint64>, uint64> contents;
+
+	uint64 boundTarget = 0;
+	uint64 boundPipeline = 0;
+	uint64 boundInputs = 0;
+
+	uint64 frameStart = 0;
+	bool frameStarted = false;
+
+	auto create = [&](TraceCall type, const TraceRecord& r, uint32& duplicates) {
+		if (r.object == 0 || r.hash == 0)
+			return;
+
+		if (liveHashes[(size_t)type][r.hash]++ > 0)
+			duplicates++;
+
+		objectHashes[(size_t)type][r.object] = r.hash;
+	};
+
+	auto destroy = [&](TraceCall type, const TraceRecord& r) {
+		auto it = objectHashes[(size_t)type].find(r.object);
+
+		if (it != objectHashes[(size_t)type].end())
+		{
+			liveHashes[(size_t)type][it->second]--;
+			objectHashes[(size_t)type].erase(it);
+		}
+	};
+
+	auto update = [&](const TraceRecord& r, uint64 key) {
+		if (r.hash == 0)
+			return;
+
+		uint64& last = contents[std::make_pair(r.object, key)];
+
+		if (last == r.hash)
+		{
+			summary.repeatedUpdates++;
+			summary.repeatedUpdateBytes += r.value1;
+		}
+
+		last = r.hash;
+	};
+
+	auto bind = [&](uint64& bound, uint64 object) {
+		if (bound == object)
+			summary.redundantBinds++;
+		bound = object;
+	};
+
+	for (const TraceRecord& r : m_records)
+	{
+		CallStats& stats = summary.calls[(size_t)r.call];
+		stats.count++;
+		stats.totalTime += r.duration;
+		stats.maxTime = (r.duration > stats.maxTime) ? r.duration : stats.maxTime;
+
+		/*
+			Frames
+		*/
+		if (summary.frames.size() <= r.frame)
+			summary.frames.resize(r.frame + 1);
+
+		FrameStats& frame = summary.frames[r.frame];
+		frame.calls++;
+		frame.callTime += r.duration;
+
+		if (!frameStarted)
+		{
+			frameStart = r.time;
+			frameStarted = true;
+		}
+
+		switch (r.call)
+		{
+		case TraceCall::COMMIT:
+			frame.wallTime = r.time + r.duration - frameStart;
+			frameStarted = false;
+			break;
+
+		/*
+			Duplicate objects
+		*/
+		case TraceCall::CREATE_PIPELINE:
+			create(r.call, r, summary.duplicatePipelines);
+			break;
+		case TraceCall::CREATE_SHADER:
+			create(r.call, r, summary.duplicateShaders);
+			break;
+		case TraceCall::CREATE_RESOURCE_SET:
+			//Recycled sets replace their previous description
+			destroy(r.call, r);
+			create(r.call, r, summary.duplicateResourceSets);
+			break;
+		case TraceCall::DESTROY_PIPELINE:
+			destroy(TraceCall::CREATE_PIPELINE, r);
+			break;
+		case TraceCall::DESTROY_SHADER:
+			destroy(TraceCall::CREATE_SHADER, r);
+			break;
+		case TraceCall::DESTROY_RESOURCE_SET:
+			destroy(TraceCall::CREATE_RESOURCE_SET, r);
+			break;
+
+		/*
+			Repeated updates
+		*/
+		case TraceCall::CREATE_BUFFER:
+			//Initial contents
+			contents.erase(std::make_pair(r.object, (uint64)0));
+			if (r.hash != 0)
+				contents[std::make_pair(r.object, (uint64)0)] = r.hash;
+			break;
+		case TraceCall::UPDATE:
+			update(r, r.value0);
+			break;
+		case TraceCall::UPDATE_STAGED:
+			//Staged updates write the whole buffer
+			update(r, 0);
+			break;
+		case TraceCall::UPDATE_RANGE:
+			update(r, ((uint64)1 << 63) | r.value0);
+			break;
+		case TraceCall::DESTROY_RESOURCE:
+			contents.erase(contents.lower_bound(std::make_pair(r.object, (uint64)0)), contents.upper_bound(std::make_pair(r.object, ~(uint64)0)));
+			break;
+
+		/*
+			Redundant binds
+		*/
+		case TraceCall::BIND_TARGET:
+			bind(boundTarget, r.object);
+			boundInputs = 0;
+			break;
+		case TraceCall::BIND_PIPELINE:
+			bind(boundPipeline, r.object);
+			break;
+		case TraceCall::BIND_RESOURCES:
+			bind(boundInputs, r.object);
+			break;
+		case TraceCall::DRAW:
+			if (r.hash != boundTarget)
+				boundInputs = 0;
+			bind(boundTarget, r.hash);
+			bind(boundPipeline, r.object);
+			bind(boundInputs, r.other);
+			frame.draws++;
+			break;
+		case TraceCall::DRAW_BOUND:
+			frame.draws++;
+			break;
+		case TraceCall::DRAW_INDIRECT:
+		case TraceCall::DRAW_INDEXED_INDIRECT:
+			frame.draws += (uint32)r.value1;
+			break;
+		case TraceCall::DISPATCH:
+		case TraceCall::DISPATCH_INDIRECT:
+			frame.dispatches++;
+			break;
+		case TraceCall::FINISH:
+			boundTarget = 0;
+			boundPipeline = 0;
+			boundInputs = 0;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return summary;
+}
+
+const char* TraceReader::callName(TraceCall call)
+{
+	static const char* names[] =
+	{
+		"commit",
+		"setDisplayConfiguration",
+		"createEmptyResource",
+		"createResourceBuffer",
+		"createResourceImage",
+		"createResourceSet",
+		"createShader",
+		"createPipeline",
+		"createTarget",
+		"destroy(Resource)",
+		"destroy(ResourceSet)",
+		"destroy(Shader)",
+		"destroy(Pipeline)",
+		"destroy(Target)",
+		"resourceUpdate",
+		"resourceUpdateRange",
+		"resourceUpdateStaged",
+		"beginStagedUpdates",
+		"endStagedUpdates",
+		"resourceCopy",
+		"imageResolve",
+		"clearColourTarget",
+		"clearDepthTarget",
+		"draw",
+		"bindTarget",
+		"bindPipeline",
+		"bindResourceSet",
+		"drawBound",
+		"batchMarker",
+		"finish",
+		"drawIndirect",
+		"drawIndexedIndirect",
+		"dispatch",
+		"dispatchIndirect",
+	};
+
+	static_assert(sizeof(names) / sizeof(names[0]) == (size_t)TraceCall::MAX_CALLS, "trace call names must match TraceCall");
+
+	return ((size_t)call < (size_t)TraceCall::MAX_CALLS) ? names[(size_t)call] : "unknown";
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,258 @@
+/*
+	Asynchronous resource creation source
+*/
+
+#include <tsgraphics/AsyncCreate.h>
+
+#include <tscore/debug/assert.h>
+#include <tscore/debug/log.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ts;
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	State
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+//A submission of buffers or images
+struct AsyncJob
+{
+	uint64 fence = 0;
+	bool images = false;
+
+	std::vector<ResourceHandle> handles;
+
+	std::vector<BufferResourceInfo> bufferInfo;
+	std::vector<ImageResourceInfo> imageInfo;
+
+	//Buffer data, or the subresource data of every image
+	std::vector<ResourceData> data;
+	//Index of the first subresource of each image, -1 if the image has no data
+	std::vector<int64> imageData;
+};
+
+struct AsyncResourceCreator::State
+{
+	RenderDevice* device;
+
+	std::thread worker;
+
+	mutable std::mutex lock;
+	std::condition_variable submitted;
+	std::condition_variable completed;
+
+	std::deque<AsyncJob> jobs;
+	uint64 lastFence = 0;
+	uint64 completedFence = 0;
+	uint32 failed = 0;
+	bool stop = false;
+
+	State(RenderDevice* device) :
+		device(device)
+	{
+		worker = std::thread(&State::run, this);
+	}
+
+	~State()
+	{
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			stop = true;
+		}
+
+		submitted.notify_all();
+		worker.join();
+	}
+
+	uint64 submit(AsyncJob&& job)
+	{
+		uint64 fence = 0;
+
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			job.fence = fence = ++lastFence;
+			jobs.push_back(std::move(job));
+		}
+
+		submitted.notify_one();
+
+		return fence;
+	}
+
+	//Worker procedure, runs until stopped and every job is complete
+	void run()
+	{
+		while (true)
+		{
+			AsyncJob job;
+
+			{
+				std::unique_lock<std::mutex> lk(lock);
+				submitted.wait(lk, [this]() { return stop || !jobs.empty(); });
+
+				if (jobs.empty())
+					return;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			const uint32 errors = execute(job);
+
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				completedFence = job.fence;
+				failed += errors;
+			}
+
+			completed.notify_all();
+		}
+	}
+
+	uint32 execute(const AsyncJob& job)
+	{
+		uint32 errors = 0;
+
+		for (size_t i = 0; i < job.handles.size(); i++)
+		{
+			//The handle could not be reserved
+			if (job.handles[i] == ResourceHandle())
+			{
+				errors++;
+				continue;
+			}
+
+			//Mips are generated on the device's immediate context, which can't be used from the worker
+			if (job.images && job.imageInfo[i].useMips)
+			{
+				tswarn("image % uses generated mips and can't be created asynchronously", i);
+				errors++;
+				continue;
+			}
+
+			RPtr<ResourceHandle> rsc;
+
+			if (job.images)
+			{
+				const ResourceData* data = (job.imageData[i] >= 0) ? &job.data[(size_t)job.imageData[i]] : nullptr;
+				rsc = device->createResourceImage(data, job.imageInfo[i], job.handles[i]);
+			}
+			else
+			{
+				rsc = device->createResourceBuffer(job.data[i], job.bufferInfo[i], job.handles[i]);
+			}
+
+			if (!rsc)
+			{
+				tswarn("unable to create resource % asynchronously", i);
+				errors++;
+			}
+
+			//The resource is created in place of it's reserved handle, which is owned by the caller
+			tsassert(!rsc || rsc.handle() == job.handles[i]);
+			rsc.release();
+		}
+
+		return errors;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Creator
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+AsyncResourceCreator::AsyncResourceCreator(RenderDevice* device) :
+	pState(new State(device))
+{
+	tsassert(device);
+}
+
+AsyncResourceCreator::~AsyncResourceCreator()
+{
+	//Completes every pending job before the worker stops
+	pState.reset();
+}
+
+RenderDevice* AsyncResourceCreator::getDevice() const
+{
+	return pState->device;
+}
+
+uint64 AsyncResourceCreator::createResourceBuffers(const ResourceData* data, const BufferResourceInfo* info, uint32 count, RPtr<ResourceHandle>* out)
+{
+	AsyncJob job;
+	job.images = false;
+	job.handles.resize(count);
+	job.bufferInfo.assign(info, info + count);
+	job.data.assign(data, data + count);
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		out[i] = pState->device->createEmptyResource();
+		job.handles[i] = out[i].handle();
+	}
+
+	return pState->submit(std::move(job));
+}
+
+uint64 AsyncResourceCreator::createResourceImages(const ResourceData* const* data, const ImageResourceInfo* info, uint32 count, RPtr<ResourceHandle>* out)
+{
+	AsyncJob job;
+	job.images = true;
+	job.handles.resize(count);
+	job.imageInfo.assign(info, info + count);
+	job.imageData.resize(count, -1);
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		//Each image has a subresource for every array element
+		if (data != nullptr && data[i] != nullptr)
+		{
+			job.imageData[i] = (int64)job.data.size();
+			job.data.insert(job.data.end(), data[i], data[i] + info[i].length);
+		}
+
+		out[i] = pState->device->createEmptyResource();
+		job.handles[i] = out[i].handle();
+	}
+
+	return pState->submit(std::move(job));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64 AsyncResourceCreator::getCompletedFence() const
+{
+	std::lock_guard<std::mutex> lk(pState->lock);
+	return pState->completedFence;
+}
+
+void AsyncResourceCreator::wait(uint64 fence)
+{
+	std::unique_lock<std::mutex> lk(pState->lock);
+
+	//Fences which haven't been submitted would never complete
+	if (fence > pState->lastFence)
+		fence = pState->lastFence;
+
+	pState->completed.wait(lk, [&]() { return pState->completedFence >= fence; });
+}
+
+void AsyncResourceCreator::waitAll()
+{
+	std::unique_lock<std::mutex> lk(pState->lock);
+	pState->completed.wait(lk, [&]() { return pState->completedFence >= pState->lastFence; });
+}
+
+uint32 AsyncResourceCreator::getFailedCount() const
+{
+	std::lock_guard<std::mutex> lk(pState->lock);
+	return pState->failed;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
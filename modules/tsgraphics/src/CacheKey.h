@@ -0,0 +1,173 @@
+/*
+	Cache key header:
+
+	Helpers shared by the caches which look up device objects by the contents of their descriptors.
+
+	- CacheKey encodes a descriptor into bytes which are hashed and compared.
+	- CacheTable maps keys to weak references of cached objects,
+	  entries of released objects are pruned as the table grows.
+*/
+
+#pragma once
+
+#include <tscore/types.h>
+#include <tscore/refcount.h>
+
+#include <string>
+#include <unordered_map>
+
+namespace ts
+{
+	namespace internal
+	{
+		const uint64 FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+		const uint64 FNV_PRIME = 0x100000001b3ull;
+
+		//FNV-1a, a hash can be continued by passing the hash of the preceding bytes
+		inline uint64 fnv1a(const void* data, size_t size, uint64 hash = FNV_OFFSET_BASIS)
+		{
+			const uint8* p = (const uint8*)data;
+
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= p[i];
+				hash *= FNV_PRIME;
+			}
+
+			return hash;
+		}
+
+		/*
+			Encodes every field of a descriptor individually so padding isn't included,
+			strings are encoded by value rather than by pointer
+		*/
+		class CacheKey
+		{
+		private:
+
+			std::string m_bytes;
+
+		public:
+
+			template<typename type_t>
+			CacheKey& value(type_t v)
+			{
+				m_bytes.append((const char*)&v, sizeof(v));
+				return *this;
+			}
+
+			//Null terminated
+			CacheKey& string(const char* s)
+			{
+				if (s != nullptr)
+					m_bytes.append(s);
+				m_bytes.push_back('\0');
+				return *this;
+			}
+
+			const std::string& bytes() const { return m_bytes; }
+
+			uint64 hash() const { return fnv1a(m_bytes.data(), m_bytes.size()); }
+		};
+
+		/*
+			Table of cached objects, the table holds weak references so objects are destroyed when their last user releases them
+		*/
+		template<typename object_t>
+		class CacheTable
+		{
+		private:
+
+			struct Entry
+			{
+				std::string key;
+				WeakRef<object_t> object;
+				//Identifies the entry of an object which is modified in place
+				const object_t* ptr;
+			};
+
+			std::unordered_multimap<uint64, Entry> m_entries;
+
+			//Entries are pruned when the table grows past this size
+			size_t m_pruneSize = 16;
+
+		public:
+
+			//Find a live object with the given key
+			IntrusivePtr<object_t> find(const CacheKey& key, uint64 h) const
+			{
+				//Equal hashes are confirmed by comparing keys
+				auto range = m_entries.equal_range(h);
+
+				for (auto it = range.first; it != range.second; ++it)
+				{
+					if (it->second.key == key.bytes())
+					{
+						if (IntrusivePtr<object_t> object = it->second.object.lock())
+							return object;
+					}
+				}
+
+				return IntrusivePtr<object_t>();
+			}
+
+			void insert(const CacheKey& key, uint64 h, const IntrusivePtr<object_t>& object)
+			{
+				//Released objects are pruned as the table grows
+				if (m_entries.size() >= m_pruneSize)
+				{
+					prune();
+				}
+
+				Entry entry;
+				entry.key = key.bytes();
+				entry.object = WeakRef<object_t>(object);
+				entry.ptr = object.get();
+				m_entries.emplace(h, std::move(entry));
+			}
+
+			//Remove the entry of a live object which was inserted with the given hash
+			void remove(const object_t* object, uint64 h)
+			{
+				auto range = m_entries.equal_range(h);
+
+				for (auto it = range.first; it != range.second; ++it)
+				{
+					if (it->second.ptr == object && !it->second.object.expired())
+					{
+						m_entries.erase(it);
+						return;
+					}
+				}
+			}
+
+			//Remove entries of released objects
+			void prune()
+			{
+				for (auto it = m_entries.begin(); it != m_entries.end();)
+				{
+					if (it->second.object.expired())
+						it = m_entries.erase(it);
+					else
+						++it;
+				}
+
+				m_pruneSize = 2 * m_entries.size() + 16;
+			}
+
+			//Number of entries with live objects
+			uint32 live() const
+			{
+				uint32 count = 0;
+
+				for (const auto& e : m_entries)
+				{
+					if (!e.second.object.expired())
+						count++;
+				}
+
+				return count;
+			}
+		};
+	}
+}
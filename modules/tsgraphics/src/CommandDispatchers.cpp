@@ -17,6 +17,53 @@ void CommandDraw::dispatch(RenderContext* context, CommandPtr data)
 	context->draw(outputs, pipeline, inputs, params);
 }
 
+static DrawMode instancedMode(DrawMode mode)
+{
+	switch (mode)
+	{
+		case DrawMode::VERTEX: return DrawMode::INSTANCED;
+		case DrawMode::INDEXED: return DrawMode::INDEXEDINSTANCED;
+		//Already instanced
+		case DrawMode::INSTANCED:
+		case DrawMode::INDEXEDINSTANCED:
+		default:
+			return mode;
+	}
+}
+
+void CommandDrawInstance::dispatch(RenderContext* context, CommandPtr data)
+{
+	dispatchInstances(context, data, 1);
+}
+
+void CommandDrawInstance::dispatchInstances(RenderContext* context, CommandPtr instances, uint32 count) const
+{
+	DrawParams instanced(params);
+	instanced.mode = instancedMode(params.mode);
+	instanced.instances = count;
+
+	context->resourceUpdateRange(instanceBuffer, instances, 0, instanceStride * count);
+	context->draw(outputs, pipeline, inputs, instanced);
+}
+
+void CommandDrawIndirect::dispatch(RenderContext* context, CommandPtr data)
+{
+	context->bindTarget(outputs);
+	context->bindPipeline(pipeline);
+	context->bindResourceSet(inputs);
+	context->multiDrawIndirect(args, offset, count, indexed);
+}
+
+void CommandDispatch::dispatch(RenderContext* context, CommandPtr data)
+{
+	context->dispatch(pipeline, inputs, params);
+}
+
+void CommandDispatchIndirect::dispatch(RenderContext* context, CommandPtr data)
+{
+	context->dispatchIndirect(pipeline, inputs, args, offset);
+}
+
 void CommandBufferUpdate::dispatch(RenderContext* context, CommandPtr data)
 {
 	context->resourceUpdate(this->hBuf, data);
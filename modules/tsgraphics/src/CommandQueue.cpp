@@ -1,16 +1,25 @@
 /*
 	Graphics Command Queue source
-
-	todo: improve memory allocation and overall efficiency
 */
 
 #include <tsgraphics/CommandQueue.h>
 #include <tscore/alloc/Linear.h>
 #include <tscore/debug/assert.h>
+#include <tscore/radixsort.h>
 
 #include <tsgraphics/Driver.h>
 
 #include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(__GNUC__) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#endif
 
 using namespace std;
 using namespace ts;
@@ -22,29 +31,57 @@ namespace ts
 	/*
 		Command Batch struct:
 
-		Implemented as a linked list of command structs.
+		Implemented as a list of command structs,
+		the tail is tracked so attaching a command is constant time.
+
+		Commands are allocated linearly so the commands of a batch that is recorded in one go
+		are laid out contiguously, executing a batch is then a forward scan through memory.
+
+		A batch is not a separate contiguous block, the commands of several batches recorded at the same time
+		are interleaved in the recorder's memory. The link of each command skips over the commands of other batches,
+		a batch can't be walked by offsets alone without copying it's commands when it is submitted.
 	*/
 	struct CommandBatch
 	{
 		Command* first;
+		Command* last;
+		uint32 count;
 	};
 
 	/*
 		Command struct:
 
 		An individual link in a Command Batch,
-		Contains a callable command dispatcher.
+		Contains the command type followed by the dispatcher data and any extra data.
+		The header is padded to the allocation alignment so dispatchers holding aligned members (eg. Vector) are not misaligned.
 	*/
-	struct Command
+	struct alignas(16) Command
 	{
 		Command* next;
-		CommandDelegate dispatchFunc;
-		uint32 dispatchSize = 0;
-		uint32 extraSize = 0;
+		CommandTypeID type;
+		uint16 reserved;
+		uint32 dispatchSize;
+		uint32 extraSize;
 	};
 
 }
 
+//Dispatchers are stored directly after the header so the header size must preserve the block alignment
+static_assert(alignof(Command) >= alignof(Vector), "Command header must keep dispatchers with vector members aligned");
+static_assert(sizeof(Command) % alignof(Command) == 0, "Dispatcher offset must be aligned");
+
+//Get a pointer to the dispatcher stored after a command header
+static inline void* commandDispatcherData(const Command* cmd)
+{
+	return (uint8*)cmd + sizeof(Command);
+}
+
+//Get a pointer to the extra data stored after a command dispatcher
+static inline const void* commandExtraData(const Command* cmd)
+{
+	return (const uint8*)commandDispatcherData(cmd) + cmd->dispatchSize;
+}
+
 /*
 	Commmand Batch Key struct:
 
@@ -62,9 +99,63 @@ struct SBatchKey
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
-// CommandQueue implementation
+// Command type table
 ///////////////////////////////////////////////////////////////////////////////////////////////
-class CommandQueue::Queue : private LinearAllocator
+
+//Dispatch function of each command type, entry 0 is an invalid command
+static CommandDispatchFunc s_commandTable[MAX_COMMAND_TYPES] = { nullptr };
+static uint32 s_commandTypeCount = 1;
+
+//Ids of registered command types by name, command types are registered once per module
+static mutex s_commandTypeLock;
+
+static unordered_map<string, CommandTypeID>& commandTypeIds()
+{
+	static unordered_map<string, CommandTypeID> s_ids;
+	return s_ids;
+}
+
+CommandTypeID ts::registerCommandType(const char* name, CommandDispatchFunc func)
+{
+	tsassert(name != nullptr);
+	tsassert(func != nullptr);
+
+	lock_guard<mutex> lk(s_commandTypeLock);
+
+	//Another module may have already registered this type, it's dispatch function is the same
+	auto it = commandTypeIds().find(name);
+	if (it != commandTypeIds().end())
+		return it->second;
+
+	const uint32 id = s_commandTypeCount++;
+	tsassert(id < MAX_COMMAND_TYPES);
+
+	s_commandTable[id] = func;
+	commandTypeIds()[name] = (CommandTypeID)id;
+
+	return (CommandTypeID)id;
+}
+
+//Start fetching a command into the cache
+static inline void prefetchCommand(const Command* cmd)
+{
+#if defined(__GNUC__)
+	__builtin_prefetch(cmd);
+#elif defined(_M_IX86) || defined(_M_X64)
+	_mm_prefetch((const char*)cmd, _MM_HINT_T0);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+// CommandShard implementation
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Command Shard class:
+
+	Memory owned by a single Command Recorder, holds the recorder's batch keys and commands.
+*/
+class ts::CommandShard : private LinearAllocator
 {
 private:
 
@@ -74,18 +165,26 @@ private:
 
 	size_t m_batchCapacity;
 
-public:
+	//Buffer updates recorded into the shard, updates are only staged if some were recorded
+	uint32 m_updates = 0;
+	uint32 m_updateBytes = 0;
 
-	Queue(uint32 numBatches) :
-		m_batchCapacity(numBatches)
+	static size_t computeCapacity(uint32 numBatches)
 	{
-		size_t initialCapacity = 0;
-		initialCapacity += numBatches * sizeof(Command) * 16;	// Each batch has enough capacity for 16 commands
-		initialCapacity += 2 * 1024 * 1024;						// 2MBs for extra memory
+		size_t capacity = 0;
+		capacity += numBatches * sizeof(SBatchKey);			// Sort keys
+		capacity += numBatches * sizeof(CommandBatch);		// Batch headers
+		capacity += numBatches * 64 * 16;					// Each batch has enough capacity for 16 commands of 64 bytes
+		capacity += 2 * 1024 * 1024;						// 2MBs for extra memory
+		return capacity;
+	}
 
-		//Call base constructor
-		this->LinearAllocator::LinearAllocator(initialCapacity);
+public:
 
+	CommandShard(uint32 numBatches) :
+		LinearAllocator(computeCapacity(numBatches)),
+		m_batchCapacity(numBatches)
+	{
 		//Reserve chunk for key allocator
 		this->alloc(numBatches * sizeof(SBatchKey));
 		
@@ -93,11 +192,6 @@ public:
 		m_batchAllocator.resize(this->getTop(), this->getEnd());
 	}
 
-	~Queue()
-	{
-		//this->LinearAllocator::~LinearAllocator();
-	}
-
 	//Allocate Command Batch from allocator
 	CommandBatch* allocBatch()
 	{
@@ -107,7 +201,7 @@ public:
 	//Allocate Command from allocator
 	Command* allocCommand(size_t cmdSize)
 	{
-		return (Command*)m_batchAllocator.alloc(cmdSize);
+		return (Command*)m_batchAllocator.alloc(cmdSize, alignof(Command));
 	}
 
 	//Allocate a Command Batch Key pair
@@ -147,11 +241,258 @@ public:
 		return m_batchCapacity;
 	}
 
+	//Get number of bytes used by keys and batches
+	size_t getUsedSize() const
+	{
+		auto keys = (size_t)m_keyAllocator.getTop() - (size_t)m_keyAllocator.getStart();
+		auto batches = (size_t)m_batchAllocator.getTop() - (size_t)m_batchAllocator.getStart();
+		return keys + batches;
+	}
+
+	//Get total number of bytes
+	size_t getCapacity() const
+	{
+		return (size_t)this->getEnd() - (size_t)this->getStart();
+	}
+
+	//Count a recorded buffer update
+	void addUpdate(uint32 size)
+	{
+		m_updates++;
+		m_updateBytes += size;
+	}
+
+	uint32 getUpdateCount() const { return m_updates; }
+	uint32 getUpdateBytes() const { return m_updateBytes; }
+
 	//Reset key and batch allocators
 	void reset()
 	{
 		m_keyAllocator.reset();
 		m_batchAllocator.reset();
+
+		m_updates = 0;
+		m_updateBytes = 0;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+// CommandQueue implementation
+///////////////////////////////////////////////////////////////////////////////////////////////
+class CommandQueue::Queue
+{
+private:
+
+	//Shard of the queue itself, followed by the shards of each additional recorder
+	std::vector<std::unique_ptr<CommandShard>> m_shards;
+	std::vector<CommandRecorder> m_recorders;
+
+	//Keys gathered from every shard and scratch memory for sorting them, reused every frame
+	std::vector<SBatchKey> m_gatheredKeys;
+	std::vector<SBatchKey> m_scratchKeys;
+	RadixSortScratch m_sortCounts;
+
+	//Filters redundant state changes while flushing
+	CachedRenderContext m_cachedContext;
+
+	//Draw merging
+	uint32 m_maxMergeRun = 256;
+	CommandQueue::MergeStats m_mergeStats;
+	std::vector<uint8> m_instanceScratch;
+
+	//Statistics of the last flush and duration of the last sort
+	CommandQueue::Stats m_stats;
+	double m_sortTime = 0.0;
+	uint64 m_allocatedPeak = 0;
+
+	//Update staging
+	bool m_enableStaging = true;
+	CommandQueue::StagingStats m_stagingStats;
+	std::vector<uint8> m_staging;
+	uint32 m_stagingTop = 0;
+
+	//Static batches submitted for the next flush and memory for merging their keys with the queue's keys
+	std::vector<const StaticCommandBatch::Batch*> m_statics;
+	std::vector<SBatchKey> m_spliceKeys;
+	std::vector<SBatchKey> m_spliceScratch;
+
+	//Range of keys to execute
+	SBatchKey* m_begin = nullptr;
+	SBatchKey* m_end = nullptr;
+	bool m_gathered = false;
+	bool m_sorted = false;
+
+public:
+
+	Queue(uint32 numBatches, uint32 numRecorders)
+	{
+		for (uint32 i = 0; i < numRecorders + 1; i++)
+		{
+			m_shards.emplace_back(new CommandShard(numBatches));
+		}
+
+		for (uint32 i = 0; i < numRecorders; i++)
+		{
+			m_recorders.push_back(CommandRecorder(m_shards[i + 1].get()));
+		}
+
+		if (numRecorders > 0)
+		{
+			m_gatheredKeys.resize(m_shards.size() * numBatches);
+		}
+
+		m_scratchKeys.resize(m_shards.size() * numBatches);
+	}
+
+	CommandShard* mainShard()
+	{
+		return m_shards[0].get();
+	}
+
+	CommandRecorder* getRecorder(uint32 index)
+	{
+		return (index < m_recorders.size()) ? &m_recorders[index] : nullptr;
+	}
+
+	uint32 getRecorderCount() const
+	{
+		return (uint32)m_recorders.size();
+	}
+
+	/*
+		Gather the keys of every shard into a single list,
+		if only one shard has been recorded into then it's keys are used in place.
+	*/
+	void gather()
+	{
+		if (m_gathered)
+			return;
+
+		CommandShard* recorded = nullptr;
+		size_t recordedCount = 0;
+
+		for (auto& shard : m_shards)
+		{
+			if (shard->getKeyCount() > 0)
+			{
+				recorded = shard.get();
+				recordedCount++;
+			}
+		}
+
+		if (recordedCount <= 1)
+		{
+			m_begin = (recorded != nullptr) ? recorded->beginKey() : nullptr;
+			m_end = (recorded != nullptr) ? recorded->endKey() : nullptr;
+		}
+		else
+		{
+			SBatchKey* top = m_gatheredKeys.data();
+
+			for (auto& shard : m_shards)
+			{
+				const size_t count = shard->getKeyCount();
+				memcpy(top, shard->beginKey(), count * sizeof(SBatchKey));
+				top += count;
+			}
+
+			m_begin = m_gatheredKeys.data();
+			m_end = top;
+		}
+
+		m_gathered = true;
+	}
+
+	//Get pointer to first key
+	SBatchKey* beginKey()
+	{
+		return m_begin;
+	}
+
+	//Get pointer to end key
+	SBatchKey* endKey()
+	{
+		return m_end;
+	}
+
+	//Get pointer to key scratch buffer, large enough to hold every key
+	SBatchKey* scratchKeys()
+	{
+		return m_scratchKeys.data();
+	}
+
+	//Get the chunk counts of the parallel sort
+	RadixSortScratch& sortCounts()
+	{
+		return m_sortCounts;
+	}
+
+	//Get the context batches are executed on
+	CachedRenderContext* cachedContext(RenderContext* context)
+	{
+		m_cachedContext.setContext(context);
+		m_cachedContext.resetStats();
+		return &m_cachedContext;
+	}
+
+	const CachedRenderContext& getCachedContext() const
+	{
+		return m_cachedContext;
+	}
+
+	uint32 getMaxMergeRun() const { return m_maxMergeRun; }
+	void setMaxMergeRun(uint32 maxRun) { m_maxMergeRun = maxRun; }
+
+	const CommandQueue::MergeStats& getMergeStats() const { return m_mergeStats; }
+	void resetMergeStats() { m_mergeStats = CommandQueue::MergeStats(); }
+
+	//Execute a run of mergeable draws as one instanced draw
+	void executeRun(RenderContext* context, const SBatchKey* run, uint32 count);
+
+	bool getUpdateStaging() const { return m_enableStaging; }
+	void setUpdateStaging(bool enable) { m_enableStaging = enable; }
+
+	const CommandQueue::StagingStats& getStagingStats() const { return m_stagingStats; }
+
+	/*
+		Reset the statistics and gather buffer updates into the staging block,
+		returns false if updates must be applied individually.
+	*/
+	bool prepare(RenderContext* context);
+
+	const CommandQueue::Stats& getStats() const { return m_stats; }
+	void setSortTime(double ms) { m_sortTime = ms; }
+
+	//Commands are counted by type while executing, the totals are summed once the flush has finished
+	void finishStats(double executeTime);
+
+	//Execute the dispatchers of each command in a batch
+	void executeBatch(RenderContext* context, const CommandBatch* batch);
+
+	//Execute a batch whose buffer updates were staged
+	void executeStagedBatch(RenderContext* context, const CommandBatch* batch);
+
+	void setSorted() { m_sorted = true; }
+
+	void addStatic(const StaticCommandBatch::Batch* batch) { m_statics.push_back(batch); }
+
+	//Merge the keys of submitted static batches into the range of keys to execute
+	void splice();
+
+	//Reset every shard
+	void reset()
+	{
+		for (auto& shard : m_shards)
+		{
+			shard->reset();
+		}
+
+		m_statics.clear();
+
+		m_begin = nullptr;
+		m_end = nullptr;
+		m_gathered = false;
+		m_sorted = false;
 	}
 };
 
@@ -159,88 +500,745 @@ public:
 // ctor/dtor
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
-CommandQueue::CommandQueue(uint32 numBatches) :
-	pQueue(new CommandQueue::Queue(numBatches))
-{}
+CommandQueue::CommandQueue(uint32 numBatches, uint32 numRecorders) :
+	pQueue(new CommandQueue::Queue(numBatches, numRecorders))
+{
+	//The queue records into it's own shard
+	CommandRecorder rec(pQueue->mainShard());
+	swapShard(rec);
+}
 
 CommandQueue::~CommandQueue()
 {
 	pQueue.reset();
 }
 
+CommandRecorder* CommandQueue::getRecorder(uint32 index)
+{
+	tsassert(pQueue);
+	return pQueue->getRecorder(index);
+}
+
+uint32 CommandQueue::getRecorderCount() const
+{
+	tsassert(pQueue);
+	return pQueue->getRecorderCount();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+// StaticCommandBatch implementation
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+class StaticCommandBatch::Batch
+{
+public:
+
+	enum DependencyType
+	{
+		DEPENDENCY_RESOURCE,
+		DEPENDENCY_RESOURCE_SET,
+		DEPENDENCY_PIPELINE,
+		DEPENDENCY_TARGET,
+	};
+
+private:
+
+	struct Dependency
+	{
+		DependencyType type;
+		uintptr handle;
+	};
+
+	CommandShard m_shard;
+	std::vector<SBatchKey> m_scratchKeys;
+	std::vector<Dependency> m_dependencies;
+
+	bool m_recording = false;
+	bool m_valid = false;
+
+public:
+
+	Batch(uint32 numBatches) :
+		m_shard(numBatches),
+		m_scratchKeys(numBatches)
+	{}
+
+	CommandShard* shard() { return &m_shard; }
+
+	void begin()
+	{
+		m_shard.reset();
+		m_dependencies.clear();
+		m_recording = true;
+		m_valid = false;
+	}
+
+	void end()
+	{
+		tsassert(m_recording);
+
+		radixSort(
+			m_shard.beginKey(),
+			m_shard.endKey(),
+			m_scratchKeys.data(),
+			[](const SBatchKey& pair) { return pair.key; }
+		);
+
+		m_recording = false;
+		m_valid = true;
+	}
+
+	void addDependency(DependencyType type, uintptr handle)
+	{
+		for (const Dependency& d : m_dependencies)
+		{
+			if (d.type == type && d.handle == handle)
+				return;
+		}
+
+		m_dependencies.push_back({ type, handle });
+	}
+
+	bool invalidate(DependencyType type, uintptr handle)
+	{
+		if (!m_valid)
+			return false;
+
+		for (const Dependency& d : m_dependencies)
+		{
+			if (d.type == type && d.handle == handle)
+			{
+				m_valid = false;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void invalidate() { m_valid = false; }
+	bool isValid() const { return m_valid; }
+
+	//Sorted keys, only usable while the batch is valid
+	const SBatchKey* beginKey() const { return const_cast<CommandShard&>(m_shard).beginKey(); }
+	const SBatchKey* endKey() const { return const_cast<CommandShard&>(m_shard).endKey(); }
+	size_t getKeyCount() const { return m_shard.getKeyCount(); }
+
+	const CommandShard& shard() const { return m_shard; }
+};
+
+StaticCommandBatch::StaticCommandBatch(uint32 numBatches) :
+	pBatch(new StaticCommandBatch::Batch(numBatches))
+{
+	CommandRecorder rec(pBatch->shard());
+	swapShard(rec);
+}
+
+StaticCommandBatch::~StaticCommandBatch()
+{
+	pBatch.reset();
+}
+
+void StaticCommandBatch::begin()
+{
+	tsassert(pBatch);
+	pBatch->begin();
+}
+
+void StaticCommandBatch::end()
+{
+	tsassert(pBatch);
+	pBatch->end();
+}
+
+void StaticCommandBatch::addDependency(ResourceHandle rsc) { tsassert(pBatch); pBatch->addDependency(Batch::DEPENDENCY_RESOURCE, (uintptr)rsc); }
+void StaticCommandBatch::addDependency(ResourceSetHandle set) { tsassert(pBatch); pBatch->addDependency(Batch::DEPENDENCY_RESOURCE_SET, (uintptr)set); }
+void StaticCommandBatch::addDependency(PipelineHandle pipeline) { tsassert(pBatch); pBatch->addDependency(Batch::DEPENDENCY_PIPELINE, (uintptr)pipeline); }
+void StaticCommandBatch::addDependency(TargetHandle target) { tsassert(pBatch); pBatch->addDependency(Batch::DEPENDENCY_TARGET, (uintptr)target); }
+
+bool StaticCommandBatch::invalidate(ResourceHandle rsc) { tsassert(pBatch); return pBatch->invalidate(Batch::DEPENDENCY_RESOURCE, (uintptr)rsc); }
+bool StaticCommandBatch::invalidate(ResourceSetHandle set) { tsassert(pBatch); return pBatch->invalidate(Batch::DEPENDENCY_RESOURCE_SET, (uintptr)set); }
+bool StaticCommandBatch::invalidate(PipelineHandle pipeline) { tsassert(pBatch); return pBatch->invalidate(Batch::DEPENDENCY_PIPELINE, (uintptr)pipeline); }
+bool StaticCommandBatch::invalidate(TargetHandle target) { tsassert(pBatch); return pBatch->invalidate(Batch::DEPENDENCY_TARGET, (uintptr)target); }
+
+void StaticCommandBatch::invalidate()
+{
+	tsassert(pBatch);
+	pBatch->invalidate();
+}
+
+bool StaticCommandBatch::isValid() const
+{
+	return pBatch && pBatch->isValid();
+}
+
+uint32 StaticCommandBatch::getBatchCount() const
+{
+	tsassert(pBatch);
+	return (uint32)pBatch->getKeyCount();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+void CommandQueue::submitStatic(const StaticCommandBatch* batch)
+{
+	tsassert(pQueue);
+	tsassert(batch && batch->isValid());
+
+	pQueue->addStatic(batch->pBatch.get());
+}
+
+void CommandQueue::Queue::splice()
+{
+	m_stats.staticBatches = 0;
+
+	if (m_statics.empty())
+		return;
+
+	size_t total = (size_t)(m_end - m_begin);
+
+	for (const StaticCommandBatch::Batch* batch : m_statics)
+	{
+		total += batch->getKeyCount();
+		m_stats.staticBatches += (uint32)batch->getKeyCount();
+	}
+
+	if (m_spliceKeys.size() < total)
+	{
+		m_spliceKeys.resize(total);
+		m_spliceScratch.resize(total);
+	}
+
+	SBatchKey* dest = m_spliceKeys.data();
+	SBatchKey* top = dest;
+
+	if (m_sorted)
+	{
+		//Merge each static batch in turn, on equal keys the queue's batches come first
+		top = std::copy(m_begin, m_end, dest);
+
+		for (const StaticCommandBatch::Batch* batch : m_statics)
+		{
+			SBatchKey* other = (dest == m_spliceKeys.data()) ? m_spliceScratch.data() : m_spliceKeys.data();
+
+			top = std::merge(
+				dest, top,
+				batch->beginKey(), batch->endKey(),
+				other,
+				[](const SBatchKey& a, const SBatchKey& b) { return a.key < b.key; }
+			);
+
+			dest = other;
+		}
+	}
+	else
+	{
+		//Unsorted queues execute static batches after their own batches
+		top = std::copy(m_begin, m_end, dest);
+
+		for (const StaticCommandBatch::Batch* batch : m_statics)
+		{
+			top = std::copy(batch->beginKey(), batch->endKey(), top);
+		}
+	}
+
+	m_begin = dest;
+	m_end = top;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////
 //	Batch methods
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
 //Allocate an empty command batch
-CommandBatch* CommandQueue::createBatch()
+CommandBatch* CommandRecorder::createBatch()
 {
-	tsassert(pQueue);
+	tsassert(m_shard);
 
-	CommandBatch* b = pQueue->allocBatch();
+	CommandBatch* b = m_shard->allocBatch();
 	tsassert(b != nullptr);
 
-	tsassert(pQueue->getKeyCount() < pQueue->getBatchCapacity());
+	tsassert(m_shard->getKeyCount() < m_shard->getBatchCapacity());
 
-	memset(b, 0, sizeof(CommandBatch));
+	b->first = nullptr;
+	b->last = nullptr;
+	b->count = 0;
 
 	return b;
 }
 
 //Enqueue a command batch
-void CommandQueue::submitBatch(SortKey key, CommandBatch* batch)
+void CommandRecorder::submitBatch(SortKey key, CommandBatch* batch)
 {
-	tsassert(pQueue);
+	tsassert(m_shard);
 
-	pQueue->addKey(key, batch);
+	m_shard->addKey(key, batch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
-//Execute the dispatcher of a given command
-static void executeCommand(RenderContext* context, Command* cmd)
+void CommandQueue::Queue::executeBatch(RenderContext* context, const CommandBatch* batch)
 {
-	if (cmd != nullptr)
+	const CommandTypeID updateType = CommandType<CommandBufferUpdate>::id();
+
+	for (const Command* cmd = batch->first; cmd != nullptr; cmd = cmd->next)
 	{
-		//Get pointer to extra parameters
-		const byte* extra = (const byte*)cmd + sizeof(Command) + cmd->dispatchSize;
+		//Start fetching the next command while this one executes
+		prefetchCommand(cmd->next);
 
-		//Call dispatcher
-		cmd->dispatchFunc(context, (const void*)extra);
+		m_stats.commandsByType[cmd->type]++;
 
-		//Recursively dispatch the next command
-		executeCommand(context, cmd->next);
+		if (cmd->type == updateType)
+			m_stats.uploadBytes += cmd->extraSize;
+
+		//Call dispatcher with pointers to the dispatcher and extra parameters
+		s_commandTable[cmd->type](context, commandDispatcherData(cmd), commandExtraData(cmd));
+	}
+}
+
+void CommandQueue::Queue::finishStats(double executeTime)
+{
+	m_stats.commands = 0;
+
+	for (uint32 count : m_stats.commandsByType)
+		m_stats.commands += count;
+
+	m_stats.updates = m_stats.commandsByType[CommandType<CommandBufferUpdate>::id()];
+	m_stats.executeTime = executeTime;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Draw merging
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+//Get a pointer to the dispatcher of a command
+template<typename dispatcher_t>
+static const dispatcher_t* commandDispatcher(const Command* cmd)
+{
+	return (const dispatcher_t*)commandDispatcherData(cmd);
+}
+
+//Get a pointer to the extra data of a command
+static const uint8* commandExtra(const Command* cmd)
+{
+	return (const uint8*)commandExtraData(cmd);
+}
+
+//Get the draw of a batch if the batch can be merged with other batches
+static const CommandDrawInstance* mergeableDraw(const CommandBatch* batch)
+{
+	const Command* cmd = batch->first;
+
+	if (batch->count != 1 || cmd->type != CommandType<CommandDrawInstance>::id())
+		return nullptr;
+
+	const CommandDrawInstance* draw = commandDispatcher<CommandDrawInstance>(cmd);
+
+	//Draws which are already instanced are not merged
+	if (draw->params.instances > 1 || cmd->extraSize < draw->instanceStride)
+		return nullptr;
+
+	return draw;
+}
+
+//Draws can be merged if everything except their per-instance data is the same
+static bool canMerge(const CommandDrawInstance& a, const CommandDrawInstance& b)
+{
+	return
+		a.outputs == b.outputs &&
+		a.pipeline == b.pipeline &&
+		a.inputs == b.inputs &&
+		a.instanceBuffer == b.instanceBuffer &&
+		a.instanceStride == b.instanceStride &&
+		a.params.start == b.params.start &&
+		a.params.count == b.params.count &&
+		a.params.vbase == b.params.vbase &&
+		a.params.constantOffset == b.params.constantOffset &&
+		a.params.mode == b.params.mode;
+}
+
+void CommandQueue::Queue::executeRun(RenderContext* context, const SBatchKey* run, uint32 count)
+{
+	const CommandDrawInstance* draw = mergeableDraw(run[0].batch);
+	const uint32 stride = draw->instanceStride;
+
+	//Pack per-instance data of each draw together
+	m_instanceScratch.resize((size_t)stride * count);
+	uint8* dest = m_instanceScratch.data();
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		memcpy(dest, commandExtra(run[i].batch->first), stride);
+		dest += stride;
+	}
+
+	draw->dispatchInstances(context, m_instanceScratch.data(), count);
+
+	m_stats.commandsByType[CommandType<CommandDrawInstance>::id()] += count;
+
+	m_mergeStats.runs++;
+	m_mergeStats.mergedDraws += count;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Update staging
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+static uint32 alignStaging(uint32 offset)
+{
+	const uint32 a = RenderContext::STAGING_ALIGNMENT;
+	return (offset + a - 1) & ~(a - 1);
+}
+
+bool CommandQueue::Queue::prepare(RenderContext* context)
+{
+	CommandQueue::Stats& stats = m_stats;
+	const uint32 staticBatches = stats.staticBatches;
+
+	stats = CommandQueue::Stats();
+	stats.staticBatches = staticBatches;
+	stats.sortTime = m_sortTime;
+	m_sortTime = 0.0;
+
+	//Recorder memory
+	for (auto& shard : m_shards)
+	{
+		stats.allocatedBytes += shard->getUsedSize();
+		stats.allocatorCapacity += shard->getCapacity();
+	}
+
+	m_allocatedPeak = std::max(m_allocatedPeak, stats.allocatedBytes);
+	stats.allocatedPeak = m_allocatedPeak;
+
+	stats.batches = (uint32)(m_end - m_begin);
+
+	m_stagingStats = CommandQueue::StagingStats();
+	m_stagingTop = 0;
+
+	if (!m_enableStaging)
+		return false;
+
+	//Recorders count the updates recorded into them, so queues without updates aren't walked
+	uint32 recordedUpdates = 0;
+	uint32 recordedBytes = 0;
+
+	for (auto& shard : m_shards)
+	{
+		recordedUpdates += shard->getUpdateCount();
+		recordedBytes += shard->getUpdateBytes();
+	}
+
+	for (const StaticCommandBatch::Batch* batch : m_statics)
+	{
+		recordedUpdates += batch->shard().getUpdateCount();
+		recordedBytes += batch->shard().getUpdateBytes();
+	}
+
+	if (recordedUpdates == 0)
+		return false;
+
+	//Enough for every recorded update to be padded to the staging alignment
+	const uint32 capacity = alignStaging(recordedBytes + recordedUpdates * (RenderContext::STAGING_ALIGNMENT - 1));
+
+	if (m_staging.size() < capacity)
+		m_staging.resize(capacity);
+
+	const CommandTypeID updateType = CommandType<CommandBufferUpdate>::id();
+
+	//Copy the contents of each update in the order they execute
+	uint32 top = 0;
+	uint32 updates = 0;
+
+	for (const SBatchKey* pair = m_begin; pair != m_end; pair++)
+	{
+		for (const Command* cmd = pair->batch->first; cmd != nullptr; cmd = cmd->next)
+		{
+			if (cmd->type == updateType)
+			{
+				top = alignStaging(top);
+				memcpy(m_staging.data() + top, commandExtra(cmd), cmd->extraSize);
+				top += cmd->extraSize;
+				updates++;
+			}
+		}
+	}
+
+	//Recorded updates may not have been submitted
+	if (updates == 0)
+		return false;
+
+	const uint32 size = alignStaging(top);
+
+	if (!context->beginStagedUpdates(m_staging.data(), size))
+		return false;
+
+	m_stagingStats.updates = updates;
+	m_stagingStats.size = size;
+
+	//The whole block is uploaded including the padding between updates
+	stats.uploadBytes = size;
+
+	return true;
+}
+
+void CommandQueue::Queue::executeStagedBatch(RenderContext* context, const CommandBatch* batch)
+{
+	const CommandTypeID updateType = CommandType<CommandBufferUpdate>::id();
+
+	for (const Command* cmd = batch->first; cmd != nullptr; cmd = cmd->next)
+	{
+		m_stats.commandsByType[cmd->type]++;
+
+		if (cmd->type == updateType)
+		{
+			//Updates are executed in the same order they were staged
+			m_stagingTop = alignStaging(m_stagingTop);
+			context->resourceUpdateStaged(commandDispatcher<CommandBufferUpdate>(cmd)->hBuf, m_stagingTop, cmd->extraSize);
+			m_stagingTop += cmd->extraSize;
+		}
+		else
+		{
+			s_commandTable[cmd->type](context, commandDispatcherData(cmd), commandExtraData(cmd));
+		}
 	}
 }
 
+void CommandQueue::setUpdateStaging(bool enable)
+{
+	tsassert(pQueue);
+	pQueue->setUpdateStaging(enable);
+}
+
+bool CommandQueue::getUpdateStaging() const
+{
+	tsassert(pQueue);
+	return pQueue->getUpdateStaging();
+}
+
+CommandQueue::StagingStats CommandQueue::getStagingStats() const
+{
+	tsassert(pQueue);
+	return pQueue->getStagingStats();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+void CommandQueue::setMaxMergeRun(uint32 maxRun)
+{
+	tsassert(pQueue);
+	pQueue->setMaxMergeRun(maxRun);
+}
+
+uint32 CommandQueue::getMaxMergeRun() const
+{
+	tsassert(pQueue);
+	return pQueue->getMaxMergeRun();
+}
+
+CommandQueue::MergeStats CommandQueue::getMergeStats() const
+{
+	tsassert(pQueue);
+	return pQueue->getMergeStats();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
 //Execute queued command batches
 void CommandQueue::flush(RenderContext* context)
 {
 	tsassert(pQueue);
 
+	const auto start = chrono::high_resolution_clock::now();
+
+	//Batches which have not been sorted are executed in the order they were submitted
+	pQueue->gather();
+	pQueue->splice();
+
+	//State is tracked for the duration of the flush only, handles may be recreated between flushes
+	RenderContext* cached = pQueue->cachedContext(context);
+
+	pQueue->resetMergeStats();
+	const uint32 maxRun = pQueue->getMaxMergeRun();
+
+	//Upload the contents of every buffer update at once
+	const bool staged = pQueue->prepare(cached);
+
+	SBatchKey* end = pQueue->endKey();
+
 	//For each key
-	for (SBatchKey* pair = pQueue->beginKey(); pair != pQueue->endKey(); pair++)
+	for (SBatchKey* pair = pQueue->beginKey(); pair != end;)
 	{
-		//Get pointer to command batch
-		CommandBatch* batch = pair->batch;
-		//Recursively execute each command in this batch
-		executeCommand(context, batch->first);
+		cached->batchMarker(pair->key);
+
+		const CommandDrawInstance* draw = (maxRun > 1) ? mergeableDraw(pair->batch) : nullptr;
+
+		if (draw != nullptr)
+		{
+			//Find the run of compatible draws which follow this one
+			const uint32 limit = std::min(maxRun, draw->instanceCapacity);
+			SBatchKey* runEnd = pair + 1;
+
+			while (runEnd != end && (uint32)(runEnd - pair) < limit)
+			{
+				const CommandDrawInstance* next = mergeableDraw(runEnd->batch);
+
+				if (next == nullptr || !canMerge(*draw, *next))
+					break;
+
+				runEnd++;
+			}
+
+			const uint32 count = (uint32)(runEnd - pair);
+
+			if (count > 1)
+			{
+				pQueue->executeRun(cached, pair, count);
+				pair = runEnd;
+				continue;
+			}
+		}
+
+		//Execute each command in this batch
+		if (staged)
+			pQueue->executeStagedBatch(cached, pair->batch);
+		else
+			pQueue->executeBatch(cached, pair->batch);
+
+		pair++;
+	}
+
+	if (staged)
+	{
+		cached->endStagedUpdates();
 	}
 
+	pQueue->finishStats(chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count());
+
 	//Clear allocators
 	pQueue->reset();
 }
 
+CommandQueue::Stats CommandQueue::getStats() const
+{
+	tsassert(pQueue);
+
+	CommandQueue::Stats stats = pQueue->getStats();
+	stats.merge = pQueue->getMergeStats();
+	return stats;
+}
+
+CommandQueue::Stats& CommandQueue::Stats::operator+=(const Stats& rhs)
+{
+	batches += rhs.batches;
+	staticBatches += rhs.staticBatches;
+	commands += rhs.commands;
+
+	for (uint32 i = 0; i < MAX_COMMAND_TYPES; i++)
+		commandsByType[i] += rhs.commandsByType[i];
+
+	allocatedBytes += rhs.allocatedBytes;
+	allocatedPeak += rhs.allocatedPeak;
+	allocatorCapacity += rhs.allocatorCapacity;
+
+	merge.runs += rhs.merge.runs;
+	merge.mergedDraws += rhs.merge.mergedDraws;
+
+	updates += rhs.updates;
+	uploadBytes += rhs.uploadBytes;
+
+	sortTime += rhs.sortTime;
+	executeTime += rhs.executeTime;
+
+	return *this;
+}
+
+CommandQueue::Stats& CommandQueue::Stats::operator/=(uint32 samples)
+{
+	tsassert(samples > 0);
+
+	auto divide = [=](auto& value) {
+		value = (value + samples / 2) / samples;
+	};
+
+	divide(batches);
+	divide(staticBatches);
+	divide(commands);
+
+	for (uint32 i = 0; i < MAX_COMMAND_TYPES; i++)
+		divide(commandsByType[i]);
+
+	divide(allocatedBytes);
+	divide(allocatedPeak);
+	divide(allocatorCapacity);
+
+	divide(merge.runs);
+	divide(merge.mergedDraws);
+
+	divide(updates);
+	divide(uploadBytes);
+
+	sortTime /= samples;
+	executeTime /= samples;
+
+	return *this;
+}
+
+CachedRenderContext::Stats CommandQueue::getStateStats() const
+{
+	tsassert(pQueue);
+	return pQueue->getCachedContext().getStats();
+}
+
+//Number of keys each task must sort before sorting is split across a thread pool
+static const size_t s_parallelSortThreshold = 16384;
+
+static uint64 getSortKey(const SBatchKey& pair)
+{
+	return pair.key;
+}
+
 //Sort queued command batches based on their keys
 void CommandQueue::sort()
 {
 	tsassert(pQueue);
 
-	//Sort array of Command Batch Key pairs
-	std::sort(
+	const auto start = chrono::high_resolution_clock::now();
+
+	pQueue->gather();
+
+	//Radix sort array of Command Batch Key pairs
+	radixSort(
+		pQueue->beginKey(),
+		pQueue->endKey(),
+		pQueue->scratchKeys(),
+		getSortKey
+	);
+
+	pQueue->setSorted();
+	pQueue->setSortTime(chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count());
+}
+
+//Sort queued command batches based on their keys using a thread pool
+void CommandQueue::sort(ThreadPool& pool)
+{
+	tsassert(pQueue);
+
+	const auto start = chrono::high_resolution_clock::now();
+
+	pQueue->gather();
+
+	radixSort(
+		pool,
+		pQueue->sortCounts(),
 		pQueue->beginKey(),
-		pQueue->endKey()
+		pQueue->endKey(),
+		pQueue->scratchKeys(),
+		getSortKey,
+		s_parallelSortThreshold
 	);
+
+	pQueue->setSorted();
+	pQueue->setSortTime(chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count());
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -248,20 +1246,21 @@ void CommandQueue::sort()
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
 //Allocate a command block capable of storing a command dispatcher + any extra parameters
-Command* CommandQueue::commandAlloc(size_t dispatchSize, size_t extraSize)
+Command* CommandRecorder::commandAlloc(size_t dispatchSize, size_t extraSize)
 {
-	tsassert(pQueue);
+	tsassert(m_shard);
 
 	const size_t totalSize = sizeof(Command) + dispatchSize + extraSize;
 	//Request memory from the batch pool
-	Command* pCmd = pQueue->allocCommand(totalSize);
+	Command* pCmd = m_shard->allocCommand(totalSize);
 
 	//If pointer is null then we have run out of memory
 	tsassert(pCmd != nullptr);
 
-	//Zero out data
-	memset(pCmd, 0, totalSize);
-
+	//Only the header needs initializing, the dispatcher and extra data are copied over afterwards
+	pCmd->next = nullptr;
+	pCmd->type = 0;
+	pCmd->reserved = 0;
 	pCmd->dispatchSize = (uint32)dispatchSize;
 	pCmd->extraSize = (uint32)extraSize;
 
@@ -269,37 +1268,32 @@ Command* CommandQueue::commandAlloc(size_t dispatchSize, size_t extraSize)
 }
 
 //Attaches an individual command to a batch for execution
-void CommandQueue::commandAttach(CommandBatch* pBatch, Command* pCmd)
+void CommandRecorder::commandAttach(CommandBatch* pBatch, Command* pCmd)
 {
-	tsassert(pQueue);
+	tsassert(m_shard);
 
 	//Appends a command to the command list of this batch
 
 	//If command batch is empty
-	if (pBatch->first == nullptr)
+	if (pBatch->last == nullptr)
 	{
 		//Set the first command to be this command
 		pBatch->first = pCmd;
 	}
 	else
 	{
-		Command* cur = pBatch->first;
-
-		//Iterate over each command until we reach the end of the list
-		while (cur->next != nullptr)
-		{
-			cur = cur->next;
-		}
-
-		//Set the command to be the end of the list
-		cur->next = pCmd;
+		//Link the command to the end of the list
+		pBatch->last->next = pCmd;
 	}
+
+	pBatch->last = pCmd;
+	pBatch->count++;
 }
 
 //Copy a given dispatcher into the command block
-void* CommandQueue::storeCommandDispatcher(Command* pCmd, const void* pDispatchSrc)
+void* CommandRecorder::storeCommandDispatcher(Command* pCmd, const void* pDispatchSrc)
 {
-	tsassert(pQueue);
+	tsassert(m_shard);
 
 	if ((pCmd == nullptr) || (pCmd->dispatchSize == 0))
 	{
@@ -307,7 +1301,7 @@ void* CommandQueue::storeCommandDispatcher(Command* pCmd, const void* pDispatchS
 	}
 
 	//Obtain address of new dispatcher
-	void* dispatchDest = (byte*)pCmd + sizeof(Command);
+	void* dispatchDest = commandDispatcherData(pCmd);
 
 	//Copy old dispatcher into the new dispatcher
 	memcpy(dispatchDest, pDispatchSrc, pCmd->dispatchSize);
@@ -316,38 +1310,54 @@ void* CommandQueue::storeCommandDispatcher(Command* pCmd, const void* pDispatchS
 	return dispatchDest;
 }
 
-//Copy a given dispatcher delegate into the command block
-void CommandQueue::storeCommandDispatcherFunc(Command* pCmd, CommandDelegate dispatcherFunc)
+//Set the type of dispatcher stored in the command block
+void CommandRecorder::storeCommandType(Command* pCmd, CommandTypeID type)
 {
-	tsassert(pQueue);
+	tsassert(m_shard);
 
 	if ((pCmd == nullptr) || (pCmd->dispatchSize == 0))
 	{
 		return;
 	}
 
-	//Set dispatcher 
-	pCmd->dispatchFunc = dispatcherFunc;
+	tsassert(type != 0);
+
+	//Set dispatcher type
+	pCmd->type = type;
+
+	if (type == CommandType<CommandBufferUpdate>::id())
+	{
+		m_shard->addUpdate(pCmd->extraSize);
+	}
+	else if (type == CommandType<CommandDrawInstance>::id())
+	{
+		//The instance data is copied from the extra data when the draw executes
+		tsassert(pCmd->extraSize >= ((const CommandDrawInstance*)commandDispatcherData(pCmd))->instanceStride);
+	}
 }
 
 //Copy a given block of memory into the command block
-void CommandQueue::storeCommandExtra(Command* pCmd, const void* pExtraSrc)
+void CommandRecorder::storeCommandExtra(Command* pCmd, const void* pExtraSrc)
 {
-	tsassert(pQueue);
+	tsassert(m_shard);
 
-	if ((pCmd == nullptr) || (pExtraSrc == nullptr) || (pCmd->dispatchSize == 0))
+	if ((pCmd == nullptr) || (pCmd->dispatchSize == 0) || (pCmd->extraSize == 0))
 	{
 		return;
 	}
 
 	//Get pointer to extra memory
-	void* extraDest = (byte*)pCmd + sizeof(Command) + pCmd->dispatchSize;
+	void* extraDest = (void*)commandExtraData(pCmd);
 
-	//Only copy extra parameters into this block if extra memory has been given
-	if (pCmd->extraSize > 0)
+	//Copy extra parameters into this block if extra memory has been given, otherwise zero it
+	if (pExtraSrc != nullptr)
 	{
 		memcpy(extraDest, pExtraSrc, pCmd->extraSize);
 	}
+	else
+	{
+		memset(extraDest, 0, pCmd->extraSize);
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,312 @@
+/*
+	Deferred Destruction source
+*/
+
+#include <tsgraphics/DeferredDestroy.h>
+
+#include <tscore/debug/assert.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace ts;
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Helpers
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+//Size in bytes of a pixel of a given format
+static uint32 imageFormatSize(ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::BYTE: return 1;
+	case ImageFormat::RGB: return 4;
+	case ImageFormat::RGBA: return 4;
+	case ImageFormat::ARGB: return 4;
+	case ImageFormat::FLOAT1: return 4;
+	case ImageFormat::FLOAT2: return 8;
+	case ImageFormat::FLOAT3: return 12;
+	case ImageFormat::FLOAT4: return 16;
+	case ImageFormat::DEPTH16: return 2;
+	case ImageFormat::DEPTH32: return 4;
+	default: return 0;
+	}
+}
+
+enum class DeferredType : uint8
+{
+	RESOURCE,
+	RESOURCE_SET,
+	SHADER,
+	PIPELINE,
+	TARGET
+};
+
+struct DeferredObject
+{
+	DeferredType type;
+	uintptr handle;
+	uint64 bytes;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	State
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct DeferredDestroyDevice::State
+{
+	RenderDevice* device;
+	uint32 latency;
+
+	mutable std::mutex lock;
+
+	/*
+		Objects released in each of the last latency + 1 frames,
+		the slot of the current frame holds the objects released latency + 1 frames ago until it is reused
+	*/
+	std::vector<std::vector<DeferredObject>> frames;
+	uint64 frame = 0;
+
+	//Objects being destroyed, kept so it's memory is reused
+	std::vector<DeferredObject> destroying;
+
+	//Memory held by each live resource
+	std::unordered_map<ResourceHandle, uint64> resourceBytes;
+
+	DeferredDestroyStats stats;
+
+	State(RenderDevice* device, uint32 latency) :
+		device(device),
+		latency(latency),
+		frames(latency + 1)
+	{}
+
+	std::vector<DeferredObject>& current() { return frames[frame % frames.size()]; }
+
+	void push(DeferredType type, uintptr handle, uint64 bytes = 0)
+	{
+		std::lock_guard<std::mutex> lk(lock);
+
+		current().push_back({ type, handle, bytes });
+		stats.pendingCount++;
+		stats.pendingBytes += bytes;
+	}
+
+	void track(ResourceHandle rsc, uint64 bytes)
+	{
+		if (rsc != ResourceHandle())
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			resourceBytes[rsc] = bytes;
+		}
+	}
+
+	uint64 untrack(ResourceHandle rsc)
+	{
+		std::lock_guard<std::mutex> lk(lock);
+
+		auto it = resourceBytes.find(rsc);
+
+		if (it == resourceBytes.end())
+			return 0;
+
+		uint64 bytes = it->second;
+		resourceBytes.erase(it);
+		return bytes;
+	}
+
+	//Destroy objects outside of the lock, destroy() may be called from other threads meanwhile
+	uint32 destroyAll(std::vector<DeferredObject>& objects)
+	{
+		for (const DeferredObject& o : objects)
+		{
+			switch (o.type)
+			{
+			case DeferredType::RESOURCE: device->destroy((ResourceHandle)o.handle); break;
+			case DeferredType::RESOURCE_SET: device->destroy((ResourceSetHandle)o.handle); break;
+			case DeferredType::SHADER: device->destroy((ShaderHandle)o.handle); break;
+			case DeferredType::PIPELINE: device->destroy((PipelineHandle)o.handle); break;
+			case DeferredType::TARGET: device->destroy((TargetHandle)o.handle); break;
+			}
+		}
+
+		const uint32 count = (uint32)objects.size();
+		objects.clear();
+		return count;
+	}
+
+	void released(const std::vector<DeferredObject>& objects)
+	{
+		for (const DeferredObject& o : objects)
+		{
+			stats.pendingCount--;
+			stats.pendingBytes -= o.bytes;
+		}
+
+		stats.destroyedTotal += objects.size();
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Device
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+DeferredDestroyDevice::DeferredDestroyDevice(RenderDevice* device, uint32 latency) :
+	pState(new State(device, latency))
+{
+	tsassert(device);
+}
+
+DeferredDestroyDevice::~DeferredDestroyDevice()
+{
+	if (pState)
+	{
+		flush();
+	}
+
+	pState.reset();
+}
+
+RenderDevice* DeferredDestroyDevice::getDevice() const
+{
+	return pState->device;
+}
+
+uint32 DeferredDestroyDevice::getLatency() const
+{
+	return pState->latency;
+}
+
+void DeferredDestroyDevice::flush()
+{
+	std::vector<DeferredObject> objects;
+
+	{
+		std::lock_guard<std::mutex> lk(pState->lock);
+
+		for (auto& frame : pState->frames)
+		{
+			objects.insert(objects.end(), frame.begin(), frame.end());
+			frame.clear();
+		}
+
+		pState->released(objects);
+	}
+
+	pState->destroyAll(objects);
+}
+
+DeferredDestroyStats DeferredDestroyDevice::getStats() const
+{
+	std::lock_guard<std::mutex> lk(pState->lock);
+	return pState->stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+RenderContext* DeferredDestroyDevice::context() { return pState->device->context(); }
+
+void DeferredDestroyDevice::commit()
+{
+	pState->device->commit();
+
+	{
+		std::lock_guard<std::mutex> lk(pState->lock);
+
+		//The slot of the next frame holds the objects which are now old enough to be destroyed
+		pState->frame++;
+		pState->destroying.swap(pState->current());
+		pState->released(pState->destroying);
+		pState->stats.destroyedLastFrame = (uint32)pState->destroying.size();
+	}
+
+	pState->destroyAll(pState->destroying);
+}
+
+uint32 DeferredDestroyDevice::acquireContexts(RenderContext** contexts, uint32 count) { return pState->device->acquireContexts(contexts, count); }
+void DeferredDestroyDevice::submitContexts(RenderContext* const* contexts, uint32 count) { pState->device->submitContexts(contexts, count); }
+
+void DeferredDestroyDevice::setDisplayConfiguration(const DisplayConfig& displayCfg) { pState->device->setDisplayConfiguration(displayCfg); }
+void DeferredDestroyDevice::getDisplayConfiguration(DisplayConfig& displayCfg) { pState->device->getDisplayConfiguration(displayCfg); }
+ResourceHandle DeferredDestroyDevice::getDisplayTarget() { return pState->device->getDisplayTarget(); }
+
+void DeferredDestroyDevice::queryStats(RenderStats& stats) { pState->device->queryStats(stats); }
+void DeferredDestroyDevice::queryInfo(RenderDeviceInfo& info) { pState->device->queryInfo(info); }
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Create/destroy
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Objects are created on the wrapped device but owned through this device so destruction can be queued
+*/
+
+RPtr<ResourceHandle> DeferredDestroyDevice::createEmptyResource(ResourceHandle recycle)
+{
+	return RPtr<ResourceHandle>(this, pState->device->createEmptyResource(recycle).release());
+}
+
+RPtr<ResourceHandle> DeferredDestroyDevice::createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle)
+{
+	RPtr<ResourceHandle> rsc = pState->device->createResourceBuffer(data, info, recycle);
+	pState->track(rsc.handle(), info.size);
+
+	return RPtr<ResourceHandle>(this, rsc.release());
+}
+
+RPtr<ResourceHandle> DeferredDestroyDevice::createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle)
+{
+	RPtr<ResourceHandle> rsc = pState->device->createResourceImage(data, info, recycle);
+	pState->track(rsc.handle(), (uint64)info.width * info.height * info.length * info.msLevels * imageFormatSize(info.format));
+
+	return RPtr<ResourceHandle>(this, rsc.release());
+}
+
+RPtr<ResourceSetHandle> DeferredDestroyDevice::createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle)
+{
+	return RPtr<ResourceSetHandle>(this, pState->device->createResourceSet(info, recycle).release());
+}
+
+RPtr<ShaderHandle> DeferredDestroyDevice::createShader(const ShaderCreateInfo& info)
+{
+	return RPtr<ShaderHandle>(this, pState->device->createShader(info).release());
+}
+
+RPtr<PipelineHandle> DeferredDestroyDevice::createPipeline(ShaderHandle program, const PipelineCreateInfo& info)
+{
+	return RPtr<PipelineHandle>(this, pState->device->createPipeline(program, info).release());
+}
+
+RPtr<TargetHandle> DeferredDestroyDevice::createTarget(const TargetCreateInfo& info, TargetHandle recycle)
+{
+	return RPtr<TargetHandle>(this, pState->device->createTarget(info, recycle).release());
+}
+
+void DeferredDestroyDevice::destroy(ResourceHandle rsc)
+{
+	pState->push(DeferredType::RESOURCE, (uintptr)rsc, pState->untrack(rsc));
+}
+
+void DeferredDestroyDevice::destroy(ResourceSetHandle set)
+{
+	pState->push(DeferredType::RESOURCE_SET, (uintptr)set);
+}
+
+void DeferredDestroyDevice::destroy(ShaderHandle shader)
+{
+	pState->push(DeferredType::SHADER, (uintptr)shader);
+}
+
+void DeferredDestroyDevice::destroy(PipelineHandle pipeline)
+{
+	pState->push(DeferredType::PIPELINE, (uintptr)pipeline);
+}
+
+void DeferredDestroyDevice::destroy(TargetHandle target)
+{
+	pState->push(DeferredType::TARGET, (uintptr)target);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
@@ -3,7 +3,12 @@
 */
 
 #include <tsgraphics/Driver.h>
+#include <tsnull.h> //null driver
+#include <tssoft.h> //software driver
+
+#ifdef WIN32
 #include <tsdx11.h> //d3d11 driver
+#endif
 
 using namespace ts;
 
@@ -13,8 +18,14 @@ RenderDevice::Ptr RenderDevice::create(RenderDriverID id, const RenderDeviceConf
 {
 	switch (id)
 	{
+#ifdef WIN32
 	case RenderDriverID::DX11:
 		return RenderDevice::Ptr(createDX11device(config));
+#endif
+	case RenderDriverID::NULLDEVICE:
+		return RenderDevice::Ptr(createNullDevice(config));
+	case RenderDriverID::SOFTWARE:
+		return RenderDevice::Ptr(createSoftDevice(config));
 	default:
 		return RenderDevice::Ptr();
 	}
@@ -22,8 +33,12 @@ RenderDevice::Ptr RenderDevice::create(RenderDriverID id, const RenderDeviceConf
 
 void RenderDevice::destroy(RenderDevice* device)
 {
-	//Hardcode for now to dx11
+	//Each driver only destroys devices it created
+#ifdef WIN32
 	destroyDX11device(device);
+#endif
+	destroyNullDevice(device);
+	destroySoftDevice(device);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,196 @@
+/*
+	Dynamic Buffer Ring source
+*/
+
+#include <tsgraphics/DynamicBuffer.h>
+
+#include <tscore/debug/assert.h>
+#include <tscore/debug/log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace ts;
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	State
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct DynamicBufferRing::State
+{
+	RenderDevice* device;
+	BufferType type;
+
+	RPtr<ResourceHandle> buffer;
+
+	uint32 frameSize;
+	uint32 frames;
+
+	//Contents of the whole buffer
+	std::vector<uint8> memory;
+
+	//The device can't update a range of the buffer so every upload updates all of it
+	bool wholeUploads = false;
+
+	uint64 frame = 0;
+	//Bytes allocated in the current frame and how many of them have been uploaded
+	uint32 top = 0;
+	uint32 uploaded = 0;
+
+	Stats stats;
+
+	State(RenderDevice* device, BufferType type, uint32 frameSize, uint32 frames) :
+		device(device),
+		type(type),
+		//Regions begin on a constant offset boundary
+		frameSize((frameSize + DrawParams::CONSTANT_OFFSET_ALIGNMENT - 1) & ~(uint32)(DrawParams::CONSTANT_OFFSET_ALIGNMENT - 1)),
+		frames(std::max(frames, 1u)),
+		memory((size_t)this->frameSize * this->frames, 0)
+	{
+		ResourceData data;
+		data.memory = memory.data();
+
+		BufferResourceInfo info;
+		info.size = (uint32)memory.size();
+		info.type = type;
+
+		buffer = device->createResourceBuffer(data, info);
+
+		if (!buffer)
+		{
+			tswarn("unable to create dynamic buffer of % bytes", info.size);
+		}
+
+		RenderDeviceInfo deviceInfo;
+		device->queryInfo(deviceInfo);
+		wholeUploads = (type == BufferType::CONSTANTS) && !deviceInfo.constantBufferRanges;
+	}
+
+	uint32 base() const { return (uint32)(frame % frames) * frameSize; }
+
+	uint32 defaultAlignment() const
+	{
+		switch (type)
+		{
+		case BufferType::CONSTANTS: return DrawParams::CONSTANT_OFFSET_ALIGNMENT;
+		case BufferType::INDEX: return sizeof(uint32);
+		default: return 16;
+		}
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Ring
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+DynamicBufferRing::DynamicBufferRing(RenderDevice* device, BufferType type, uint32 frameSize, uint32 frames) :
+	pState(new State(device, type, frameSize, frames))
+{
+	tsassert(device);
+}
+
+DynamicBufferRing::~DynamicBufferRing()
+{
+	pState.reset();
+}
+
+RenderDevice* DynamicBufferRing::getDevice() const { return pState->device; }
+ResourceHandle DynamicBufferRing::getBuffer() const { return pState->buffer.handle(); }
+BufferType DynamicBufferRing::getType() const { return pState->type; }
+uint32 DynamicBufferRing::getFrameSize() const { return pState->frameSize; }
+uint32 DynamicBufferRing::getFrameCount() const { return pState->frames; }
+
+DynamicAllocation DynamicBufferRing::allocate(uint32 size, uint32 alignment)
+{
+	tsassert(pState);
+
+	State& s = *pState;
+
+	if (alignment == 0)
+		alignment = s.defaultAlignment();
+
+	//Constant offsets must also be a multiple of the constant offset alignment
+	if (s.type == BufferType::CONSTANTS)
+		alignment = std::max(alignment, (uint32)DrawParams::CONSTANT_OFFSET_ALIGNMENT);
+
+	//Offsets are aligned from the start of the buffer, vertex strides need not be a power of two
+	const uint32 base = s.base();
+	const uint64 offset = (((uint64)base + s.top + alignment - 1) / alignment) * alignment;
+
+	if (!s.buffer || offset + size > (uint64)base + s.frameSize)
+	{
+		tswarn("dynamic buffer is full, unable to allocate % bytes", size);
+		s.stats.overflows++;
+		return DynamicAllocation();
+	}
+
+	s.top = (uint32)(offset + size - base);
+
+	s.stats.allocations++;
+	s.stats.bytes = s.top;
+	s.stats.peakBytes = std::max(s.stats.peakBytes, s.top);
+
+	DynamicAllocation a;
+	a.buffer = s.buffer.handle();
+	a.offset = (uint32)offset;
+	a.size = size;
+	a.memory = &s.memory[(size_t)offset];
+	return a;
+}
+
+DynamicAllocation DynamicBufferRing::write(const void* data, uint32 size, uint32 alignment)
+{
+	DynamicAllocation a = allocate(size, alignment);
+
+	if (a.valid())
+	{
+		memcpy(a.memory, data, size);
+	}
+
+	return a;
+}
+
+void DynamicBufferRing::upload(RenderContext* context)
+{
+	tsassert(pState);
+
+	State& s = *pState;
+
+	if (s.top > s.uploaded)
+	{
+		if (s.wholeUploads)
+		{
+			//The regions of other frames are rewritten with the same contents
+			context->resourceUpdate(s.buffer.handle(), s.memory.data());
+		}
+		else
+		{
+			const uint32 offset = s.base() + s.uploaded;
+			context->resourceUpdateRange(s.buffer.handle(), &s.memory[offset], offset, s.top - s.uploaded);
+		}
+
+		s.uploaded = s.top;
+	}
+}
+
+void DynamicBufferRing::nextFrame()
+{
+	tsassert(pState);
+
+	State& s = *pState;
+
+	s.frame++;
+	s.top = 0;
+	s.uploaded = 0;
+
+	s.stats.allocations = 0;
+	s.stats.bytes = 0;
+}
+
+DynamicBufferRing::Stats DynamicBufferRing::getStats() const
+{
+	return pState->stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
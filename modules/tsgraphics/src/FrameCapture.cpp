@@ -0,0 +1,1556 @@
+/*
+	Frame Capture source
+*/
+
+#include <tsgraphics/FrameCapture.h>
+#include <tsgraphics/schemas/FrameCapture.rcs.h>
+
+#include <tscore/debug/assert.h>
+#include <tscore/debug/log.h>
+
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+using namespace ts;
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Helpers
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+enum
+{
+	CAPTURE_SIGNATURE = 0x43465354, //TSFC
+	CAPTURE_VERSION = 3
+};
+
+//Size in bytes of a pixel of a given format
+static uint32 imageFormatSize(ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::BYTE: return 1;
+	case ImageFormat::RGB: return 4;
+	case ImageFormat::RGBA: return 4;
+	case ImageFormat::ARGB: return 4;
+	case ImageFormat::FLOAT1: return 4;
+	case ImageFormat::FLOAT2: return 8;
+	case ImageFormat::FLOAT3: return 12;
+	case ImageFormat::FLOAT4: return 16;
+	case ImageFormat::DEPTH16: return 2;
+	case ImageFormat::DEPTH32: return 4;
+	default: return 0;
+	}
+}
+
+//Write an array to a resource, empty arrays are allowed
+template<typename type_t>
+static rc::Ref<rc::ArrayView<type_t>> writeArray(rc::ResourceBuilder& builder, const std::vector<type_t>& items)
+{
+	return builder.createArray(items.data(), (rc::SizeType)items.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Object descriptions
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct ResourceDesc
+{
+	bool isImage = false;
+	BufferResourceInfo buffer;
+	ImageResourceInfo image;
+	std::vector<byte> data;
+};
+
+struct ShaderDesc
+{
+	std::vector<byte> stages[(size_t)ShaderStage::MAX_STAGES];
+};
+
+struct PipelineDesc
+{
+	ShaderHandle shader = ShaderHandle();
+	PipelineCreateInfo info;
+	std::vector<SamplerState> samplers;
+	std::vector<VertexAttribute> attributes;
+	std::vector<String> semantics;
+};
+
+struct TargetDesc
+{
+	std::vector<ImageView> attachments;
+	ImageView depth;
+	Viewport viewport;
+	Viewport scissor;
+};
+
+struct ResourceSetDesc
+{
+	std::vector<ImageView> resources;
+	std::vector<ResourceHandle> constantBuffers;
+	std::vector<VertexBufferView> vertexBuffers;
+	ResourceHandle indexBuffer = ResourceHandle();
+	uint32 dynamicConstants = 0;
+	std::vector<ResourceHandle> storageBuffers;
+	std::vector<ImageView> storageImages;
+};
+
+//Context call, objects are kept as handles until the capture is written
+struct CapturedCall
+{
+	tsr::CaptureCallType type;
+	uintptr objects[3] = {};
+	uint32 value = 0;
+	uint64 key = 0;
+	uint32 payloadOffset = 0;
+	uint32 payloadSize = 0;
+	DrawParams params;
+	DispatchParams dispatch;
+
+	CapturedCall(tsr::CaptureCallType type) : type(type) {}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Capture context
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct CaptureState;
+
+class CaptureContext : public RenderContext
+{
+private:
+
+	CaptureState* m_state;
+
+public:
+
+	CaptureContext(CaptureState* state) : m_state(state) {}
+
+	void resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index) override;
+	void resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size) override;
+	void resourceCopy(ResourceHandle src, ResourceHandle dest) override;
+	void imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index) override;
+
+	void clearColourTarget(TargetHandle pass, uint32 colour) override;
+	void clearDepthTarget(TargetHandle pass, float depth) override;
+
+	void draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params) override;
+
+	void bindTarget(TargetHandle outputs) override;
+	void bindPipeline(PipelineHandle pipeline) override;
+	void bindResourceSet(ResourceSetHandle inputs) override;
+	void drawBound(const DrawParams& params) override;
+	void multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed) override;
+
+	void dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params) override;
+	void dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset) override;
+
+	void batchMarker(uint64 sortKey) override;
+
+	//Staged updates are applied individually while capturing so each update is recorded
+	bool beginStagedUpdates(const void* memory, uint32 size) override;
+	void resourceUpdateStaged(ResourceHandle rsc, uint32 offset, uint32 size) override;
+	void endStagedUpdates() override;
+
+	void finish() override;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct CaptureState
+{
+	RenderDevice* device;
+	RenderContext* deviceContext;
+	CaptureContext context;
+
+	//Live objects
+	std::unordered_map<ResourceHandle, ResourceDesc> resources;
+	std::unordered_map<ShaderHandle, ShaderDesc> shaders;
+	std::unordered_map<PipelineHandle, PipelineDesc> pipelines;
+	std::unordered_map<TargetHandle, TargetDesc> targets;
+	std::unordered_map<ResourceSetHandle, ResourceSetDesc> resourceSets;
+
+	//Calls recorded since the capture began
+	bool capturing = false;
+	std::vector<CapturedCall> calls;
+	std::vector<byte> payload;
+
+	CaptureState(RenderDevice* device) :
+		device(device),
+		deviceContext(device->context()),
+		context(this)
+	{}
+
+	void record(const CapturedCall& call)
+	{
+		calls.push_back(call);
+	}
+
+	//Copy memory into the payload
+	void recordPayload(CapturedCall& call, const void* memory, uint32 size)
+	{
+		call.payloadOffset = (uint32)payload.size();
+		call.payloadSize = (memory != nullptr) ? size : 0;
+
+		if (call.payloadSize > 0)
+		{
+			payload.insert(payload.end(), (const byte*)memory, (const byte*)memory + size);
+		}
+	}
+
+	//Size of the memory passed to resourceUpdate()
+	uint32 updateSize(ResourceHandle rsc) const
+	{
+		auto it = resources.find(rsc);
+
+		if (it == resources.end())
+			return 0;
+
+		const ResourceDesc& desc = it->second;
+
+		if (desc.isImage)
+			return desc.image.width * desc.image.height * imageFormatSize(desc.image.format);
+
+		return desc.buffer.size;
+	}
+
+	bool write(std::ostream& out);
+};
+
+struct CaptureDevice::State : public CaptureState
+{
+	State(RenderDevice* device) : CaptureState(device) {}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Context calls
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+void CaptureContext::resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_UPDATE);
+		call.objects[0] = (uintptr)rsc;
+		call.value = index;
+		m_state->recordPayload(call, memory, m_state->updateSize(rsc));
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->resourceUpdate(rsc, memory, index);
+}
+
+void CaptureContext::resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_UPDATE_RANGE);
+		call.objects[0] = (uintptr)rsc;
+		call.value = offset;
+		m_state->recordPayload(call, memory, size);
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->resourceUpdateRange(rsc, memory, offset, size);
+}
+
+void CaptureContext::resourceCopy(ResourceHandle src, ResourceHandle dest)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_COPY);
+		call.objects[0] = (uintptr)src;
+		call.objects[1] = (uintptr)dest;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->resourceCopy(src, dest);
+}
+
+void CaptureContext::imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_RESOLVE);
+		call.objects[0] = (uintptr)src;
+		call.objects[1] = (uintptr)dest;
+		call.value = index;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->imageResolve(src, dest, index);
+}
+
+void CaptureContext::clearColourTarget(TargetHandle pass, uint32 colour)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_CLEAR_COLOUR);
+		call.objects[0] = (uintptr)pass;
+		call.value = colour;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->clearColourTarget(pass, colour);
+}
+
+void CaptureContext::clearDepthTarget(TargetHandle pass, float depth)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_CLEAR_DEPTH);
+		call.objects[0] = (uintptr)pass;
+		memcpy(&call.value, &depth, sizeof(float));
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->clearDepthTarget(pass, depth);
+}
+
+void CaptureContext::draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_DRAW);
+		call.objects[0] = (uintptr)outputs;
+		call.objects[1] = (uintptr)pipeline;
+		call.objects[2] = (uintptr)inputs;
+		call.params = params;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->draw(outputs, pipeline, inputs, params);
+}
+
+void CaptureContext::bindTarget(TargetHandle outputs)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_BIND_TARGET);
+		call.objects[0] = (uintptr)outputs;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->bindTarget(outputs);
+}
+
+void CaptureContext::bindPipeline(PipelineHandle pipeline)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_BIND_PIPELINE);
+		call.objects[1] = (uintptr)pipeline;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->bindPipeline(pipeline);
+}
+
+void CaptureContext::bindResourceSet(ResourceSetHandle inputs)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_BIND_RESOURCES);
+		call.objects[2] = (uintptr)inputs;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->bindResourceSet(inputs);
+}
+
+void CaptureContext::drawBound(const DrawParams& params)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_DRAW_BOUND);
+		call.params = params;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->drawBound(params);
+}
+
+void CaptureContext::multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed)
+{
+	if (m_state->capturing)
+	{
+		//The draw count and whether the draws are indexed are stored in the draw params
+		CapturedCall call(tsr::CAPTURE_CALL_DRAW_INDIRECT);
+		call.objects[0] = (uintptr)args;
+		call.value = offset;
+		call.params.count = count;
+		call.params.mode = indexed ? DrawMode::INDEXEDINSTANCED : DrawMode::INSTANCED;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->multiDrawIndirect(args, offset, count, indexed);
+}
+
+void CaptureContext::dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_DISPATCH);
+		call.objects[1] = (uintptr)pipeline;
+		call.objects[2] = (uintptr)inputs;
+		call.dispatch = params;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->dispatch(pipeline, inputs, params);
+}
+
+void CaptureContext::dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_DISPATCH_INDIRECT);
+		call.objects[0] = (uintptr)args;
+		call.objects[1] = (uintptr)pipeline;
+		call.objects[2] = (uintptr)inputs;
+		call.value = offset;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->dispatchIndirect(pipeline, inputs, args, offset);
+}
+
+void CaptureContext::batchMarker(uint64 sortKey)
+{
+	if (m_state->capturing)
+	{
+		CapturedCall call(tsr::CAPTURE_CALL_BATCH);
+		call.key = sortKey;
+		m_state->record(call);
+	}
+
+	m_state->deviceContext->batchMarker(sortKey);
+}
+
+bool CaptureContext::beginStagedUpdates(const void* memory, uint32 size)
+{
+	if (m_state->capturing)
+		return false;
+
+	return m_state->deviceContext->beginStagedUpdates(memory, size);
+}
+
+void CaptureContext::resourceUpdateStaged(ResourceHandle rsc, uint32 offset, uint32 size)
+{
+	m_state->deviceContext->resourceUpdateStaged(rsc, offset, size);
+}
+
+void CaptureContext::endStagedUpdates()
+{
+	m_state->deviceContext->endStagedUpdates();
+}
+
+void CaptureContext::finish()
+{
+	if (m_state->capturing)
+	{
+		m_state->record(CapturedCall(tsr::CAPTURE_CALL_FINISH));
+	}
+
+	m_state->deviceContext->finish();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Capture writer
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+//Assigns capture ids to live objects
+template<typename handle_t>
+class CaptureIds
+{
+private:
+
+	std::unordered_map<handle_t, uint32> m_ids;
+
+public:
+
+	uint32 add(handle_t h)
+	{
+		uint32 id = (uint32)m_ids.size() + 1;
+		m_ids[h] = id;
+		return id;
+	}
+
+	//Objects which were not live when the capture ended have no id
+	uint32 get(handle_t h) const
+	{
+		auto it = m_ids.find(h);
+		return (it != m_ids.end()) ? it->second : 0;
+	}
+};
+
+bool CaptureState::write(std::ostream& out)
+{
+	tsr::FrameCaptureBuilder builder;
+
+	CaptureIds<ResourceHandle> resourceIds;
+	CaptureIds<ShaderHandle> shaderIds;
+	CaptureIds<PipelineHandle> pipelineIds;
+	CaptureIds<TargetHandle> targetIds;
+	CaptureIds<ResourceSetHandle> resourceSetIds;
+
+	std::vector<tsr::CaptureResource> resourceList;
+	std::vector<tsr::CaptureShader> shaderList;
+	std::vector<tsr::CapturePipeline> pipelineList;
+	std::vector<tsr::CaptureTarget> targetList;
+	std::vector<tsr::CaptureResourceSet> resourceSetList;
+
+	std::vector<tsr::CaptureImageView> imageViews;
+	std::vector<tsr::CaptureVertexBufferView> vertexBuffers;
+	std::vector<uint32> constantBuffers;
+	std::vector<uint32> storageBuffers;
+	std::vector<tsr::CaptureSampler> samplers;
+	std::vector<tsr::CaptureVertexAttribute> vertexAttributes;
+
+	std::vector<tsr::CaptureCall> callList;
+	callList.reserve(calls.size());
+
+	auto appendPayload = [this](const void* memory, size_t size) {
+		tsr::CaptureRange range;
+		range.offset = (uint32)payload.size();
+		range.size = (uint32)size;
+		payload.insert(payload.end(), (const byte*)memory, (const byte*)memory + size);
+		return range;
+	};
+
+	auto imageView = [&](const ImageView& view) {
+		tsr::CaptureImageView v;
+		v.image = resourceIds.get(view.image);
+		v.index = view.index;
+		v.count = view.count;
+		v.type = (uint32)view.type;
+		return v;
+	};
+
+	auto viewport = [](const Viewport& vp) {
+		tsr::CaptureViewport v;
+		v.w = vp.w;
+		v.h = vp.h;
+		v.x = vp.x;
+		v.y = vp.y;
+		return v;
+	};
+
+	/*
+		Resources
+	*/
+
+	//The display target is not created through the device
+	{
+		tsr::CaptureResource r = {};
+		r.isImage = true;
+		r.isDisplay = true;
+		resourceList.push_back(r);
+		resourceIds.add(device->getDisplayTarget());
+	}
+
+	for (const auto& entry : resources)
+	{
+		const ResourceDesc& desc = entry.second;
+
+		tsr::CaptureResource r = {};
+		r.isImage = desc.isImage;
+		r.size = desc.buffer.size;
+		r.bufferType = (uint32)desc.buffer.type;
+		r.format = (uint32)desc.image.format;
+		r.imageType = (uint32)desc.image.type;
+		r.usage = (uint32)desc.image.usage;
+		r.width = desc.image.width;
+		r.height = desc.image.height;
+		r.length = desc.image.length;
+		r.useMips = desc.image.useMips;
+		r.msLevels = desc.image.msLevels;
+		r.mipLevels = desc.image.mipLevels;
+		r.data = appendPayload(desc.data.data(), desc.data.size());
+
+		resourceList.push_back(r);
+		resourceIds.add(entry.first);
+	}
+
+	/*
+		Shaders
+	*/
+	for (const auto& entry : shaders)
+	{
+		const ShaderDesc& desc = entry.second;
+
+		tsr::CaptureShader s;
+		tsr::CaptureRange* stages[] = { &s.vertex, &s.geometry, &s.tessCtrl, &s.tessEval, &s.pixel, &s.compute };
+		static_assert(sizeof(stages) / sizeof(stages[0]) == (size_t)ShaderStage::MAX_STAGES, "Capture shader stages do not match ShaderStage");
+
+		for (size_t i = 0; i < (size_t)ShaderStage::MAX_STAGES; i++)
+			*stages[i] = appendPayload(desc.stages[i].data(), desc.stages[i].size());
+
+		shaderList.push_back(s);
+		shaderIds.add(entry.first);
+	}
+
+	/*
+		Pipelines
+	*/
+	for (const auto& entry : pipelines)
+	{
+		const PipelineDesc& desc = entry.second;
+
+		tsr::CapturePipeline p;
+		p.shader = shaderIds.get(desc.shader);
+		p.enableScissor = desc.info.raster.enableScissor;
+		p.cullMode = (uint32)desc.info.raster.cullMode;
+		p.fillMode = (uint32)desc.info.raster.fillMode;
+		p.enableDepth = desc.info.depth.enableDepth;
+		p.enableStencil = desc.info.depth.enableStencil;
+		p.enableBlend = desc.info.blend.enable;
+		p.topology = (uint32)desc.info.topology;
+
+		p.samplerStart = (uint32)samplers.size();
+		p.samplerCount = (uint32)desc.samplers.size();
+
+		for (const SamplerState& sampler : desc.samplers)
+		{
+			tsr::CaptureSampler s;
+			s.addressU = (uint32)sampler.addressU;
+			s.addressV = (uint32)sampler.addressV;
+			s.addressW = (uint32)sampler.addressW;
+			s.filtering = (uint32)sampler.filtering;
+			s.borderColour = sampler.borderColour.get();
+			s.anisotropy = sampler.anisotropy;
+			samplers.push_back(s);
+		}
+
+		p.attributeStart = (uint32)vertexAttributes.size();
+		p.attributeCount = (uint32)desc.attributes.size();
+
+		for (size_t i = 0; i < desc.attributes.size(); i++)
+		{
+			const VertexAttribute& attrib = desc.attributes[i];
+
+			tsr::CaptureVertexAttribute a;
+			a.bufferSlot = attrib.bufferSlot;
+			a.semanticName = appendPayload(desc.semantics[i].c_str(), desc.semantics[i].size() + 1);
+			a.byteOffset = attrib.byteOffset;
+			a.type = (uint32)attrib.type;
+			a.channel = (uint32)attrib.channel;
+			vertexAttributes.push_back(a);
+		}
+
+		pipelineList.push_back(p);
+		pipelineIds.add(entry.first);
+	}
+
+	/*
+		Targets
+	*/
+	for (const auto& entry : targets)
+	{
+		const TargetDesc& desc = entry.second;
+
+		tsr::CaptureTarget t;
+		t.attachmentStart = (uint32)imageViews.size();
+		t.attachmentCount = (uint32)desc.attachments.size();
+
+		for (const ImageView& view : desc.attachments)
+			imageViews.push_back(imageView(view));
+
+		t.depth = imageView(desc.depth);
+		t.viewport = viewport(desc.viewport);
+		t.scissor = viewport(desc.scissor);
+
+		targetList.push_back(t);
+		targetIds.add(entry.first);
+	}
+
+	/*
+		Resource sets
+	*/
+	for (const auto& entry : resourceSets)
+	{
+		const ResourceSetDesc& desc = entry.second;
+
+		tsr::CaptureResourceSet s;
+		s.resourceStart = (uint32)imageViews.size();
+		s.resourceCount = (uint32)desc.resources.size();
+
+		for (const ImageView& view : desc.resources)
+			imageViews.push_back(imageView(view));
+
+		s.constantStart = (uint32)constantBuffers.size();
+		s.constantCount = (uint32)desc.constantBuffers.size();
+
+		for (ResourceHandle buffer : desc.constantBuffers)
+			constantBuffers.push_back(resourceIds.get(buffer));
+
+		s.vertexBufferStart = (uint32)vertexBuffers.size();
+		s.vertexBufferCount = (uint32)desc.vertexBuffers.size();
+
+		for (const VertexBufferView& view : desc.vertexBuffers)
+		{
+			tsr::CaptureVertexBufferView v;
+			v.buffer = resourceIds.get(view.buffer);
+			v.stride = view.stride;
+			v.offset = view.offset;
+			vertexBuffers.push_back(v);
+		}
+
+		s.indexBuffer = resourceIds.get(desc.indexBuffer);
+		s.dynamicConstants = desc.dynamicConstants;
+
+		s.storageBufferStart = (uint32)storageBuffers.size();
+		s.storageBufferCount = (uint32)desc.storageBuffers.size();
+
+		for (ResourceHandle buffer : desc.storageBuffers)
+			storageBuffers.push_back(resourceIds.get(buffer));
+
+		s.storageImageStart = (uint32)imageViews.size();
+		s.storageImageCount = (uint32)desc.storageImages.size();
+
+		for (const ImageView& view : desc.storageImages)
+			imageViews.push_back(imageView(view));
+
+		resourceSetList.push_back(s);
+		resourceSetIds.add(entry.first);
+	}
+
+	/*
+		Calls
+	*/
+	for (const CapturedCall& call : calls)
+	{
+		tsr::CaptureCall c = {};
+		c.type = (uint32)call.type;
+		c.value = call.value;
+		c.key = call.key;
+		c.payload.offset = call.payloadOffset;
+		c.payload.size = call.payloadSize;
+
+		c.params.start = call.params.start;
+		c.params.count = call.params.count;
+		c.params.vbase = call.params.vbase;
+		c.params.instances = call.params.instances;
+		c.params.constantOffset = call.params.constantOffset;
+		c.params.mode = (uint32)call.params.mode;
+
+		c.dispatch.groupsX = call.dispatch.groupsX;
+		c.dispatch.groupsY = call.dispatch.groupsY;
+		c.dispatch.groupsZ = call.dispatch.groupsZ;
+		c.dispatch.constantOffset = call.dispatch.constantOffset;
+
+		switch (call.type)
+		{
+		case tsr::CAPTURE_CALL_UPDATE:
+		case tsr::CAPTURE_CALL_UPDATE_RANGE:
+		case tsr::CAPTURE_CALL_COPY:
+		case tsr::CAPTURE_CALL_RESOLVE:
+		case tsr::CAPTURE_CALL_DRAW_INDIRECT:
+			c.object0 = resourceIds.get((ResourceHandle)call.objects[0]);
+			c.object1 = resourceIds.get((ResourceHandle)call.objects[1]);
+			break;
+		case tsr::CAPTURE_CALL_DISPATCH_INDIRECT:
+			c.object0 = resourceIds.get((ResourceHandle)call.objects[0]);
+			c.object1 = pipelineIds.get((PipelineHandle)call.objects[1]);
+			c.object2 = resourceSetIds.get((ResourceSetHandle)call.objects[2]);
+			break;
+		default:
+			c.object0 = targetIds.get((TargetHandle)call.objects[0]);
+			c.object1 = pipelineIds.get((PipelineHandle)call.objects[1]);
+			c.object2 = resourceSetIds.get((ResourceSetHandle)call.objects[2]);
+			break;
+		}
+
+		callList.push_back(c);
+	}
+
+	builder.set_signature(CAPTURE_SIGNATURE);
+	builder.set_version(CAPTURE_VERSION);
+
+	builder.set_resources(writeArray(builder, resourceList));
+	builder.set_shaders(writeArray(builder, shaderList));
+	builder.set_pipelines(writeArray(builder, pipelineList));
+	builder.set_targets(writeArray(builder, targetList));
+	builder.set_resourceSets(writeArray(builder, resourceSetList));
+
+	builder.set_imageViews(writeArray(builder, imageViews));
+	builder.set_vertexBuffers(writeArray(builder, vertexBuffers));
+	builder.set_constantBuffers(writeArray(builder, constantBuffers));
+	builder.set_storageBuffers(writeArray(builder, storageBuffers));
+	builder.set_samplers(writeArray(builder, samplers));
+	builder.set_vertexAttributes(writeArray(builder, vertexAttributes));
+
+	builder.set_calls(writeArray(builder, callList));
+	builder.set_payload(writeArray(builder, payload));
+
+	builder.build(out);
+
+	return out.good();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Capture device
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+CaptureDevice::CaptureDevice(RenderDevice* device) :
+	pState(new State(device))
+{
+	tsassert(device);
+}
+
+CaptureDevice::~CaptureDevice()
+{
+	pState.reset();
+}
+
+RenderDevice* CaptureDevice::getDevice() const
+{
+	return pState->device;
+}
+
+void CaptureDevice::beginCapture()
+{
+	tsassert(pState);
+
+	pState->calls.clear();
+	pState->payload.clear();
+	pState->capturing = true;
+}
+
+bool CaptureDevice::endCapture(std::ostream& out)
+{
+	tsassert(pState);
+
+	if (!pState->capturing)
+	{
+		tswarn("endCapture() called without beginCapture()");
+		return false;
+	}
+
+	pState->capturing = false;
+
+	bool ok = pState->write(out);
+
+	pState->calls.clear();
+	pState->payload.clear();
+
+	return ok;
+}
+
+bool CaptureDevice::endCapture(const Path& file)
+{
+	std::ofstream out(file.str(), std::ios::binary);
+
+	if (!out)
+	{
+		tswarn("unable to open capture file \"%\"", file.str());
+	}
+
+	return endCapture(out) && out.good();
+}
+
+bool CaptureDevice::isCapturing() const
+{
+	return pState->capturing;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+RenderContext* CaptureDevice::context() { return &pState->context; }
+void CaptureDevice::commit() { pState->device->commit(); }
+
+void CaptureDevice::setDisplayConfiguration(const DisplayConfig& displayCfg) { pState->device->setDisplayConfiguration(displayCfg); }
+void CaptureDevice::getDisplayConfiguration(DisplayConfig& displayCfg) { pState->device->getDisplayConfiguration(displayCfg); }
+ResourceHandle CaptureDevice::getDisplayTarget() { return pState->device->getDisplayTarget(); }
+
+void CaptureDevice::queryStats(RenderStats& stats) { pState->device->queryStats(stats); }
+void CaptureDevice::queryInfo(RenderDeviceInfo& info) { pState->device->queryInfo(info); }
+
+/*
+	Objects are created on the wrapped device but owned through this device,
+	so their descriptions are removed when they are destroyed
+*/
+
+RPtr<ResourceHandle> CaptureDevice::createEmptyResource(ResourceHandle recycle)
+{
+	RPtr<ResourceHandle> rsc = pState->device->createEmptyResource(recycle);
+
+	if (rsc)
+	{
+		pState->resources[rsc.handle()] = ResourceDesc();
+	}
+
+	return RPtr<ResourceHandle>(this, rsc.release());
+}
+
+RPtr<ResourceHandle> CaptureDevice::createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle)
+{
+	RPtr<ResourceHandle> rsc = pState->device->createResourceBuffer(data, info, recycle);
+
+	if (rsc)
+	{
+		ResourceDesc desc;
+		desc.buffer = info;
+
+		if (data.memory != nullptr)
+		{
+			desc.data.assign((const byte*)data.memory, (const byte*)data.memory + info.size);
+		}
+
+		pState->resources[rsc.handle()] = std::move(desc);
+	}
+
+	return RPtr<ResourceHandle>(this, rsc.release());
+}
+
+RPtr<ResourceHandle> CaptureDevice::createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle)
+{
+	RPtr<ResourceHandle> rsc = pState->device->createResourceImage(data, info, recycle);
+
+	if (rsc)
+	{
+		//Image contents are not captured, replayed images are created empty
+		ResourceDesc desc;
+		desc.isImage = true;
+		desc.image = info;
+
+		pState->resources[rsc.handle()] = std::move(desc);
+	}
+
+	return RPtr<ResourceHandle>(this, rsc.release());
+}
+
+RPtr<ResourceSetHandle> CaptureDevice::createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle)
+{
+	RPtr<ResourceSetHandle> set = pState->device->createResourceSet(info, recycle);
+
+	if (set)
+	{
+		ResourceSetDesc desc;
+		desc.resources.assign(info.resources, info.resources + info.resourceCount);
+		desc.constantBuffers.assign(info.constantBuffers, info.constantBuffers + info.constantBuffersCount);
+		desc.vertexBuffers.assign(info.vertexBuffers, info.vertexBuffers + info.vertexBufferCount);
+		desc.indexBuffer = info.indexBuffer;
+		desc.dynamicConstants = info.dynamicConstants;
+		desc.storageBuffers.assign(info.storageBuffers, info.storageBuffers + info.storageBufferCount);
+		desc.storageImages.assign(info.storageImages, info.storageImages + info.storageImageCount);
+
+		pState->resourceSets[set.handle()] = std::move(desc);
+	}
+
+	return RPtr<ResourceSetHandle>(this, set.release());
+}
+
+RPtr<ShaderHandle> CaptureDevice::createShader(const ShaderCreateInfo& info)
+{
+	RPtr<ShaderHandle> shader = pState->device->createShader(info);
+
+	if (shader)
+	{
+		ShaderDesc desc;
+
+		for (size_t i = 0; i < (size_t)ShaderStage::MAX_STAGES; i++)
+		{
+			const byte* code = (const byte*)info.stages[i].bytecode;
+
+			if (code != nullptr)
+			{
+				desc.stages[i].assign(code, code + info.stages[i].size);
+			}
+		}
+
+		pState->shaders[shader.handle()] = std::move(desc);
+	}
+
+	return RPtr<ShaderHandle>(this, shader.release());
+}
+
+RPtr<PipelineHandle> CaptureDevice::createPipeline(ShaderHandle program, const PipelineCreateInfo& info)
+{
+	RPtr<PipelineHandle> pipeline = pState->device->createPipeline(program, info);
+
+	if (pipeline)
+	{
+		PipelineDesc desc;
+		desc.shader = program;
+		desc.info = info;
+		desc.samplers.assign(info.samplers, info.samplers + info.samplerCount);
+		desc.attributes.assign(info.vertexAttributeList, info.vertexAttributeList + info.vertexAttributeCount);
+
+		//Semantic names are owned by the caller
+		for (const VertexAttribute& attrib : desc.attributes)
+		{
+			desc.semantics.push_back(attrib.semanticName);
+		}
+
+		desc.info.samplers = nullptr;
+		desc.info.vertexAttributeList = nullptr;
+
+		pState->pipelines[pipeline.handle()] = std::move(desc);
+	}
+
+	return RPtr<PipelineHandle>(this, pipeline.release());
+}
+
+RPtr<TargetHandle> CaptureDevice::createTarget(const TargetCreateInfo& info, TargetHandle recycle)
+{
+	RPtr<TargetHandle> target = pState->device->createTarget(info, recycle);
+
+	if (target)
+	{
+		TargetDesc desc;
+		desc.attachments.assign(info.attachments, info.attachments + info.attachmentCount);
+		desc.depth = info.depth;
+		desc.viewport = info.viewport;
+		desc.scissor = info.scissor;
+
+		pState->targets[target.handle()] = std::move(desc);
+	}
+
+	return RPtr<TargetHandle>(this, target.release());
+}
+
+void CaptureDevice::destroy(ResourceHandle rsc)
+{
+	pState->resources.erase(rsc);
+	pState->device->destroy(rsc);
+}
+
+void CaptureDevice::destroy(ResourceSetHandle set)
+{
+	pState->resourceSets.erase(set);
+	pState->device->destroy(set);
+}
+
+void CaptureDevice::destroy(ShaderHandle shader)
+{
+	pState->shaders.erase(shader);
+	pState->device->destroy(shader);
+}
+
+void CaptureDevice::destroy(PipelineHandle state)
+{
+	pState->pipelines.erase(state);
+	pState->device->destroy(state);
+}
+
+void CaptureDevice::destroy(TargetHandle pass)
+{
+	pState->targets.erase(pass);
+	pState->device->destroy(pass);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Replay
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+//Decoded call, objects are resolved to handles of the replay device
+struct ReplayCall
+{
+	tsr::CaptureCallType type;
+	uintptr objects[3];
+	uint32 value;
+	uint64 key;
+	const void* payload;
+	uint32 payloadSize;
+	DrawParams params;
+	DispatchParams dispatch;
+};
+
+struct FrameReplay::Replay
+{
+	rc::ResourceLoader loader;
+	const tsr::FrameCapture* capture = nullptr;
+
+	RenderDevice* device = nullptr;
+
+	//Objects created on the replay device, indexed by capture id - 1
+	std::vector<RPtr<ResourceHandle>> resources;
+	std::vector<RPtr<ShaderHandle>> shaders;
+	std::vector<RPtr<PipelineHandle>> pipelines;
+	std::vector<RPtr<TargetHandle>> targets;
+	std::vector<RPtr<ResourceSetHandle>> resourceSets;
+
+	//The display target is owned by the device
+	ResourceHandle display = ResourceHandle();
+
+	std::vector<ReplayCall> calls;
+	Stats stats;
+
+	template<typename handle_t>
+	static handle_t lookup(const std::vector<RPtr<handle_t>>& objects, uint32 id)
+	{
+		return (id > 0 && id <= objects.size()) ? objects[id - 1].handle() : handle_t();
+	}
+
+	ResourceHandle resource(uint32 id) const
+	{
+		if (id > 0 && id <= resources.size() && capture->resources()[id - 1].isDisplay)
+			return display;
+
+		return lookup(resources, id);
+	}
+
+	const byte* payload(const tsr::CaptureRange& range) const
+	{
+		return (range.size > 0) ? capture->payload().data() + range.offset : nullptr;
+	}
+
+	ImageView imageView(const tsr::CaptureImageView& v) const
+	{
+		ImageView view;
+		view.image = resource(v.image);
+		view.index = v.index;
+		view.count = v.count;
+		view.type = (ImageType)v.type;
+		return view;
+	}
+
+	static Viewport viewport(const tsr::CaptureViewport& v)
+	{
+		Viewport vp;
+		vp.w = v.w;
+		vp.h = v.h;
+		vp.x = v.x;
+		vp.y = v.y;
+		return vp;
+	}
+
+	void release()
+	{
+		//Destroy objects in reverse order of their dependencies
+		calls.clear();
+		resourceSets.clear();
+		targets.clear();
+		pipelines.clear();
+		shaders.clear();
+		resources.clear();
+
+		display = ResourceHandle();
+		device = nullptr;
+	}
+
+	bool create(RenderDevice* device);
+};
+
+bool FrameReplay::Replay::create(RenderDevice* replayDevice)
+{
+	release();
+
+	device = replayDevice;
+	display = device->getDisplayTarget();
+
+	/*
+		Resources
+	*/
+	for (uint32 i = 0; i < capture->resources().length(); i++)
+	{
+		const tsr::CaptureResource& r = capture->resources()[i];
+
+		if (r.isDisplay)
+		{
+			resources.push_back(RPtr<ResourceHandle>());
+		}
+		else if (r.isImage)
+		{
+			ImageResourceInfo info;
+			info.format = (ImageFormat)r.format;
+			info.type = (ImageType)r.imageType;
+			info.usage = (ImageUsage)r.usage;
+			info.width = r.width;
+			info.height = r.height;
+			info.length = r.length;
+			info.useMips = r.useMips;
+			info.msLevels = r.msLevels;
+			info.mipLevels = r.mipLevels;
+
+			resources.push_back(device->createResourceImage(nullptr, info, ResourceHandle()));
+		}
+		else if (r.size > 0)
+		{
+			BufferResourceInfo info;
+			info.size = r.size;
+			info.type = (BufferType)r.bufferType;
+
+			ResourceData data;
+			data.memory = payload(r.data);
+
+			resources.push_back(device->createResourceBuffer(data, info, ResourceHandle()));
+		}
+		else
+		{
+			resources.push_back(device->createEmptyResource(ResourceHandle()));
+		}
+	}
+
+	/*
+		Shaders
+	*/
+	for (uint32 i = 0; i < capture->shaders().length(); i++)
+	{
+		const tsr::CaptureShader& s = capture->shaders()[i];
+		const tsr::CaptureRange* stages[] = { &s.vertex, &s.geometry, &s.tessCtrl, &s.tessEval, &s.pixel, &s.compute };
+
+		ShaderCreateInfo info;
+
+		for (size_t stage = 0; stage < (size_t)ShaderStage::MAX_STAGES; stage++)
+		{
+			info.stages[stage].bytecode = payload(*stages[stage]);
+			info.stages[stage].size = stages[stage]->size;
+		}
+
+		shaders.push_back(device->createShader(info));
+	}
+
+	/*
+		Pipelines
+	*/
+	for (uint32 i = 0; i < capture->pipelines().length(); i++)
+	{
+		const tsr::CapturePipeline& p = capture->pipelines()[i];
+
+		std::vector<SamplerState> samplers(p.samplerCount);
+		std::vector<VertexAttribute> attributes(p.attributeCount);
+
+		for (uint32 j = 0; j < p.samplerCount; j++)
+		{
+			const tsr::CaptureSampler& s = capture->samplers()[p.samplerStart + j];
+			samplers[j].addressU = (ImageAddressMode)s.addressU;
+			samplers[j].addressV = (ImageAddressMode)s.addressV;
+			samplers[j].addressW = (ImageAddressMode)s.addressW;
+			samplers[j].filtering = (ImageFilterMode)s.filtering;
+			samplers[j].borderColour = RGBA(s.borderColour);
+			samplers[j].anisotropy = s.anisotropy;
+		}
+
+		for (uint32 j = 0; j < p.attributeCount; j++)
+		{
+			const tsr::CaptureVertexAttribute& a = capture->vertexAttributes()[p.attributeStart + j];
+			attributes[j].bufferSlot = a.bufferSlot;
+			attributes[j].semanticName = (const char*)payload(a.semanticName);
+			attributes[j].byteOffset = a.byteOffset;
+			attributes[j].type = (VertexAttributeType)a.type;
+			attributes[j].channel = (VertexAttributeChannel)a.channel;
+		}
+
+		PipelineCreateInfo info;
+		info.raster.enableScissor = p.enableScissor;
+		info.raster.cullMode = (CullMode)p.cullMode;
+		info.raster.fillMode = (FillMode)p.fillMode;
+		info.depth.enableDepth = p.enableDepth;
+		info.depth.enableStencil = p.enableStencil;
+		info.blend.enable = p.enableBlend;
+		info.topology = (VertexTopology)p.topology;
+		info.samplers = samplers.data();
+		info.samplerCount = samplers.size();
+		info.vertexAttributeList = attributes.data();
+		info.vertexAttributeCount = attributes.size();
+
+		pipelines.push_back(device->createPipeline(lookup(shaders, p.shader), info));
+	}
+
+	/*
+		Targets
+	*/
+	for (uint32 i = 0; i < capture->targets().length(); i++)
+	{
+		const tsr::CaptureTarget& t = capture->targets()[i];
+
+		std::vector<ImageView> attachments(t.attachmentCount);
+
+		for (uint32 j = 0; j < t.attachmentCount; j++)
+			attachments[j] = imageView(capture->imageViews()[t.attachmentStart + j]);
+
+		TargetCreateInfo info;
+		info.attachments = attachments.data();
+		info.attachmentCount = (uint32)attachments.size();
+		info.depth = imageView(t.depth);
+		info.viewport = viewport(t.viewport);
+		info.scissor = viewport(t.scissor);
+
+		targets.push_back(device->createTarget(info, TargetHandle()));
+	}
+
+	/*
+		Resource sets
+	*/
+	for (uint32 i = 0; i < capture->resourceSets().length(); i++)
+	{
+		const tsr::CaptureResourceSet& s = capture->resourceSets()[i];
+
+		std::vector<ImageView> views(s.resourceCount);
+		std::vector<ResourceHandle> constants(s.constantCount);
+		std::vector<VertexBufferView> vertexBuffers(s.vertexBufferCount);
+		std::vector<ResourceHandle> storageBuffers(s.storageBufferCount);
+		std::vector<ImageView> storageImages(s.storageImageCount);
+
+		for (uint32 j = 0; j < s.resourceCount; j++)
+			views[j] = imageView(capture->imageViews()[s.resourceStart + j]);
+
+		for (uint32 j = 0; j < s.constantCount; j++)
+			constants[j] = resource(capture->constantBuffers()[s.constantStart + j]);
+
+		for (uint32 j = 0; j < s.vertexBufferCount; j++)
+		{
+			const tsr::CaptureVertexBufferView& v = capture->vertexBuffers()[s.vertexBufferStart + j];
+			vertexBuffers[j].buffer = resource(v.buffer);
+			vertexBuffers[j].stride = v.stride;
+			vertexBuffers[j].offset = v.offset;
+		}
+
+		for (uint32 j = 0; j < s.storageBufferCount; j++)
+			storageBuffers[j] = resource(capture->storageBuffers()[s.storageBufferStart + j]);
+
+		for (uint32 j = 0; j < s.storageImageCount; j++)
+			storageImages[j] = imageView(capture->imageViews()[s.storageImageStart + j]);
+
+		ResourceSetCreateInfo info;
+		info.resources = views.data();
+		info.resourceCount = (uint32)views.size();
+		info.constantBuffers = constants.data();
+		info.constantBuffersCount = (uint32)constants.size();
+		info.vertexBuffers = vertexBuffers.data();
+		info.vertexBufferCount = (uint32)vertexBuffers.size();
+		info.indexBuffer = resource(s.indexBuffer);
+		info.dynamicConstants = s.dynamicConstants;
+		info.storageBuffers = storageBuffers.data();
+		info.storageBufferCount = (uint32)storageBuffers.size();
+		info.storageImages = storageImages.data();
+		info.storageImageCount = (uint32)storageImages.size();
+
+		resourceSets.push_back(device->createResourceSet(info, ResourceSetHandle()));
+	}
+
+	/*
+		Decode calls up front so execution only measures submission
+	*/
+	calls.reserve(capture->calls().length());
+
+	for (uint32 i = 0; i < capture->calls().length(); i++)
+	{
+		const tsr::CaptureCall& c = capture->calls()[i];
+
+		ReplayCall call;
+		call.type = (tsr::CaptureCallType)c.type;
+		call.value = c.value;
+		call.key = c.key;
+		call.payload = payload(c.payload);
+		call.payloadSize = c.payload.size;
+
+		call.params.start = c.params.start;
+		call.params.count = c.params.count;
+		call.params.vbase = c.params.vbase;
+		call.params.instances = c.params.instances;
+		call.params.constantOffset = c.params.constantOffset;
+		call.params.mode = (DrawMode)c.params.mode;
+
+		call.dispatch.groupsX = c.dispatch.groupsX;
+		call.dispatch.groupsY = c.dispatch.groupsY;
+		call.dispatch.groupsZ = c.dispatch.groupsZ;
+		call.dispatch.constantOffset = c.dispatch.constantOffset;
+
+		switch (call.type)
+		{
+		case tsr::CAPTURE_CALL_UPDATE:
+		case tsr::CAPTURE_CALL_UPDATE_RANGE:
+		case tsr::CAPTURE_CALL_COPY:
+		case tsr::CAPTURE_CALL_RESOLVE:
+		case tsr::CAPTURE_CALL_DRAW_INDIRECT:
+			call.objects[0] = (uintptr)resource(c.object0);
+			call.objects[1] = (uintptr)resource(c.object1);
+			call.objects[2] = 0;
+			break;
+		case tsr::CAPTURE_CALL_DISPATCH_INDIRECT:
+			call.objects[0] = (uintptr)resource(c.object0);
+			call.objects[1] = (uintptr)lookup(pipelines, c.object1);
+			call.objects[2] = (uintptr)lookup(resourceSets, c.object2);
+			break;
+		default:
+			call.objects[0] = (uintptr)lookup(targets, c.object0);
+			call.objects[1] = (uintptr)lookup(pipelines, c.object1);
+			call.objects[2] = (uintptr)lookup(resourceSets, c.object2);
+			break;
+		}
+
+		calls.push_back(call);
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameReplay::FrameReplay() :
+	pReplay(new Replay())
+{
+}
+
+FrameReplay::~FrameReplay()
+{
+	if (pReplay)
+	{
+		pReplay->release();
+	}
+
+	pReplay.reset();
+}
+
+bool FrameReplay::load(std::istream& in)
+{
+	tsassert(pReplay);
+
+	pReplay->release();
+	pReplay->capture = nullptr;
+	pReplay->stats = Stats();
+
+	pReplay->loader.load(in);
+
+	if (pReplay->loader.fail())
+	{
+		tswarn("unable to read frame capture");
+		return false;
+	}
+
+	const tsr::FrameCapture& capture = pReplay->loader.deserialize<tsr::FrameCapture>();
+
+	if (capture.signature() != CAPTURE_SIGNATURE || capture.version() != CAPTURE_VERSION)
+	{
+		tswarn("invalid frame capture");
+		return false;
+	}
+
+	pReplay->capture = &capture;
+
+	Stats& stats = pReplay->stats;
+
+	for (uint32 i = 0; i < capture.calls().length(); i++)
+	{
+		const uint32 type = capture.calls()[i].type;
+
+		stats.calls++;
+		stats.batches += (type == tsr::CAPTURE_CALL_BATCH) ? 1 : 0;
+		stats.draws += (type == tsr::CAPTURE_CALL_DRAW || type == tsr::CAPTURE_CALL_DRAW_BOUND) ? 1 : 0;
+		stats.draws += (type == tsr::CAPTURE_CALL_DRAW_INDIRECT) ? capture.calls()[i].params.count : 0;
+		stats.dispatches += (type == tsr::CAPTURE_CALL_DISPATCH || type == tsr::CAPTURE_CALL_DISPATCH_INDIRECT) ? 1 : 0;
+	}
+
+	stats.objects =
+		capture.resources().length() +
+		capture.shaders().length() +
+		capture.pipelines().length() +
+		capture.targets().length() +
+		capture.resourceSets().length();
+
+	stats.payloadSize = capture.payload().length();
+
+	return true;
+}
+
+bool FrameReplay::load(const Path& file)
+{
+	std::ifstream in(file.str(), std::ios::binary);
+
+	if (!in)
+	{
+		tswarn("unable to open frame capture \"%\"", file.str());
+		return false;
+	}
+
+	return load(in);
+}
+
+bool FrameReplay::create(RenderDevice* device)
+{
+	tsassert(pReplay);
+	tsassert(device);
+
+	if (pReplay->capture == nullptr)
+	{
+		tswarn("no frame capture has been loaded");
+		return false;
+	}
+
+	return pReplay->create(device);
+}
+
+void FrameReplay::execute(RenderContext* context)
+{
+	tsassert(pReplay);
+	tsassert(context);
+
+	for (const ReplayCall& call : pReplay->calls)
+	{
+		switch (call.type)
+		{
+		case tsr::CAPTURE_CALL_BATCH:
+			context->batchMarker(call.key);
+			break;
+		case tsr::CAPTURE_CALL_UPDATE:
+			if (call.payload != nullptr)
+				context->resourceUpdate((ResourceHandle)call.objects[0], call.payload, call.value);
+			break;
+		case tsr::CAPTURE_CALL_UPDATE_RANGE:
+			if (call.payload != nullptr)
+				context->resourceUpdateRange((ResourceHandle)call.objects[0], call.payload, call.value, call.payloadSize);
+			break;
+		case tsr::CAPTURE_CALL_COPY:
+			context->resourceCopy((ResourceHandle)call.objects[0], (ResourceHandle)call.objects[1]);
+			break;
+		case tsr::CAPTURE_CALL_RESOLVE:
+			context->imageResolve((ResourceHandle)call.objects[0], (ResourceHandle)call.objects[1], call.value);
+			break;
+		case tsr::CAPTURE_CALL_CLEAR_COLOUR:
+			context->clearColourTarget((TargetHandle)call.objects[0], call.value);
+			break;
+		case tsr::CAPTURE_CALL_CLEAR_DEPTH:
+		{
+			float depth;
+			memcpy(&depth, &call.value, sizeof(float));
+			context->clearDepthTarget((TargetHandle)call.objects[0], depth);
+			break;
+		}
+		case tsr::CAPTURE_CALL_DRAW:
+			context->draw((TargetHandle)call.objects[0], (PipelineHandle)call.objects[1], (ResourceSetHandle)call.objects[2], call.params);
+			break;
+		case tsr::CAPTURE_CALL_BIND_TARGET:
+			context->bindTarget((TargetHandle)call.objects[0]);
+			break;
+		case tsr::CAPTURE_CALL_BIND_PIPELINE:
+			context->bindPipeline((PipelineHandle)call.objects[1]);
+			break;
+		case tsr::CAPTURE_CALL_BIND_RESOURCES:
+			context->bindResourceSet((ResourceSetHandle)call.objects[2]);
+			break;
+		case tsr::CAPTURE_CALL_DRAW_BOUND:
+			context->drawBound(call.params);
+			break;
+		case tsr::CAPTURE_CALL_DRAW_INDIRECT:
+			context->multiDrawIndirect((ResourceHandle)call.objects[0], call.value, call.params.count, call.params.mode == DrawMode::INDEXEDINSTANCED);
+			break;
+		case tsr::CAPTURE_CALL_DISPATCH:
+			context->dispatch((PipelineHandle)call.objects[1], (ResourceSetHandle)call.objects[2], call.dispatch);
+			break;
+		case tsr::CAPTURE_CALL_DISPATCH_INDIRECT:
+			context->dispatchIndirect((PipelineHandle)call.objects[1], (ResourceSetHandle)call.objects[2], (ResourceHandle)call.objects[0], call.value);
+			break;
+		case tsr::CAPTURE_CALL_FINISH:
+			context->finish();
+			break;
+		}
+	}
+}
+
+void FrameReplay::release()
+{
+	tsassert(pReplay);
+	pReplay->release();
+}
+
+FrameReplay::Stats FrameReplay::getStats() const
+{
+	tsassert(pReplay);
+	return pReplay->stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
@@ -10,6 +10,7 @@
 
 #include <mutex>
 #include <atomic>
+#include <vector>
 
 #include <tsgraphics/Graphics.h>
 #include <tsgraphics/Driver.h>
@@ -27,6 +28,20 @@ struct GraphicsSystem::System : public GraphicsConfig
 	GraphicsSystem* system = nullptr;
 	//Primary rendering context
 	RenderContext* context = nullptr;
+
+	//Deferred destruction, must outlive every object created through it
+	UPtr<DeferredDestroyDevice> deferred;
+
+	//Frame capture, must outlive every object created through it
+	UPtr<CaptureDevice> capture;
+	Path captureFile;
+	bool capturePending = false;
+
+	//Command queue statistics of the current frame, the last frame and recent frames
+	CommandQueue::Stats frameStats;
+	CommandQueue::Stats lastFrameStats;
+	std::vector<CommandQueue::Stats> statsHistory;
+	uint32 statsIndex = 0;
 	
 	//Render target pool
 	ImageTargetPool displayTargets;
@@ -38,6 +53,10 @@ struct GraphicsSystem::System : public GraphicsConfig
 	ImageCache imageCache;
 	ModelCache modelCache;
 
+	//Shared pipelines and resource sets
+	PipelineCache pipelineCache;
+	ResourceSetCache resourceSetCache;
+
 	/*
 		Construct system
 	*/
@@ -64,16 +83,30 @@ GraphicsSystem::GraphicsSystem(const GraphicsConfig& cfg) :
 	devcfg.display.resolutionW = cfg.display.width;
 	devcfg.display.fullscreen = (cfg.display.mode == DisplayMode::FULLSCREEN);
 	devcfg.display.multisampleLevel = cfg.display.multisampleLevel;
-	devcfg.windowHandle = pSystem->surface->getHandle();
+	//Headless devices have no surface
+	devcfg.windowHandle = (pSystem->surface) ? pSystem->surface->getHandle() : 0;
 
 #ifdef _DEBUG
 	devcfg.flags |= RenderDeviceConfig::DEBUG;
 #endif
 
-	pDevice = RenderDevice::create(RenderDriverID::DX11, devcfg);
+	pDevice = RenderDevice::create(cfg.id, devcfg);
+	tsassert(pDevice);
+
+	if (cfg.deferDestruction)
+	{
+		pSystem->deferred.reset(new DeferredDestroyDevice(pDevice.get(), cfg.destroyLatency));
+	}
+
+	if (cfg.enableCapture)
+	{
+		//Captures objects created through the deferred device
+		RenderDevice* captured = pSystem->deferred ? (RenderDevice*)pSystem->deferred.get() : pDevice.get();
+		pSystem->capture.reset(new CaptureDevice(captured));
+	}
 
 	//If desired display mode is borderless, ISurface::enableBorderless() must be called manually
-	if (cfg.display.mode == DisplayMode::BORDERLESS)
+	if (cfg.display.mode == DisplayMode::BORDERLESS && cfg.surface)
 	{
 		cfg.surface->enableBorderless(true);
 		//Refreshing the display forces the display to resize
@@ -86,7 +119,7 @@ GraphicsSystem::GraphicsSystem(const GraphicsConfig& cfg) :
 	}
 
 	//Create main render context
-	pSystem->context = pDevice->context();
+	pSystem->context = device()->context();
 
 	//Prepare image target pool
 	pSystem->displayTargets = ImageTargetPool(device(), cfg.display.width, cfg.display.height, cfg.display.multisampleLevel);
@@ -94,6 +127,8 @@ GraphicsSystem::GraphicsSystem(const GraphicsConfig& cfg) :
 	//Initialize caches
 	pSystem->imageCache = ImageCache(device());
 	pSystem->modelCache = ModelCache(device());
+	pSystem->pipelineCache = PipelineCache(device());
+	pSystem->resourceSetCache = ResourceSetCache(device());
 
 	//Register display change signal handler
 	onDisplayChange += DisplayEvent::CallbackType::fromMethod<ImageTargetPool, &ImageTargetPool::resize>(getDisplayTargetPool());
@@ -105,6 +140,21 @@ GraphicsSystem::~GraphicsSystem()
 	pSystem.reset();
 }
 
+RenderDevice* GraphicsSystem::device() const
+{
+	if (pSystem && pSystem->capture)
+	{
+		return pSystem->capture.get();
+	}
+
+	if (pSystem && pSystem->deferred)
+	{
+		return pSystem->deferred.get();
+	}
+
+	return pDevice.get();
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 // Manage display settings
 /////////////////////////////////////////////////////////////////////////////////////////////////
@@ -129,6 +179,9 @@ void GraphicsSystem::refreshDisplay()
 
 	Guard g(pSystem->displayLock);
 
+	if (!pSystem->surface)
+		return;
+
 	pSystem->surface->getSize(
 		pSystem->display.width,
 		pSystem->display.height
@@ -202,7 +255,7 @@ void GraphicsSystem::System::doRebuildDisplay()
 
 		if (config.fullscreen)
 			curMode = DisplayMode::FULLSCREEN;
-		else if (surface->isBorderless())
+		else if (surface && surface->isBorderless())
 			curMode = DisplayMode::BORDERLESS;
 		else
 			curMode = DisplayMode::WINDOWED;
@@ -217,7 +270,7 @@ void GraphicsSystem::System::doRebuildDisplay()
 			{
 				case DisplayMode::WINDOWED:
 				{
-					if (mode == DisplayMode::BORDERLESS)
+					if (mode == DisplayMode::BORDERLESS && surface)
 					{
 						//Enter borderless
 						surface->enableBorderless(true);
@@ -239,7 +292,8 @@ void GraphicsSystem::System::doRebuildDisplay()
 					curMode = DisplayMode::WINDOWED;
 
 					//Exit borderless
-					surface->enableBorderless(false);
+					if (surface)
+						surface->enableBorderless(false);
 					break;
 				}
 
@@ -262,7 +316,7 @@ void GraphicsSystem::System::doRebuildDisplay()
 	*/
 	if ((config.resolutionH != display.height) || (config.resolutionW != display.width))
 	{
-		if (display.mode == DisplayMode::WINDOWED)
+		if (display.mode == DisplayMode::WINDOWED && surface)
 		{
 			uint curW = 0;
 			uint curH = 0;
@@ -307,6 +361,16 @@ ImageTargetPool* GraphicsSystem::getDisplayTargetPool() const
 	return &pSystem->displayTargets;
 }
 
+PipelineCache* GraphicsSystem::getPipelineCache() const
+{
+	return &pSystem->pipelineCache;
+}
+
+ResourceSetCache* GraphicsSystem::getResourceSetCache() const
+{
+	return &pSystem->resourceSetCache;
+}
+
 ImageView GraphicsSystem::getDisplayView() const
 {
 	ImageView view;
@@ -361,6 +425,12 @@ void GraphicsSystem::begin()
 
 	//Main context
 	RenderContext* rc = pSystem->context;
+
+	if (pSystem->capturePending)
+	{
+		pSystem->capture->beginCapture();
+		pSystem->capturePending = false;
+	}
 }
 
 void GraphicsSystem::end()
@@ -372,6 +442,49 @@ void GraphicsSystem::end()
 
 	rc->finish();
 	device()->commit();
+
+	//Record queue statistics of this frame
+	pSystem->lastFrameStats = pSystem->frameStats;
+	pSystem->frameStats = CommandQueue::Stats();
+
+	if (pSystem->statsFrames > 0)
+	{
+		auto& history = pSystem->statsHistory;
+
+		if (history.size() < pSystem->statsFrames)
+		{
+			history.push_back(pSystem->lastFrameStats);
+		}
+		else
+		{
+			history[pSystem->statsIndex] = pSystem->lastFrameStats;
+			pSystem->statsIndex = (pSystem->statsIndex + 1) % pSystem->statsFrames;
+		}
+	}
+
+	if (pSystem->capture && pSystem->capture->isCapturing())
+	{
+		if (pSystem->capture->endCapture(pSystem->captureFile))
+		{
+			tsinfo("Captured frame to \"%\"", pSystem->captureFile.str());
+		}
+	}
+}
+
+bool GraphicsSystem::captureFrame(const Path& file)
+{
+	tsassert(pSystem);
+
+	if (!pSystem->capture)
+	{
+		tswarn("Frame capture is not enabled");
+		return false;
+	}
+
+	pSystem->captureFile = file;
+	pSystem->capturePending = true;
+
+	return true;
 }
 
 void GraphicsSystem::execute(CommandQueue* queue)
@@ -379,6 +492,43 @@ void GraphicsSystem::execute(CommandQueue* queue)
 	tsassert(pSystem);
 
 	queue->flush(pSystem->context);
+
+	pSystem->frameStats += queue->getStats();
+}
+
+CommandQueue::Stats GraphicsSystem::getQueueStats() const
+{
+	tsassert(pSystem);
+	return pSystem->lastFrameStats;
+}
+
+CommandQueue::Stats GraphicsSystem::getQueueStatsAverage() const
+{
+	tsassert(pSystem);
+
+	CommandQueue::Stats average;
+
+	if (pSystem->statsHistory.empty())
+		return average;
+
+	for (const CommandQueue::Stats& stats : pSystem->statsHistory)
+	{
+		average += stats;
+	}
+
+	average /= (uint32)pSystem->statsHistory.size();
+
+	return average;
+}
+
+DeferredDestroyStats GraphicsSystem::getDestroyStats() const
+{
+	tsassert(pSystem);
+
+	if (!pSystem->deferred)
+		return DeferredDestroyStats();
+
+	return pSystem->deferred->getStats();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,238 @@
+/*
+	Indirect Draw Builder source
+*/
+
+#include <tsgraphics/IndirectDraw.h>
+
+#include <tscore/debug/assert.h>
+#include <tscore/debug/log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace ts;
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	State
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct IndirectBatch
+{
+	TargetHandle outputs;
+	PipelineHandle pipeline;
+	ResourceSetHandle inputs;
+	bool indexed = false;
+
+	//Direct batches are a single draw of their params, indirect batches draw count arguments from a byte offset
+	bool direct = false;
+	DrawParams params;
+	uint32 offset = 0;
+	uint32 count = 0;
+};
+
+struct IndirectDrawBuilder::State
+{
+	RenderDevice* device;
+
+	RPtr<ResourceHandle> buffer;
+	uint32 capacity = 0;
+
+	std::vector<uint8> arguments;
+	std::vector<IndirectBatch> batches;
+
+	//True if the buffer holds the current arguments
+	bool uploaded = false;
+
+	Stats stats;
+
+	State(RenderDevice* device) : device(device) {}
+
+	template<typename args_t>
+	void write(const args_t& args)
+	{
+		const size_t offset = arguments.size();
+		arguments.resize(offset + sizeof(args_t));
+		memcpy(&arguments[offset], &args, sizeof(args_t));
+	}
+
+	bool grow(uint32 size)
+	{
+		const uint32 capacity = std::max(size, this->capacity * 2);
+
+		//The new buffer is created with the arguments so it needn't be updated
+		std::vector<uint8> contents(capacity, 0);
+		memcpy(contents.data(), arguments.data(), arguments.size());
+
+		ResourceData data;
+		data.memory = contents.data();
+
+		BufferResourceInfo info;
+		info.size = capacity;
+		info.type = BufferType::INDIRECT;
+
+		buffer = device->createResourceBuffer(data, info);
+		this->capacity = buffer ? capacity : 0;
+
+		if (!buffer)
+		{
+			tswarn("unable to create indirect argument buffer of % bytes", capacity);
+			return false;
+		}
+
+		return true;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Builder
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+IndirectDrawBuilder::IndirectDrawBuilder(RenderDevice* device) :
+	pState(new State(device))
+{
+	tsassert(device);
+}
+
+IndirectDrawBuilder::~IndirectDrawBuilder()
+{
+	pState.reset();
+}
+
+RenderDevice* IndirectDrawBuilder::getDevice() const { return pState->device; }
+ResourceHandle IndirectDrawBuilder::getBuffer() const { return pState->buffer.handle(); }
+
+void IndirectDrawBuilder::add(const CommandDraw& draw)
+{
+	tsassert(pState);
+
+	State& s = *pState;
+
+	const DrawParams& p = draw.params;
+	const bool indexed = (p.mode == DrawMode::INDEXED || p.mode == DrawMode::INDEXEDINSTANCED);
+	const bool instanced = (p.mode == DrawMode::INSTANCED || p.mode == DrawMode::INDEXEDINSTANCED);
+
+	s.stats.draws++;
+
+	//Dynamic constant buffers of indirect draws are bound at offset 0
+	if (p.constantOffset != 0)
+	{
+		IndirectBatch b;
+		b.outputs = draw.outputs;
+		b.pipeline = draw.pipeline;
+		b.inputs = draw.inputs;
+		b.indexed = indexed;
+		b.direct = true;
+		b.params = p;
+		s.batches.push_back(b);
+
+		s.stats.directDraws++;
+		return;
+	}
+
+	const IndirectBatch* last = s.batches.empty() ? nullptr : &s.batches.back();
+
+	if (last == nullptr || last->direct ||
+		last->outputs != draw.outputs || last->pipeline != draw.pipeline || last->inputs != draw.inputs ||
+		last->indexed != indexed)
+	{
+		IndirectBatch b;
+		b.outputs = draw.outputs;
+		b.pipeline = draw.pipeline;
+		b.inputs = draw.inputs;
+		b.indexed = indexed;
+		b.offset = (uint32)s.arguments.size();
+		s.batches.push_back(b);
+
+		s.stats.batches++;
+	}
+
+	if (indexed)
+	{
+		DrawIndexedIndirectArgs args;
+		args.count = p.count;
+		args.instances = instanced ? p.instances : 1;
+		args.start = p.start;
+		args.vbase = p.vbase;
+		s.write(args);
+	}
+	else
+	{
+		DrawIndirectArgs args;
+		args.count = p.count;
+		args.instances = instanced ? p.instances : 1;
+		args.start = p.start;
+		s.write(args);
+	}
+
+	s.batches.back().count++;
+	s.stats.argumentBytes = (uint32)s.arguments.size();
+	s.uploaded = false;
+}
+
+void IndirectDrawBuilder::add(const CommandDraw* draws, uint32 count)
+{
+	for (uint32 i = 0; i < count; i++)
+	{
+		add(draws[i]);
+	}
+}
+
+void IndirectDrawBuilder::submit(RenderContext* context)
+{
+	tsassert(pState);
+	tsassert(context);
+
+	State& s = *pState;
+
+	if (!s.uploaded && !s.arguments.empty())
+	{
+		const uint32 size = (uint32)s.arguments.size();
+
+		if (size > s.capacity)
+		{
+			if (!s.grow(size))
+				return;
+		}
+		else
+		{
+			context->resourceUpdateRange(s.buffer.handle(), s.arguments.data(), 0, size);
+		}
+
+		s.uploaded = true;
+	}
+
+	for (const IndirectBatch& b : s.batches)
+	{
+		if (b.direct)
+		{
+			context->draw(b.outputs, b.pipeline, b.inputs, b.params);
+		}
+		else
+		{
+			context->bindTarget(b.outputs);
+			context->bindPipeline(b.pipeline);
+			context->bindResourceSet(b.inputs);
+			context->multiDrawIndirect(s.buffer.handle(), b.offset, b.count, b.indexed);
+		}
+	}
+}
+
+void IndirectDrawBuilder::clear()
+{
+	tsassert(pState);
+
+	State& s = *pState;
+
+	s.arguments.clear();
+	s.batches.clear();
+	s.uploaded = false;
+	s.stats = Stats();
+}
+
+IndirectDrawBuilder::Stats IndirectDrawBuilder::getStats() const
+{
+	return pState->stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
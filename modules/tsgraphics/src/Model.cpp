@@ -27,23 +27,29 @@ bool Model::load(RenderDevice* device, const String& filePath)
 		return !setError(true);
 	}
 
-	m_vertices = Buffer::create(
-		device,
-		modelReader.vertexData().data(),
-		modelReader.vertexData().size(),
-		BufferType::VERTEX
-	);
+	//Vertex and index buffers are created together
+	ResourceData data[2];
+	BufferResourceInfo info[2];
+	RPtr<ResourceHandle> buffers[2];
+	uint32 bufferCount = 1;
+
+	data[0].memory = modelReader.vertexData().data();
+	info[0].size = modelReader.vertexData().size();
+	info[0].type = BufferType::VERTEX;
 
 	if (modelReader.has_indexData())
 	{
-		m_indices = Buffer::create(
-			device,
-			modelReader.indexData().data(),
-			modelReader.indexData().size() * sizeof(uint32),
-			BufferType::INDEX
-		);
+		data[1].memory = modelReader.indexData().data();
+		info[1].size = modelReader.indexData().size() * sizeof(uint32);
+		info[1].type = BufferType::INDEX;
+		bufferCount++;
 	}
 
+	device->createResourceBuffers(data, info, bufferCount, buffers);
+
+	m_vertices = Buffer(std::move(buffers[0]));
+	m_indices = Buffer(std::move(buffers[1]));
+
 	//Copy attributes
 	if (modelReader.has_attributeNames())
 	{
@@ -0,0 +1,134 @@
+/*
+	Pipeline Cache source
+*/
+
+#include <tsgraphics/PipelineCache.h>
+
+#include <tscore/debug/assert.h>
+
+#include <mutex>
+
+#include "CacheKey.h"
+
+using namespace ts;
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Descriptor keys
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+//Vertex attribute semantics are encoded as strings rather than pointers
+static internal::CacheKey pipelineKey(ShaderHandle program, const PipelineCreateInfo& info)
+{
+	internal::CacheKey key;
+
+	key.value(program);
+
+	key.value(info.raster.enableScissor).value(info.raster.cullMode).value(info.raster.fillMode);
+	key.value(info.depth.enableDepth).value(info.depth.enableStencil);
+	key.value(info.blend.enable);
+	key.value(info.topology);
+
+	key.value((uint32)info.samplerCount);
+
+	for (size_t i = 0; i < info.samplerCount; i++)
+	{
+		const SamplerState& s = info.samplers[i];
+		key.value(s.addressU).value(s.addressV).value(s.addressW).value(s.filtering).value(s.borderColour.get()).value(s.anisotropy);
+	}
+
+	key.value((uint32)info.vertexAttributeCount);
+
+	for (size_t i = 0; i < info.vertexAttributeCount; i++)
+	{
+		const VertexAttribute& a = info.vertexAttributeList[i];
+		key.value(a.bufferSlot).value(a.byteOffset).value(a.type).value(a.channel).string(a.semanticName);
+	}
+
+	return key;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	State
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct PipelineCache::State
+{
+	RenderDevice* device;
+
+	mutable std::mutex lock;
+	internal::CacheTable<CachedPipeline> pipelines;
+
+	Stats stats;
+
+	State(RenderDevice* device) : device(device) {}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Cache
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+PipelineCache::PipelineCache(RenderDevice* device) :
+	pState(new State(device))
+{
+	tsassert(device);
+}
+
+PipelineCache::~PipelineCache()
+{
+	pState.reset();
+}
+
+RenderDevice* PipelineCache::getDevice() const
+{
+	return pState->device;
+}
+
+PipelineRef PipelineCache::get(ShaderHandle program, const PipelineCreateInfo& info)
+{
+	tsassert(pState);
+
+	const internal::CacheKey key = pipelineKey(program, info);
+	const uint64 h = key.hash();
+
+	std::lock_guard<std::mutex> lk(pState->lock);
+
+	pState->stats.lookups++;
+
+	if (PipelineRef pipeline = pState->pipelines.find(key, h))
+	{
+		pState->stats.hits++;
+		pState->stats.savedBytes += key.bytes().size();
+		return pipeline;
+	}
+
+	RPtr<PipelineHandle> handle = pState->device->createPipeline(program, info);
+
+	if (!handle)
+		return PipelineRef();
+
+	PipelineRef pipeline(new CachedPipeline(std::move(handle), h));
+	pState->pipelines.insert(key, h, pipeline);
+
+	pState->stats.created++;
+
+	return pipeline;
+}
+
+PipelineCache::Stats PipelineCache::getStats() const
+{
+	tsassert(pState);
+
+	std::lock_guard<std::mutex> lk(pState->lock);
+
+	Stats stats = pState->stats;
+	stats.live = pState->pipelines.live();
+
+	return stats;
+}
+
+uint64 PipelineCache::hash(ShaderHandle program, const PipelineCreateInfo& info)
+{
+	return pipelineKey(program, info).hash();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
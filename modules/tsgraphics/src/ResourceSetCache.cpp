@@ -0,0 +1,281 @@
+/*
+	Resource Set Cache source
+*/
+
+#include <tsgraphics/ResourceSetCache.h>
+
+#include <tscore/debug/assert.h>
+#include <tscore/debug/log.h>
+
+#include <mutex>
+
+#include "CacheKey.h"
+
+using namespace ts;
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Descriptor keys
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+static void imageViewKey(internal::CacheKey& key, const ImageView& v)
+{
+	key.value(v.image).value(v.index).value(v.count).value(v.type);
+}
+
+static internal::CacheKey resourceSetKey(const ResourceSetCreateInfo& info)
+{
+	internal::CacheKey key;
+
+	key.value(info.resourceCount);
+
+	for (size_t i = 0; i < info.resourceCount; i++)
+	{
+		imageViewKey(key, info.resources[i]);
+	}
+
+	key.value(info.constantBuffersCount);
+
+	for (size_t i = 0; i < info.constantBuffersCount; i++)
+	{
+		key.value(info.constantBuffers[i]);
+	}
+
+	key.value(info.vertexBufferCount);
+
+	for (size_t i = 0; i < info.vertexBufferCount; i++)
+	{
+		const VertexBufferView& v = info.vertexBuffers[i];
+		key.value(v.buffer).value(v.stride).value(v.offset);
+	}
+
+	key.value(info.indexBuffer);
+	key.value(info.dynamicConstants);
+
+	key.value(info.storageBufferCount);
+
+	for (size_t i = 0; i < info.storageBufferCount; i++)
+	{
+		key.value(info.storageBuffers[i]);
+	}
+
+	key.value(info.storageImageCount);
+
+	for (size_t i = 0; i < info.storageImageCount; i++)
+	{
+		imageViewKey(key, info.storageImages[i]);
+	}
+
+	return key;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	State
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct ResourceSetCache::State
+{
+	RenderDevice* device;
+
+	mutable std::mutex lock;
+	internal::CacheTable<CachedResourceSet> sets;
+
+	Stats stats;
+
+	State(RenderDevice* device) : device(device) {}
+
+	ResourceSetRef create(const internal::CacheKey& key, uint64 h, const ResourceSetCreateInfo& info)
+	{
+		RPtr<ResourceSetHandle> handle = device->createResourceSet(info);
+
+		if (!handle)
+			return ResourceSetRef();
+
+		ResourceSetRef set(new CachedResourceSet(std::move(handle), h, info));
+		sets.insert(key, h, set);
+
+		stats.created++;
+
+		return set;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//	Cache
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+ResourceSetCache::ResourceSetCache(RenderDevice* device) :
+	pState(new State(device))
+{
+	tsassert(device);
+}
+
+ResourceSetCache::~ResourceSetCache()
+{
+	pState.reset();
+}
+
+RenderDevice* ResourceSetCache::getDevice() const
+{
+	return pState->device;
+}
+
+ResourceSetRef ResourceSetCache::get(const ResourceSetCreateInfo& info)
+{
+	tsassert(pState);
+
+	const internal::CacheKey key = resourceSetKey(info);
+	const uint64 h = key.hash();
+
+	std::lock_guard<std::mutex> lk(pState->lock);
+
+	pState->stats.lookups++;
+
+	if (ResourceSetRef set = pState->sets.find(key, h))
+	{
+		pState->stats.hits++;
+		return set;
+	}
+
+	return pState->create(key, h, info);
+}
+
+bool ResourceSetCache::update(ResourceSetRef& set, const ResourceSetUpdate* updates, uint32 count)
+{
+	tsassert(pState);
+	tsassert(set);
+
+	//Patch a copy of the set's bindings
+	std::vector<ImageView> resources(set->m_resources);
+	std::vector<ResourceHandle> constantBuffers(set->m_constantBuffers);
+	std::vector<VertexBufferView> vertexBuffers(set->m_vertexBuffers);
+	ResourceHandle indexBuffer = set->m_indexBuffer;
+	uint32 dynamicConstants = set->m_dynamicConstants;
+	std::vector<ResourceHandle> storageBuffers(set->m_storageBuffers);
+	std::vector<ImageView> storageImages(set->m_storageImages);
+
+	for (uint32 i = 0; i < count; i++)
+	{
+		const ResourceSetUpdate& u = updates[i];
+
+		switch (u.type)
+		{
+		case ResourceSetSlot::RESOURCE:
+			if (u.slot >= resources.size()) resources.resize(u.slot + 1);
+			resources[u.slot] = u.resource;
+			break;
+		case ResourceSetSlot::CONSTANT_BUFFER:
+			if (u.slot >= constantBuffers.size()) constantBuffers.resize(u.slot + 1, ResourceHandle());
+			constantBuffers[u.slot] = u.buffer;
+			dynamicConstants = u.dynamic ? (dynamicConstants | (1u << u.slot)) : (dynamicConstants & ~(1u << u.slot));
+			break;
+		case ResourceSetSlot::VERTEX_BUFFER:
+			if (u.slot >= vertexBuffers.size()) vertexBuffers.resize(u.slot + 1);
+			vertexBuffers[u.slot] = u.vertexBuffer;
+			break;
+		case ResourceSetSlot::INDEX_BUFFER:
+			indexBuffer = u.buffer;
+			break;
+		case ResourceSetSlot::STORAGE_BUFFER:
+			if (u.slot >= storageBuffers.size()) storageBuffers.resize(u.slot + 1, ResourceHandle());
+			storageBuffers[u.slot] = u.buffer;
+			break;
+		case ResourceSetSlot::STORAGE_IMAGE:
+			if (u.slot >= storageImages.size()) storageImages.resize(u.slot + 1);
+			storageImages[u.slot] = u.resource;
+			break;
+		}
+	}
+
+	ResourceSetCreateInfo info;
+	info.resources = resources.data();
+	info.resourceCount = (uint32)resources.size();
+	info.constantBuffers = constantBuffers.data();
+	info.constantBuffersCount = (uint32)constantBuffers.size();
+	info.vertexBuffers = vertexBuffers.data();
+	info.vertexBufferCount = (uint32)vertexBuffers.size();
+	info.indexBuffer = indexBuffer;
+	info.dynamicConstants = dynamicConstants;
+	info.storageBuffers = storageBuffers.data();
+	info.storageBufferCount = (uint32)storageBuffers.size();
+	info.storageImages = storageImages.data();
+	info.storageImageCount = (uint32)storageImages.size();
+
+	const internal::CacheKey key = resourceSetKey(info);
+	const uint64 h = key.hash();
+
+	std::lock_guard<std::mutex> lk(pState->lock);
+
+	pState->stats.updates++;
+
+	//Share a set which already has the new bindings
+	if (ResourceSetRef existing = pState->sets.find(key, h))
+	{
+		set = existing;
+		return true;
+	}
+
+	/*
+		A set only referenced by the caller is rebound in place, the cache's weak reference can't be locked meanwhile.
+		Shared sets are copied so other users keep their bindings.
+	*/
+	if (set->refCount() == 1)
+	{
+		RPtr<ResourceSetHandle> rebound = pState->device->createResourceSet(info, set->handle());
+
+		if (!rebound)
+		{
+			tswarn("unable to rebind resource set");
+			return false;
+		}
+
+		//The set already owns the recycled handle
+		tsassert(rebound.handle() == set->handle());
+		rebound.release();
+
+		pState->sets.remove(set.get(), set->hash());
+
+		set->m_hash = h;
+		set->m_resources.swap(resources);
+		set->m_constantBuffers.swap(constantBuffers);
+		set->m_vertexBuffers.swap(vertexBuffers);
+		set->m_indexBuffer = indexBuffer;
+		set->m_dynamicConstants = dynamicConstants;
+		set->m_storageBuffers.swap(storageBuffers);
+		set->m_storageImages.swap(storageImages);
+
+		pState->sets.insert(key, h, set);
+		pState->stats.rebinds++;
+
+		return true;
+	}
+
+	ResourceSetRef copy = pState->create(key, h, info);
+
+	if (!copy)
+	{
+		tswarn("unable to create resource set");
+		return false;
+	}
+
+	set = copy;
+	return true;
+}
+
+ResourceSetCache::Stats ResourceSetCache::getStats() const
+{
+	tsassert(pState);
+
+	std::lock_guard<std::mutex> lk(pState->lock);
+
+	Stats stats = pState->stats;
+	stats.live = pState->sets.live();
+
+	return stats;
+}
+
+uint64 ResourceSetCache::hash(const ResourceSetCreateInfo& info)
+{
+	return resourceSetKey(info).hash();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
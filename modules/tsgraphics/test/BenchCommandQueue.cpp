@@ -0,0 +1,323 @@
+/*
+	Command Queue benchmark
+
+	-	Measures the CPU cost of recording, sorting and executing command batches
+		against a render context which does no work.
+*/
+
+#include <tsgraphics/CommandQueue.h>
+#include <tscore/radixsort.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace ts;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Render context which counts calls but does nothing
+*/
+struct NullContext : public RenderContext
+{
+	uint64 calls = 0;
+
+	void resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index) override { calls++; }
+	void resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size) override { calls++; }
+	void resourceCopy(ResourceHandle src, ResourceHandle dest) override { calls++; }
+	void imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index) override { calls++; }
+
+	void clearColourTarget(TargetHandle pass, uint32 colour) override { calls++; }
+	void clearDepthTarget(TargetHandle pass, float depth) override { calls++; }
+
+	void draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params) override { calls++; }
+
+	void bindTarget(TargetHandle outputs) override { calls++; }
+	void bindPipeline(PipelineHandle pipeline) override { calls++; }
+	void bindResourceSet(ResourceSetHandle inputs) override { calls++; }
+	void drawBound(const DrawParams& params) override { calls++; }
+	void multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed) override { calls++; }
+	void dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params) override { calls++; }
+	void dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset) override { calls++; }
+
+	void finish() override {}
+};
+
+/*
+	Simple scope timer
+*/
+class ScopeTimer
+{
+private:
+
+	const char* m_name;
+	chrono::high_resolution_clock::time_point m_start;
+
+public:
+
+	ScopeTimer(const char* name) : m_name(name), m_start(chrono::high_resolution_clock::now()) {}
+
+	~ScopeTimer()
+	{
+		auto dt = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - m_start);
+		cout << "  " << m_name << ": " << dt.count() << "ms" << endl;
+	}
+};
+
+struct ObjectConstants
+{
+	float world[16];
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Benchmarks
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Record a draw made of 3-5 commands
+void recordDraw(CommandRecorder& rec, uint32 d, CommandRecorder::SortKey key)
+{
+	ObjectConstants constants = {};
+
+	CommandBatch* batch = rec.createBatch();
+
+	CommandDraw draw;
+	draw.outputs = (TargetHandle)1;
+	draw.pipeline = (PipelineHandle)(d % 32 + 1);
+	draw.inputs = (ResourceSetHandle)(d % 256 + 1);
+	draw.params.count = 36;
+
+	rec.addCommand(batch, CommandBufferUpdate((ResourceHandle)1), constants);
+	rec.addCommand(batch, CommandBufferUpdate((ResourceHandle)2), constants);
+
+	if (d % 3 > 0)
+		rec.addCommand(batch, CommandTextureUpdate((ResourceHandle)3, 0), constants);
+	if (d % 3 > 1)
+		rec.addCommand(batch, CommandTextureResolve((ResourceHandle)4, (ResourceHandle)5));
+
+	rec.addCommand(batch, draw);
+
+	rec.submitBatch(key, batch);
+}
+
+/*
+	Record 100k draws made of 3-5 commands each
+*/
+void benchRecordDraws(uint32 iterations, ThreadPool& pool)
+{
+	const uint32 drawCount = 100000;
+
+	CommandQueue queue(drawCount);
+	NullContext context;
+
+	mt19937_64 rng(1234);
+
+	cout << "[" << __FUNCTION__ << "] " << drawCount << " draws" << endl;
+
+	for (uint32 i = 0; i < iterations; i++)
+	{
+		{
+			ScopeTimer t("record");
+
+			for (uint32 d = 0; d < drawCount; d++)
+			{
+				recordDraw(queue, d, rng());
+			}
+		}
+
+		{
+			ScopeTimer t("sort");
+			queue.sort(pool);
+		}
+
+		{
+			ScopeTimer t("execute");
+			queue.flush(&context);
+		}
+	}
+
+	cout << "  calls: " << context.calls << endl;
+}
+
+/*
+	Record 100k draws split between several recorders on a thread pool
+*/
+void benchRecordDrawsParallel(uint32 iterations, ThreadPool& pool)
+{
+	const uint32 drawCount = 100000;
+	const uint32 recorderCount = (uint32)pool.size() + 1;
+	const uint32 drawsPerRecorder = (drawCount + recorderCount - 1) / recorderCount;
+
+	CommandQueue queue(drawsPerRecorder, recorderCount);
+	NullContext context;
+
+	cout << "[" << __FUNCTION__ << "] " << drawCount << " draws, " << recorderCount << " recorders" << endl;
+
+	for (uint32 i = 0; i < iterations; i++)
+	{
+		{
+			ScopeTimer t("record");
+
+			parallel_for(pool, recorderCount, [&](size_t r) {
+				CommandRecorder* rec = queue.getRecorder((uint32)r);
+				mt19937_64 rng(r);
+
+				for (uint32 d = 0; d < drawsPerRecorder; d++)
+				{
+					recordDraw(*rec, d, rng());
+				}
+			});
+		}
+
+		{
+			ScopeTimer t("sort");
+			queue.sort(pool);
+		}
+
+		{
+			ScopeTimer t("execute");
+			queue.flush(&context);
+		}
+	}
+
+	cout << "  calls: " << context.calls << endl;
+}
+
+/*
+	Submit 100k draws which do not change between frames as a static batch
+*/
+void benchStaticBatch(uint32 iterations, ThreadPool& pool)
+{
+	const uint32 drawCount = 100000;
+
+	CommandQueue queue(1024);
+	StaticCommandBatch statics(drawCount);
+	NullContext context;
+
+	mt19937_64 rng(1234);
+
+	cout << "[" << __FUNCTION__ << "] " << drawCount << " draws" << endl;
+
+	{
+		ScopeTimer t("record once");
+
+		statics.begin();
+
+		for (uint32 d = 0; d < drawCount; d++)
+		{
+			recordDraw(statics, d, rng());
+		}
+
+		statics.end();
+	}
+
+	for (uint32 i = 0; i < iterations; i++)
+	{
+		{
+			ScopeTimer t("submit");
+			queue.submitStatic(&statics);
+			queue.sort(pool);
+		}
+
+		{
+			ScopeTimer t("execute");
+			queue.flush(&context);
+		}
+	}
+
+	cout << "  calls: " << context.calls << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct KeyPair
+{
+	uint64 key;
+	void* payload;
+};
+
+template<typename function_t>
+void timeSort(const char* name, const vector<KeyPair>& keys, uint32 iterations, function_t sortFunc)
+{
+	vector<KeyPair> sorted;
+
+	{
+		ScopeTimer t(name);
+
+		for (uint32 i = 0; i < iterations; i++)
+		{
+			sorted = keys;
+			sortFunc(sorted);
+		}
+	}
+
+	bool ordered = is_sorted(sorted.begin(), sorted.end(), [](const KeyPair& a, const KeyPair& b) { return a.key < b.key; });
+
+	if (!ordered)
+	{
+		cout << "  " << name << ": keys are not in order" << endl;
+		exit(1);
+	}
+}
+
+/*
+	Compare sorting methods for 64 bit keys with pointer payloads
+*/
+void benchSortKeys(uint32 iterations, ThreadPool& pool, const char* label, const vector<KeyPair>& keys)
+{
+	cout << "[" << __FUNCTION__ << "] " << keys.size() << " " << label << " keys x" << iterations << endl;
+
+	auto lessKey = [](const KeyPair& a, const KeyPair& b) { return a.key < b.key; };
+	auto getKey = [](const KeyPair& k) { return k.key; };
+
+	vector<KeyPair> scratch(keys.size());
+
+	timeSort("std::sort", keys, iterations, [&](vector<KeyPair>& k) { std::sort(k.begin(), k.end(), lessKey); });
+	timeSort("std::stable_sort", keys, iterations, [&](vector<KeyPair>& k) { std::stable_sort(k.begin(), k.end(), lessKey); });
+	timeSort("radixSort", keys, iterations, [&](vector<KeyPair>& k) { radixSort(k.data(), k.data() + k.size(), scratch.data(), getKey); });
+	timeSort("radixSort (pool)", keys, iterations, [&](vector<KeyPair>& k) { radixSort(pool, k.data(), k.data() + k.size(), scratch.data(), getKey); });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+	const uint32 iterations = (argc > 1) ? (uint32)atoi(argv[1]) : 3;
+
+	ThreadPool pool;
+
+	benchRecordDraws(iterations, pool);
+	benchRecordDrawsParallel(iterations, pool);
+	benchStaticBatch(iterations, pool);
+
+	mt19937_64 rng(5678);
+	vector<KeyPair> keys(100000);
+
+	//Uniformly distributed keys
+	for (KeyPair& k : keys)
+	{
+		k.key = rng();
+		k.payload = &k;
+	}
+
+	benchSortKeys(iterations, pool, "random", keys);
+
+	//Typical render keys: constant layer, pipeline and quantized depth
+	for (KeyPair& k : keys)
+	{
+		uint64 pipeline = rng() % 64;
+		uint64 depth = rng() & 0xffffff;
+		k.key = (1ull << 56) | (pipeline << 24) | depth;
+	}
+
+	benchSortKeys(iterations, pool, "render", keys);
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
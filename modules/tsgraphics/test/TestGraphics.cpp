@@ -0,0 +1,1582 @@
+/*
+	Graphics module tests
+
+	-	Tests the backend independent parts of the graphics module against a mock render context.
+*/
+
+#include <tsgraphics/CommandQueue.h>
+#include <tsgraphics/CachedContext.h>
+#include <tsgraphics/FrameCapture.h>
+#include <tsgraphics/ApiTrace.h>
+#include <tsgraphics/DeferredDestroy.h>
+#include <tsgraphics/AsyncCreate.h>
+#include <tsgraphics/PipelineCache.h>
+#include <tsgraphics/ResourceSetCache.h>
+#include <tsgraphics/DynamicBuffer.h>
+#include <tsgraphics/IndirectDraw.h>
+#include <tsgraphics/SortKey.h>
+
+#include <tsnull.h>
+
+#include <tscore/system/thread.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace ts;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Assertion helper
+void _assert(const char* func, const char* expr, bool eval)
+{
+	if (!eval)
+	{
+		cerr << "[" << func << "] Assertion failed: " << expr << endl;
+		exit(-1);
+	}
+}
+
+#define assert(expr) _assert(__FUNCTION__, #expr, (expr))
+
+/*
+	Render context which records the calls made to it
+*/
+struct MockContext : public RenderContext
+{
+	enum CallType
+	{
+		UPDATE,
+		COPY,
+		RESOLVE,
+		CLEAR_COLOUR,
+		CLEAR_DEPTH,
+		BIND_TARGET,
+		BIND_PIPELINE,
+		BIND_RESOURCES,
+		DRAW,
+		DRAW_INDIRECT,
+		DISPATCH,
+		FINISH
+	};
+
+	struct Call
+	{
+		CallType type;
+		uintptr handle;
+	};
+
+	vector<Call> calls;
+
+	void record(CallType type, uintptr handle = 0) { calls.push_back({ type, handle }); }
+
+	size_t count(CallType type) const
+	{
+		size_t n = 0;
+		for (const Call& c : calls)
+			n += (c.type == type) ? 1 : 0;
+		return n;
+	}
+
+	void resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index) override { record(UPDATE, (uintptr)rsc); }
+	uint32 rangeUpdates = 0;
+	void resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size) override { rangeUpdates++; record(UPDATE, (uintptr)rsc); }
+	void resourceCopy(ResourceHandle src, ResourceHandle dest) override { record(COPY, (uintptr)dest); }
+	void imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index) override { record(RESOLVE, (uintptr)dest); }
+
+	void clearColourTarget(TargetHandle pass, uint32 colour) override { record(CLEAR_COLOUR, (uintptr)pass); }
+	void clearDepthTarget(TargetHandle pass, float depth) override { record(CLEAR_DEPTH, (uintptr)pass); }
+
+	void draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params) override
+	{
+		bindTarget(outputs);
+		bindPipeline(pipeline);
+		bindResourceSet(inputs);
+		drawBound(params);
+	}
+
+	void bindTarget(TargetHandle outputs) override { record(BIND_TARGET, (uintptr)outputs); }
+	void bindPipeline(PipelineHandle pipeline) override { record(BIND_PIPELINE, (uintptr)pipeline); }
+	void bindResourceSet(ResourceSetHandle inputs) override { record(BIND_RESOURCES, (uintptr)inputs); }
+	//Draws record their instance count
+	void drawBound(const DrawParams& params) override { record(DRAW, params.instances); }
+	//Indirect draws record their argument buffer once for each draw
+	void multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed) override
+	{
+		for (uint32 i = 0; i < count; i++)
+			record(DRAW_INDIRECT, (uintptr)args);
+	}
+
+	void dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params) override { record(DISPATCH, (uintptr)pipeline); }
+	void dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset) override { record(DISPATCH, (uintptr)pipeline); }
+
+	//Staged updates record the first word of their contents
+	bool staging = false;
+	uint32 stagingBlocks = 0;
+	const uint8* staged = nullptr;
+	vector<uint32> stagedOffsets;
+	vector<uint32> stagedValues;
+
+	bool beginStagedUpdates(const void* memory, uint32 size) override
+	{
+		staged = (const uint8*)memory;
+		stagingBlocks++;
+		return staging;
+	}
+
+	void resourceUpdateStaged(ResourceHandle rsc, uint32 offset, uint32 size) override
+	{
+		stagedOffsets.push_back(offset);
+		stagedValues.push_back(*(const uint32*)(staged + offset));
+		record(UPDATE, (uintptr)rsc);
+	}
+
+	void endStagedUpdates() override { staged = nullptr; }
+
+	void finish() override { record(FINISH); }
+};
+
+/*
+	Render device which hands out unique handles
+*/
+struct MockDevice : public RenderDevice
+{
+	MockContext mock;
+
+	uintptr nextHandle = 1;
+	uint32 live = 0;
+
+	template<typename handle_t>
+	RPtr<handle_t> create()
+	{
+		live++;
+		return RPtr<handle_t>(this, (handle_t)nextHandle++);
+	}
+
+	RenderContext* context() override { return &mock; }
+	void commit() override {}
+
+	void setDisplayConfiguration(const DisplayConfig& displayCfg) override {}
+	void getDisplayConfiguration(DisplayConfig& displayCfg) override {}
+	ResourceHandle getDisplayTarget() override { return (ResourceHandle)~(uintptr)0; }
+
+	void queryStats(RenderStats& stats) override {}
+	bool constantBufferRanges = true;
+	void queryInfo(RenderDeviceInfo& info) override { info.constantBufferRanges = constantBufferRanges; }
+
+	RPtr<ResourceHandle> createEmptyResource(ResourceHandle recycle) override { return create<ResourceHandle>(); }
+	//Resources are created in place of a recycled handle, buffers record their first word of data
+	vector<uint32> bufferValues;
+
+	RPtr<ResourceHandle> createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle) override
+	{
+		if (data.memory != nullptr && info.size >= sizeof(uint32))
+			bufferValues.push_back(*(const uint32*)data.memory);
+
+		return (recycle != ResourceHandle()) ? RPtr<ResourceHandle>(this, recycle) : create<ResourceHandle>();
+	}
+
+	RPtr<ResourceHandle> createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle) override
+	{
+		return (recycle != ResourceHandle()) ? RPtr<ResourceHandle>(this, recycle) : create<ResourceHandle>();
+	}
+
+	RPtr<ResourceSetHandle> createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle) override
+	{
+		return (recycle != ResourceSetHandle()) ? RPtr<ResourceSetHandle>(this, recycle) : create<ResourceSetHandle>();
+	}
+	RPtr<ShaderHandle> createShader(const ShaderCreateInfo& info) override { return create<ShaderHandle>(); }
+	RPtr<PipelineHandle> createPipeline(ShaderHandle program, const PipelineCreateInfo& info) override { return create<PipelineHandle>(); }
+	RPtr<TargetHandle> createTarget(const TargetCreateInfo& info, TargetHandle recycle) override { return create<TargetHandle>(); }
+
+	void destroy(ResourceHandle rsc) override { live--; }
+	void destroy(ResourceSetHandle set) override { live--; }
+	void destroy(ShaderHandle shader) override { live--; }
+	void destroy(PipelineHandle state) override { live--; }
+	void destroy(TargetHandle pass) override { live--; }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Test cases
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void testCachedContextElidesBinds()
+{
+	MockContext mock;
+	CachedRenderContext ctx(&mock);
+
+	DrawParams params;
+
+	ctx.draw((TargetHandle)1, (PipelineHandle)1, (ResourceSetHandle)1, params);
+	ctx.draw((TargetHandle)1, (PipelineHandle)1, (ResourceSetHandle)1, params);
+	ctx.draw((TargetHandle)1, (PipelineHandle)1, (ResourceSetHandle)2, params);
+	ctx.draw((TargetHandle)1, (PipelineHandle)2, (ResourceSetHandle)2, params);
+
+	assert(mock.count(MockContext::DRAW) == 4);
+	assert(mock.count(MockContext::BIND_TARGET) == 1);
+	assert(mock.count(MockContext::BIND_PIPELINE) == 2);
+	assert(mock.count(MockContext::BIND_RESOURCES) == 2);
+
+	const CachedRenderContext::Stats& stats = ctx.getStats();
+	assert(stats.draws == 4);
+	assert(stats.targetBindsElided == 3);
+	assert(stats.pipelineBindsElided == 2);
+	assert(stats.resourceSetBindsElided == 2);
+	assert(stats.elided() == 7);
+}
+
+void testCachedContextTargetChange()
+{
+	MockContext mock;
+	CachedRenderContext ctx(&mock);
+
+	DrawParams params;
+
+	//Changing target rebinds resources but not the pipeline
+	ctx.draw((TargetHandle)1, (PipelineHandle)1, (ResourceSetHandle)1, params);
+	ctx.draw((TargetHandle)2, (PipelineHandle)1, (ResourceSetHandle)1, params);
+
+	assert(mock.count(MockContext::BIND_TARGET) == 2);
+	assert(mock.count(MockContext::BIND_PIPELINE) == 1);
+	assert(mock.count(MockContext::BIND_RESOURCES) == 2);
+}
+
+void testCachedContextInvalidate()
+{
+	MockContext mock;
+	CachedRenderContext ctx(&mock);
+
+	DrawParams params;
+
+	ctx.draw((TargetHandle)1, (PipelineHandle)1, (ResourceSetHandle)1, params);
+	ctx.invalidate();
+	ctx.draw((TargetHandle)1, (PipelineHandle)1, (ResourceSetHandle)1, params);
+
+	assert(mock.count(MockContext::BIND_TARGET) == 2);
+	assert(mock.count(MockContext::BIND_PIPELINE) == 2);
+	assert(mock.count(MockContext::BIND_RESOURCES) == 2);
+
+	//Finishing a context resets it's state
+	ctx.finish();
+	ctx.draw((TargetHandle)1, (PipelineHandle)1, (ResourceSetHandle)1, params);
+
+	assert(mock.count(MockContext::BIND_PIPELINE) == 3);
+}
+
+void testCachedContextDispatch()
+{
+	MockContext mock;
+	CachedRenderContext ctx(&mock);
+
+	DrawParams params;
+	DispatchParams dispatch;
+
+	//Draws following a dispatch bind their pipeline and resources again but not their target
+	ctx.draw((TargetHandle)1, (PipelineHandle)1, (ResourceSetHandle)1, params);
+	ctx.dispatch((PipelineHandle)2, (ResourceSetHandle)2, dispatch);
+	ctx.draw((TargetHandle)1, (PipelineHandle)1, (ResourceSetHandle)1, params);
+
+	assert(mock.count(MockContext::BIND_TARGET) == 1);
+	assert(mock.count(MockContext::BIND_PIPELINE) == 2);
+	assert(mock.count(MockContext::BIND_RESOURCES) == 2);
+
+	ctx.dispatchIndirect((PipelineHandle)2, (ResourceSetHandle)2, (ResourceHandle)1, 0);
+	ctx.draw((TargetHandle)1, (PipelineHandle)1, (ResourceSetHandle)1, params);
+
+	assert(mock.count(MockContext::BIND_PIPELINE) == 3);
+	assert(mock.count(MockContext::BIND_RESOURCES) == 3);
+	assert(ctx.getStats().dispatches == 2);
+}
+
+void testQueueFlushElidesBinds()
+{
+	MockContext mock;
+	CommandQueue queue(64);
+
+	//Two pipelines submitted in alternating order
+	for (uint32 i = 0; i < 8; i++)
+	{
+		CommandDraw draw;
+		draw.outputs = (TargetHandle)1;
+		draw.pipeline = (PipelineHandle)(1 + i % 2);
+		draw.inputs = (ResourceSetHandle)1;
+
+		CommandBatch* batch = queue.createBatch();
+		queue.addCommand(batch, draw);
+		queue.submitBatch(i % 2, batch);
+	}
+
+	queue.sort();
+	queue.flush(&mock);
+
+	assert(mock.count(MockContext::DRAW) == 8);
+	assert(mock.count(MockContext::BIND_TARGET) == 1);
+	assert(mock.count(MockContext::BIND_PIPELINE) == 2);
+
+	CachedRenderContext::Stats stats = queue.getStateStats();
+	assert(stats.draws == 8);
+	assert(stats.pipelineBindsElided == 6);
+}
+
+struct InstanceData
+{
+	float world[16];
+};
+
+//Submit a single instance draw
+void submitInstance(CommandQueue& queue, CommandQueue::SortKey key, PipelineHandle pipeline, uint32 capacity)
+{
+	InstanceData data = {};
+
+	CommandDrawInstance draw;
+	draw.outputs = (TargetHandle)1;
+	draw.pipeline = pipeline;
+	draw.inputs = (ResourceSetHandle)1;
+	draw.instanceBuffer = (ResourceHandle)1;
+	draw.instanceStride = sizeof(InstanceData);
+	draw.instanceCapacity = capacity;
+	draw.params.count = 36;
+	draw.params.mode = DrawMode::INDEXED;
+
+	CommandBatch* batch = queue.createBatch();
+	queue.addCommand(batch, draw, data);
+	queue.submitBatch(key, batch);
+}
+
+void testQueueRecorders()
+{
+	MockContext mock;
+	ThreadPool pool(2);
+
+	const uint32 recorders = 3;
+	const uint32 batchesPerRecorder = 16;
+	//The queue records alongside the additional recorders
+	const uint32 total = (recorders + 1) * batchesPerRecorder;
+
+	CommandQueue queue(batchesPerRecorder, recorders);
+	assert(queue.getRecorderCount() == recorders);
+
+	for (int frame = 0; frame < 2; frame++)
+	{
+		mock.calls.clear();
+
+		//Each recorder submits keys which interleave with the other recorders' keys, in a scrambled order
+		auto record = [&](CommandRecorder* rec, uint32 r) {
+			for (uint32 i = 0; i < batchesPerRecorder; i++)
+			{
+				const uint32 key = ((i * (recorders + 1) + r) * 37) % 256;
+
+				//Resolves record their destination, which identifies the batch's key
+				CommandBatch* batch = rec->createBatch();
+				rec->addCommand(batch, CommandTextureResolve((ResourceHandle)1, (ResourceHandle)(uintptr)(key + 1)));
+				rec->submitBatch(key, batch);
+			}
+		};
+
+		vector<thread> threads;
+
+		for (uint32 r = 0; r < recorders; r++)
+			threads.emplace_back(record, queue.getRecorder(r), r + 1);
+
+		record(&queue, 0);
+
+		for (thread& t : threads)
+			t.join();
+
+		if (frame == 0)
+			queue.sort();
+		else
+			queue.sort(pool);
+
+		queue.flush(&mock);
+
+		//Batches of every recorder are executed once each in order of their keys
+		assert(mock.count(MockContext::RESOLVE) == total);
+		assert(queue.getStats().batches == total);
+
+		uintptr last = 0;
+
+		for (const MockContext::Call& c : mock.calls)
+		{
+			if (c.type == MockContext::RESOLVE)
+			{
+				assert(c.handle > last);
+				last = c.handle;
+			}
+		}
+	}
+}
+
+void testSortKeyFields()
+{
+	struct KeyHigh : public SortKeyField<4> {};
+	struct KeyMid : public SortKeyField<12> {};
+	struct KeyLow : public SortKeyField<8> {};
+	struct KeyWide : public SortKeyField<40> {};
+
+	typedef SortKeyLayout<KeyHigh, KeyMid, KeyLow, KeyWide> Layout;
+
+	static_assert(Layout::width == 64, "layout should fill the key");
+	static_assert(Layout::Offset<KeyHigh>::value == 60, "first field should be packed against the top of the key");
+	static_assert(Layout::Offset<KeyWide>::value == 0, "last field of a full layout should start at bit 0");
+
+	SortKeyBuilder<Layout> key;
+	key.set<KeyHigh>(0x3);
+	key.set<KeyMid>(0xabc);
+	key.set<KeyLow>(0x5a);
+	key.set<KeyWide>(0x12345678ull);
+
+	assert(key.key() == 0x3abc5a0012345678ull);
+	assert(key.get<KeyMid>() == 0xabc);
+
+	//Values wider than a field are truncated and must not spill into the neighbouring fields
+	key.set<KeyMid>(0xfffff123);
+	assert(key.get<KeyMid>() == 0x123);
+	assert(key.get<KeyHigh>() == 0x3);
+	assert(key.get<KeyLow>() == 0x5a);
+
+	key.set<KeyWide>(~0ull);
+	assert(key.get<KeyWide>() == KeyWide::maxValue);
+	assert(key.get<KeyLow>() == 0x5a);
+
+	//Setting a field replaces its previous bits rather than merging with them
+	key.set<KeyLow>(0x01);
+	assert(key.get<KeyLow>() == 0x01);
+	assert(key.key() == 0x3123010000000000ull + KeyWide::maxValue);
+
+	//Higher fields dominate the ordering regardless of lower fields
+	SortKeyBuilder<Layout> a, b;
+	a.set<KeyHigh>(1).set<KeyMid>(KeyMid::maxValue).set<KeyWide>(KeyWide::maxValue);
+	b.set<KeyHigh>(2);
+	assert(a.key() < b.key());
+
+	//Layouts narrower than 64 bits leave the low bits clear
+	typedef SortKeyLayout<KeyHigh, KeyMid> ShortLayout;
+	SortKeyBuilder<ShortLayout> s;
+	s.set<KeyHigh>(~0ull).set<KeyMid>(~0ull);
+	assert(s.key() == 0xffff000000000000ull);
+}
+
+void testSortKeyDepth()
+{
+	const float zNear = 1.0f;
+	const float zFar = 100.0f;
+
+	//Depth is clamped to the view range
+	assert(quantizeDepth(zNear, zNear, zFar, 8, DepthOrder::FRONT_TO_BACK) == 0);
+	assert(quantizeDepth(zFar, zNear, zFar, 8, DepthOrder::FRONT_TO_BACK) == 255);
+	assert(quantizeDepth(-10.0f, zNear, zFar, 8, DepthOrder::FRONT_TO_BACK) == 0);
+	assert(quantizeDepth(1000.0f, zNear, zFar, 8, DepthOrder::FRONT_TO_BACK) == 255);
+	assert(quantizeDepth(zNear, zNear, zFar, 8, DepthOrder::BACK_TO_FRONT) == 255);
+	assert(quantizeDepth(zFar, zNear, zFar, 8, DepthOrder::BACK_TO_FRONT) == 0);
+
+	//Degenerate ranges do not divide by zero
+	assert(quantizeDepth(5.0f, 10.0f, 10.0f, 8, DepthOrder::FRONT_TO_BACK) == 0);
+
+	//Full width fields do not overflow, the value is limited to 32 bits
+	assert(quantizeDepth(zFar, zNear, zFar, 64, DepthOrder::BACK_TO_FRONT) == 0);
+	assert(quantizeDepth(zNear, zNear, zFar, 64, DepthOrder::BACK_TO_FRONT) == 0xffffffffull);
+	assert(quantizeDepth(zFar, zNear, zFar, 64, DepthOrder::FRONT_TO_BACK) == 0xffffffffull);
+
+	//Keys built from increasing depths sort nearest first in opaque layouts and furthest first in translucent layouts
+	uint64 lastOpaque = 0;
+	uint64 lastTranslucent = ~0ull;
+
+	for (float depth = zNear; depth <= zFar; depth += 0.5f)
+	{
+		OpaqueSortKey opaque;
+		opaque.set<SortKeyPass>(1).set<SortKeyPipeline>(7);
+		opaque.setDepth<SortKeyDepth>(depth, zNear, zFar, DepthOrder::FRONT_TO_BACK);
+
+		TranslucentSortKey translucent;
+		translucent.set<SortKeyPass>(1).set<SortKeyTranslucent>(1).set<SortKeyPipeline>(7);
+		translucent.setDepth<SortKeyDepth>(depth, zNear, zFar, DepthOrder::BACK_TO_FRONT);
+
+		assert(opaque.key() > lastOpaque);
+		assert(translucent.key() < lastTranslucent);
+		assert(opaque.get<SortKeyPipeline>() == 7);
+		assert(translucent.get<SortKeyPipeline>() == 7);
+
+		lastOpaque = opaque.key();
+		lastTranslucent = translucent.key();
+	}
+
+	//Translucent geometry sorts after opaque geometry within the same pass and layer
+	OpaqueSortKey opaque;
+	opaque.set<SortKeyPass>(1).setDepth<SortKeyDepth>(zFar, zNear, zFar, DepthOrder::FRONT_TO_BACK);
+	TranslucentSortKey translucent;
+	translucent.set<SortKeyPass>(1).set<SortKeyTranslucent>(1).setDepth<SortKeyDepth>(zFar, zNear, zFar, DepthOrder::BACK_TO_FRONT);
+	assert(opaque.key() < translucent.key());
+}
+
+void testQueueMergesDraws()
+{
+	MockContext mock;
+	CommandQueue queue(64);
+
+	//Two runs separated by a pipeline change
+	for (uint32 i = 0; i < 6; i++)
+		submitInstance(queue, i, (PipelineHandle)(i < 4 ? 1 : 2), 64);
+
+	queue.sort();
+	queue.flush(&mock);
+
+	assert(mock.count(MockContext::DRAW) == 2);
+	assert(mock.count(MockContext::UPDATE) == 2);
+	assert(mock.calls.back().type == MockContext::DRAW && mock.calls.back().handle == 2);
+
+	CommandQueue::MergeStats stats = queue.getMergeStats();
+	assert(stats.runs == 2);
+	assert(stats.mergedDraws == 6);
+}
+
+void testQueueMergeLimits()
+{
+	MockContext mock;
+	CommandQueue queue(64);
+
+	//Runs are split by the instance buffer capacity
+	for (uint32 i = 0; i < 5; i++)
+		submitInstance(queue, i, (PipelineHandle)1, 2);
+
+	queue.flush(&mock);
+
+	assert(mock.count(MockContext::DRAW) == 3);
+	assert(queue.getMergeStats().runs == 2);
+	assert(queue.getMergeStats().mergedDraws == 4);
+
+	//Merging can be disabled
+	mock.calls.clear();
+	queue.setMaxMergeRun(1);
+
+	for (uint32 i = 0; i < 5; i++)
+		submitInstance(queue, i, (PipelineHandle)1, 64);
+
+	queue.flush(&mock);
+
+	assert(mock.count(MockContext::DRAW) == 5);
+	assert(queue.getMergeStats().runs == 0);
+}
+
+//Submit a draw whose pipeline handle is it's sort key
+void submitKeyedDraw(CommandRecorder& rec, CommandRecorder::SortKey key)
+{
+	CommandDraw draw;
+	draw.outputs = (TargetHandle)1;
+	draw.pipeline = (PipelineHandle)(key + 1);
+	draw.inputs = (ResourceSetHandle)1;
+
+	CommandBatch* batch = rec.createBatch();
+	rec.addCommand(batch, draw);
+	rec.submitBatch(key, batch);
+}
+
+//Get the pipelines bound by a context in order, which are the keys of the executed batches
+vector<uintptr> boundKeys(const MockContext& mock)
+{
+	vector<uintptr> keys;
+	for (const MockContext::Call& c : mock.calls)
+	{
+		if (c.type == MockContext::BIND_PIPELINE)
+			keys.push_back(c.handle - 1);
+	}
+	return keys;
+}
+
+void testQueueStaticBatches()
+{
+	MockContext mock;
+	CommandQueue queue(64);
+	StaticCommandBatch statics(64);
+
+	assert(!statics.isValid());
+
+	//Static keys are recorded out of order and sorted once
+	statics.begin();
+	submitKeyedDraw(statics, 5);
+	submitKeyedDraw(statics, 1);
+	submitKeyedDraw(statics, 3);
+	statics.addDependency((TargetHandle)1);
+	statics.end();
+
+	assert(statics.isValid());
+	assert(statics.getBatchCount() == 3);
+
+	//The static batch is reused by consecutive flushes
+	for (uint32 frame = 0; frame < 2; frame++)
+	{
+		mock.calls.clear();
+
+		submitKeyedDraw(queue, 4);
+		submitKeyedDraw(queue, 0);
+		submitKeyedDraw(queue, 2);
+
+		queue.submitStatic(&statics);
+		queue.sort();
+		queue.flush(&mock);
+
+		assert(boundKeys(mock) == vector<uintptr>({ 0, 1, 2, 3, 4, 5 }));
+	}
+
+	//Static batches are referenced for one flush only
+	mock.calls.clear();
+	submitKeyedDraw(queue, 0);
+	queue.flush(&mock);
+	assert(mock.count(MockContext::DRAW) == 1);
+
+	//Only dependencies invalidate the batch
+	assert(!statics.invalidate((TargetHandle)2));
+	assert(!statics.invalidate((PipelineHandle)1));
+	assert(statics.isValid());
+	assert(statics.invalidate((TargetHandle)1));
+	assert(!statics.isValid());
+
+	//Re-recording discards the previous batches
+	statics.begin();
+	submitKeyedDraw(statics, 7);
+	statics.end();
+
+	assert(statics.getBatchCount() == 1);
+
+	//Unsorted queues execute static batches last
+	mock.calls.clear();
+	submitKeyedDraw(queue, 9);
+	queue.submitStatic(&statics);
+	queue.flush(&mock);
+
+	assert(boundKeys(mock) == vector<uintptr>({ 9, 7 }));
+}
+
+void testQueueStagesUpdates()
+{
+	MockContext mock;
+	mock.staging = true;
+
+	CommandQueue queue(64);
+
+	auto submitUpdates = [&]() {
+		for (uint32 i = 0; i < 3; i++)
+		{
+			uint32 constants[5] = { i + 10 };
+
+			CommandDraw draw;
+			draw.outputs = (TargetHandle)1;
+			draw.pipeline = (PipelineHandle)1;
+			draw.inputs = (ResourceSetHandle)1;
+
+			CommandBatch* batch = queue.createBatch();
+			queue.addCommand(batch, CommandBufferUpdate((ResourceHandle)1), constants);
+			queue.addCommand(batch, draw);
+			queue.submitBatch(i, batch);
+		}
+	};
+
+	//Each update is given an aligned range of one staging block
+	submitUpdates();
+	queue.flush(&mock);
+
+	assert(queue.getStagingStats().updates == 3);
+	assert(queue.getStagingStats().size == 3 * RenderContext::STAGING_ALIGNMENT);
+	assert(mock.stagedOffsets == vector<uint32>({ 0, 256, 512 }));
+	assert(mock.stagedValues == vector<uint32>({ 10, 11, 12 }));
+	assert(mock.count(MockContext::UPDATE) == 3);
+	assert(mock.count(MockContext::DRAW) == 3);
+
+	//Updates are applied individually if the context can't stage them
+	mock.calls.clear();
+	mock.stagedOffsets.clear();
+	mock.staging = false;
+
+	submitUpdates();
+	queue.flush(&mock);
+
+	assert(queue.getStagingStats().updates == 0);
+	assert(mock.stagedOffsets.empty());
+	assert(mock.count(MockContext::UPDATE) == 3);
+
+	//Or if staging is disabled
+	mock.calls.clear();
+	mock.staging = true;
+	queue.setUpdateStaging(false);
+
+	submitUpdates();
+	queue.flush(&mock);
+
+	assert(mock.stagedOffsets.empty());
+	assert(mock.count(MockContext::UPDATE) == 3);
+
+	//Flushes without updates don't stage
+	queue.setUpdateStaging(true);
+	mock.stagingBlocks = 0;
+
+	submitKeyedDraw(queue, 0);
+	queue.flush(&mock);
+
+	assert(mock.stagingBlocks == 0);
+
+	//Updates recorded into static batches are staged
+	StaticCommandBatch statics(8);
+	statics.begin();
+
+	uint32 constants[5] = { 20 };
+	CommandBatch* batch = statics.createBatch();
+	statics.addCommand(batch, CommandBufferUpdate((ResourceHandle)1), constants);
+	statics.submitBatch(0, batch);
+	statics.end();
+
+	mock.stagedValues.clear();
+	queue.submitStatic(&statics);
+	queue.flush(&mock);
+
+	assert(mock.stagingBlocks == 1);
+	assert(mock.stagedValues == vector<uint32>({ 20 }));
+}
+
+void testQueueStats()
+{
+	MockContext mock;
+	CommandQueue queue(64);
+
+	StaticCommandBatch statics(64);
+	statics.begin();
+	submitKeyedDraw(statics, 1);
+	statics.end();
+
+	for (uint32 i = 0; i < 3; i++)
+	{
+		uint32 constants[5] = {};
+
+		CommandBatch* batch = queue.createBatch();
+		queue.addCommand(batch, CommandBufferUpdate((ResourceHandle)1), constants);
+		queue.addCommand(batch, CommandDraw());
+		queue.submitBatch(i, batch);
+	}
+
+	queue.submitStatic(&statics);
+	queue.sort();
+	queue.flush(&mock);
+
+	CommandQueue::Stats stats = queue.getStats();
+	assert(stats.batches == 4);
+	assert(stats.staticBatches == 1);
+	assert(stats.commands == 7);
+	assert(stats.getCommandCount<CommandDraw>() == 4);
+	assert(stats.getCommandCount<CommandBufferUpdate>() == 3);
+	assert(stats.updates == 3);
+	assert(stats.uploadBytes == 3 * sizeof(uint32[5]));
+	assert(stats.allocatedBytes > 0);
+	assert(stats.allocatedPeak == stats.allocatedBytes);
+	assert(stats.allocatorCapacity > stats.allocatedBytes);
+	assert(stats.sortTime >= 0.0 && stats.executeTime >= 0.0);
+
+	//The peak is kept by later flushes which use less memory
+	submitKeyedDraw(queue, 0);
+	queue.flush(&mock);
+
+	CommandQueue::Stats next = queue.getStats();
+	assert(next.batches == 1);
+	assert(next.sortTime == 0.0);
+	assert(next.allocatedBytes < stats.allocatedBytes);
+	assert(next.allocatedPeak == stats.allocatedPeak);
+
+	//Averages
+	CommandQueue::Stats average;
+	average += stats;
+	average += next;
+	average /= 2;
+
+	assert(average.batches == 3);
+	assert(average.getCommandCount<CommandBufferUpdate>() == 2);
+}
+
+struct CommandLateType
+{
+	void dispatch(RenderContext* context, CommandPtr extra) {}
+};
+
+void testQueueStatsTypes()
+{
+	//Fill the table so the next type has a high id
+	for (uint32 i = 0; i < 100; i++)
+	{
+		string name = "TestGraphics::CommandFiller" + to_string(i);
+		registerCommandType(name.c_str(), &CommandType<CommandDraw>::dispatch);
+	}
+
+	assert(CommandType<CommandLateType>::id() >= 100);
+
+	MockContext mock;
+	CommandQueue queue(8);
+
+	CommandBatch* batch = queue.createBatch();
+	queue.addCommand(batch, CommandLateType());
+	queue.addCommand(batch, CommandLateType());
+	queue.submitBatch(0, batch);
+	queue.flush(&mock);
+
+	//Every registered type is counted separately
+	CommandQueue::Stats stats = queue.getStats();
+	assert(stats.commands == 2);
+	assert(stats.getCommandCount<CommandLateType>() == 2);
+	assert(stats.getCommandCount<CommandDraw>() == 0);
+}
+
+void testCommandTypeIds()
+{
+	//Registering a type again by name, as another module would, returns the same id
+	const CommandTypeID id = CommandType<CommandDraw>::id();
+	assert(id != 0);
+	assert(registerCommandType(typeid(CommandDraw).name(), &CommandType<CommandDraw>::dispatch) == id);
+
+	//Distinct types have distinct ids
+	assert(CommandType<CommandDrawInstance>::id() != id);
+	assert(CommandType<CommandBufferUpdate>::id() != CommandType<CommandDrawInstance>::id());
+}
+
+void testFrameCaptureReplay()
+{
+	MockDevice device;
+	CaptureDevice capture(&device);
+
+	//Create a set of objects through the capture device
+	InstanceData constants = {};
+
+	BufferResourceInfo bufferInfo;
+	bufferInfo.size = sizeof(InstanceData);
+	bufferInfo.type = BufferType::CONSTANTS;
+
+	ResourceData bufferData;
+	bufferData.memory = &constants;
+
+	RPtr<ResourceHandle> buffer = capture.createResourceBuffer(bufferData, bufferInfo, ResourceHandle());
+
+	ImageView display;
+	display.image = capture.getDisplayTarget();
+
+	TargetCreateInfo targetInfo = {};
+	targetInfo.attachments = &display;
+	targetInfo.attachmentCount = 1;
+	RPtr<TargetHandle> target = capture.createTarget(targetInfo, TargetHandle());
+
+	RPtr<ShaderHandle> shader = capture.createShader(ShaderCreateInfo());
+	RPtr<PipelineHandle> pipeline = capture.createPipeline(shader.handle(), PipelineCreateInfo());
+
+	ResourceHandle constantBuffers[] = { buffer.handle() };
+	ResourceSetCreateInfo setInfo;
+	setInfo.constantBuffers = constantBuffers;
+	setInfo.constantBuffersCount = 1;
+	RPtr<ResourceSetHandle> inputs = capture.createResourceSet(setInfo, ResourceSetHandle());
+
+	assert(device.live == 5);
+
+	//Capture a frame of three draws
+	CommandQueue queue(64);
+
+	for (uint32 i = 0; i < 3; i++)
+	{
+		CommandDraw draw;
+		draw.outputs = target.handle();
+		draw.pipeline = pipeline.handle();
+		draw.inputs = inputs.handle();
+		draw.params.count = 3 + i;
+
+		CommandBatch* batch = queue.createBatch();
+		queue.addCommand(batch, CommandBufferUpdate(buffer.handle()), constants);
+		queue.addCommand(batch, draw);
+		queue.submitBatch(i, batch);
+	}
+
+	//And a dispatch
+	CommandDispatch dispatch;
+	dispatch.pipeline = pipeline.handle();
+	dispatch.inputs = inputs.handle();
+	dispatch.params.groupsX = 4;
+
+	CommandBatch* dispatchBatch = queue.createBatch();
+	queue.addCommand(dispatchBatch, dispatch);
+	queue.submitBatch(3, dispatchBatch);
+
+	stringstream file(ios::binary | ios::out | ios::in);
+
+	capture.beginCapture();
+	queue.flush(capture.context());
+	capture.context()->finish();
+	assert(capture.endCapture(file));
+
+	//Replay the frame on another device
+	FrameReplay replay;
+	assert(replay.load(file));
+
+	FrameReplay::Stats stats = replay.getStats();
+	assert(stats.batches == 4);
+	assert(stats.draws == 3);
+	assert(stats.dispatches == 1);
+
+	MockDevice replayDevice;
+	assert(replay.create(&replayDevice));
+	assert(replayDevice.live == 5);
+
+	replay.execute(replayDevice.context());
+
+	const vector<MockContext::Call>& captured = device.mock.calls;
+	const vector<MockContext::Call>& replayed = replayDevice.mock.calls;
+
+	assert(captured.size() == replayed.size());
+
+	for (size_t i = 0; i < captured.size(); i++)
+		assert(captured[i].type == replayed[i].type);
+
+	assert(replayDevice.mock.count(MockContext::DISPATCH) == 1);
+	assert(replayed.back().type == MockContext::FINISH);
+
+	replay.release();
+	assert(replayDevice.live == 0);
+}
+
+void testApiTrace()
+{
+	MockDevice device;
+	stringstream file(ios::binary | ios::out | ios::in);
+
+	{
+		TraceDevice trace(&device, file);
+
+		uint32 constants[4] = { 1, 2, 3, 4 };
+
+		BufferResourceInfo bufferInfo;
+		bufferInfo.size = sizeof(constants);
+		bufferInfo.type = BufferType::CONSTANTS;
+
+		ResourceData bufferData;
+		bufferData.memory = constants;
+
+		RPtr<ResourceHandle> buffer = trace.createResourceBuffer(bufferData, bufferInfo, ResourceHandle());
+
+		//Two pipelines with the same description
+		RPtr<ShaderHandle> shader = trace.createShader(ShaderCreateInfo());
+		RPtr<PipelineHandle> pipeline0 = trace.createPipeline(shader.handle(), PipelineCreateInfo());
+		RPtr<PipelineHandle> pipeline1 = trace.createPipeline(shader.handle(), PipelineCreateInfo());
+
+		RPtr<ResourceSetHandle> inputs = trace.createResourceSet(ResourceSetCreateInfo(), ResourceSetHandle());
+
+		assert(device.live == 5);
+
+		RenderContext* ctx = trace.context();
+		DrawParams params;
+		params.count = 3;
+
+		//Frame 0: an update with the buffer's initial contents and a redundant pipeline bind
+		ctx->resourceUpdate(buffer.handle(), constants, 0);
+		ctx->bindTarget((TargetHandle)1);
+		ctx->bindPipeline(pipeline0.handle());
+		ctx->bindPipeline(pipeline0.handle());
+		ctx->bindResourceSet(inputs.handle());
+		ctx->drawBound(params);
+		ctx->finish();
+		trace.commit();
+
+		//Frame 1: a changed update then the same contents again
+		constants[0] = 5;
+		ctx->resourceUpdate(buffer.handle(), constants, 0);
+		ctx->draw((TargetHandle)1, pipeline1.handle(), inputs.handle(), params);
+		ctx->resourceUpdate(buffer.handle(), constants, 0);
+		ctx->draw((TargetHandle)1, pipeline1.handle(), inputs.handle(), params);
+		ctx->finish();
+		trace.commit();
+
+		//Calls are forwarded
+		assert(device.mock.count(MockContext::DRAW) == 3);
+		assert(device.mock.count(MockContext::UPDATE) == 3);
+	}
+
+	//All objects were released through the trace device
+	assert(device.live == 0);
+
+	TraceReader reader;
+	assert(reader.load(file));
+
+	TraceReader::Summary summary = reader.summarize();
+
+	assert(summary.frames.size() == 3);
+	assert(summary.frames[0].draws == 1);
+	assert(summary.frames[1].draws == 2);
+	assert(summary.frames[0].calls == 13);
+	assert(summary.frames[2].calls == 5);
+
+	assert(summary.calls[(size_t)TraceCall::COMMIT].count == 2);
+	assert(summary.calls[(size_t)TraceCall::CREATE_PIPELINE].count == 2);
+	assert(summary.calls[(size_t)TraceCall::DESTROY_PIPELINE].count == 2);
+	assert(summary.calls[(size_t)TraceCall::UPDATE].count == 3);
+
+	assert(summary.duplicatePipelines == 1);
+	assert(summary.duplicateShaders == 0);
+	assert(summary.repeatedUpdates == 2);
+	assert(summary.repeatedUpdateBytes == 2 * 4 * sizeof(uint32));
+	//One repeated pipeline bind, then the target, pipeline and inputs of the second draw
+	assert(summary.redundantBinds == 4);
+}
+
+void testDeferredDestroy()
+{
+	MockDevice device;
+
+	{
+		DeferredDestroyDevice deferred(&device, 2);
+
+		BufferResourceInfo bufferInfo;
+		bufferInfo.size = 256;
+		bufferInfo.type = BufferType::VERTEX;
+
+		RPtr<ResourceHandle> buffer = deferred.createResourceBuffer(ResourceData(), bufferInfo, ResourceHandle());
+		RPtr<ShaderHandle> shader = deferred.createShader(ShaderCreateInfo());
+		RPtr<PipelineHandle> pipeline = deferred.createPipeline(shader.handle(), PipelineCreateInfo());
+
+		assert(device.live == 3);
+
+		//Frame 0: release the buffer
+		buffer.reset();
+		assert(device.live == 3);
+		assert(deferred.getStats().pendingCount == 1);
+		assert(deferred.getStats().pendingBytes == 256);
+		deferred.commit();
+
+		//Frame 1: release the pipeline
+		pipeline.reset();
+		deferred.commit();
+		assert(device.live == 3);
+
+		//Frame 2: the buffer is destroyed once frame 0 + 2 is committed
+		deferred.commit();
+		assert(device.live == 2);
+		assert(deferred.getStats().destroyedLastFrame == 1);
+		assert(deferred.getStats().pendingCount == 1);
+		assert(deferred.getStats().pendingBytes == 0);
+
+		deferred.commit();
+		assert(device.live == 1);
+
+		//Remaining objects are destroyed when the device is
+		shader.reset();
+		assert(device.live == 1);
+	}
+
+	assert(device.live == 0);
+}
+
+void testBatchCreate()
+{
+	MockDevice device;
+
+	uint32 values[3] = { 10, 20, 30 };
+	ResourceData data[3];
+	BufferResourceInfo info[3];
+
+	for (uint32 i = 0; i < 3; i++)
+	{
+		data[i].memory = &values[i];
+		info[i].size = sizeof(uint32);
+		info[i].type = BufferType::CONSTANTS;
+	}
+
+	{
+		//Batch creation
+		RPtr<ResourceHandle> buffers[3];
+		device.createResourceBuffers(data, info, 3, buffers);
+
+		assert(device.live == 3);
+		assert(device.bufferValues.size() == 3);
+
+		for (uint32 i = 0; i < 3; i++)
+		{
+			assert(buffers[i]);
+			assert(device.bufferValues[i] == values[i]);
+		}
+
+		RPtr<ResourceSetHandle> sets[2];
+		ResourceSetCreateInfo setInfo[2];
+		device.createResourceSets(setInfo, 2, sets);
+		assert(device.live == 5);
+	}
+
+	assert(device.live == 0);
+	device.bufferValues.clear();
+
+	{
+		//Asynchronous creation returns reserved handles immediately
+		AsyncResourceCreator creator(&device);
+
+		RPtr<ResourceHandle> buffers[3];
+		uint64 fence0 = creator.createResourceBuffers(data, info, 2, buffers);
+		uint64 fence1 = creator.createResourceBuffer(data[2], info[2], buffers[2]);
+
+		assert(fence1 > fence0);
+		assert(device.live == 3);
+
+		for (uint32 i = 0; i < 3; i++)
+			assert(buffers[i]);
+
+		const ResourceHandle reserved = buffers[2].handle();
+
+		creator.wait(fence1);
+		assert(creator.isComplete(fence0));
+		assert(creator.getFailedCount() == 0);
+
+		//Created in place of the reserved handles, in submission order
+		assert(buffers[2].handle() == reserved);
+		assert(device.live == 3);
+		assert(device.bufferValues.size() == 3);
+
+		for (uint32 i = 0; i < 3; i++)
+			assert(device.bufferValues[i] == values[i]);
+
+		ImageResourceInfo imageInfo;
+		imageInfo.format = ImageFormat::RGBA;
+
+		RPtr<ResourceHandle> image;
+		creator.createResourceImage(nullptr, imageInfo, image);
+		creator.waitAll();
+
+		assert(image);
+		assert(device.live == 4);
+	}
+
+	assert(device.live == 0);
+}
+
+void testAsyncCreateNull()
+{
+	RenderDeviceConfig cfg;
+	cfg.display.resolutionW = 16;
+	cfg.display.resolutionH = 16;
+	RenderDevice* device = createNullDevice(cfg);
+
+	NullDeviceStats before;
+	assert(queryNullDeviceStats(device, &before));
+
+	uint32 values[4] = { 1, 2, 3, 4 };
+	uint32 pixels[4 * 4] = {};
+
+	{
+		AsyncResourceCreator creator(device);
+
+		ResourceData bufferData[3];
+		BufferResourceInfo bufferInfo[3];
+
+		for (uint32 i = 0; i < 3; i++)
+		{
+			bufferData[i].memory = values;
+			bufferInfo[i].size = sizeof(values);
+			bufferInfo[i].type = BufferType::VERTEX;
+		}
+
+		//A zero sized buffer is rejected by the device
+		bufferInfo[2].size = 0;
+
+		ResourceData imageData;
+		imageData.memory = pixels;
+		imageData.memoryByteWidth = 4 * sizeof(uint32);
+
+		ImageResourceInfo imageInfo[2];
+
+		for (ImageResourceInfo& info : imageInfo)
+		{
+			info.format = ImageFormat::RGBA;
+			info.usage = ImageUsage::SRV;
+			info.width = 4;
+			info.height = 4;
+		}
+
+		//Generated mips aren't supported off the main thread
+		imageInfo[1].useMips = true;
+
+		const ResourceData* images[2] = { &imageData, &imageData };
+
+		RPtr<ResourceHandle> buffers[3];
+		RPtr<ResourceHandle> textures[2];
+		creator.createResourceBuffers(bufferData, bufferInfo, 3, buffers);
+		const uint64 fence = creator.createResourceImages(images, imageInfo, 2, textures);
+
+		creator.wait(fence);
+		assert(creator.isComplete(fence));
+		assert(creator.getFailedCount() == 2);
+
+		//Failed creations leave their reserved handles valid and empty
+		NullDeviceStats stats;
+		assert(queryNullDeviceStats(device, &stats));
+		assert(stats.resources == before.resources + 5);
+		assert(stats.bufferMemory == before.bufferMemory + 2 * sizeof(values));
+		assert(stats.imageMemory == before.imageMemory + sizeof(pixels));
+		assert(stats.errors == before.errors + 1);
+
+		for (uint32 i = 0; i < 3; i++)
+			assert(buffers[i]);
+
+		for (uint32 i = 0; i < 2; i++)
+			assert(textures[i]);
+	}
+
+	//Every reserved handle is released exactly once
+	NullDeviceStats after;
+	assert(queryNullDeviceStats(device, &after));
+	assert(after.resources == before.resources);
+	assert(after.bufferMemory == before.bufferMemory);
+	assert(after.imageMemory == before.imageMemory);
+	assert(after.errors == before.errors + 1);
+
+	destroyNullDevice(device);
+}
+
+void testPipelineCache()
+{
+	MockDevice device;
+
+	{
+		PipelineCache cache(&device);
+
+		VertexAttribute attribs[2];
+		attribs[0].semanticName = "POSITION";
+		attribs[0].type = VertexAttributeType::FLOAT4;
+		attribs[1].semanticName = "TEXCOORD";
+		attribs[1].type = VertexAttributeType::FLOAT2;
+		attribs[1].byteOffset = 16;
+
+		PipelineCreateInfo info;
+		info.depth.enableDepth = true;
+		info.vertexAttributeList = attribs;
+		info.vertexAttributeCount = 2;
+		info.topology = VertexTopology::TRIANGLELIST;
+
+		PipelineRef a = cache.get((ShaderHandle)1, info);
+		assert(!a.null());
+		assert(device.live == 1);
+
+		//Equal descriptors share a pipeline, even if they are stored elsewhere
+		char semantic[] = "TEXCOORD";
+		VertexAttribute copy[2] = { attribs[0], attribs[1] };
+		copy[1].semanticName = semantic;
+
+		PipelineCreateInfo equal(info);
+		equal.vertexAttributeList = copy;
+
+		PipelineRef b = cache.get((ShaderHandle)1, equal);
+		assert(b == a);
+		assert(device.live == 1);
+
+		//Any difference creates a new pipeline
+		PipelineCreateInfo blended(info);
+		blended.blend.enable = true;
+		PipelineRef c = cache.get((ShaderHandle)1, blended);
+		PipelineRef d = cache.get((ShaderHandle)2, info);
+
+		copy[1].byteOffset = 12;
+		PipelineRef e = cache.get((ShaderHandle)1, equal);
+
+		assert(c != a && d != a && e != a);
+		assert(device.live == 4);
+		assert(PipelineCache::hash((ShaderHandle)1, info) == a->hash());
+
+		PipelineCache::Stats stats = cache.getStats();
+		assert(stats.lookups == 5);
+		assert(stats.hits == 1);
+		assert(stats.created == 4);
+		assert(stats.live == 4);
+		assert(stats.savedBytes > 0);
+		assert(stats.hitRate() == 0.2);
+
+		//Pipelines are destroyed when their last reference is released
+		a.reset();
+		assert(device.live == 4);
+		b.reset();
+		assert(device.live == 3);
+		assert(cache.getStats().live == 3);
+
+		//Released pipelines are created again
+		a = cache.get((ShaderHandle)1, info);
+		assert(device.live == 4);
+		assert(cache.getStats().created == 5);
+	}
+
+	assert(device.live == 0);
+}
+
+void testResourceSetCache()
+{
+	MockDevice device;
+
+	{
+		ResourceSetCache cache(&device);
+
+		ImageView images[2];
+		images[0].image = (ResourceHandle)10;
+		images[1].image = (ResourceHandle)11;
+
+		ResourceHandle constants[1] = { (ResourceHandle)20 };
+
+		ResourceSetCreateInfo info;
+		info.resources = images;
+		info.resourceCount = 2;
+		info.constantBuffers = constants;
+		info.constantBuffersCount = 1;
+
+		ResourceSetRef a = cache.get(info);
+		assert(!a.null());
+		assert(device.live == 1);
+
+		//Equal bindings share a set, even if they are stored elsewhere
+		ImageView copy[2] = { images[0], images[1] };
+		ResourceSetCreateInfo equal(info);
+		equal.resources = copy;
+
+		ResourceSetRef b = cache.get(equal);
+		assert(b == a);
+		assert(device.live == 1);
+		assert(ResourceSetCache::hash(info) == a->hash());
+
+		copy[1].index = 1;
+		ResourceSetRef c = cache.get(equal);
+		assert(c != a);
+		assert(device.live == 2);
+
+		//Updating a shared set copies it, the other user keeps it's bindings
+		ImageView shadow;
+		shadow.image = (ResourceHandle)12;
+		ResourceSetUpdate u = ResourceSetUpdate::makeResource(2, shadow);
+
+		assert(cache.update(b, &u, 1));
+		assert(b != a);
+		assert(device.live == 3);
+		assert(a->info().resourceCount == 2);
+		assert(b->info().resourceCount == 3);
+		assert(b->info().resources[2].image == shadow.image);
+
+		//Updating to bindings of a live set shares that set
+		ResourceSetRef d = a;
+		assert(cache.update(d, &u, 1));
+		assert(d == b);
+		assert(device.live == 3);
+
+		//A set which isn't shared is rebound in place
+		d.reset();
+		const ResourceSetHandle handle = b->handle();
+		u.resource.image = (ResourceHandle)13;
+
+		assert(cache.update(b, &u, 1));
+		assert(b->handle() == handle);
+		assert(b->info().resources[2].image == (ResourceHandle)13);
+		assert(device.live == 3);
+
+		//The rebound set is found by it's new bindings only
+		ResourceSetRef e = cache.get(b->info());
+		assert(e == b);
+
+		ResourceSetCreateInfo old(info);
+		ImageView oldImages[3] = { images[0], images[1], shadow };
+		old.resources = oldImages;
+		old.resourceCount = 3;
+
+		ResourceSetRef f = cache.get(old);
+		assert(f != b);
+		assert(device.live == 4);
+
+		ResourceSetCache::Stats stats = cache.getStats();
+		assert(stats.lookups == 5);
+		assert(stats.hits == 2);
+		assert(stats.created == 4);
+		assert(stats.live == 4);
+		assert(stats.updates == 3);
+		assert(stats.rebinds == 1);
+
+		//Storage bindings are part of a set's key
+		ResourceSetUpdate storage = ResourceSetUpdate::makeStorageBuffer(0, (ResourceHandle)30);
+		ResourceSetRef g = a;
+
+		assert(cache.update(g, &storage, 1));
+		assert(g != a);
+		assert(g->info().storageBufferCount == 1);
+		assert(g->info().storageBuffers[0] == (ResourceHandle)30);
+		assert(cache.get(g->info()) == g);
+	}
+
+	assert(device.live == 0);
+}
+
+void testDynamicBufferRing()
+{
+	MockDevice device;
+	MockContext context;
+
+	{
+		//Frame regions are rounded to the constant offset alignment
+		DynamicBufferRing ring(&device, BufferType::CONSTANTS, 1000, 2);
+		assert(ring.getFrameSize() == 1024);
+		assert(ring.getBuffer() != ResourceHandle());
+		assert(device.live == 1);
+
+		//Constants are aligned so they can be bound at a draw's constant offset
+		const uint32 value = 7;
+		DynamicAllocation a = ring.write(value);
+		DynamicAllocation b = ring.write(value);
+		DynamicAllocation c = ring.allocate(100);
+
+		assert(a.valid() && b.valid() && c.valid());
+		assert(a.offset == 0);
+		assert(b.offset == 256);
+		assert(c.offset == 512);
+		assert(*(const uint32*)b.memory == value);
+
+		//Allocations past the end of the frame's region fail
+		DynamicAllocation d = ring.allocate(600);
+		assert(!d.valid());
+		assert(ring.getStats().overflows == 1);
+		assert(ring.getStats().allocations == 3);
+		assert(ring.getStats().bytes == 612);
+
+		//Ranges are uploaded once
+		ring.upload(&context);
+		ring.upload(&context);
+		assert(context.count(MockContext::UPDATE) == 1);
+		assert(context.rangeUpdates == 1);
+
+		//Each frame in flight has it's own region
+		ring.nextFrame();
+		assert(ring.write(value).offset == 1024);
+		assert(ring.getStats().allocations == 1);
+		assert(ring.getStats().peakBytes == 612);
+
+		ring.nextFrame();
+		assert(ring.write(value).offset == 0);
+
+		//Vertices are aligned to their stride from the start of the buffer
+		DynamicBufferRing vertices(&device, BufferType::VERTEX, 1024, 2);
+		assert(vertices.allocate(36, 12).offset == 0);
+		assert(vertices.allocate(12, 12).offset == 36);
+
+		vertices.nextFrame();
+		assert(vertices.allocate(12, 12).offset == 1032);
+		assert(device.live == 2);
+
+		//Constant buffers are updated whole on devices which can't update ranges of them
+		device.constantBufferRanges = false;
+		context.calls.clear();
+		context.rangeUpdates = 0;
+
+		DynamicBufferRing whole(&device, BufferType::CONSTANTS, 1024, 2);
+		whole.write(value);
+		whole.upload(&context);
+		assert(context.count(MockContext::UPDATE) == 1);
+		assert(context.rangeUpdates == 0);
+
+		//Other buffer types are still updated in ranges
+		DynamicBufferRing wholeVertices(&device, BufferType::VERTEX, 1024, 2);
+		wholeVertices.allocate(12, 12);
+		wholeVertices.upload(&context);
+		assert(context.rangeUpdates == 1);
+	}
+
+	assert(device.live == 0);
+}
+
+void testIndirectDrawBuilder()
+{
+	MockDevice device;
+	MockContext context;
+
+	{
+		IndirectDrawBuilder builder(&device);
+
+		CommandDraw draw;
+		draw.outputs = (TargetHandle)1;
+		draw.pipeline = (PipelineHandle)1;
+		draw.inputs = (ResourceSetHandle)1;
+		draw.params.count = 3;
+
+		//Draws which share state are merged into one batch
+		builder.add(draw);
+		draw.params.count = 6;
+		builder.add(draw);
+		builder.add(draw);
+
+		//Indexed draws and draws with other state begin a new batch
+		draw.params.mode = DrawMode::INDEXED;
+		builder.add(draw);
+		draw.params.mode = DrawMode::VERTEX;
+		draw.pipeline = (PipelineHandle)2;
+		builder.add(draw);
+
+		//Draws with a constant offset are drawn directly
+		draw.params.constantOffset = 256;
+		builder.add(draw);
+
+		IndirectDrawBuilder::Stats stats = builder.getStats();
+		assert(stats.draws == 6);
+		assert(stats.batches == 3);
+		assert(stats.directDraws == 1);
+		assert(stats.argumentBytes == 4 * sizeof(DrawIndirectArgs) + sizeof(DrawIndexedIndirectArgs));
+
+		//The argument buffer is created with the first arguments
+		builder.submit(&context);
+		assert(builder.getBuffer() != ResourceHandle());
+		assert(device.bufferValues.size() == 1);
+		assert(device.bufferValues[0] == 3);
+		assert(context.count(MockContext::UPDATE) == 0);
+		assert(context.count(MockContext::DRAW_INDIRECT) == 5);
+		assert(context.count(MockContext::DRAW) == 1);
+
+		//Unchanged arguments aren't uploaded again
+		builder.submit(&context);
+		assert(context.count(MockContext::UPDATE) == 0);
+		assert(context.count(MockContext::DRAW_INDIRECT) == 10);
+
+		//Arguments which fit are uploaded to the same buffer
+		builder.clear();
+		draw.params.constantOffset = 0;
+		builder.add(draw);
+		builder.submit(&context);
+		assert(context.count(MockContext::UPDATE) == 1);
+		assert(device.bufferValues.size() == 1);
+		assert(device.live == 1);
+	}
+
+	assert(device.live == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+	//Execute test cases
+	testCachedContextElidesBinds();
+	testCachedContextTargetChange();
+	testCachedContextInvalidate();
+	testCachedContextDispatch();
+	testQueueFlushElidesBinds();
+	testQueueRecorders();
+	testSortKeyFields();
+	testSortKeyDepth();
+	testQueueMergesDraws();
+	testQueueMergeLimits();
+	testQueueStaticBatches();
+	testQueueStagesUpdates();
+	testQueueStats();
+	testQueueStatsTypes();
+	testCommandTypeIds();
+	testFrameCaptureReplay();
+	testApiTrace();
+	testDeferredDestroy();
+	testBatchCreate();
+	testAsyncCreateNull();
+	testPipelineCache();
+	testResourceSetCache();
+	testDynamicBufferRing();
+	testIndirectDrawBuilder();
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,60 @@
+/*
+	Public interface for the null rendering backend
+
+	The null device implements every device and context call without doing any GPU work.
+	Handles and parameters are validated, resource memory is tracked and calls are counted,
+	so graphics code can be tested and profiled on machines without a GPU.
+*/
+
+#pragma once
+
+#include <tsgraphics/Driver.h>
+
+namespace ts
+{
+	struct NullDeviceStats
+	{
+		//Context calls
+		uint64 updates = 0;
+		uint64 copies = 0;
+		uint64 resolves = 0;
+		uint64 clears = 0;
+		uint64 draws = 0;
+		uint64 dispatches = 0;
+		uint64 binds = 0;
+		uint64 finishes = 0;
+
+		//Device calls
+		uint64 creates = 0;
+		uint64 destroys = 0;
+		uint64 commits = 0;
+
+		//Worker contexts acquired and submitted for parallel recording
+		uint64 acquires = 0;
+		uint64 submits = 0;
+
+		//Live device objects
+		uint32 resources = 0;
+		uint32 resourceSets = 0;
+		uint32 shaders = 0;
+		uint32 pipelines = 0;
+		uint32 targets = 0;
+
+		//Bytes of memory used by live buffers and images
+		uint64 bufferMemory = 0;
+		uint64 imageMemory = 0;
+
+		//Calls which were made with invalid handles or parameters
+		uint64 errors = 0;
+	};
+}
+
+extern "C"
+{
+	ts::RenderDevice* createNullDevice(const ts::RenderDeviceConfig& config);
+
+	void destroyNullDevice(ts::RenderDevice* device);
+
+	//Get the counters of a null device, returns false if the device is not a null device
+	bool queryNullDeviceStats(ts::RenderDevice* device, ts::NullDeviceStats* stats);
+}
@@ -0,0 +1,356 @@
+/*
+	Render API
+
+	Null context implementation
+*/
+
+#include "NullDevice.h"
+
+#include <cstring>
+
+using namespace std;
+using namespace ts;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Resource commands
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void NullContext::resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	count(&NullDeviceStats::updates);
+
+	NullResource* r = m_device->findResource(rsc);
+
+	if (r == nullptr)
+		m_device->error("updating an invalid resource");
+	else if (memory == nullptr)
+		m_device->error("updating a resource with no data");
+	else if (index >= r->subresources)
+		m_device->error("updating a resource with an out of range index");
+	else if (r->isImage)
+		countUpdate(RenderStatsCounter::IMAGE_UPDATES, RenderStatsCounter::IMAGE_UPDATE_BYTES, m_device->getUpdateSize(r, index));
+	else
+	{
+		countUpdate(RenderStatsCounter::BUFFER_UPDATES, RenderStatsCounter::BUFFER_UPDATE_BYTES, m_device->getUpdateSize(r, index));
+
+		if (!r->contents.empty())
+			memcpy(r->contents.data(), memory, r->contents.size());
+	}
+}
+
+void NullContext::resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	count(&NullDeviceStats::updates);
+
+	NullResource* r = m_device->findResource(rsc);
+
+	if (r == nullptr || r->isImage)
+		m_device->error("updating a range of an invalid buffer");
+	else if (memory == nullptr)
+		m_device->error("updating a buffer with no data");
+	else if ((uint64)offset + size > r->buffer.size)
+		m_device->error("updating an out of range buffer range");
+	else
+	{
+		countUpdate(RenderStatsCounter::BUFFER_UPDATES, RenderStatsCounter::BUFFER_UPDATE_BYTES, size);
+
+		if (!r->contents.empty())
+			memcpy(r->contents.data() + offset, memory, size);
+	}
+}
+
+void NullContext::resourceCopy(ResourceHandle src, ResourceHandle dest)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	count(&NullDeviceStats::copies);
+
+	NullResource* s = m_device->findResource(src);
+	NullResource* d = m_device->findResource(dest);
+
+	if (s == nullptr || d == nullptr)
+		m_device->error("copying an invalid resource");
+	else if (src == dest)
+		m_device->error("copying a resource to itself");
+	else if (s->isImage != d->isImage || s->size != d->size)
+		m_device->error("copying between incompatible resources");
+	else if (!d->contents.empty())
+		d->contents = s->contents.empty() ? vector<uint8>(d->contents.size(), 0) : s->contents;
+}
+
+void NullContext::imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	count(&NullDeviceStats::resolves);
+
+	NullResource* s = m_device->findResource(src);
+	NullResource* d = m_device->findResource(dest);
+
+	if (s == nullptr || d == nullptr || !s->isImage || !d->isImage)
+		m_device->error("resolving an invalid image");
+	else if (d->image.msLevels > 1)
+		m_device->error("resolving into a multisampled image");
+	else if (index >= s->subresources || index >= d->subresources)
+		m_device->error("resolving an out of range index");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Target commands
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void NullContext::clearColourTarget(TargetHandle pass, uint32 colour)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	count(&NullDeviceStats::clears);
+
+	if (m_device->findTarget(pass) == nullptr)
+		m_device->error("clearing an invalid target");
+}
+
+void NullContext::clearDepthTarget(TargetHandle pass, float depth)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	count(&NullDeviceStats::clears);
+
+	NullTarget* t = m_device->findTarget(pass);
+
+	if (t == nullptr)
+		m_device->error("clearing an invalid target");
+	else if (t->depth.image == ResourceHandle())
+		m_device->error("clearing the depth of a target without a depth attachment");
+	else if (depth < 0.0f || depth > 1.0f)
+		m_device->error("clearing depth to a value outside [0,1]");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Draw commands
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void NullContext::draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params)
+{
+	bindTarget(outputs);
+	bindPipeline(pipeline);
+	bindResourceSet(inputs);
+	drawBound(params);
+}
+
+void NullContext::bindTarget(TargetHandle outputs)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	count(&NullDeviceStats::binds);
+	m_device->getRenderStats().add(RenderStatsCounter::TARGET_BINDS);
+
+	if (m_device->findTarget(outputs) == nullptr)
+		m_device->error("binding an invalid target");
+
+	m_target = outputs;
+}
+
+void NullContext::bindPipeline(PipelineHandle pipeline)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	count(&NullDeviceStats::binds);
+	m_device->getRenderStats().add(RenderStatsCounter::PIPELINE_BINDS);
+
+	if (m_device->findPipeline(pipeline) == nullptr)
+		m_device->error("binding an invalid pipeline");
+
+	m_pipeline = pipeline;
+}
+
+void NullContext::bindResourceSet(ResourceSetHandle inputs)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	count(&NullDeviceStats::binds);
+	m_device->getRenderStats().add(RenderStatsCounter::RESOURCE_SET_BINDS);
+
+	if (m_device->findResourceSet(inputs) == nullptr)
+		m_device->error("binding an invalid resource set");
+
+	m_inputs = inputs;
+}
+
+void NullContext::drawBound(const DrawParams& params)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	m_pending++;
+
+	//Bound objects may have been destroyed since they were bound
+	NullResourceSet* set = m_device->findResourceSet(m_inputs);
+	NullPipeline* pipeline = m_device->findPipeline(m_pipeline);
+
+	//Draws with no valid pipeline have no known topology and count no triangles
+	m_device->countDraw((pipeline != nullptr) ? pipeline->topology : VertexTopology::POINTLIST, params);
+
+	if (m_device->findTarget(m_target) == nullptr)
+	{
+		m_device->error("drawing with no valid target bound");
+	}
+	else if (pipeline == nullptr)
+	{
+		m_device->error("drawing with no valid pipeline bound");
+	}
+	else if (pipeline->compute)
+	{
+		m_device->error("drawing with a compute pipeline bound");
+	}
+	else if (set == nullptr)
+	{
+		m_device->error("drawing with no valid resource set bound");
+	}
+	else if (params.count == 0 || params.instances == 0)
+	{
+		m_device->error("drawing zero vertices");
+	}
+	else if ((params.mode == DrawMode::INDEXED || params.mode == DrawMode::INDEXEDINSTANCED) && m_device->findResource(set->indexBuffer) == nullptr)
+	{
+		m_device->error("indexed draw with no valid index buffer");
+	}
+	else if (!validateConstantOffset(set, params.constantOffset))
+	{
+		m_device->error("draw has an invalid constant offset");
+	}
+}
+
+void NullContext::multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 drawCount, bool indexed)
+{
+	m_pending++;
+
+	const uint32 stride = indexed ? sizeof(DrawIndexedIndirectArgs) : sizeof(DrawIndirectArgs);
+
+	if (const uint8* contents = findIndirectArgs(args, offset, (uint64)stride * drawCount))
+	{
+		//Each draw is validated as if it was drawn directly
+		for (uint32 i = 0; i < drawCount; i++)
+		{
+			const uint8* memory = contents + (size_t)i * stride;
+
+			if (indexed)
+			{
+				DrawIndexedIndirectArgs a;
+				memcpy(&a, memory, sizeof(a));
+				drawBound(a.params());
+			}
+			else
+			{
+				DrawIndirectArgs a;
+				memcpy(&a, memory, sizeof(a));
+				drawBound(a.params());
+			}
+		}
+	}
+}
+
+void NullContext::dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	count(&NullDeviceStats::dispatches);
+	m_device->getRenderStats().add(RenderStatsCounter::DISPATCHES);
+
+	NullPipeline* p = m_device->findPipeline(pipeline);
+	NullResourceSet* set = m_device->findResourceSet(inputs);
+
+	if (p == nullptr || !p->compute)
+	{
+		m_device->error("dispatching with an invalid compute pipeline");
+	}
+	else if (set == nullptr)
+	{
+		m_device->error("dispatching with an invalid resource set");
+	}
+	else if (params.groupsX == 0 || params.groupsY == 0 || params.groupsZ == 0)
+	{
+		m_device->error("dispatching zero thread groups");
+	}
+	else if (params.groupsX > DispatchParams::MAX_GROUPS || params.groupsY > DispatchParams::MAX_GROUPS || params.groupsZ > DispatchParams::MAX_GROUPS)
+	{
+		m_device->error("dispatching more thread groups than a dimension allows");
+	}
+	else if (!validateConstantOffset(set, params.constantOffset))
+	{
+		m_device->error("dispatch has an invalid constant offset");
+	}
+}
+
+void NullContext::dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset)
+{
+	m_pending++;
+
+	//The dispatch is validated as if it was dispatched directly
+	if (const uint8* contents = findIndirectArgs(args, offset, sizeof(DispatchIndirectArgs)))
+	{
+		DispatchIndirectArgs a;
+		memcpy(&a, contents, sizeof(a));
+		dispatch(pipeline, inputs, a.params());
+	}
+}
+
+const uint8* NullContext::findIndirectArgs(ResourceHandle args, uint32 offset, uint64 size)
+{
+	NullResource* r = m_device->findResource(args);
+
+	if (r == nullptr || r->isImage || r->buffer.type != BufferType::INDIRECT)
+	{
+		m_device->error("indirect call with an invalid argument buffer");
+	}
+	else if (offset % 4 != 0)
+	{
+		m_device->error("indirect argument offset must be a multiple of 4");
+	}
+	else if ((uint64)offset + size > r->contents.size())
+	{
+		m_device->error("indirect arguments are outside of the argument buffer");
+	}
+	else
+	{
+		return r->contents.data() + offset;
+	}
+
+	return nullptr;
+}
+
+void NullContext::count(uint64 NullDeviceStats::* counter)
+{
+	m_pending++;
+	m_device->count(counter);
+}
+
+void NullContext::countUpdate(RenderStatsCounter calls, RenderStatsCounter bytes, uint64 size)
+{
+	m_device->getRenderStats().add(calls);
+	m_device->getRenderStats().add(bytes, size);
+}
+
+bool NullContext::validateConstantOffset(const NullResourceSet* set, uint32 offset) const
+{
+	if (set->dynamicConstants == 0)
+		return true;
+
+	if (offset % DrawParams::CONSTANT_OFFSET_ALIGNMENT != 0)
+		return false;
+
+	for (size_t i = 0; i < set->constantBuffers.size(); i++)
+	{
+		NullResource* rsc = m_device->findResource(set->constantBuffers[i]);
+
+		if ((set->dynamicConstants & (1u << i)) != 0 && rsc != nullptr && offset >= rsc->buffer.size)
+			return false;
+	}
+
+	return true;
+}
+
+void NullContext::finish()
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	m_device->count(&NullDeviceStats::finishes);
+
+	m_pending = 0;
+
+	m_target = TargetHandle();
+	m_pipeline = PipelineHandle();
+	m_inputs = ResourceSetHandle();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,677 @@
+/*
+	Render API
+
+	Null implementation of Render Driver
+*/
+
+#include "NullDevice.h"
+
+#include <tscore/debug/assert.h>
+
+#include <algorithm>
+
+using namespace std;
+using namespace ts;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Helpers
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static uint32 getFormatSize(ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::BYTE: return 1;
+	case ImageFormat::RGB: return 4; //Padded to 4 bytes
+	case ImageFormat::RGBA: return 4;
+	case ImageFormat::ARGB: return 4;
+	case ImageFormat::FLOAT1: return 4;
+	case ImageFormat::FLOAT2: return 8;
+	case ImageFormat::FLOAT3: return 12;
+	case ImageFormat::FLOAT4: return 16;
+	case ImageFormat::DEPTH16: return 2;
+	case ImageFormat::DEPTH32: return 4;
+	default: return 0;
+	}
+}
+
+//Number of mip levels of an image
+static uint32 getMipCount(const ImageResourceInfo& info)
+{
+	if (!info.useMips)
+		return 1;
+
+	if (info.mipLevels > 1)
+		return info.mipLevels;
+
+	//Full mip chain
+	uint32 levels = 1;
+	for (uint32 size = max(info.width, info.height); size > 1; size /= 2)
+		levels++;
+
+	return levels;
+}
+
+//Number of subresources of an image
+static uint32 getSubresourceCount(const ImageResourceInfo& info)
+{
+	const uint32 layers = (info.type == ImageType::CUBE) ? 6 * info.length : ((info.type == ImageType::_3D) ? 1 : info.length);
+	return layers * getMipCount(info);
+}
+
+//Bytes of memory used by an image
+static uint64 getImageSize(const ImageResourceInfo& info)
+{
+	uint64 size = 0;
+
+	uint64 w = info.width;
+	uint64 h = info.height;
+	uint64 d = (info.type == ImageType::_3D) ? info.length : 1;
+
+	for (uint32 i = 0; i < getMipCount(info); i++)
+	{
+		size += w * h * d;
+		w = max<uint64>(w / 2, 1);
+		h = max<uint64>(h / 2, 1);
+		d = max<uint64>(d / 2, 1);
+	}
+
+	const uint64 layers = (info.type == ImageType::CUBE) ? 6 * info.length : ((info.type == ImageType::_3D) ? 1 : info.length);
+
+	return size * layers * getFormatSize(info.format) * max(info.msLevels, 1u);
+}
+
+//Bytes of memory used by one subresource of an image, subresources are ordered by mip level within each layer
+static uint64 getSubresourceSize(const ImageResourceInfo& info, uint32 index)
+{
+	const uint32 mip = index % getMipCount(info);
+
+	const uint64 w = max<uint64>(info.width >> mip, 1);
+	const uint64 h = max<uint64>(info.height >> mip, 1);
+	const uint64 d = (info.type == ImageType::_3D) ? max<uint64>(info.length >> mip, 1) : 1;
+
+	return w * h * d * getFormatSize(info.format) * max(info.msLevels, 1u);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Constructor/destructor
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+NullDevice::NullDevice(const RenderDeviceConfig& cfg) :
+	m_context(this),
+	m_display(cfg.display)
+{
+	updateDisplayTarget();
+}
+
+NullDevice::~NullDevice()
+{
+	if (m_displayTarget != ResourceHandle())
+	{
+		destroy(m_displayTarget);
+	}
+
+	const uint32 live = m_resources.size() + m_resourceSets.size() + m_shaders.size() + m_pipelines.size() + m_targets.size();
+
+	if (live > 0)
+	{
+		tswarn("null device destroyed with % live objects", live);
+	}
+}
+
+void NullDevice::commit()
+{
+	count(&NullDeviceStats::commits);
+
+	for (uint32 i = 0; i < m_acquiredContexts; i++)
+	{
+		if (!m_submitted[i])
+			error("worker context was acquired but not submitted");
+	}
+
+	m_acquiredContexts = 0;
+
+	//Reset frame counters each frame
+	m_renderStats.nextFrame();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Parallel recording
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32 NullDevice::acquireContexts(RenderContext** contexts, uint32 count)
+{
+	for (uint32 i = 0; i < count; i++)
+	{
+		if (m_acquiredContexts == m_workerContexts.size())
+		{
+			m_workerContexts.push_back(unique_ptr<NullContext>(new NullContext(this)));
+			m_submitted.push_back(false);
+		}
+
+		m_submitted[m_acquiredContexts] = false;
+		contexts[i] = m_workerContexts[m_acquiredContexts++].get();
+
+		this->count(&NullDeviceStats::acquires);
+	}
+
+	return count;
+}
+
+void NullDevice::submitContexts(RenderContext* const* contexts, uint32 count)
+{
+	//Worker commands were validated as they were recorded, only the submission itself is checked
+	for (uint32 i = 0; i < count; i++)
+	{
+		uint32 index = 0;
+
+		while (index < m_acquiredContexts && m_workerContexts[index].get() != contexts[i])
+			index++;
+
+		if (index == m_acquiredContexts)
+		{
+			error("submitting a context which wasn't acquired this frame");
+		}
+		else if (m_submitted[index])
+		{
+			error("submitting a worker context twice");
+		}
+		else if (!m_workerContexts[index]->isFinished())
+		{
+			error("submitting a worker context before it was finished");
+		}
+		else
+		{
+			m_submitted[index] = true;
+			this->count(&NullDeviceStats::submits);
+		}
+	}
+
+	//Submission resets the main context's bound state
+	m_context.finish();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Counters
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void NullDevice::error(const char* message)
+{
+	count(&NullDeviceStats::errors);
+	tswarn("null device: %", message);
+}
+
+void NullDevice::count(uint64 NullDeviceStats::* counter)
+{
+	lock_guard<mutex> lk(m_statsLock);
+	m_stats.*counter += 1;
+}
+
+void NullDevice::queryStats(RenderStats& stats)
+{
+	m_renderStats.query(stats);
+}
+
+void NullDevice::queryNullStats(NullDeviceStats& stats)
+{
+	{
+		lock_guard<mutex> lk(m_statsLock);
+		stats = m_stats;
+	}
+
+	stats.resources = m_resources.size();
+	stats.resourceSets = m_resourceSets.size();
+	stats.shaders = m_shaders.size();
+	stats.pipelines = m_pipelines.size();
+	stats.targets = m_targets.size();
+}
+
+void NullDevice::queryInfo(RenderDeviceInfo& info)
+{
+	info.adapterName = "Null Device";
+	info.gpuVideoMemory = 0;
+	info.gpuSystemMemory = 0;
+	info.sharedSystemMemory = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Display
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void NullDevice::setDisplayConfiguration(const DisplayConfig& displayCfg)
+{
+	m_display = displayCfg;
+	updateDisplayTarget();
+}
+
+void NullDevice::getDisplayConfiguration(DisplayConfig& displayCfg)
+{
+	displayCfg = m_display;
+}
+
+//The display target is an image the size of the display which is recreated in place when the display changes
+void NullDevice::updateDisplayTarget()
+{
+	ImageResourceInfo info;
+	info.format = ImageFormat::RGBA;
+	info.usage = ImageUsage::RTV;
+	info.width = max<uint32>(m_display.resolutionW, 1);
+	info.height = max<uint32>(m_display.resolutionH, 1);
+	info.msLevels = max<uint32>(m_display.multisampleLevel, 1);
+
+	m_displayTarget = createResourceImage(nullptr, info, m_displayTarget).release();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Resources
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void NullDevice::setResourceSize(NullResource* rsc, uint64 size)
+{
+	lock_guard<mutex> lk(m_statsLock);
+
+	const RenderStatsCounter memory = rsc->isImage ? RenderStatsCollector::getMemoryCounter(rsc->image.usage) : RenderStatsCollector::getMemoryCounter(rsc->buffer.type);
+
+	(rsc->isImage ? m_stats.imageMemory : m_stats.bufferMemory) -= rsc->size;
+	m_renderStats.subtract(memory, rsc->size);
+	rsc->size = size;
+	(rsc->isImage ? m_stats.imageMemory : m_stats.bufferMemory) += rsc->size;
+	m_renderStats.add(memory, rsc->size);
+}
+
+uint64 NullDevice::getUpdateSize(const NullResource* rsc, uint32 index) const
+{
+	return rsc->isImage ? getSubresourceSize(rsc->image, index) : rsc->buffer.size;
+}
+
+/*
+	Get the object to create into:
+	A valid recycle handle is reused, otherwise a new object is created.
+*/
+template<typename object_t, typename handle_t, typename table_t>
+static object_t* recycleObject(NullDevice* device, table_t& table, handle_t recycle, handle_t& handle)
+{
+	if (recycle != handle_t())
+	{
+		if (object_t* o = table.find(recycle))
+		{
+			handle = recycle;
+			return o;
+		}
+
+		device->error("recycled handle is not valid");
+	}
+
+	object_t* o = new object_t();
+	handle = table.insert(unique_ptr<object_t>(o));
+	return o;
+}
+
+RPtr<ResourceHandle> NullDevice::createEmptyResource(ResourceHandle recycle)
+{
+	count(&NullDeviceStats::creates);
+
+	ResourceHandle h;
+	NullResource* rsc = recycleObject<NullResource>(this, m_resources, recycle, h);
+	setResourceSize(rsc, 0);
+	*rsc = NullResource();
+
+	return RPtr<ResourceHandle>(this, h);
+}
+
+RPtr<ResourceHandle> NullDevice::createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle)
+{
+	count(&NullDeviceStats::creates);
+
+	if (info.size == 0)
+	{
+		error("buffer size is zero");
+		return RPtr<ResourceHandle>();
+	}
+
+	if (info.type == BufferType::CONSTANTS && (info.size % 16) != 0)
+	{
+		error("constant buffer size must be a multiple of 16");
+		return RPtr<ResourceHandle>();
+	}
+
+	ResourceHandle h;
+	NullResource* rsc = recycleObject<NullResource>(this, m_resources, recycle, h);
+	setResourceSize(rsc, 0);
+
+	rsc->isImage = false;
+	rsc->buffer = info;
+	rsc->subresources = 1;
+	setResourceSize(rsc, info.size);
+
+	//Indirect draws and dispatches read their arguments on the CPU
+	if (info.type == BufferType::INDIRECT)
+	{
+		const uint8* memory = (const uint8*)data.memory;
+		rsc->contents.assign(info.size, 0);
+
+		if (memory != nullptr)
+			rsc->contents.assign(memory, memory + info.size);
+	}
+	else
+	{
+		rsc->contents.clear();
+	}
+	m_renderStats.add(RenderStatsCounter::BUFFERS_CREATED);
+
+	return RPtr<ResourceHandle>(this, h);
+}
+
+RPtr<ResourceHandle> NullDevice::createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle)
+{
+	count(&NullDeviceStats::creates);
+
+	if (getFormatSize(info.format) == 0)
+	{
+		error("image format is unknown");
+		return RPtr<ResourceHandle>();
+	}
+
+	if (info.width == 0 || info.height == 0 || info.length == 0)
+	{
+		error("image dimensions are zero");
+		return RPtr<ResourceHandle>();
+	}
+
+	if (data != nullptr)
+	{
+		for (uint32 i = 0; i < getSubresourceCount(info); i++)
+		{
+			if (data[i].memory == nullptr)
+			{
+				error("image data is missing a subresource");
+				return RPtr<ResourceHandle>();
+			}
+		}
+	}
+
+	ResourceHandle h;
+	NullResource* rsc = recycleObject<NullResource>(this, m_resources, recycle, h);
+	setResourceSize(rsc, 0);
+
+	rsc->isImage = true;
+	rsc->image = info;
+	rsc->subresources = getSubresourceCount(info);
+	setResourceSize(rsc, getImageSize(info));
+	m_renderStats.add(RenderStatsCounter::IMAGES_CREATED);
+
+	return RPtr<ResourceHandle>(this, h);
+}
+
+bool NullDevice::validateView(const ImageView& view, ImageUsage usage, const char* message)
+{
+	NullResource* rsc = findResource(view.image);
+
+	if (rsc == nullptr || !rsc->isImage || (rsc->image.usage & usage) == 0)
+	{
+		error(message);
+		return false;
+	}
+
+	return true;
+}
+
+RPtr<ResourceSetHandle> NullDevice::createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle)
+{
+	count(&NullDeviceStats::creates);
+
+	//Null handles are allowed and leave a slot unbound
+	auto isBuffer = [this](ResourceHandle h) {
+		if (h == ResourceHandle())
+			return true;
+		NullResource* rsc = findResource(h);
+		return rsc != nullptr && !rsc->isImage;
+	};
+
+	for (uint32 i = 0; i < info.resourceCount; i++)
+	{
+		if (info.resources[i].image != ResourceHandle() && !validateView(info.resources[i], ImageUsage::SRV, "resource set has an invalid image"))
+			return RPtr<ResourceSetHandle>();
+	}
+
+	for (uint32 i = 0; i < info.constantBuffersCount; i++)
+	{
+		if (!isBuffer(info.constantBuffers[i]))
+		{
+			error("resource set has an invalid constant buffer");
+			return RPtr<ResourceSetHandle>();
+		}
+	}
+
+	if (info.constantBuffersCount < 32 && (info.dynamicConstants >> info.constantBuffersCount) != 0)
+	{
+		error("resource set has dynamic constant slots with no constant buffer");
+		return RPtr<ResourceSetHandle>();
+	}
+
+	for (uint32 i = 0; i < info.vertexBufferCount; i++)
+	{
+		if (!isBuffer(info.vertexBuffers[i].buffer))
+		{
+			error("resource set has an invalid vertex buffer");
+			return RPtr<ResourceSetHandle>();
+		}
+	}
+
+	if (!isBuffer(info.indexBuffer))
+	{
+		error("resource set has an invalid index buffer");
+		return RPtr<ResourceSetHandle>();
+	}
+
+	for (uint32 i = 0; i < info.storageBufferCount; i++)
+	{
+		NullResource* rsc = findResource(info.storageBuffers[i]);
+
+		if (info.storageBuffers[i] != ResourceHandle() &&
+			(rsc == nullptr || rsc->isImage || (rsc->buffer.type != BufferType::STORAGE && rsc->buffer.type != BufferType::INDIRECT)))
+		{
+			error("resource set has an invalid storage buffer");
+			return RPtr<ResourceSetHandle>();
+		}
+	}
+
+	for (uint32 i = 0; i < info.storageImageCount; i++)
+	{
+		if (info.storageImages[i].image != ResourceHandle() && !validateView(info.storageImages[i], ImageUsage::UAV, "resource set has an invalid storage image"))
+			return RPtr<ResourceSetHandle>();
+	}
+
+	ResourceSetHandle h;
+	NullResourceSet* set = recycleObject<NullResourceSet>(this, m_resourceSets, recycle, h);
+
+	set->resources.assign(info.resources, info.resources + info.resourceCount);
+	set->constantBuffers.assign(info.constantBuffers, info.constantBuffers + info.constantBuffersCount);
+	set->vertexBuffers.assign(info.vertexBuffers, info.vertexBuffers + info.vertexBufferCount);
+	set->indexBuffer = info.indexBuffer;
+	set->dynamicConstants = info.dynamicConstants;
+	set->storageBuffers.assign(info.storageBuffers, info.storageBuffers + info.storageBufferCount);
+	set->storageImages.assign(info.storageImages, info.storageImages + info.storageImageCount);
+	m_renderStats.add(RenderStatsCounter::RESOURCE_SETS_CREATED);
+
+	return RPtr<ResourceSetHandle>(this, h);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Pipeline state
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RPtr<ShaderHandle> NullDevice::createShader(const ShaderCreateInfo& info)
+{
+	count(&NullDeviceStats::creates);
+
+	unique_ptr<NullShader> shader(new NullShader());
+	bool hasStage = false;
+
+	for (size_t i = 0; i < (size_t)ShaderStage::MAX_STAGES; i++)
+	{
+		shader->stages[i] = (info.stages[i].bytecode != nullptr && info.stages[i].size > 0);
+		hasStage |= shader->stages[i];
+	}
+
+	if (!hasStage)
+	{
+		error("shader has no stages");
+		return RPtr<ShaderHandle>();
+	}
+
+	if (shader->stages[(size_t)ShaderStage::COMPUTE] && std::count(shader->stages, shader->stages + (size_t)ShaderStage::MAX_STAGES, true) > 1)
+	{
+		error("shader combines compute and graphics stages");
+		return RPtr<ShaderHandle>();
+	}
+
+	m_renderStats.add(RenderStatsCounter::SHADERS_CREATED);
+
+	return RPtr<ShaderHandle>(this, m_shaders.insert(move(shader)));
+}
+
+RPtr<PipelineHandle> NullDevice::createPipeline(ShaderHandle program, const PipelineCreateInfo& info)
+{
+	count(&NullDeviceStats::creates);
+
+	NullShader* shader = m_shaders.find(program);
+
+	if (shader == nullptr)
+	{
+		error("pipeline has an invalid shader");
+		return RPtr<PipelineHandle>();
+	}
+
+	unique_ptr<NullPipeline> pipeline(new NullPipeline());
+	pipeline->shader = program;
+	pipeline->topology = info.topology;
+	pipeline->compute = shader->stages[(size_t)ShaderStage::COMPUTE];
+
+	m_renderStats.add(RenderStatsCounter::PIPELINES_CREATED);
+
+	return RPtr<PipelineHandle>(this, m_pipelines.insert(move(pipeline)));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Targets
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RPtr<TargetHandle> NullDevice::createTarget(const TargetCreateInfo& info, TargetHandle recycle)
+{
+	count(&NullDeviceStats::creates);
+
+	for (uint32 i = 0; i < info.attachmentCount; i++)
+	{
+		if (!validateView(info.attachments[i], ImageUsage::RTV, "target has an invalid attachment"))
+			return RPtr<TargetHandle>();
+	}
+
+	if (info.depth.image != ResourceHandle() && !validateView(info.depth, ImageUsage::DSV, "target has an invalid depth attachment"))
+		return RPtr<TargetHandle>();
+
+	TargetHandle h;
+	NullTarget* target = recycleObject<NullTarget>(this, m_targets, recycle, h);
+
+	target->attachments.assign(info.attachments, info.attachments + info.attachmentCount);
+	target->depth = info.depth;
+	target->viewport = info.viewport;
+	target->scissor = info.scissor;
+	m_renderStats.add(RenderStatsCounter::TARGETS_CREATED);
+
+	return RPtr<TargetHandle>(this, h);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Destroy
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void NullDevice::destroy(ResourceHandle rsc)
+{
+	count(&NullDeviceStats::destroys);
+
+	if (NullResource* r = findResource(rsc))
+	{
+		//Empty resources have no memory and aren't counted as buffers or images
+		if (r->size > 0)
+			m_renderStats.add(r->isImage ? RenderStatsCounter::IMAGES_DESTROYED : RenderStatsCounter::BUFFERS_DESTROYED);
+
+		setResourceSize(r, 0);
+		m_resources.erase(rsc);
+	}
+	else
+	{
+		error("destroying an invalid resource");
+	}
+}
+
+void NullDevice::destroy(ResourceSetHandle set)
+{
+	count(&NullDeviceStats::destroys);
+
+	if (m_resourceSets.erase(set))
+		m_renderStats.add(RenderStatsCounter::RESOURCE_SETS_DESTROYED);
+	else
+		error("destroying an invalid resource set");
+}
+
+void NullDevice::destroy(ShaderHandle shader)
+{
+	count(&NullDeviceStats::destroys);
+
+	if (m_shaders.erase(shader))
+		m_renderStats.add(RenderStatsCounter::SHADERS_DESTROYED);
+	else
+		error("destroying an invalid shader");
+}
+
+void NullDevice::destroy(PipelineHandle pipeline)
+{
+	count(&NullDeviceStats::destroys);
+
+	if (m_pipelines.erase(pipeline))
+		m_renderStats.add(RenderStatsCounter::PIPELINES_DESTROYED);
+	else
+		error("destroying an invalid pipeline");
+}
+
+void NullDevice::destroy(TargetHandle target)
+{
+	count(&NullDeviceStats::destroys);
+
+	if (m_targets.erase(target))
+		m_renderStats.add(RenderStatsCounter::TARGETS_DESTROYED);
+	else
+		error("destroying an invalid target");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C"
+{
+	RenderDevice* createNullDevice(const RenderDeviceConfig& config)
+	{
+		return new NullDevice(config);
+	}
+
+	void destroyNullDevice(RenderDevice* device)
+	{
+		if (auto d = dynamic_cast<NullDevice*>(device))
+		{
+			delete d;
+		}
+	}
+
+	bool queryNullDeviceStats(RenderDevice* device, NullDeviceStats* stats)
+	{
+		if (auto d = dynamic_cast<NullDevice*>(device))
+		{
+			d->queryNullStats(*stats);
+			return true;
+		}
+
+		return false;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,274 @@
+/*
+	Render API
+
+	Null implementation of Render Driver
+*/
+
+#pragma once
+
+#include <tsnull.h>
+#include <tsgraphics/DriverStats.h>
+#include <tscore/debug/log.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ts
+{
+	class NullDevice;
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Device objects
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	struct NullResource
+	{
+		bool isImage = false;
+		BufferResourceInfo buffer;
+		ImageResourceInfo image;
+
+		//Number of images which can be updated individually
+		uint32 subresources = 1;
+
+		//Bytes of memory the resource would use
+		uint64 size = 0;
+
+		//Contents of indirect argument buffers, the only contents the device reads
+		std::vector<uint8> contents;
+	};
+
+	struct NullResourceSet
+	{
+		std::vector<ImageView> resources;
+		std::vector<ResourceHandle> constantBuffers;
+		std::vector<VertexBufferView> vertexBuffers;
+		ResourceHandle indexBuffer = ResourceHandle();
+		uint32 dynamicConstants = 0;
+		std::vector<ResourceHandle> storageBuffers;
+		std::vector<ImageView> storageImages;
+	};
+
+	struct NullShader
+	{
+		bool stages[(size_t)ShaderStage::MAX_STAGES] = {};
+	};
+
+	struct NullPipeline
+	{
+		ShaderHandle shader = ShaderHandle();
+		VertexTopology topology = VertexTopology::TRIANGLELIST;
+		//Pipelines of compute shaders can only be dispatched
+		bool compute = false;
+	};
+
+	struct NullTarget
+	{
+		std::vector<ImageView> attachments;
+		ImageView depth;
+		Viewport viewport;
+		Viewport scissor;
+	};
+
+	/*
+		Table of live objects of one type, a handle is the address of it's object.
+		Handles are only valid while they are in the table so stale handles are detected.
+	*/
+	template<typename object_t, typename handle_t>
+	class NullObjectTable
+	{
+	private:
+
+		mutable std::mutex m_lock;
+		std::unordered_map<uintptr, std::unique_ptr<object_t>> m_objects;
+
+	public:
+
+		handle_t insert(std::unique_ptr<object_t> object)
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			const uintptr h = (uintptr)object.get();
+			m_objects[h] = std::move(object);
+			return (handle_t)h;
+		}
+
+		object_t* find(handle_t handle) const
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			auto it = m_objects.find((uintptr)handle);
+			return (it != m_objects.end()) ? it->second.get() : nullptr;
+		}
+
+		bool erase(handle_t handle)
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			return m_objects.erase((uintptr)handle) > 0;
+		}
+
+		uint32 size() const
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			return (uint32)m_objects.size();
+		}
+	};
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Context
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	class NullContext : public RenderContext
+	{
+	private:
+
+		NullDevice* m_device;
+
+		//Currently bound state, handles are looked up on each draw so destroyed objects are detected
+		TargetHandle m_target = TargetHandle();
+		PipelineHandle m_pipeline = PipelineHandle();
+		ResourceSetHandle m_inputs = ResourceSetHandle();
+
+		//Commands recorded since the context was last finished
+		uint32 m_pending = 0;
+
+		//Count a command recorded on this context
+		void count(uint64 NullDeviceStats::* counter);
+		//Count a valid update call and the bytes it uploads
+		void countUpdate(RenderStatsCounter calls, RenderStatsCounter bytes, uint64 size);
+
+		//Check the dynamic constant buffers of a set can be read at an offset
+		bool validateConstantOffset(const NullResourceSet* set, uint32 offset) const;
+
+		//Find the arguments of an indirect call in an argument buffer, null if they are invalid
+		const uint8* findIndirectArgs(ResourceHandle args, uint32 offset, uint64 size);
+
+	public:
+
+		NullContext(NullDevice* device) : m_device(device) {}
+
+		void resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index) override;
+		void resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size) override;
+		void resourceCopy(ResourceHandle src, ResourceHandle dest) override;
+		void imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index) override;
+
+		void clearColourTarget(TargetHandle pass, uint32 colour) override;
+		void clearDepthTarget(TargetHandle pass, float depth) override;
+
+		void draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params) override;
+
+		void bindTarget(TargetHandle outputs) override;
+		void bindPipeline(PipelineHandle pipeline) override;
+		void bindResourceSet(ResourceSetHandle inputs) override;
+		void drawBound(const DrawParams& params) override;
+		void multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed) override;
+
+		void dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params) override;
+		void dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset) override;
+
+		void finish() override;
+
+		bool isFinished() const { return m_pending == 0; }
+	};
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Device
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	class NullDevice final : public RenderDevice
+	{
+	public:
+
+		NullDevice(const RenderDeviceConfig& cfg);
+		~NullDevice();
+
+		NullDevice(const NullDevice&) = delete;
+
+		RenderContext* context() override { return &m_context; }
+		void commit() override;
+
+		//Parallel recording
+		uint32 acquireContexts(RenderContext** contexts, uint32 count) override;
+		void submitContexts(RenderContext* const* contexts, uint32 count) override;
+
+		//Display methods
+		void setDisplayConfiguration(const DisplayConfig& displayCfg) override;
+		void getDisplayConfiguration(DisplayConfig& displayCfg) override;
+		ResourceHandle getDisplayTarget() override { return m_displayTarget; }
+
+		//Query device
+		void queryStats(RenderStats& stats) override;
+		void queryInfo(RenderDeviceInfo& info) override;
+
+		//Resources
+		RPtr<ResourceHandle> createEmptyResource(ResourceHandle recycle) override;
+		RPtr<ResourceHandle> createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle) override;
+		RPtr<ResourceHandle> createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle) override;
+		//Resource set
+		RPtr<ResourceSetHandle> createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle) override;
+		//Pipeline state
+		RPtr<ShaderHandle> createShader(const ShaderCreateInfo& info) override;
+		RPtr<PipelineHandle> createPipeline(ShaderHandle program, const PipelineCreateInfo& info) override;
+		//Output target
+		RPtr<TargetHandle> createTarget(const TargetCreateInfo& info, TargetHandle recycle) override;
+
+		//Destroy device objects
+		void destroy(ResourceHandle rsc) override;
+		void destroy(ResourceSetHandle set) override;
+		void destroy(ShaderHandle shader) override;
+		void destroy(PipelineHandle state) override;
+		void destroy(TargetHandle pass) override;
+
+		//Internal methods
+		NullResource* findResource(ResourceHandle h) const { return m_resources.find(h); }
+		NullResourceSet* findResourceSet(ResourceSetHandle h) const { return m_resourceSets.find(h); }
+		NullPipeline* findPipeline(PipelineHandle h) const { return m_pipelines.find(h); }
+		NullTarget* findTarget(TargetHandle h) const { return m_targets.find(h); }
+
+		//Report an invalid call
+		void error(const char* message);
+
+		//Increment a counter
+		void count(uint64 NullDeviceStats::* counter);
+
+		void queryNullStats(NullDeviceStats& stats);
+
+		void countDraw(VertexTopology topology, const DrawParams& params) { m_renderStats.countDraw(topology, params); count(&NullDeviceStats::draws); }
+
+		RenderStatsCollector& getRenderStats() { return m_renderStats; }
+
+		//Bytes uploaded by an update of a resource
+		uint64 getUpdateSize(const NullResource* rsc, uint32 index) const;
+
+	private:
+
+		NullContext m_context;
+
+		//Worker contexts, the first m_acquiredContexts are in use this frame
+		std::vector<std::unique_ptr<NullContext>> m_workerContexts;
+		std::vector<bool> m_submitted;
+		uint32 m_acquiredContexts = 0;
+
+		DisplayConfig m_display;
+		ResourceHandle m_displayTarget = ResourceHandle();
+
+		NullObjectTable<NullResource, ResourceHandle> m_resources;
+		NullObjectTable<NullResourceSet, ResourceSetHandle> m_resourceSets;
+		NullObjectTable<NullShader, ShaderHandle> m_shaders;
+		NullObjectTable<NullPipeline, PipelineHandle> m_pipelines;
+		NullObjectTable<NullTarget, TargetHandle> m_targets;
+
+		//Counters are updated by the device and it's contexts
+		std::mutex m_statsLock;
+		NullDeviceStats m_stats;
+
+		//Render stats of the frame, workers count in parallel
+		RenderStatsCollector m_renderStats;
+
+		//Image views must refer to live images
+		bool validateView(const ImageView& view, ImageUsage usage, const char* message);
+
+		//Update the tracked memory of a resource
+		void setResourceSize(NullResource* rsc, uint64 size);
+		void updateDisplayTarget();
+	};
+}
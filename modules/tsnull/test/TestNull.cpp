@@ -0,0 +1,654 @@
+/*
+	Null device tests
+
+	-	Tests that the null device validates calls and tracks device objects.
+*/
+
+#include <tsnull.h>
+#include <tsgraphics/DriverStats.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace ts;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Assertion helper
+void _assert(const char* func, const char* expr, bool eval)
+{
+	if (!eval)
+	{
+		cerr << "[" << func << "] Assertion failed: " << expr << endl;
+		exit(-1);
+	}
+}
+
+#define assert(expr) _assert(__FUNCTION__, #expr, (expr))
+
+static NullDeviceStats getStats(RenderDevice* device)
+{
+	NullDeviceStats stats;
+	assert(queryNullDeviceStats(device, &stats));
+	return stats;
+}
+
+//Null devices are destroyed directly as the module doesn't link to RenderDevice::destroy()
+struct NullDeleter
+{
+	void operator()(RenderDevice* device) { destroyNullDevice(device); }
+};
+
+using NullDevicePtr = unique_ptr<RenderDevice, NullDeleter>;
+
+static NullDevicePtr createDevice()
+{
+	RenderDeviceConfig cfg;
+	cfg.display.resolutionW = 64;
+	cfg.display.resolutionH = 32;
+	return NullDevicePtr(createNullDevice(cfg));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void testNullTracksMemory()
+{
+	NullDevicePtr device = createDevice();
+
+	//Display target is a 64x32 RGBA image
+	NullDeviceStats stats = getStats(device.get());
+	assert(stats.resources == 1);
+	assert(stats.imageMemory == 64 * 32 * 4);
+
+	{
+		BufferResourceInfo info;
+		info.type = BufferType::CONSTANTS;
+		info.size = 256;
+
+		ResourceData data;
+		RPtr<ResourceHandle> buffer = device->createResourceBuffer(data, info, ResourceHandle());
+		assert(buffer);
+		assert(getStats(device.get()).bufferMemory == 256);
+
+		//Recycling replaces the buffer in place
+		info.size = 512;
+		ResourceHandle h = device->createResourceBuffer(data, info, buffer.handle()).release();
+		assert(h == buffer.handle());
+
+		stats = getStats(device.get());
+		assert(stats.resources == 2);
+		assert(stats.bufferMemory == 512);
+	}
+
+	stats = getStats(device.get());
+	assert(stats.resources == 1);
+	assert(stats.bufferMemory == 0);
+	assert(stats.errors == 0);
+
+	//Display changes resize the display target
+	DisplayConfig display;
+	device->getDisplayConfiguration(display);
+	display.resolutionW = 128;
+	device->setDisplayConfiguration(display);
+
+	stats = getStats(device.get());
+	assert(stats.resources == 1);
+	assert(stats.imageMemory == 128 * 32 * 4);
+}
+
+void testNullValidatesCalls()
+{
+	NullDevicePtr device = createDevice();
+	RenderContext* context = device->context();
+
+	ResourceData data;
+	BufferResourceInfo info;
+	info.type = BufferType::CONSTANTS;
+
+	//Invalid size
+	info.size = 20;
+	assert(!device->createResourceBuffer(data, info, ResourceHandle()));
+	assert(getStats(device.get()).errors == 1);
+
+	info.size = 32;
+	ResourceHandle buffer = device->createResourceBuffer(data, info, ResourceHandle()).release();
+	assert(buffer != ResourceHandle());
+
+	char memory[64] = {};
+
+	context->resourceUpdateRange(buffer, memory, 16, 16);
+	assert(getStats(device.get()).errors == 1);
+
+	//Out of range update
+	context->resourceUpdateRange(buffer, memory, 16, 32);
+	assert(getStats(device.get()).errors == 2);
+
+	//Stale handle
+	device->destroy(buffer);
+	context->resourceUpdate(buffer, memory);
+	assert(getStats(device.get()).errors == 3);
+
+	//Draw with nothing bound
+	DrawParams params;
+	params.count = 3;
+	context->drawBound(params);
+
+	NullDeviceStats stats = getStats(device.get());
+	assert(stats.errors == 4);
+	assert(stats.draws == 1);
+	assert(stats.updates == 3);
+
+	RenderStats frame;
+	device->queryStats(frame);
+	assert(frame.drawcalls == 1);
+
+	//Draw calls are counted per frame
+	device->commit();
+	device->queryStats(frame);
+	assert(frame.drawcalls == 0);
+}
+
+void testNullDraws()
+{
+	NullDevicePtr device = createDevice();
+	RenderContext* context = device->context();
+
+	const char bytecode[] = "null";
+	ShaderCreateInfo shaderInfo;
+	shaderInfo.stages[(size_t)ShaderStage::VERTEX].bytecode = bytecode;
+	shaderInfo.stages[(size_t)ShaderStage::VERTEX].size = sizeof(bytecode);
+
+	RPtr<ShaderHandle> shader = device->createShader(shaderInfo);
+	assert(shader);
+
+	PipelineCreateInfo pipelineInfo;
+	pipelineInfo.topology = VertexTopology::TRIANGLELIST;
+	RPtr<PipelineHandle> pipeline = device->createPipeline(shader.handle(), pipelineInfo);
+	assert(pipeline);
+
+	ImageView attachment;
+	attachment.image = device->getDisplayTarget();
+
+	TargetCreateInfo targetInfo;
+	targetInfo.attachments = &attachment;
+	targetInfo.attachmentCount = 1;
+	RPtr<TargetHandle> target = device->createTarget(targetInfo, TargetHandle());
+	assert(target);
+
+	ResourceSetCreateInfo setInfo;
+	RPtr<ResourceSetHandle> inputs = device->createResourceSet(setInfo, ResourceSetHandle());
+	assert(inputs);
+
+	DrawParams params;
+	params.count = 3;
+	context->draw(target.handle(), pipeline.handle(), inputs.handle(), params);
+
+	//Indexed draws need an index buffer
+	params.mode = DrawMode::INDEXED;
+	context->draw(target.handle(), pipeline.handle(), inputs.handle(), params);
+
+	//Target has no depth attachment
+	context->clearDepthTarget(target.handle(), 1.0f);
+
+	//Dynamic constant buffers are read at each draw's offset, which must be aligned and inside the buffer
+	BufferResourceInfo bufferInfo;
+	bufferInfo.size = 512;
+	bufferInfo.type = BufferType::CONSTANTS;
+	RPtr<ResourceHandle> constants = device->createResourceBuffer(ResourceData(), bufferInfo);
+	assert(constants);
+
+	const ResourceHandle constantsHandle = constants.handle();
+	ResourceSetCreateInfo dynamicInfo;
+	dynamicInfo.constantBuffers = &constantsHandle;
+	dynamicInfo.constantBuffersCount = 1;
+	dynamicInfo.dynamicConstants = 1;
+	RPtr<ResourceSetHandle> dynamicInputs = device->createResourceSet(dynamicInfo, ResourceSetHandle());
+	assert(dynamicInputs);
+
+	params.mode = DrawMode::VERTEX;
+	params.constantOffset = 256;
+	context->draw(target.handle(), pipeline.handle(), dynamicInputs.handle(), params);
+	params.constantOffset = 100;
+	context->draw(target.handle(), pipeline.handle(), dynamicInputs.handle(), params);
+	params.constantOffset = 512;
+	context->draw(target.handle(), pipeline.handle(), dynamicInputs.handle(), params);
+
+	//Dynamic slots must have a constant buffer
+	dynamicInfo.dynamicConstants = 2;
+	assert(!device->createResourceSet(dynamicInfo, ResourceSetHandle()));
+
+	context->finish();
+
+	NullDeviceStats stats = getStats(device.get());
+	assert(stats.draws == 5);
+	assert(stats.binds == 15);
+	assert(stats.clears == 1);
+	assert(stats.finishes == 1);
+	assert(stats.errors == 5);
+	assert(stats.shaders == 1);
+	assert(stats.pipelines == 1);
+	assert(stats.targets == 1);
+	assert(stats.resourceSets == 2);
+}
+
+void testNullDrawIndirect()
+{
+	NullDevicePtr device = createDevice();
+	RenderContext* context = device->context();
+
+	const char bytecode[] = "null";
+	ShaderCreateInfo shaderInfo;
+	shaderInfo.stages[(size_t)ShaderStage::VERTEX].bytecode = bytecode;
+	shaderInfo.stages[(size_t)ShaderStage::VERTEX].size = sizeof(bytecode);
+	RPtr<ShaderHandle> shader = device->createShader(shaderInfo);
+
+	PipelineCreateInfo pipelineInfo;
+	pipelineInfo.topology = VertexTopology::TRIANGLELIST;
+	RPtr<PipelineHandle> pipeline = device->createPipeline(shader.handle(), pipelineInfo);
+
+	ImageView attachment;
+	attachment.image = device->getDisplayTarget();
+
+	TargetCreateInfo targetInfo;
+	targetInfo.attachments = &attachment;
+	targetInfo.attachmentCount = 1;
+	RPtr<TargetHandle> target = device->createTarget(targetInfo, TargetHandle());
+
+	ResourceSetCreateInfo setInfo;
+	RPtr<ResourceSetHandle> inputs = device->createResourceSet(setInfo, ResourceSetHandle());
+
+	DrawIndirectArgs args[2];
+	args[0].count = 3;
+	args[1].count = 6;
+	args[1].instances = 2;
+
+	BufferResourceInfo argsInfo;
+	argsInfo.size = sizeof(args);
+	argsInfo.type = BufferType::INDIRECT;
+	ResourceData argsData;
+	argsData.memory = args;
+	RPtr<ResourceHandle> argsBuffer = device->createResourceBuffer(argsData, argsInfo);
+	assert(argsBuffer);
+
+	context->bindTarget(target.handle());
+	context->bindPipeline(pipeline.handle());
+	context->bindResourceSet(inputs.handle());
+
+	//Each argument is validated and counted as a draw
+	context->multiDrawIndirect(argsBuffer.handle(), 0, 2, false);
+
+	RenderStats frame;
+	device->queryStats(frame);
+	assert(frame.drawcalls == 2);
+	assert(frame.instances == 3);
+	assert(frame.triangles == 5);
+	assert(getStats(device.get()).errors == 0);
+
+	//Arguments are read when drawn so updates are seen
+	args[0].count = 0;
+	context->resourceUpdateRange(argsBuffer.handle(), &args[0], 0, sizeof(DrawIndirectArgs));
+	context->drawIndirect(argsBuffer.handle(), 0, false);
+
+	//Argument buffers must be indirect buffers and arguments must be aligned and inside the buffer
+	BufferResourceInfo vertexInfo;
+	vertexInfo.size = sizeof(args);
+	vertexInfo.type = BufferType::VERTEX;
+	RPtr<ResourceHandle> vertices = device->createResourceBuffer(ResourceData(), vertexInfo);
+
+	context->drawIndirect(vertices.handle(), 0, false);
+	context->drawIndirect(argsBuffer.handle(), 2, false);
+	context->multiDrawIndirect(argsBuffer.handle(), sizeof(DrawIndirectArgs), 2, false);
+	context->drawIndirect(argsBuffer.handle(), 16, true);
+
+	context->finish();
+
+	NullDeviceStats stats = getStats(device.get());
+	assert(stats.draws == 3);
+	assert(stats.errors == 5);
+}
+
+void testNullDispatch()
+{
+	NullDevicePtr device = createDevice();
+	RenderContext* context = device->context();
+
+	const char bytecode[] = "null";
+	ShaderCreateInfo shaderInfo;
+	shaderInfo.stages[(size_t)ShaderStage::COMPUTE].bytecode = bytecode;
+	shaderInfo.stages[(size_t)ShaderStage::COMPUTE].size = sizeof(bytecode);
+	RPtr<ShaderHandle> shader = device->createShader(shaderInfo);
+	assert(shader);
+
+	RPtr<PipelineHandle> pipeline = device->createPipeline(shader.handle(), PipelineCreateInfo());
+	assert(pipeline);
+
+	//Compute stages can't be combined with graphics stages
+	shaderInfo.stages[(size_t)ShaderStage::VERTEX] = shaderInfo.stages[(size_t)ShaderStage::COMPUTE];
+	assert(!device->createShader(shaderInfo));
+
+	//Storage buffers must be storage or indirect buffers, storage images must be created for unordered access
+	BufferResourceInfo storageInfo;
+	storageInfo.size = 256;
+	storageInfo.type = BufferType::STORAGE;
+	RPtr<ResourceHandle> storage = device->createResourceBuffer(ResourceData(), storageInfo);
+
+	DispatchIndirectArgs args;
+	args.groupsX = 8;
+
+	BufferResourceInfo argsInfo;
+	argsInfo.size = sizeof(args);
+	argsInfo.type = BufferType::INDIRECT;
+	ResourceData argsData;
+	argsData.memory = &args;
+	RPtr<ResourceHandle> argsBuffer = device->createResourceBuffer(argsData, argsInfo);
+
+	ImageResourceInfo imageInfo;
+	imageInfo.format = ImageFormat::RGBA;
+	imageInfo.width = 16;
+	imageInfo.height = 16;
+	imageInfo.usage = ImageUsage::SRV | ImageUsage::UAV;
+	RPtr<ResourceHandle> image = device->createResourceImage(nullptr, imageInfo);
+
+	const ResourceHandle storageBuffers[] = { storage.handle(), argsBuffer.handle() };
+	ImageView storageImage;
+	storageImage.image = image.handle();
+
+	ResourceSetCreateInfo setInfo;
+	setInfo.storageBuffers = storageBuffers;
+	setInfo.storageBufferCount = 2;
+	setInfo.storageImages = &storageImage;
+	setInfo.storageImageCount = 1;
+	RPtr<ResourceSetHandle> inputs = device->createResourceSet(setInfo, ResourceSetHandle());
+	assert(inputs);
+
+	setInfo.storageImages = nullptr;
+	setInfo.storageImageCount = 0;
+	setInfo.storageBuffers = &storageImage.image;
+	setInfo.storageBufferCount = 1;
+	assert(!device->createResourceSet(setInfo, ResourceSetHandle()));
+
+	storageImage.image = device->getDisplayTarget();
+	setInfo.storageBuffers = nullptr;
+	setInfo.storageBufferCount = 0;
+	setInfo.storageImages = &storageImage;
+	setInfo.storageImageCount = 1;
+	assert(!device->createResourceSet(setInfo, ResourceSetHandle()));
+
+	assert(getStats(device.get()).errors == 3);
+
+	DispatchParams params;
+	params.groupsX = 4;
+	params.groupsY = 4;
+	context->dispatch(pipeline.handle(), inputs.handle(), params);
+	context->dispatchIndirect(pipeline.handle(), inputs.handle(), argsBuffer.handle(), 0);
+
+	RenderStats frame;
+	device->queryStats(frame);
+	assert(frame.dispatches == 2);
+	assert(frame.drawcalls == 0);
+	assert(getStats(device.get()).errors == 3);
+
+	//Dispatches need at least one group and compute pipelines can't be drawn with
+	params.groupsZ = 0;
+	context->dispatch(pipeline.handle(), inputs.handle(), params);
+	params.groupsZ = DispatchParams::MAX_GROUPS + 1;
+	context->dispatch(pipeline.handle(), inputs.handle(), params);
+	context->dispatchIndirect(pipeline.handle(), inputs.handle(), argsBuffer.handle(), 4);
+
+	ImageView attachment;
+	attachment.image = device->getDisplayTarget();
+
+	TargetCreateInfo targetInfo;
+	targetInfo.attachments = &attachment;
+	targetInfo.attachmentCount = 1;
+	RPtr<TargetHandle> target = device->createTarget(targetInfo, TargetHandle());
+
+	DrawParams draw;
+	draw.count = 3;
+	context->bindTarget(target.handle());
+	context->bindPipeline(pipeline.handle());
+	context->bindResourceSet(inputs.handle());
+	context->drawBound(draw);
+
+	context->finish();
+
+	NullDeviceStats stats = getStats(device.get());
+	assert(stats.dispatches == 4);
+	assert(stats.errors == 7);
+}
+
+void testNullParallelRecording()
+{
+	NullDevicePtr device = createDevice();
+
+	const char bytecode[] = "null";
+	ShaderCreateInfo shaderInfo;
+	shaderInfo.stages[(size_t)ShaderStage::VERTEX].bytecode = bytecode;
+	shaderInfo.stages[(size_t)ShaderStage::VERTEX].size = sizeof(bytecode);
+	RPtr<ShaderHandle> shader = device->createShader(shaderInfo);
+	RPtr<PipelineHandle> pipeline = device->createPipeline(shader.handle(), PipelineCreateInfo());
+
+	ImageView attachment;
+	attachment.image = device->getDisplayTarget();
+
+	TargetCreateInfo targetInfo;
+	targetInfo.attachments = &attachment;
+	targetInfo.attachmentCount = 1;
+	RPtr<TargetHandle> target = device->createTarget(targetInfo, TargetHandle());
+	RPtr<ResourceSetHandle> inputs = device->createResourceSet(ResourceSetCreateInfo(), ResourceSetHandle());
+
+	const uint32 workerCount = 4;
+	const uint32 drawsPerWorker = 100;
+
+	RenderContext* workers[workerCount] = {};
+	assert(device->acquireContexts(workers, workerCount) == workerCount);
+
+	//Each worker records and finishes on it's own thread
+	vector<thread> threads;
+
+	for (RenderContext* worker : workers)
+	{
+		threads.emplace_back([&, worker]() {
+			DrawParams params;
+			params.count = 3;
+
+			for (uint32 i = 0; i < drawsPerWorker; i++)
+				worker->draw(target.handle(), pipeline.handle(), inputs.handle(), params);
+
+			worker->finish();
+		});
+	}
+
+	for (thread& t : threads)
+		t.join();
+
+	device->submitContexts(workers, workerCount);
+
+	RenderStats frame;
+	device->queryStats(frame);
+	assert(frame.drawcalls == workerCount * drawsPerWorker);
+
+	NullDeviceStats stats = getStats(device.get());
+	assert(stats.draws == workerCount * drawsPerWorker);
+	assert(stats.finishes == workerCount + 1);
+	assert(stats.acquires == workerCount);
+	assert(stats.submits == workerCount);
+	assert(stats.errors == 0);
+
+	device->commit();
+
+	//Workers are reused next frame
+	RenderContext* next[2] = {};
+	assert(device->acquireContexts(next, 2) == 2);
+	assert(next[0] == workers[0] && next[1] == workers[1]);
+
+	//Submitting an unfinished worker, the main context or a worker twice is an error
+	next[0]->clearColourTarget(target.handle(), 0);
+	device->submitContexts(next, 1);
+	device->submitContexts(&next[1], 1);
+	device->submitContexts(&next[1], 1);
+
+	RenderContext* main = device->context();
+	device->submitContexts(&main, 1);
+
+	assert(getStats(device.get()).errors == 3);
+
+	//next[0] was never submitted
+	device->commit();
+	assert(getStats(device.get()).errors == 4);
+	assert(getStats(device.get()).submits == workerCount + 1);
+}
+
+void testNullRenderStats()
+{
+	NullDevicePtr device = createDevice();
+	RenderContext* context = device->context();
+
+	RenderStats initial;
+	device->queryStats(initial);
+	//The display target is a render target image
+	assert(initial.targetMemory == 64 * 32 * 4);
+	assert(initial.imagesCreated == 1);
+
+	BufferResourceInfo bufferInfo;
+	bufferInfo.type = BufferType::VERTEX;
+	bufferInfo.size = 96;
+	RPtr<ResourceHandle> vertices = device->createResourceBuffer(ResourceData(), bufferInfo);
+	bufferInfo.type = BufferType::INDEX;
+	bufferInfo.size = 24;
+	RPtr<ResourceHandle> indices = device->createResourceBuffer(ResourceData(), bufferInfo);
+	bufferInfo.type = BufferType::CONSTANTS;
+	bufferInfo.size = 64;
+	RPtr<ResourceHandle> constants = device->createResourceBuffer(ResourceData(), bufferInfo);
+
+	ImageResourceInfo imageInfo;
+	imageInfo.format = ImageFormat::RGBA;
+	imageInfo.width = 8;
+	imageInfo.height = 4;
+	imageInfo.useMips = true;
+	RPtr<ResourceHandle> texture = device->createResourceImage(nullptr, imageInfo);
+
+	const char bytecode[] = "null";
+	ShaderCreateInfo shaderInfo;
+	shaderInfo.stages[(size_t)ShaderStage::VERTEX].bytecode = bytecode;
+	shaderInfo.stages[(size_t)ShaderStage::VERTEX].size = sizeof(bytecode);
+	RPtr<ShaderHandle> shader = device->createShader(shaderInfo);
+
+	PipelineCreateInfo pipelineInfo;
+	pipelineInfo.topology = VertexTopology::TRIANGLELIST;
+	RPtr<PipelineHandle> list = device->createPipeline(shader.handle(), pipelineInfo);
+	pipelineInfo.topology = VertexTopology::TRIANGLESTRIP;
+	RPtr<PipelineHandle> strip = device->createPipeline(shader.handle(), pipelineInfo);
+
+	ImageView attachment;
+	attachment.image = device->getDisplayTarget();
+	TargetCreateInfo targetInfo;
+	targetInfo.attachments = &attachment;
+	targetInfo.attachmentCount = 1;
+	RPtr<TargetHandle> target = device->createTarget(targetInfo, TargetHandle());
+
+	ResourceSetCreateInfo setInfo;
+	setInfo.indexBuffer = indices.handle();
+	RPtr<ResourceSetHandle> inputs = device->createResourceSet(setInfo, ResourceSetHandle());
+
+	char memory[128] = {};
+	context->resourceUpdate(vertices.handle(), memory);
+	context->resourceUpdateRange(constants.handle(), memory, 16, 32);
+	//Second mip of the texture is 4x2
+	context->resourceUpdate(texture.handle(), memory, 1);
+
+	DrawParams params;
+	params.count = 6;
+	context->draw(target.handle(), list.handle(), inputs.handle(), params);
+
+	params.mode = DrawMode::INDEXEDINSTANCED;
+	params.instances = 3;
+	context->bindPipeline(strip.handle());
+	context->drawBound(params);
+	context->finish();
+
+	RenderStats frame;
+	device->queryStats(frame);
+
+	assert(frame.drawcalls == 2);
+	assert(frame.instances == 4);
+	assert(frame.triangles == 2 + 3 * 4);
+	assert(frame.pipelineBinds == 2);
+	assert(frame.resourceSetBinds == 1);
+	assert(frame.targetBinds == 1);
+	assert(frame.bufferUpdates == 2);
+	assert(frame.bufferUpdateBytes == 96 + 32);
+	assert(frame.imageUpdates == 1);
+	assert(frame.imageUpdateBytes == 4 * 2 * 4);
+	assert(frame.buffersCreated == 3);
+	assert(frame.imagesCreated == 2);
+	assert(frame.shadersCreated == 1);
+	assert(frame.pipelinesCreated == 2);
+	assert(frame.targetsCreated == 1);
+	assert(frame.resourceSetsCreated == 1);
+	assert(frame.contextTime > 0);
+
+	assert(frame.vertexBufferMemory == 96);
+	assert(frame.indexBufferMemory == 24);
+	assert(frame.constantBufferMemory == 64);
+	assert(frame.imageMemory == (8 * 4 + 4 * 2 + 2 * 1 + 1 * 1) * 4);
+	assert(frame.targetMemory == initial.targetMemory);
+
+	//Over budget counters are reported
+	RenderStatsBudget budget;
+	budget.set(RenderStatsCounter::DRAWCALLS, 1);
+	budget.set(RenderStatsCounter::TRIANGLES, 100);
+	RenderStatsCounter over[4];
+	assert(budget.check(frame, over, 4) == 1);
+	assert(over[0] == RenderStatsCounter::DRAWCALLS);
+
+	//Frame counters are reset when the frame is committed, memory counters are kept
+	device->commit();
+
+	constants.reset();
+	context->drawBound(params);
+
+	RenderStats next;
+	device->queryStats(next);
+
+	assert(next.drawcalls == 1);
+	assert(next.buffersDestroyed == 1);
+	assert(next.buffersCreated == 0);
+
+	RenderStatsDelta delta(frame, next);
+	assert(delta[RenderStatsCounter::DRAWCALLS] == -1);
+	assert(delta[RenderStatsCounter::BUFFERS_DESTROYED] == 1);
+	assert(delta[RenderStatsCounter::CONSTANT_BUFFER_MEMORY] == -64);
+	assert(delta[RenderStatsCounter::IMAGE_MEMORY] == 0);
+	assert(!delta.empty());
+	assert(RenderStatsDelta(next, next).empty());
+
+	assert(getRenderStatsCounter(next, RenderStatsCounter::INDEX_BUFFER_MEMORY) == 24);
+	assert(string(getRenderStatsCounterName(RenderStatsCounter::TARGET_BINDS)) == "targetBinds");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+	//Execute test cases
+	testNullTracksMemory();
+	testNullValidatesCalls();
+	testNullDraws();
+	testNullDrawIndirect();
+	testNullDispatch();
+	testNullParallelRecording();
+	testNullRenderStats();
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
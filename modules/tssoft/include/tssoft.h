@@ -0,0 +1,151 @@
+/*
+	Public interface for the software rendering backend
+
+	The software device rasterises on the CPU so frames can be rendered and compared without a GPU.
+	Triangles are binned into screen tiles which are rasterised in parallel on a thread pool.
+
+	Shaders are C++ callables: a shader is created from a SoftProgram passed as the bytecode of the vertex stage
+	(or of the compute stage for compute shaders), or a program can be registered for an existing pipeline with setSoftPipelineProgram().
+*/
+
+#pragma once
+
+#include <tsgraphics/Driver.h>
+#include <tssoft_export.h>
+
+#include <functional>
+
+namespace ts
+{
+	enum SoftLimits
+	{
+		SOFT_MAX_VARYINGS = 16,
+		SOFT_MAX_VERTEX_BUFFERS = 8,
+		SOFT_MAX_CONSTANT_BUFFERS = 8,
+		SOFT_MAX_TEXTURES = 8,
+		SOFT_MAX_SAMPLERS = 4,
+		SOFT_MAX_STORAGE_BUFFERS = 8,
+		SOFT_MAX_STORAGE_IMAGES = 4,
+	};
+
+	/*
+		View of the top mip of an image (or of one element of an image array)
+	*/
+	struct SoftTexture
+	{
+		const uint8* data = nullptr;
+		uint32 width = 0;
+		uint32 height = 0;
+		uint32 rowPitch = 0;
+		ImageFormat format = ImageFormat::UNKNOWN;
+	};
+
+	//Writable view of a storage buffer
+	struct SoftStorageBuffer
+	{
+		uint8* data = nullptr;
+		uint32 size = 0;
+	};
+
+	//Writable view of the top mip of a storage image (or of one element of an image array)
+	struct SoftStorageImage
+	{
+		uint8* data = nullptr;
+		uint32 width = 0;
+		uint32 height = 0;
+		uint32 rowPitch = 0;
+		ImageFormat format = ImageFormat::UNKNOWN;
+	};
+
+	/*
+		Resources bound to a draw or dispatch
+	*/
+	struct SoftShaderResources
+	{
+		//Contents of each bound constant buffer
+		const uint8* constants[SOFT_MAX_CONSTANT_BUFFERS] = {};
+
+		SoftTexture textures[SOFT_MAX_TEXTURES];
+		SamplerState samplers[SOFT_MAX_SAMPLERS] = {};
+
+		//Read-write resources of the resource set
+		SoftStorageBuffer storageBuffers[SOFT_MAX_STORAGE_BUFFERS];
+		SoftStorageImage storageImages[SOFT_MAX_STORAGE_IMAGES];
+	};
+
+	struct SoftVertexInput
+	{
+		//Element of each bound vertex buffer for this vertex (or instance for instanced attributes)
+		const uint8* buffers[SOFT_MAX_VERTEX_BUFFERS] = {};
+
+		uint32 vertexID = 0;
+		uint32 instanceID = 0;
+	};
+
+	struct SoftVertexOutput
+	{
+		//Clip space position
+		float position[4];
+
+		//Interpolated across the triangle with perspective correction
+		float varyings[SOFT_MAX_VARYINGS];
+	};
+
+	struct SoftComputeInput
+	{
+		uint32 groupID[3] = {};
+		//Thread within the group
+		uint32 threadID[3] = {};
+		//Thread within the dispatch, groupID * groupSize + threadID
+		uint32 dispatchThreadID[3] = {};
+	};
+
+	/*
+		Shader program:
+
+		vertex() is called once per vertex, pixel() once per covered pixel which passed the depth test.
+		pixel() returns false to discard the pixel.
+
+		compute() is called once per thread of a dispatch. Thread groups run concurrently, the threads of a group
+		run one after another, so threads of different groups which write the same memory must use atomics.
+
+		All are called concurrently from the device's worker threads.
+	*/
+	struct SoftProgram
+	{
+		enum { MAGIC = 0x53465450 };
+
+		//Identifies a program passed as shader bytecode
+		uint32 magic = MAGIC;
+
+		//Number of varyings written by the vertex shader
+		uint32 varyingCount = 0;
+
+		std::function<void(const SoftVertexInput& input, const SoftShaderResources& resources, SoftVertexOutput& output)> vertex;
+		std::function<bool(const float* varyings, const SoftShaderResources& resources, float colour[4])> pixel;
+
+		//Threads in each dimension of a compute thread group
+		uint32 groupSize[3] = { 1, 1, 1 };
+
+		std::function<void(const SoftComputeInput& input, const SoftShaderResources& resources)> compute;
+	};
+
+	//Sample a texture at normalized coordinates, missing textures sample as transparent black
+	TSSOFT_API void sampleSoftTexture(const SoftTexture& texture, const SamplerState& sampler, float u, float v, float colour[4]);
+}
+
+extern "C"
+{
+	ts::RenderDevice* createSoftDevice(const ts::RenderDeviceConfig& config);
+
+	void destroySoftDevice(ts::RenderDevice* device);
+
+	//Register the program a pipeline draws with, returns false if the device is not a software device or the pipeline is invalid
+	bool setSoftPipelineProgram(ts::RenderDevice* device, ts::PipelineHandle pipeline, const ts::SoftProgram* program);
+
+	//Copy one subresource of an image as tightly packed RGBA8 pixels, dest must hold width * height * 4 bytes
+	bool readSoftImage(ts::RenderDevice* device, ts::ResourceHandle image, ts::uint32 index, void* dest);
+
+	//Write one subresource of an image to a PNG file
+	bool writeSoftImagePNG(ts::RenderDevice* device, ts::ResourceHandle image, ts::uint32 index, const char* path);
+}
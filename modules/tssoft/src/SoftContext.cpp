@@ -0,0 +1,568 @@
+/*
+	Render API
+
+	Software context implementation
+*/
+
+#include "SoftDevice.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+using namespace std;
+using namespace ts;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Resource commands
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SoftContext::resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	SoftResource* r = SoftResource::upcast(rsc);
+
+	if (r == nullptr || memory == nullptr)
+		return;
+
+	RenderStatsCollector& stats = m_device->getRenderStats();
+
+	if (!r->isImage)
+	{
+		memcpy(r->data.data(), memory, r->data.size());
+
+		stats.add(RenderStatsCounter::BUFFER_UPDATES);
+		stats.add(RenderStatsCounter::BUFFER_UPDATE_BYTES, r->data.size());
+	}
+	else if (index < r->subresources.size())
+	{
+		SoftSubresource& sub = r->subresources[index];
+		memcpy(sub.data.data(), memory, sub.data.size());
+
+		stats.add(RenderStatsCounter::IMAGE_UPDATES);
+		stats.add(RenderStatsCounter::IMAGE_UPDATE_BYTES, sub.data.size());
+	}
+}
+
+void SoftContext::resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	SoftResource* r = SoftResource::upcast(rsc);
+
+	if (r == nullptr || r->isImage || memory == nullptr || (uint64)offset + size > r->data.size())
+	{
+		tswarn("software device: invalid buffer range update (offset % size %)", offset, size);
+		return;
+	}
+
+	memcpy(r->data.data() + offset, memory, size);
+
+	m_device->getRenderStats().add(RenderStatsCounter::BUFFER_UPDATES);
+	m_device->getRenderStats().add(RenderStatsCounter::BUFFER_UPDATE_BYTES, size);
+}
+
+void SoftContext::resourceCopy(ResourceHandle src, ResourceHandle dest)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	SoftResource* s = SoftResource::upcast(src);
+	SoftResource* d = SoftResource::upcast(dest);
+
+	if (s == nullptr || d == nullptr || s->isImage != d->isImage || s->data.size() != d->data.size() || s->subresources.size() != d->subresources.size())
+	{
+		tswarn("software device: resources % and % can't be copied", (uintptr)src, (uintptr)dest);
+		return;
+	}
+
+	d->data = s->data;
+
+	for (size_t i = 0; i < s->subresources.size(); i++)
+	{
+		d->subresources[i].data = s->subresources[i].data;
+	}
+}
+
+void SoftContext::imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	SoftResource* s = SoftResource::upcast(src);
+	SoftResource* d = SoftResource::upcast(dest);
+
+	//Images are rendered with a single sample so resolving is a copy
+	if (s == nullptr || d == nullptr || index >= s->subresources.size() || index >= d->subresources.size()
+		|| s->subresources[index].data.size() != d->subresources[index].data.size())
+	{
+		tswarn("software device: images % and % can't be resolved", (uintptr)src, (uintptr)dest);
+		return;
+	}
+
+	d->subresources[index].data = s->subresources[index].data;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Target commands
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void fillSubresource(SoftSubresource& sub, ImageFormat format, const float colour[4])
+{
+	const uint32 pixelSize = getSoftPixelSize(format);
+
+	uint8 pixel[16];
+	storeSoftPixel(format, pixel, colour);
+
+	for (size_t i = 0; i < sub.data.size(); i += pixelSize)
+	{
+		memcpy(&sub.data[i], pixel, pixelSize);
+	}
+}
+
+void SoftContext::clearColourTarget(TargetHandle pass, uint32 colour)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	if (SoftTarget* target = SoftTarget::upcast(pass))
+	{
+		RGBA c(colour);
+		const float clear[4] = { c.R() / 255.0f, c.G() / 255.0f, c.B() / 255.0f, c.A() / 255.0f };
+
+		for (const ImageView& view : target->attachments)
+		{
+			SoftResource* rsc = SoftResource::upcast(view.image);
+
+			if (SoftSubresource* sub = (rsc != nullptr) ? rsc->getSubresource(view.index) : nullptr)
+			{
+				fillSubresource(*sub, rsc->image.format, clear);
+			}
+		}
+	}
+}
+
+void SoftContext::clearDepthTarget(TargetHandle pass, float depth)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	if (SoftTarget* target = SoftTarget::upcast(pass))
+	{
+		SoftResource* rsc = SoftResource::upcast(target->depth.image);
+
+		if (SoftSubresource* sub = (rsc != nullptr) ? rsc->getSubresource(target->depth.index) : nullptr)
+		{
+			const float clear[4] = { depth, 0.0f, 0.0f, 0.0f };
+			fillSubresource(*sub, rsc->image.format, clear);
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Draw commands
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SoftContext::draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params)
+{
+	bindTarget(outputs);
+	bindPipeline(pipeline);
+	bindResourceSet(inputs);
+	drawBound(params);
+}
+
+void SoftContext::bindTarget(TargetHandle outputs)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	m_device->getRenderStats().add(RenderStatsCounter::TARGET_BINDS);
+	m_target = SoftTarget::upcast(outputs);
+}
+
+void SoftContext::bindPipeline(PipelineHandle pipeline)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	m_device->getRenderStats().add(RenderStatsCounter::PIPELINE_BINDS);
+	m_pipeline = SoftPipeline::upcast(pipeline);
+}
+
+void SoftContext::bindResourceSet(ResourceSetHandle inputs)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	m_device->getRenderStats().add(RenderStatsCounter::RESOURCE_SET_BINDS);
+	m_inputs = SoftResourceSet::upcast(inputs);
+}
+
+bool SoftContext::getSurface(SoftSurface& surface) const
+{
+	int32 width = INT_MAX;
+	int32 height = INT_MAX;
+
+	for (const ImageView& view : m_target->attachments)
+	{
+		SoftResource* rsc = SoftResource::upcast(view.image);
+		SoftSubresource* sub = (rsc != nullptr) ? rsc->getSubresource(view.index) : nullptr;
+
+		if (sub == nullptr)
+			return false;
+
+		surface.colour[surface.colourCount] = sub;
+		surface.colourFormat[surface.colourCount] = rsc->image.format;
+		surface.colourCount++;
+
+		width = min(width, (int32)sub->width);
+		height = min(height, (int32)sub->height);
+	}
+
+	if (m_target->depth.image != ResourceHandle())
+	{
+		SoftResource* rsc = SoftResource::upcast(m_target->depth.image);
+		surface.depth = (rsc != nullptr) ? rsc->getSubresource(m_target->depth.index) : nullptr;
+
+		if (surface.depth == nullptr)
+			return false;
+
+		width = min(width, (int32)surface.depth->width);
+		height = min(height, (int32)surface.depth->height);
+	}
+
+	if (width == INT_MAX || height == INT_MAX)
+		return false;
+
+	//An empty viewport covers the whole target
+	Viewport vp = m_target->viewport;
+
+	if (vp.w == 0 || vp.h == 0)
+	{
+		vp.x = 0;
+		vp.y = 0;
+		vp.w = width;
+		vp.h = height;
+	}
+
+	surface.vpX = (float)vp.x;
+	surface.vpY = (float)vp.y;
+	surface.vpW = (float)vp.w;
+	surface.vpH = (float)vp.h;
+
+	surface.x0 = (int32)vp.x;
+	surface.y0 = (int32)vp.y;
+	surface.x1 = min((int32)(vp.x + vp.w), width);
+	surface.y1 = min((int32)(vp.y + vp.h), height);
+
+	if (m_pipeline->raster.enableScissor)
+	{
+		const Viewport& sc = m_target->scissor;
+		surface.x0 = max(surface.x0, (int32)sc.x);
+		surface.y0 = max(surface.y0, (int32)sc.y);
+		surface.x1 = min(surface.x1, (int32)(sc.x + sc.w));
+		surface.y1 = min(surface.y1, (int32)(sc.y + sc.h));
+	}
+
+	return true;
+}
+
+void SoftContext::getResources(SoftShaderResources& resources, const SoftPipeline& pipeline, const SoftResourceSet& set, uint32 constantOffset) const
+{
+	for (size_t i = 0; i < set.resources.size(); i++)
+	{
+		const ImageView& view = set.resources[i];
+		SoftResource* rsc = SoftResource::upcast(view.image);
+
+		if (SoftSubresource* sub = (rsc != nullptr && rsc->isImage) ? rsc->getSubresource(view.index) : nullptr)
+		{
+			resources.textures[i] = sub->view(rsc->image.format);
+		}
+	}
+
+	for (size_t i = 0; i < set.constantBuffers.size(); i++)
+	{
+		SoftResource* rsc = SoftResource::upcast(set.constantBuffers[i]);
+		resources.constants[i] = (rsc != nullptr && !rsc->isImage) ? rsc->data.data() : nullptr;
+
+		//Dynamic constant buffers are read at the offset of the draw
+		if (resources.constants[i] != nullptr && (set.dynamicConstants & (1u << i)) != 0)
+		{
+			if (constantOffset < rsc->data.size())
+			{
+				resources.constants[i] += constantOffset;
+			}
+			else
+			{
+				tswarn("software device: constant offset % is outside of the buffer", constantOffset);
+				resources.constants[i] = nullptr;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < set.storageBuffers.size(); i++)
+	{
+		SoftResource* rsc = SoftResource::upcast(set.storageBuffers[i]);
+
+		if (rsc != nullptr && !rsc->isImage)
+		{
+			resources.storageBuffers[i].data = rsc->data.data();
+			resources.storageBuffers[i].size = (uint32)rsc->data.size();
+		}
+	}
+
+	for (size_t i = 0; i < set.storageImages.size(); i++)
+	{
+		const ImageView& view = set.storageImages[i];
+		SoftResource* rsc = SoftResource::upcast(view.image);
+
+		if (SoftSubresource* sub = (rsc != nullptr && rsc->isImage) ? rsc->getSubresource(view.index) : nullptr)
+		{
+			resources.storageImages[i] = sub->storage(rsc->image.format);
+		}
+	}
+
+	for (int i = 0; i < SOFT_MAX_SAMPLERS; i++)
+	{
+		resources.samplers[i] = pipeline.samplers[i];
+	}
+}
+
+void SoftContext::drawBound(const DrawParams& params)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	m_device->getRenderStats().countDraw((m_pipeline != nullptr) ? m_pipeline->topology : VertexTopology::POINTLIST, params);
+
+	drawInstances(params, 0);
+}
+
+void SoftContext::multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+
+	SoftResource* rsc = SoftResource::upcast(args);
+	const uint32 stride = indexed ? sizeof(DrawIndexedIndirectArgs) : sizeof(DrawIndirectArgs);
+
+	if (rsc == nullptr || rsc->isImage || rsc->buffer.type != BufferType::INDIRECT)
+	{
+		tswarn("software device: indirect draw with an invalid argument buffer");
+		return;
+	}
+
+	if (offset % 4 != 0 || (uint64)offset + (uint64)stride * count > rsc->data.size())
+	{
+		tswarn("software device: indirect arguments are outside of the argument buffer (% draws at offset %)", count, offset);
+		return;
+	}
+
+	//Arguments are read from the buffer contents and drawn one at a time
+	for (uint32 i = 0; i < count; i++)
+	{
+		const uint8* memory = rsc->data.data() + offset + (size_t)i * stride;
+
+		DrawParams params;
+		uint32 startInstance = 0;
+
+		if (indexed)
+		{
+			DrawIndexedIndirectArgs a;
+			memcpy(&a, memory, sizeof(a));
+			params = a.params();
+			startInstance = a.startInstance;
+		}
+		else
+		{
+			DrawIndirectArgs a;
+			memcpy(&a, memory, sizeof(a));
+			params = a.params();
+			startInstance = a.startInstance;
+		}
+
+		m_device->getRenderStats().countDraw((m_pipeline != nullptr) ? m_pipeline->topology : VertexTopology::POINTLIST, params);
+		drawInstances(params, startInstance);
+	}
+}
+
+void SoftContext::drawInstances(const DrawParams& params, uint32 startInstance)
+{
+	if (m_target == nullptr || m_pipeline == nullptr || m_inputs == nullptr)
+	{
+		tswarn("software device: draw with invalid state (% vertices)", params.count);
+		return;
+	}
+
+	SoftSurface surface;
+	SoftShaderResources resources;
+
+	if (!getSurface(surface))
+		return;
+
+	getResources(resources, *m_pipeline, *m_inputs, params.constantOffset);
+
+	const bool indexed = (params.mode == DrawMode::INDEXED || params.mode == DrawMode::INDEXEDINSTANCED);
+	const bool instanced = (params.mode == DrawMode::INSTANCED || params.mode == DrawMode::INDEXEDINSTANCED);
+	const uint32 instances = instanced ? params.instances : 1;
+
+	/*
+		Find the range of vertices referenced by the draw
+	*/
+	int64 first = params.start;
+	uint32 count = params.count;
+
+	if (indexed)
+	{
+		SoftResource* ib = SoftResource::upcast(m_inputs->indexBuffer);
+
+		if (ib == nullptr || ib->isImage || ((uint64)params.start + params.count) * sizeof(uint32) > ib->data.size())
+		{
+			tswarn("software device: indexed draw with an invalid index buffer (% indices)", params.count);
+			return;
+		}
+
+		const uint32* indices = reinterpret_cast<const uint32*>(ib->data.data()) + params.start;
+
+		if (count == 0)
+			return;
+
+		uint32 lo = indices[0];
+		uint32 hi = indices[0];
+
+		for (uint32 i = 1; i < count; i++)
+		{
+			lo = min(lo, indices[i]);
+			hi = max(hi, indices[i]);
+		}
+
+		//Only the referenced vertices are shaded
+		m_indices.resize(count);
+
+		for (uint32 i = 0; i < count; i++)
+			m_indices[i] = indices[i] - lo;
+
+		first = (int64)lo + params.vbase;
+		count = hi - lo + 1;
+
+		if (first < 0)
+		{
+			tswarn("software device: indexed draw with a negative vertex base (%)", params.vbase);
+			return;
+		}
+	}
+
+	/*
+		Fetch vertex inputs and draw each instance
+	*/
+	const size_t slots = min<size_t>(m_inputs->vertexBuffers.size(), SOFT_MAX_VERTEX_BUFFERS);
+	const uint8* buffers[SOFT_MAX_VERTEX_BUFFERS] = {};
+	uint64 sizes[SOFT_MAX_VERTEX_BUFFERS] = {};
+
+	for (size_t s = 0; s < slots; s++)
+	{
+		if (SoftResource* vb = SoftResource::upcast(m_inputs->vertexBuffers[s].buffer))
+		{
+			buffers[s] = vb->data.data();
+			sizes[s] = vb->data.size();
+		}
+	}
+
+	m_vertexInputs.resize(count);
+
+	for (uint32 instance = 0; instance < instances; instance++)
+	{
+		for (uint32 i = 0; i < count; i++)
+		{
+			SoftVertexInput& input = m_vertexInputs[i];
+			input.vertexID = (uint32)(first + i);
+			input.instanceID = instance;
+
+			for (size_t s = 0; s < slots; s++)
+			{
+				const VertexBufferView& view = m_inputs->vertexBuffers[s];
+				const uint64 element = m_pipeline->instanced[s] ? (uint64)startInstance + instance : input.vertexID;
+				const uint64 offset = view.offset + element * view.stride;
+
+				//Out of range elements are null
+				input.buffers[s] = (buffers[s] != nullptr && offset + view.stride <= sizes[s]) ? buffers[s] + offset : nullptr;
+			}
+		}
+
+		m_rasteriser.draw(surface, *m_pipeline, resources, m_vertexInputs.data(), count, indexed ? m_indices.data() : nullptr, params.count);
+	}
+}
+
+void SoftContext::dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	m_device->getRenderStats().add(RenderStatsCounter::DISPATCHES);
+
+	dispatchGroups(SoftPipeline::upcast(pipeline), SoftResourceSet::upcast(inputs), params);
+}
+
+void SoftContext::dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset)
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+
+	SoftResource* rsc = SoftResource::upcast(args);
+
+	if (rsc == nullptr || rsc->isImage || rsc->buffer.type != BufferType::INDIRECT ||
+		offset % 4 != 0 || (uint64)offset + sizeof(DispatchIndirectArgs) > rsc->data.size())
+	{
+		tswarn("software device: indirect dispatch with invalid arguments (offset %)", offset);
+		return;
+	}
+
+	//Arguments written by earlier dispatches are read from the buffer contents
+	DispatchIndirectArgs a;
+	memcpy(&a, rsc->data.data() + offset, sizeof(a));
+
+	m_device->getRenderStats().add(RenderStatsCounter::DISPATCHES);
+
+	dispatchGroups(SoftPipeline::upcast(pipeline), SoftResourceSet::upcast(inputs), a.params());
+}
+
+void SoftContext::dispatchGroups(const SoftPipeline* pipeline, const SoftResourceSet* set, const DispatchParams& params)
+{
+	if (pipeline == nullptr || set == nullptr || !pipeline->program.compute)
+	{
+		tswarn("software device: dispatch with invalid state (% x % x % groups)", params.groupsX, params.groupsY, params.groupsZ);
+		return;
+	}
+
+	if (params.groupsX > DispatchParams::MAX_GROUPS || params.groupsY > DispatchParams::MAX_GROUPS || params.groupsZ > DispatchParams::MAX_GROUPS)
+	{
+		tswarn("software device: dispatch has too many groups (% x % x %)", params.groupsX, params.groupsY, params.groupsZ);
+		return;
+	}
+
+	SoftShaderResources resources;
+	getResources(resources, *pipeline, *set, params.constantOffset);
+
+	const SoftProgram& program = pipeline->program;
+	const uint32* size = program.groupSize;
+	const uint64 groups = (uint64)params.groupsX * params.groupsY * params.groupsZ;
+
+	//Groups are run in chunks so large dispatches don't create a task per group
+	enum { GROUP_CHUNK = 64 };
+
+	parallel_for(m_pool, (size_t)((groups + GROUP_CHUNK - 1) / GROUP_CHUNK), [&](size_t chunk) {
+		const uint64 end = min<uint64>((uint64)(chunk + 1) * GROUP_CHUNK, groups);
+
+		for (uint64 g = (uint64)chunk * GROUP_CHUNK; g < end; g++)
+		{
+			SoftComputeInput input;
+			input.groupID[0] = (uint32)(g % params.groupsX);
+			input.groupID[1] = (uint32)((g / params.groupsX) % params.groupsY);
+			input.groupID[2] = (uint32)(g / ((uint64)params.groupsX * params.groupsY));
+
+			for (uint32 z = 0; z < size[2]; z++)
+			for (uint32 y = 0; y < size[1]; y++)
+			for (uint32 x = 0; x < size[0]; x++)
+			{
+				const uint32 thread[3] = { x, y, z };
+
+				for (int i = 0; i < 3; i++)
+				{
+					input.threadID[i] = thread[i];
+					input.dispatchThreadID[i] = input.groupID[i] * size[i] + thread[i];
+				}
+
+				program.compute(input, resources);
+			}
+		}
+	});
+}
+
+void SoftContext::finish()
+{
+	RenderStatsTimer timer(m_device->getRenderStats());
+	m_target = nullptr;
+	m_pipeline = nullptr;
+	m_inputs = nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,491 @@
+/*
+	Render API
+
+	Software implementation of Render Driver
+*/
+
+#include "SoftDevice.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace ts;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Helpers
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static uint32 getMipCount(const ImageResourceInfo& info)
+{
+	if (!info.useMips)
+		return 1;
+
+	if (info.mipLevels > 1)
+		return info.mipLevels;
+
+	//Full mip chain
+	uint32 levels = 1;
+	for (uint32 size = max(info.width, info.height); size > 1; size /= 2)
+		levels++;
+
+	return levels;
+}
+
+//Number of array elements of an image, 3D images have one element
+static uint32 getElementCount(const ImageResourceInfo& info)
+{
+	switch (info.type)
+	{
+	case ImageType::CUBE: return 6 * info.length;
+	case ImageType::_3D: return 1;
+	default: return info.length;
+	}
+}
+
+//The pool does not include the calling thread which takes part in rasterising
+static uint32 getWorkerCount()
+{
+	const uint32 n = thread::hardware_concurrency();
+	return (n > 1) ? n - 1 : 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Constructor/destructor
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SoftDevice::SoftDevice(const RenderDeviceConfig& cfg) :
+	m_pool((int)getWorkerCount()),
+	m_context(this, m_pool),
+	m_display(cfg.display)
+{
+	updateDisplayTarget();
+}
+
+SoftDevice::~SoftDevice()
+{
+	if (m_displayTarget != ResourceHandle())
+	{
+		destroy(m_displayTarget);
+	}
+}
+
+void SoftDevice::commit()
+{
+	//Nothing to present, the display target can be read back with readSoftImage()
+
+	//Commands of workers which weren't submitted are dropped
+	for (uint32 i = 0; i < m_acquiredContexts; i++)
+	{
+		m_workerContexts[i]->reset();
+	}
+
+	m_acquiredContexts = 0;
+
+	//Reset frame counters each frame
+	m_renderStats.nextFrame();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Parallel recording
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32 SoftDevice::acquireContexts(RenderContext** contexts, uint32 count)
+{
+	for (uint32 i = 0; i < count; i++)
+	{
+		if (m_acquiredContexts == m_workerContexts.size())
+		{
+			m_workerContexts.push_back(unique_ptr<SoftWorkerContext>(new SoftWorkerContext()));
+		}
+
+		contexts[i] = m_workerContexts[m_acquiredContexts++].get();
+	}
+
+	return count;
+}
+
+void SoftDevice::submitContexts(RenderContext* const* contexts, uint32 count)
+{
+	//Commands already recorded on the main context have been executed, the worker commands follow them in order
+	for (uint32 i = 0; i < count; i++)
+	{
+		SoftWorkerContext* worker = static_cast<SoftWorkerContext*>(contexts[i]);
+
+		if (!worker->isFinished())
+		{
+			tswarn("software device: worker context submitted before it was finished");
+			continue;
+		}
+
+		worker->execute(&m_context);
+	}
+
+	//Submission resets the main context's bound state
+	m_context.finish();
+}
+
+void SoftDevice::queryStats(RenderStats& stats)
+{
+	m_renderStats.query(stats);
+}
+
+void SoftDevice::queryInfo(RenderDeviceInfo& info)
+{
+	info.adapterName = "Software Device";
+	info.gpuVideoMemory = 0;
+	info.gpuSystemMemory = 0;
+	info.sharedSystemMemory = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Display
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SoftDevice::setDisplayConfiguration(const DisplayConfig& displayCfg)
+{
+	m_display = displayCfg;
+	updateDisplayTarget();
+}
+
+void SoftDevice::getDisplayConfiguration(DisplayConfig& displayCfg)
+{
+	displayCfg = m_display;
+}
+
+//The display target is an image the size of the display which is recreated in place when the display changes
+void SoftDevice::updateDisplayTarget()
+{
+	ImageResourceInfo info;
+	info.format = ImageFormat::RGBA;
+	info.usage = ImageUsage::RTV | ImageUsage::SRV;
+	info.width = max<uint32>(m_display.resolutionW, 1);
+	info.height = max<uint32>(m_display.resolutionH, 1);
+
+	m_displayTarget = createResourceImage(nullptr, info, m_displayTarget).release();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Resources
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Reuse the object of a valid recycle handle, otherwise create a new object
+template<typename object_t, typename handle_t>
+static object_t* recycleObject(handle_t recycle)
+{
+	if (object_t* o = object_t::upcast(recycle))
+	{
+		*o = object_t();
+		return o;
+	}
+
+	return new object_t();
+}
+
+void SoftDevice::countMemory(const SoftResource* rsc, bool live)
+{
+	uint64 size = rsc->data.size();
+
+	for (const SoftSubresource& sub : rsc->subresources)
+	{
+		size += sub.data.size();
+	}
+
+	const RenderStatsCounter counter = rsc->isImage ? RenderStatsCollector::getMemoryCounter(rsc->image.usage) : RenderStatsCollector::getMemoryCounter(rsc->buffer.type);
+
+	if (live)
+		m_renderStats.add(counter, size);
+	else
+		m_renderStats.subtract(counter, size);
+}
+
+SoftResource* SoftDevice::recycleResource(ResourceHandle recycle)
+{
+	if (SoftResource* old = SoftResource::upcast(recycle))
+	{
+		countMemory(old, false);
+	}
+
+	return recycleObject<SoftResource>(recycle);
+}
+
+RPtr<ResourceHandle> SoftDevice::createEmptyResource(ResourceHandle recycle)
+{
+	SoftResource* rsc = recycleResource(recycle);
+	return RPtr<ResourceHandle>(this, rsc->handle());
+}
+
+RPtr<ResourceHandle> SoftDevice::createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle)
+{
+	if (info.size == 0)
+	{
+		tswarn("software device: buffer size % is invalid", info.size);
+		return RPtr<ResourceHandle>();
+	}
+
+	SoftResource* rsc = recycleResource(recycle);
+
+	rsc->isImage = false;
+	rsc->buffer = info;
+	rsc->data.resize(info.size, 0);
+
+	if (data.memory != nullptr)
+	{
+		memcpy(rsc->data.data(), data.memory, info.size);
+	}
+
+	countMemory(rsc, true);
+	m_renderStats.add(RenderStatsCounter::BUFFERS_CREATED);
+
+	return RPtr<ResourceHandle>(this, rsc->handle());
+}
+
+RPtr<ResourceHandle> SoftDevice::createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle)
+{
+	const uint32 pixelSize = getSoftPixelSize(info.format);
+
+	if (pixelSize == 0 || info.width == 0 || info.height == 0 || info.length == 0)
+	{
+		tswarn("software device: image format or dimensions are invalid (% x %)", info.width, info.height);
+		return RPtr<ResourceHandle>();
+	}
+
+	SoftResource* rsc = recycleResource(recycle);
+
+	rsc->isImage = true;
+	rsc->image = info;
+	rsc->mipCount = getMipCount(info);
+
+	const uint32 elements = getElementCount(info);
+	rsc->subresources.resize(elements * rsc->mipCount);
+
+	for (uint32 e = 0; e < elements; e++)
+	{
+		uint32 w = info.width;
+		uint32 h = info.height;
+		uint32 d = (info.type == ImageType::_3D) ? info.length : 1;
+
+		for (uint32 m = 0; m < rsc->mipCount; m++)
+		{
+			SoftSubresource& sub = *rsc->getSubresource(e, m);
+			sub.width = w;
+			sub.height = h;
+			sub.depth = d;
+			sub.rowPitch = w * pixelSize;
+			sub.data.resize((size_t)sub.rowPitch * h * d, 0);
+
+			const ResourceData* init = (data != nullptr) ? &data[m + e * rsc->mipCount] : nullptr;
+
+			//Copy initial data row by row as the source pitch may be padded
+			if (init != nullptr && init->memory != nullptr)
+			{
+				const uint32 srcPitch = (init->memoryByteWidth > 0) ? init->memoryByteWidth : sub.rowPitch;
+
+				for (uint32 y = 0; y < h * d; y++)
+				{
+					memcpy(&sub.data[(size_t)y * sub.rowPitch], (const uint8*)init->memory + (size_t)y * srcPitch, sub.rowPitch);
+				}
+			}
+
+			w = max(w / 2, 1u);
+			h = max(h / 2, 1u);
+			d = max(d / 2, 1u);
+		}
+	}
+
+	countMemory(rsc, true);
+	m_renderStats.add(RenderStatsCounter::IMAGES_CREATED);
+
+	return RPtr<ResourceHandle>(this, rsc->handle());
+}
+
+RPtr<ResourceSetHandle> SoftDevice::createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle)
+{
+	if (info.resourceCount > SOFT_MAX_TEXTURES || info.constantBuffersCount > SOFT_MAX_CONSTANT_BUFFERS || info.vertexBufferCount > SOFT_MAX_VERTEX_BUFFERS ||
+		info.storageBufferCount > SOFT_MAX_STORAGE_BUFFERS || info.storageImageCount > SOFT_MAX_STORAGE_IMAGES)
+	{
+		tswarn("software device: resource set has too many bindings (% resources)", info.resourceCount);
+		return RPtr<ResourceSetHandle>();
+	}
+
+	SoftResourceSet* set = recycleObject<SoftResourceSet>(recycle);
+
+	set->resources.assign(info.resources, info.resources + info.resourceCount);
+	set->constantBuffers.assign(info.constantBuffers, info.constantBuffers + info.constantBuffersCount);
+	set->vertexBuffers.assign(info.vertexBuffers, info.vertexBuffers + info.vertexBufferCount);
+	set->indexBuffer = info.indexBuffer;
+	set->dynamicConstants = info.dynamicConstants;
+	set->storageBuffers.assign(info.storageBuffers, info.storageBuffers + info.storageBufferCount);
+	set->storageImages.assign(info.storageImages, info.storageImages + info.storageImageCount);
+
+	m_renderStats.add(RenderStatsCounter::RESOURCE_SETS_CREATED);
+
+	return RPtr<ResourceSetHandle>(this, set->handle());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Pipeline state
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RPtr<ShaderHandle> SoftDevice::createShader(const ShaderCreateInfo& info)
+{
+	SoftShader* shader = new SoftShader();
+
+	//Shaders which were not created from a program (eg. compiled HLSL) draw nothing until a program is registered for the pipeline
+	for (ShaderStage stage : { ShaderStage::VERTEX, ShaderStage::COMPUTE })
+	{
+		const ShaderBytecode& code = info.stages[(size_t)stage];
+
+		if (code.size == sizeof(SoftProgram) && reinterpret_cast<const SoftProgram*>(code.bytecode)->magic == SoftProgram::MAGIC)
+		{
+			shader->program = *reinterpret_cast<const SoftProgram*>(code.bytecode);
+			break;
+		}
+	}
+
+	m_renderStats.add(RenderStatsCounter::SHADERS_CREATED);
+
+	return RPtr<ShaderHandle>(this, shader->handle());
+}
+
+RPtr<PipelineHandle> SoftDevice::createPipeline(ShaderHandle program, const PipelineCreateInfo& info)
+{
+	SoftShader* shader = SoftShader::upcast(program);
+
+	if (shader == nullptr)
+	{
+		tswarn("software device: pipeline shader % is invalid", (uintptr)program);
+		return RPtr<PipelineHandle>();
+	}
+
+	SoftPipeline* pipeline = new SoftPipeline();
+	pipeline->program = shader->program;
+	pipeline->raster = info.raster;
+	pipeline->depth = info.depth;
+	pipeline->blend = info.blend;
+	pipeline->topology = info.topology;
+
+	for (size_t i = 0; i < min<size_t>(info.samplerCount, SOFT_MAX_SAMPLERS); i++)
+	{
+		pipeline->samplers[i] = info.samplers[i];
+	}
+
+	for (size_t i = 0; i < info.vertexAttributeCount; i++)
+	{
+		const VertexAttribute& attrib = info.vertexAttributeList[i];
+
+		if (attrib.bufferSlot < SOFT_MAX_VERTEX_BUFFERS && attrib.channel == VertexAttributeChannel::INSTANCE)
+		{
+			pipeline->instanced[attrib.bufferSlot] = true;
+		}
+	}
+
+	m_renderStats.add(RenderStatsCounter::PIPELINES_CREATED);
+
+	return RPtr<PipelineHandle>(this, pipeline->handle());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Targets
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RPtr<TargetHandle> SoftDevice::createTarget(const TargetCreateInfo& info, TargetHandle recycle)
+{
+	if (info.attachmentCount > SoftSurface::MAX_ATTACHMENTS)
+	{
+		tswarn("software device: target has too many attachments (%)", info.attachmentCount);
+		return RPtr<TargetHandle>();
+	}
+
+	SoftTarget* target = recycleObject<SoftTarget>(recycle);
+
+	target->attachments.assign(info.attachments, info.attachments + info.attachmentCount);
+	target->depth = info.depth;
+	target->viewport = info.viewport;
+	target->scissor = info.scissor;
+
+	m_renderStats.add(RenderStatsCounter::TARGETS_CREATED);
+
+	return RPtr<TargetHandle>(this, target->handle());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Destroy
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SoftDevice::destroy(ResourceHandle rsc)
+{
+	if (SoftResource* r = SoftResource::upcast(rsc))
+	{
+		//Empty resources have no contents and aren't counted as buffers or images
+		if (r->isImage)
+			m_renderStats.add(RenderStatsCounter::IMAGES_DESTROYED);
+		else if (!r->data.empty())
+			m_renderStats.add(RenderStatsCounter::BUFFERS_DESTROYED);
+
+		countMemory(r, false);
+		delete r;
+	}
+}
+
+//Destroy an object and count it's destruction
+template<typename object_t, typename handle_t>
+static void destroyObject(RenderStatsCollector& stats, RenderStatsCounter counter, handle_t h)
+{
+	if (object_t* o = object_t::upcast(h))
+	{
+		stats.add(counter);
+		delete o;
+	}
+}
+
+void SoftDevice::destroy(ResourceSetHandle set)
+{
+	destroyObject<SoftResourceSet>(m_renderStats, RenderStatsCounter::RESOURCE_SETS_DESTROYED, set);
+}
+
+void SoftDevice::destroy(ShaderHandle shader)
+{
+	destroyObject<SoftShader>(m_renderStats, RenderStatsCounter::SHADERS_DESTROYED, shader);
+}
+
+void SoftDevice::destroy(PipelineHandle pipeline)
+{
+	destroyObject<SoftPipeline>(m_renderStats, RenderStatsCounter::PIPELINES_DESTROYED, pipeline);
+}
+
+void SoftDevice::destroy(TargetHandle target)
+{
+	destroyObject<SoftTarget>(m_renderStats, RenderStatsCounter::TARGETS_DESTROYED, target);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C"
+{
+	RenderDevice* createSoftDevice(const RenderDeviceConfig& config)
+	{
+		return new SoftDevice(config);
+	}
+
+	void destroySoftDevice(RenderDevice* device)
+	{
+		if (auto d = dynamic_cast<SoftDevice*>(device))
+		{
+			delete d;
+		}
+	}
+
+	bool setSoftPipelineProgram(RenderDevice* device, PipelineHandle pipeline, const SoftProgram* program)
+	{
+		SoftPipeline* p = SoftPipeline::upcast(pipeline);
+
+		if (dynamic_cast<SoftDevice*>(device) == nullptr || p == nullptr || program == nullptr)
+			return false;
+
+		p->program = *program;
+		return true;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
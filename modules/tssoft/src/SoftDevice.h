@@ -0,0 +1,463 @@
+/*
+	Render API
+
+	Software implementation of Render Driver
+*/
+
+#pragma once
+
+#include <tssoft.h>
+#include <tsgraphics/DriverStats.h>
+#include <tscore/debug/log.h>
+#include <tscore/system/thread.h>
+
+#include <memory>
+#include <vector>
+
+namespace ts
+{
+	class SoftDevice;
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Device objects
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Base of device objects, a handle is the address of it's object.
+		The id is checked when a handle is upcast so handles of the wrong type are rejected.
+	*/
+	template<typename object_t, typename handle_t, uint32 id>
+	struct SoftObject
+	{
+		uint32 m_id = id;
+
+		~SoftObject() { m_id = 0; }
+
+		handle_t handle() { return (handle_t)reinterpret_cast<uintptr>(this); }
+
+		static object_t* upcast(handle_t h)
+		{
+			if (auto o = reinterpret_cast<SoftObject*>(h))
+			{
+				if (o->m_id == id)
+					return static_cast<object_t*>(o);
+			}
+
+			return nullptr;
+		}
+	};
+
+	//Image memory of one mip level of one array element
+	struct SoftSubresource
+	{
+		uint32 width = 0;
+		uint32 height = 0;
+		uint32 depth = 0;
+		uint32 rowPitch = 0;
+		std::vector<uint8> data;
+
+		SoftTexture view(ImageFormat format) const
+		{
+			SoftTexture t;
+			t.data = data.data();
+			t.width = width;
+			t.height = height;
+			t.rowPitch = rowPitch;
+			t.format = format;
+			return t;
+		}
+
+		SoftStorageImage storage(ImageFormat format)
+		{
+			SoftStorageImage s;
+			s.data = data.data();
+			s.width = width;
+			s.height = height;
+			s.rowPitch = rowPitch;
+			s.format = format;
+			return s;
+		}
+	};
+
+	struct SoftResource : public SoftObject<SoftResource, ResourceHandle, 0x52534300>
+	{
+		bool isImage = false;
+		BufferResourceInfo buffer;
+		ImageResourceInfo image;
+
+		//Buffer contents
+		std::vector<uint8> data;
+
+		//Image contents, subresource index = mip + (element * mipCount)
+		std::vector<SoftSubresource> subresources;
+		uint32 mipCount = 1;
+
+		SoftSubresource* getSubresource(uint32 element, uint32 mip = 0)
+		{
+			const uint32 i = mip + element * mipCount;
+			return (i < subresources.size()) ? &subresources[i] : nullptr;
+		}
+	};
+
+	struct SoftResourceSet : public SoftObject<SoftResourceSet, ResourceSetHandle, 0x52534500>
+	{
+		std::vector<ImageView> resources;
+		std::vector<ResourceHandle> constantBuffers;
+		std::vector<VertexBufferView> vertexBuffers;
+		ResourceHandle indexBuffer = ResourceHandle();
+		//Constant buffer slots read at the offset of each draw
+		uint32 dynamicConstants = 0;
+		std::vector<ResourceHandle> storageBuffers;
+		std::vector<ImageView> storageImages;
+	};
+
+	struct SoftShader : public SoftObject<SoftShader, ShaderHandle, 0x53484400>
+	{
+		SoftProgram program;
+	};
+
+	struct SoftPipeline : public SoftObject<SoftPipeline, PipelineHandle, 0x50495000>
+	{
+		SoftProgram program;
+
+		RasterizerState raster;
+		DepthState depth;
+		BlendState blend;
+		VertexTopology topology = VertexTopology::TRIANGLELIST;
+
+		SamplerState samplers[SOFT_MAX_SAMPLERS] = {};
+
+		//Vertex buffer slots which are indexed by instance
+		bool instanced[SOFT_MAX_VERTEX_BUFFERS] = {};
+	};
+
+	struct SoftTarget : public SoftObject<SoftTarget, TargetHandle, 0x54475400>
+	{
+		std::vector<ImageView> attachments;
+		ImageView depth;
+		Viewport viewport;
+		Viewport scissor;
+	};
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Formats
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	//Bytes per pixel of a format, depth formats are stored as 32bit floats
+	uint32 getSoftPixelSize(ImageFormat format);
+
+	//Convert a pixel to/from normalized floating point
+	void loadSoftPixel(ImageFormat format, const uint8* pixel, float colour[4]);
+	void storeSoftPixel(ImageFormat format, uint8* pixel, const float colour[4]);
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Rasteriser
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	/*
+		Surfaces a draw renders to
+	*/
+	struct SoftSurface
+	{
+		enum { MAX_ATTACHMENTS = 8 };
+
+		SoftSubresource* colour[MAX_ATTACHMENTS] = {};
+		ImageFormat colourFormat[MAX_ATTACHMENTS] = {};
+		uint32 colourCount = 0;
+
+		//Depth values are floats
+		SoftSubresource* depth = nullptr;
+
+		//Viewport transform
+		float vpX = 0.0f;
+		float vpY = 0.0f;
+		float vpW = 0.0f;
+		float vpH = 0.0f;
+
+		//Pixels which can be written [x0, x1) x [y0, y1)
+		int32 x0 = 0;
+		int32 y0 = 0;
+		int32 x1 = 0;
+		int32 y1 = 0;
+	};
+
+	/*
+		Triangle setup for rasterisation
+	*/
+	struct SoftTriangle
+	{
+		//Edge functions a*x + b*y + c, positive inside the triangle
+		float a[3];
+		float b[3];
+		float c[3];
+		bool topLeft[3];
+
+		//Plane equations of interpolants: dx*x + dy*y + c
+		float z[3];
+		float invW[3];
+		float varyings[SOFT_MAX_VARYINGS][3];
+
+		//Pixel bounds, inclusive
+		int32 minX;
+		int32 minY;
+		int32 maxX;
+		int32 maxY;
+	};
+
+	/*
+		Tile based rasteriser:
+
+		Triangles are binned into fixed size screen tiles in submission order,
+		then each tile is rasterised on it's own thread so blending order is preserved without locking.
+	*/
+	class SoftRasteriser
+	{
+	public:
+
+		enum { TILE_SIZE = 64 };
+
+		SoftRasteriser(ThreadPool& pool) : m_pool(pool) {}
+
+		/*
+			Shade vertices, assemble, clip and setup triangles, then bin and rasterise them.
+			Indices refer to the vertex inputs, if there are no indices the inputs are drawn in order.
+		*/
+		void draw(
+			const SoftSurface& surface,
+			const SoftPipeline& pipeline,
+			const SoftShaderResources& resources,
+			const SoftVertexInput* inputs,
+			uint32 inputCount,
+			const uint32* indices,
+			uint32 indexCount
+		);
+
+	private:
+
+		ThreadPool& m_pool;
+		uint32 m_tilesX = 0;
+
+		std::vector<SoftVertexOutput> m_vertices;
+		std::vector<SoftTriangle> m_triangles;
+		std::vector<std::vector<uint32>> m_bins;
+		std::vector<uint32> m_activeBins;
+
+		void setupTriangle(const SoftSurface& surface, const SoftPipeline& pipeline, const SoftVertexOutput* const v[3]);
+		void clipTriangle(const SoftSurface& surface, const SoftPipeline& pipeline, const SoftVertexOutput& v0, const SoftVertexOutput& v1, const SoftVertexOutput& v2);
+		void rasteriseTile(const SoftSurface& surface, const SoftPipeline& pipeline, const SoftShaderResources& resources, uint32 tile);
+	};
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Context
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	class SoftContext : public RenderContext
+	{
+	private:
+
+		SoftDevice* m_device;
+		ThreadPool& m_pool;
+		SoftRasteriser m_rasteriser;
+
+		SoftTarget* m_target = nullptr;
+		SoftPipeline* m_pipeline = nullptr;
+		SoftResourceSet* m_inputs = nullptr;
+
+		std::vector<SoftVertexInput> m_vertexInputs;
+		std::vector<uint32> m_indices;
+
+		bool getSurface(SoftSurface& surface) const;
+		void getResources(SoftShaderResources& resources, const SoftPipeline& pipeline, const SoftResourceSet& set, uint32 constantOffset) const;
+
+		//Draw with the bound state, per-instance vertex elements begin at startInstance
+		void drawInstances(const DrawParams& params, uint32 startInstance);
+
+		//Run every thread of a dispatch
+		void dispatchGroups(const SoftPipeline* pipeline, const SoftResourceSet* set, const DispatchParams& params);
+
+	public:
+
+		SoftContext(SoftDevice* device, ThreadPool& pool) : m_device(device), m_pool(pool), m_rasteriser(pool) {}
+
+		void resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index) override;
+		void resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size) override;
+		void resourceCopy(ResourceHandle src, ResourceHandle dest) override;
+		void imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index) override;
+
+		void clearColourTarget(TargetHandle pass, uint32 colour) override;
+		void clearDepthTarget(TargetHandle pass, float depth) override;
+
+		void draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params) override;
+
+		void bindTarget(TargetHandle outputs) override;
+		void bindPipeline(PipelineHandle pipeline) override;
+		void bindResourceSet(ResourceSetHandle inputs) override;
+		void drawBound(const DrawParams& params) override;
+		void multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed) override;
+
+		void dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params) override;
+		void dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset) override;
+
+		void finish() override;
+	};
+
+	/*
+		Worker context
+
+		Records commands on a worker thread without touching device objects, the commands are
+		executed on the device's context in the order the workers are submitted.
+		Contents of resource updates are copied as they are recorded.
+	*/
+	class SoftWorkerContext : public RenderContext
+	{
+	private:
+
+		enum class CommandType : uint8
+		{
+			UPDATE,
+			UPDATE_RANGE,
+			COPY,
+			RESOLVE,
+			CLEAR_COLOUR,
+			CLEAR_DEPTH,
+			BIND_TARGET,
+			BIND_PIPELINE,
+			BIND_RESOURCE_SET,
+			DRAW,
+			DRAW_INDIRECT,
+			DISPATCH,
+			DISPATCH_INDIRECT
+		};
+
+		struct Command
+		{
+			CommandType type;
+
+			ResourceHandle src = ResourceHandle();
+			ResourceHandle dest = ResourceHandle();
+			TargetHandle target = TargetHandle();
+			PipelineHandle pipeline = PipelineHandle();
+			ResourceSetHandle inputs = ResourceSetHandle();
+
+			uint32 index = 0;      //Subresource index, clear colour or indirect draw count
+			uint32 offset = 0;     //Range or indirect argument offset
+			uint32 size = 0;       //Bytes of update data
+			size_t data = 0;       //Offset of update data
+			float depth = 0.0f;
+			bool indexed = false;
+			DrawParams params;
+			DispatchParams dispatch;
+
+			Command(CommandType type) : type(type) {}
+		};
+
+		std::vector<Command> m_commands;
+		std::vector<uint8> m_data;
+		bool m_finished = false;
+
+		Command& record(CommandType type);
+		size_t store(const void* memory, size_t size);
+
+	public:
+
+		void resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index) override;
+		void resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size) override;
+		void resourceCopy(ResourceHandle src, ResourceHandle dest) override;
+		void imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index) override;
+
+		void clearColourTarget(TargetHandle pass, uint32 colour) override;
+		void clearDepthTarget(TargetHandle pass, float depth) override;
+
+		void draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params) override;
+
+		void bindTarget(TargetHandle outputs) override;
+		void bindPipeline(PipelineHandle pipeline) override;
+		void bindResourceSet(ResourceSetHandle inputs) override;
+		void drawBound(const DrawParams& params) override;
+		void multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed) override;
+
+		void dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params) override;
+		void dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset) override;
+
+		void finish() override;
+
+		bool isFinished() const { return m_finished; }
+
+		//Execute the recorded commands on a context and clear them
+		void execute(RenderContext* context);
+		void reset();
+	};
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//	Device
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+
+	class SoftDevice final : public RenderDevice
+	{
+	public:
+
+		SoftDevice(const RenderDeviceConfig& cfg);
+		~SoftDevice();
+
+		SoftDevice(const SoftDevice&) = delete;
+
+		RenderContext* context() override { return &m_context; }
+		void commit() override;
+
+		//Parallel recording
+		uint32 acquireContexts(RenderContext** contexts, uint32 count) override;
+		void submitContexts(RenderContext* const* contexts, uint32 count) override;
+
+		//Display methods
+		void setDisplayConfiguration(const DisplayConfig& displayCfg) override;
+		void getDisplayConfiguration(DisplayConfig& displayCfg) override;
+		ResourceHandle getDisplayTarget() override { return m_displayTarget; }
+
+		//Query device
+		void queryStats(RenderStats& stats) override;
+		void queryInfo(RenderDeviceInfo& info) override;
+
+		//Resources
+		RPtr<ResourceHandle> createEmptyResource(ResourceHandle recycle) override;
+		RPtr<ResourceHandle> createResourceBuffer(const ResourceData& data, const BufferResourceInfo& info, ResourceHandle recycle) override;
+		RPtr<ResourceHandle> createResourceImage(const ResourceData* data, const ImageResourceInfo& info, ResourceHandle recycle) override;
+		//Resource set
+		RPtr<ResourceSetHandle> createResourceSet(const ResourceSetCreateInfo& info, ResourceSetHandle recycle) override;
+		//Pipeline state
+		RPtr<ShaderHandle> createShader(const ShaderCreateInfo& info) override;
+		RPtr<PipelineHandle> createPipeline(ShaderHandle program, const PipelineCreateInfo& info) override;
+		//Output target
+		RPtr<TargetHandle> createTarget(const TargetCreateInfo& info, TargetHandle recycle) override;
+
+		//Destroy device objects
+		void destroy(ResourceHandle rsc) override;
+		void destroy(ResourceSetHandle set) override;
+		void destroy(ShaderHandle shader) override;
+		void destroy(PipelineHandle state) override;
+		void destroy(TargetHandle pass) override;
+
+		//Internal methods
+		RenderStatsCollector& getRenderStats() { return m_renderStats; }
+
+	private:
+
+		ThreadPool m_pool;
+		SoftContext m_context;
+
+		//Worker contexts, the first m_acquiredContexts are in use this frame
+		std::vector<std::unique_ptr<SoftWorkerContext>> m_workerContexts;
+		uint32 m_acquiredContexts = 0;
+
+		DisplayConfig m_display;
+		ResourceHandle m_displayTarget = ResourceHandle();
+
+		RenderStatsCollector m_renderStats;
+
+		//Add or remove the memory of a resource from the memory counters
+		void countMemory(const SoftResource* rsc, bool live);
+		//Get the object of a resource to create, the memory of a recycled resource is removed
+		SoftResource* recycleResource(ResourceHandle recycle);
+
+		void updateDisplayTarget();
+	};
+}
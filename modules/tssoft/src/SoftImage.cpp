@@ -0,0 +1,395 @@
+/*
+	Render API
+
+	Software image formats, sampling and readback
+*/
+
+#include "SoftDevice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+using namespace ts;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Formats
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32 ts::getSoftPixelSize(ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::BYTE: return 1;
+	case ImageFormat::RGB: return 4; //Padded to 4 bytes
+	case ImageFormat::RGBA: return 4;
+	case ImageFormat::ARGB: return 4;
+	case ImageFormat::FLOAT1: return 4;
+	case ImageFormat::FLOAT2: return 8;
+	case ImageFormat::FLOAT3: return 16; //Padded to 4 floats
+	case ImageFormat::FLOAT4: return 16;
+	case ImageFormat::DEPTH16: return 4;
+	case ImageFormat::DEPTH32: return 4;
+	default: return 0;
+	}
+}
+
+static uint8 toUnorm8(float f)
+{
+	f = (f < 0.0f) ? 0.0f : ((f > 1.0f) ? 1.0f : f);
+	return (uint8)(f * 255.0f + 0.5f);
+}
+
+void ts::loadSoftPixel(ImageFormat format, const uint8* pixel, float colour[4])
+{
+	const float* f = reinterpret_cast<const float*>(pixel);
+
+	switch (format)
+	{
+	case ImageFormat::BYTE:
+		colour[0] = pixel[0] / 255.0f;
+		colour[1] = colour[2] = 0.0f;
+		colour[3] = 1.0f;
+		break;
+	case ImageFormat::RGB:
+	case ImageFormat::RGBA:
+		colour[0] = pixel[0] / 255.0f;
+		colour[1] = pixel[1] / 255.0f;
+		colour[2] = pixel[2] / 255.0f;
+		colour[3] = (format == ImageFormat::RGB) ? 1.0f : pixel[3] / 255.0f;
+		break;
+	case ImageFormat::ARGB: //BGRA in memory
+		colour[0] = pixel[2] / 255.0f;
+		colour[1] = pixel[1] / 255.0f;
+		colour[2] = pixel[0] / 255.0f;
+		colour[3] = pixel[3] / 255.0f;
+		break;
+	case ImageFormat::FLOAT1:
+	case ImageFormat::DEPTH16:
+	case ImageFormat::DEPTH32:
+		colour[0] = f[0];
+		colour[1] = colour[2] = 0.0f;
+		colour[3] = 1.0f;
+		break;
+	case ImageFormat::FLOAT2:
+		colour[0] = f[0];
+		colour[1] = f[1];
+		colour[2] = 0.0f;
+		colour[3] = 1.0f;
+		break;
+	case ImageFormat::FLOAT3:
+	case ImageFormat::FLOAT4:
+		colour[0] = f[0];
+		colour[1] = f[1];
+		colour[2] = f[2];
+		colour[3] = (format == ImageFormat::FLOAT3) ? 1.0f : f[3];
+		break;
+	default:
+		colour[0] = colour[1] = colour[2] = colour[3] = 0.0f;
+	}
+}
+
+void ts::storeSoftPixel(ImageFormat format, uint8* pixel, const float colour[4])
+{
+	float* f = reinterpret_cast<float*>(pixel);
+
+	switch (format)
+	{
+	case ImageFormat::BYTE:
+		pixel[0] = toUnorm8(colour[0]);
+		break;
+	case ImageFormat::RGB:
+	case ImageFormat::RGBA:
+		pixel[0] = toUnorm8(colour[0]);
+		pixel[1] = toUnorm8(colour[1]);
+		pixel[2] = toUnorm8(colour[2]);
+		pixel[3] = toUnorm8(colour[3]);
+		break;
+	case ImageFormat::ARGB:
+		pixel[0] = toUnorm8(colour[2]);
+		pixel[1] = toUnorm8(colour[1]);
+		pixel[2] = toUnorm8(colour[0]);
+		pixel[3] = toUnorm8(colour[3]);
+		break;
+	case ImageFormat::FLOAT1:
+	case ImageFormat::DEPTH16:
+	case ImageFormat::DEPTH32:
+		f[0] = colour[0];
+		break;
+	case ImageFormat::FLOAT2:
+		f[0] = colour[0];
+		f[1] = colour[1];
+		break;
+	case ImageFormat::FLOAT3:
+	case ImageFormat::FLOAT4:
+		f[0] = colour[0];
+		f[1] = colour[1];
+		f[2] = colour[2];
+		f[3] = colour[3];
+		break;
+	default:
+		break;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Sampling
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Map a texel coordinate into the image, returns false if the border colour is sampled
+static bool addressTexel(ImageAddressMode mode, int32& i, int32 size)
+{
+	switch (mode)
+	{
+	case ImageAddressMode::WRAP:
+		i %= size;
+		i += (i < 0) ? size : 0;
+		return true;
+	case ImageAddressMode::MIRROR:
+	{
+		const int32 period = 2 * size;
+		int32 m = i % period;
+		m += (m < 0) ? period : 0;
+		i = (m < size) ? m : (period - 1 - m);
+		return true;
+	}
+	case ImageAddressMode::BORDER:
+		return (i >= 0 && i < size);
+	default:
+		i = (i < 0) ? 0 : ((i >= size) ? size - 1 : i);
+		return true;
+	}
+}
+
+static void loadTexel(const SoftTexture& texture, const SamplerState& sampler, int32 x, int32 y, float colour[4])
+{
+	if (!addressTexel(sampler.addressU, x, (int32)texture.width) || !addressTexel(sampler.addressV, y, (int32)texture.height))
+	{
+		RGBA border = sampler.borderColour;
+		colour[0] = border.R() / 255.0f;
+		colour[1] = border.G() / 255.0f;
+		colour[2] = border.B() / 255.0f;
+		colour[3] = border.A() / 255.0f;
+		return;
+	}
+
+	const uint8* pixel = texture.data + (size_t)y * texture.rowPitch + (size_t)x * getSoftPixelSize(texture.format);
+	loadSoftPixel(texture.format, pixel, colour);
+}
+
+void ts::sampleSoftTexture(const SoftTexture& texture, const SamplerState& sampler, float u, float v, float colour[4])
+{
+	if (texture.data == nullptr)
+	{
+		colour[0] = colour[1] = colour[2] = colour[3] = 0.0f;
+		return;
+	}
+
+	const float x = u * texture.width - 0.5f;
+	const float y = v * texture.height - 0.5f;
+
+	if (sampler.filtering == ImageFilterMode::POINT)
+	{
+		loadTexel(texture, sampler, (int32)floor(x + 0.5f), (int32)floor(y + 0.5f), colour);
+		return;
+	}
+
+	//Bilinear filtering of the top mip
+	const float fx = floor(x);
+	const float fy = floor(y);
+	const float tx = x - fx;
+	const float ty = y - fy;
+	const int32 ix = (int32)fx;
+	const int32 iy = (int32)fy;
+
+	float t00[4], t10[4], t01[4], t11[4];
+	loadTexel(texture, sampler, ix, iy, t00);
+	loadTexel(texture, sampler, ix + 1, iy, t10);
+	loadTexel(texture, sampler, ix, iy + 1, t01);
+	loadTexel(texture, sampler, ix + 1, iy + 1, t11);
+
+	for (int i = 0; i < 4; i++)
+	{
+		const float top = t00[i] + (t10[i] - t00[i]) * tx;
+		const float bottom = t01[i] + (t11[i] - t01[i]) * tx;
+		colour[i] = top + (bottom - top) * ty;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Readback
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static SoftSubresource* findImage(RenderDevice* device, ResourceHandle image, uint32 index, ImageFormat& format)
+{
+	SoftResource* rsc = SoftResource::upcast(image);
+
+	if (dynamic_cast<SoftDevice*>(device) == nullptr || rsc == nullptr || !rsc->isImage || index >= rsc->subresources.size())
+		return nullptr;
+
+	format = rsc->image.format;
+	return &rsc->subresources[index];
+}
+
+static void readPixels(const SoftSubresource& sub, ImageFormat format, uint8* dest)
+{
+	const uint32 pixelSize = getSoftPixelSize(format);
+
+	for (uint32 y = 0; y < sub.height; y++)
+	{
+		for (uint32 x = 0; x < sub.width; x++)
+		{
+			float colour[4];
+			loadSoftPixel(format, &sub.data[(size_t)y * sub.rowPitch + (size_t)x * pixelSize], colour);
+
+			for (int i = 0; i < 4; i++)
+				*dest++ = toUnorm8(colour[i]);
+		}
+	}
+}
+
+/*
+	PNG encoding:
+
+	Pixels are written uncompressed as stored deflate blocks, which keeps the encoder small.
+	Golden images are compared in memory so the file size doesn't matter.
+*/
+struct CrcTable
+{
+	uint32 entries[256];
+
+	CrcTable()
+	{
+		for (uint32 n = 0; n < 256; n++)
+		{
+			uint32 c = n;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+			entries[n] = c;
+		}
+	}
+};
+
+static uint32 crc32(const uint8* data, size_t size, uint32 crc = 0)
+{
+	static const CrcTable crcTable;
+	const uint32* table = crcTable.entries;
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void writeBE32(vector<uint8>& out, uint32 v)
+{
+	out.push_back((uint8)(v >> 24));
+	out.push_back((uint8)(v >> 16));
+	out.push_back((uint8)(v >> 8));
+	out.push_back((uint8)v);
+}
+
+static void writeChunk(ofstream& file, const char* type, const vector<uint8>& data)
+{
+	vector<uint8> chunk;
+	writeBE32(chunk, (uint32)data.size());
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	writeBE32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+
+	file.write((const char*)chunk.data(), chunk.size());
+}
+
+static bool writePNG(const char* path, uint32 width, uint32 height, const uint8* rgba)
+{
+	ofstream file(path, ios::binary);
+
+	if (!file)
+		return false;
+
+	const uint8 signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write((const char*)signature, sizeof(signature));
+
+	vector<uint8> header;
+	writeBE32(header, width);
+	writeBE32(header, height);
+	header.push_back(8); //bit depth
+	header.push_back(6); //RGBA
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	writeChunk(file, "IHDR", header);
+
+	//Each row is prefixed with a filter type of none
+	vector<uint8> raw;
+	raw.reserve((size_t)(width * 4 + 1) * height);
+
+	for (uint32 y = 0; y < height; y++)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), rgba + (size_t)y * width * 4, rgba + (size_t)(y + 1) * width * 4);
+	}
+
+	//zlib stream of stored blocks
+	vector<uint8> z = { 0x78, 0x01 };
+	uint32 a = 1, b = 0;
+
+	for (size_t i = 0; i < raw.size(); i += 0xFFFF)
+	{
+		const uint16 len = (uint16)min<size_t>(raw.size() - i, 0xFFFF);
+		z.push_back((i + len == raw.size()) ? 1 : 0);
+		z.push_back((uint8)len);
+		z.push_back((uint8)(len >> 8));
+		z.push_back((uint8)~len);
+		z.push_back((uint8)(~len >> 8));
+		z.insert(z.end(), raw.begin() + i, raw.begin() + i + len);
+	}
+
+	for (uint8 c : raw)
+	{
+		a = (a + c) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	writeBE32(z, (b << 16) | a);
+	writeChunk(file, "IDAT", z);
+	writeChunk(file, "IEND", vector<uint8>());
+
+	return file.good();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C"
+{
+	bool readSoftImage(RenderDevice* device, ResourceHandle image, uint32 index, void* dest)
+	{
+		ImageFormat format;
+
+		if (SoftSubresource* sub = findImage(device, image, index, format))
+		{
+			readPixels(*sub, format, (uint8*)dest);
+			return true;
+		}
+
+		return false;
+	}
+
+	bool writeSoftImagePNG(RenderDevice* device, ResourceHandle image, uint32 index, const char* path)
+	{
+		ImageFormat format;
+
+		if (SoftSubresource* sub = findImage(device, image, index, format))
+		{
+			vector<uint8> pixels((size_t)sub->width * sub->height * 4);
+			readPixels(*sub, format, pixels.data());
+			return writePNG(path, sub->width, sub->height, pixels.data());
+		}
+
+		return false;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
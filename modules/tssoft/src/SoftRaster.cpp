@@ -0,0 +1,440 @@
+/*
+	Render API
+
+	Software tile based rasteriser
+*/
+
+#include "SoftDevice.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace ts;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Pixels processed together by the inner loop, written as fixed size loops so they are vectorised
+enum { LANES = 8 };
+
+//Vertices shaded per task
+enum { VERTEX_CHUNK = 1024 };
+
+//Minimum w of a vertex after clipping, avoids dividing by zero
+static const float W_EPSILON = 1e-5f;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Draw
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SoftRasteriser::draw(
+	const SoftSurface& surface,
+	const SoftPipeline& pipeline,
+	const SoftShaderResources& resources,
+	const SoftVertexInput* inputs,
+	uint32 inputCount,
+	const uint32* indices,
+	uint32 indexCount
+)
+{
+	const SoftProgram& program = pipeline.program;
+
+	if (!program.vertex || !program.pixel || surface.x1 <= surface.x0 || surface.y1 <= surface.y0)
+		return;
+
+	/*
+		Shade vertices
+	*/
+	m_vertices.resize(inputCount);
+
+	parallel_for(m_pool, (inputCount + VERTEX_CHUNK - 1) / VERTEX_CHUNK, [&](size_t chunk) {
+		const uint32 end = min<uint32>((uint32)(chunk + 1) * VERTEX_CHUNK, inputCount);
+
+		for (uint32 i = (uint32)chunk * VERTEX_CHUNK; i < end; i++)
+		{
+			program.vertex(inputs[i], resources, m_vertices[i]);
+		}
+	});
+
+	/*
+		Assemble, clip and setup triangles
+	*/
+	m_triangles.clear();
+
+	auto vertex = [&](uint32 i) -> const SoftVertexOutput& {
+		return m_vertices[(indices != nullptr) ? indices[i] : i];
+	};
+
+	switch (pipeline.topology)
+	{
+	case VertexTopology::TRIANGLELIST:
+		for (uint32 i = 0; i + 2 < indexCount; i += 3)
+		{
+			clipTriangle(surface, pipeline, vertex(i), vertex(i + 1), vertex(i + 2));
+		}
+		break;
+
+	case VertexTopology::TRIANGLESTRIP:
+		for (uint32 i = 0; i + 2 < indexCount; i++)
+		{
+			//Every other triangle has it's winding reversed
+			if (i % 2 == 0)
+				clipTriangle(surface, pipeline, vertex(i), vertex(i + 1), vertex(i + 2));
+			else
+				clipTriangle(surface, pipeline, vertex(i + 1), vertex(i), vertex(i + 2));
+		}
+		break;
+
+	default:
+		tswarn("software device: topology % is not supported", (uint32)pipeline.topology);
+		return;
+	}
+
+	if (m_triangles.empty())
+		return;
+
+	/*
+		Bin triangles in submission order
+	*/
+	m_tilesX = ((uint32)surface.x1 + TILE_SIZE - 1) / TILE_SIZE;
+	const uint32 tilesY = ((uint32)surface.y1 + TILE_SIZE - 1) / TILE_SIZE;
+
+	m_bins.resize(m_tilesX * tilesY);
+	for (auto& bin : m_bins)
+		bin.clear();
+
+	for (uint32 t = 0; t < (uint32)m_triangles.size(); t++)
+	{
+		const SoftTriangle& tri = m_triangles[t];
+
+		for (int32 ty = tri.minY / TILE_SIZE; ty <= tri.maxY / TILE_SIZE; ty++)
+		{
+			for (int32 tx = tri.minX / TILE_SIZE; tx <= tri.maxX / TILE_SIZE; tx++)
+			{
+				m_bins[ty * m_tilesX + tx].push_back(t);
+			}
+		}
+	}
+
+	m_activeBins.clear();
+
+	for (uint32 i = 0; i < (uint32)m_bins.size(); i++)
+	{
+		if (!m_bins[i].empty())
+			m_activeBins.push_back(i);
+	}
+
+	/*
+		Rasterise tiles in parallel, tiles don't overlap so no synchronization is needed
+	*/
+	parallel_for(m_pool, m_activeBins.size(), [&](size_t i) {
+		rasteriseTile(surface, pipeline, resources, m_activeBins[i]);
+	});
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Clipping
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void lerpVertex(const SoftVertexOutput& a, const SoftVertexOutput& b, float t, uint32 varyingCount, SoftVertexOutput& out)
+{
+	for (int i = 0; i < 4; i++)
+		out.position[i] = a.position[i] + (b.position[i] - a.position[i]) * t;
+
+	for (uint32 i = 0; i < varyingCount; i++)
+		out.varyings[i] = a.varyings[i] + (b.varyings[i] - a.varyings[i]) * t;
+}
+
+/*
+	Clip a triangle against the near plane (z >= 0) and w > 0.
+	Other planes are handled by clamping rasterisation to the surface bounds and discarding pixels behind the far plane.
+*/
+void SoftRasteriser::clipTriangle(const SoftSurface& surface, const SoftPipeline& pipeline, const SoftVertexOutput& v0, const SoftVertexOutput& v1, const SoftVertexOutput& v2)
+{
+	const SoftVertexOutput* tri[3] = { &v0, &v1, &v2 };
+
+	auto inside = [](const SoftVertexOutput* v) {
+		return v->position[2] >= 0.0f && v->position[3] >= W_EPSILON;
+	};
+
+	if (inside(tri[0]) && inside(tri[1]) && inside(tri[2]))
+	{
+		setupTriangle(surface, pipeline, tri);
+		return;
+	}
+
+	//Trivially reject triangles which are outside one of the side planes
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (v0.position[axis] > v0.position[3] && v1.position[axis] > v1.position[3] && v2.position[axis] > v2.position[3])
+			return;
+		if (v0.position[axis] < -v0.position[3] && v1.position[axis] < -v1.position[3] && v2.position[axis] < -v2.position[3])
+			return;
+	}
+
+	/*
+		Clip the polygon against each plane in turn, a triangle clipped by two planes has at most 5 vertices
+	*/
+	SoftVertexOutput buffers[2][5];
+	uint32 counts[2] = { 3, 0 };
+
+	buffers[0][0] = v0;
+	buffers[0][1] = v1;
+	buffers[0][2] = v2;
+
+	const uint32 varyingCount = pipeline.program.varyingCount;
+	uint32 src = 0;
+
+	for (int plane = 0; plane < 2; plane++)
+	{
+		const uint32 dst = src ^ 1;
+		counts[dst] = 0;
+
+		auto distance = [plane](const SoftVertexOutput& v) {
+			return (plane == 0) ? v.position[2] : v.position[3] - W_EPSILON;
+		};
+
+		for (uint32 i = 0; i < counts[src]; i++)
+		{
+			const SoftVertexOutput& a = buffers[src][i];
+			const SoftVertexOutput& b = buffers[src][(i + 1) % counts[src]];
+			const float da = distance(a);
+			const float db = distance(b);
+
+			if (da >= 0.0f)
+				buffers[dst][counts[dst]++] = a;
+
+			if ((da >= 0.0f) != (db >= 0.0f))
+				lerpVertex(a, b, da / (da - db), varyingCount, buffers[dst][counts[dst]++]);
+		}
+
+		src = dst;
+	}
+
+	//Triangulate as a fan
+	for (uint32 i = 1; i + 1 < counts[src]; i++)
+	{
+		const SoftVertexOutput* fan[3] = { &buffers[src][0], &buffers[src][i], &buffers[src][i + 1] };
+		setupTriangle(surface, pipeline, fan);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Setup
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SoftRasteriser::setupTriangle(const SoftSurface& surface, const SoftPipeline& pipeline, const SoftVertexOutput* const v[3])
+{
+	float sx[3], sy[3], sz[3], iw[3];
+
+	//Project to screen space
+	for (int i = 0; i < 3; i++)
+	{
+		iw[i] = 1.0f / v[i]->position[3];
+		sx[i] = surface.vpX + (v[i]->position[0] * iw[i] + 1.0f) * 0.5f * surface.vpW;
+		sy[i] = surface.vpY + (1.0f - v[i]->position[1] * iw[i]) * 0.5f * surface.vpH;
+		sz[i] = v[i]->position[2] * iw[i];
+	}
+
+	SoftTriangle tri;
+
+	for (int i = 0; i < 3; i++)
+	{
+		const int j = (i + 1) % 3;
+		const int k = (i + 2) % 3;
+		tri.a[i] = sy[j] - sy[k];
+		tri.b[i] = sx[k] - sx[j];
+		tri.c[i] = sx[j] * sy[k] - sx[k] * sy[j];
+	}
+
+	//Twice the signed area, positive if the triangle is clockwise on screen (front facing)
+	float area = tri.a[0] * sx[0] + tri.b[0] * sy[0] + tri.c[0];
+
+	if (area == 0.0f || std::isnan(area))
+		return;
+
+	const bool front = area > 0.0f;
+
+	if ((pipeline.raster.cullMode == CullMode::BACK && !front) || (pipeline.raster.cullMode == CullMode::FRONT && front))
+		return;
+
+	//Orient the edges so the inside of the triangle is positive
+	if (!front)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			tri.a[i] = -tri.a[i];
+			tri.b[i] = -tri.b[i];
+			tri.c[i] = -tri.c[i];
+		}
+
+		area = -area;
+	}
+
+	//Pixels exactly on an edge belong to the triangle if the edge is a top or left edge
+	for (int i = 0; i < 3; i++)
+	{
+		tri.topLeft[i] = (tri.a[i] > 0.0f) || (tri.a[i] == 0.0f && tri.b[i] > 0.0f);
+	}
+
+	//Pixel bounds, clamped to the surface
+	tri.minX = max((int32)floor(min(sx[0], min(sx[1], sx[2]))), surface.x0);
+	tri.minY = max((int32)floor(min(sy[0], min(sy[1], sy[2]))), surface.y0);
+	tri.maxX = min((int32)ceil(max(sx[0], max(sx[1], sx[2]))), surface.x1 - 1);
+	tri.maxY = min((int32)ceil(max(sy[0], max(sy[1], sy[2]))), surface.y1 - 1);
+
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+		return;
+
+	//Interpolants are planes over screen space, weighted by the normalized edge functions
+	const float invArea = 1.0f / area;
+
+	auto plane = [&](const float values[3], float out[3]) {
+		out[0] = (tri.a[0] * values[0] + tri.a[1] * values[1] + tri.a[2] * values[2]) * invArea;
+		out[1] = (tri.b[0] * values[0] + tri.b[1] * values[1] + tri.b[2] * values[2]) * invArea;
+		out[2] = (tri.c[0] * values[0] + tri.c[1] * values[1] + tri.c[2] * values[2]) * invArea;
+	};
+
+	plane(sz, tri.z);
+	plane(iw, tri.invW);
+
+	//Varyings are divided by w so they can be interpolated linearly in screen space
+	for (uint32 n = 0; n < pipeline.program.varyingCount; n++)
+	{
+		const float values[3] = { v[0]->varyings[n] * iw[0], v[1]->varyings[n] * iw[1], v[2]->varyings[n] * iw[2] };
+		plane(values, tri.varyings[n]);
+	}
+
+	m_triangles.push_back(tri);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Rasterisation
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void blendPixel(float src[4], const float dst[4])
+{
+	//Matches the fixed blend state of the other backends: src alpha/inverse src alpha for colour
+	const float a = src[3];
+
+	for (int i = 0; i < 3; i++)
+		src[i] = src[i] * a + dst[i] * (1.0f - a);
+
+	src[3] = a * (1.0f - dst[3]) + dst[3];
+}
+
+void SoftRasteriser::rasteriseTile(const SoftSurface& surface, const SoftPipeline& pipeline, const SoftShaderResources& resources, uint32 tile)
+{
+	const SoftProgram& program = pipeline.program;
+	const uint32 varyingCount = program.varyingCount;
+	const bool depthTest = pipeline.depth.enableDepth && surface.depth != nullptr;
+
+	const int32 tileX = (int32)(tile % m_tilesX) * TILE_SIZE;
+	const int32 tileY = (int32)(tile / m_tilesX) * TILE_SIZE;
+
+	uint32 pixelSizes[SoftSurface::MAX_ATTACHMENTS];
+	for (uint32 i = 0; i < surface.colourCount; i++)
+		pixelSizes[i] = getSoftPixelSize(surface.colourFormat[i]);
+
+	for (uint32 t : m_bins[tile])
+	{
+		const SoftTriangle& tri = m_triangles[t];
+
+		const int32 x0 = max(tri.minX, tileX);
+		const int32 y0 = max(tri.minY, tileY);
+		const int32 x1 = min(tri.maxX, tileX + TILE_SIZE - 1);
+		const int32 y1 = min(tri.maxY, tileY + TILE_SIZE - 1);
+
+		for (int32 y = y0; y <= y1; y++)
+		{
+			const float py = (float)y + 0.5f;
+			float* depthRow = depthTest ? reinterpret_cast<float*>(&surface.depth->data[(size_t)y * surface.depth->rowPitch]) : nullptr;
+
+			for (int32 xb = x0; xb <= x1; xb += LANES)
+			{
+				/*
+					Evaluate edge functions and depth for a block of pixels
+				*/
+				float e0[LANES], e1[LANES], e2[LANES], z[LANES];
+
+				const float pxb = (float)xb + 0.5f;
+				const float base0 = tri.a[0] * pxb + tri.b[0] * py + tri.c[0];
+				const float base1 = tri.a[1] * pxb + tri.b[1] * py + tri.c[1];
+				const float base2 = tri.a[2] * pxb + tri.b[2] * py + tri.c[2];
+				const float baseZ = tri.z[0] * pxb + tri.z[1] * py + tri.z[2];
+
+				for (int k = 0; k < LANES; k++)
+				{
+					e0[k] = base0 + tri.a[0] * k;
+					e1[k] = base1 + tri.a[1] * k;
+					e2[k] = base2 + tri.a[2] * k;
+					z[k] = baseZ + tri.z[0] * k;
+				}
+
+				uint32 mask = 0;
+
+				for (int k = 0; k < LANES; k++)
+				{
+					const bool in0 = (e0[k] > 0.0f) || (e0[k] == 0.0f && tri.topLeft[0]);
+					const bool in1 = (e1[k] > 0.0f) || (e1[k] == 0.0f && tri.topLeft[1]);
+					const bool in2 = (e2[k] > 0.0f) || (e2[k] == 0.0f && tri.topLeft[2]);
+					const bool depthRange = (z[k] >= 0.0f) && (z[k] <= 1.0f);
+					const bool covered = (xb + k <= x1);
+
+					mask |= (uint32)(in0 && in1 && in2 && depthRange && covered) << k;
+				}
+
+				if (mask == 0)
+					continue;
+
+				/*
+					Shade covered pixels
+				*/
+				for (int k = 0; k < LANES; k++)
+				{
+					if ((mask & (1u << k)) == 0)
+						continue;
+
+					const int32 x = xb + k;
+
+					if (depthTest && !(z[k] < depthRow[x]))
+						continue;
+
+					const float px = (float)x + 0.5f;
+					const float w = 1.0f / (tri.invW[0] * px + tri.invW[1] * py + tri.invW[2]);
+
+					float varyings[SOFT_MAX_VARYINGS];
+					for (uint32 n = 0; n < varyingCount; n++)
+						varyings[n] = (tri.varyings[n][0] * px + tri.varyings[n][1] * py + tri.varyings[n][2]) * w;
+
+					float colour[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+					if (!program.pixel(varyings, resources, colour))
+						continue;
+
+					if (depthTest)
+						depthRow[x] = z[k];
+
+					for (uint32 i = 0; i < surface.colourCount; i++)
+					{
+						SoftSubresource* rt = surface.colour[i];
+						uint8* pixel = &rt->data[(size_t)y * rt->rowPitch + (size_t)x * pixelSizes[i]];
+
+						float out[4] = { colour[0], colour[1], colour[2], colour[3] };
+
+						if (pipeline.blend.enable)
+						{
+							float dst[4];
+							loadSoftPixel(surface.colourFormat[i], pixel, dst);
+							blendPixel(out, dst);
+						}
+
+						storeSoftPixel(surface.colourFormat[i], pixel, out);
+					}
+				}
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
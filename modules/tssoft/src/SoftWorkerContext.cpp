@@ -0,0 +1,228 @@
+/*
+	Render API
+
+	Software worker context implementation
+*/
+
+#include "SoftDevice.h"
+
+#include <cstring>
+
+using namespace std;
+using namespace ts;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Recording
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SoftWorkerContext::Command& SoftWorkerContext::record(CommandType type)
+{
+	//Recording after a finish begins a new command list
+	m_finished = false;
+
+	m_commands.push_back(Command(type));
+	return m_commands.back();
+}
+
+size_t SoftWorkerContext::store(const void* memory, size_t size)
+{
+	const size_t offset = m_data.size();
+	m_data.resize(offset + size);
+	memcpy(m_data.data() + offset, memory, size);
+	return offset;
+}
+
+void SoftWorkerContext::resourceUpdate(ResourceHandle rsc, const void* memory, uint32 index)
+{
+	SoftResource* r = SoftResource::upcast(rsc);
+
+	if (r == nullptr || memory == nullptr)
+		return;
+
+	//The size of the update is known from the resource, it's contents are not accessed until execution
+	size_t size = 0;
+
+	if (!r->isImage)
+		size = r->data.size();
+	else if (index < r->subresources.size())
+		size = r->subresources[index].data.size();
+	else
+		return;
+
+	Command& cmd = record(CommandType::UPDATE);
+	cmd.dest = rsc;
+	cmd.index = index;
+	cmd.size = (uint32)size;
+	cmd.data = store(memory, size);
+}
+
+void SoftWorkerContext::resourceUpdateRange(ResourceHandle rsc, const void* memory, uint32 offset, uint32 size)
+{
+	if (memory == nullptr)
+	{
+		tswarn("software device: invalid buffer range update (offset % size %)", offset, size);
+		return;
+	}
+
+	Command& cmd = record(CommandType::UPDATE_RANGE);
+	cmd.dest = rsc;
+	cmd.offset = offset;
+	cmd.size = size;
+	cmd.data = store(memory, size);
+}
+
+void SoftWorkerContext::resourceCopy(ResourceHandle src, ResourceHandle dest)
+{
+	Command& cmd = record(CommandType::COPY);
+	cmd.src = src;
+	cmd.dest = dest;
+}
+
+void SoftWorkerContext::imageResolve(ResourceHandle src, ResourceHandle dest, uint32 index)
+{
+	Command& cmd = record(CommandType::RESOLVE);
+	cmd.src = src;
+	cmd.dest = dest;
+	cmd.index = index;
+}
+
+void SoftWorkerContext::clearColourTarget(TargetHandle pass, uint32 colour)
+{
+	Command& cmd = record(CommandType::CLEAR_COLOUR);
+	cmd.target = pass;
+	cmd.index = colour;
+}
+
+void SoftWorkerContext::clearDepthTarget(TargetHandle pass, float depth)
+{
+	Command& cmd = record(CommandType::CLEAR_DEPTH);
+	cmd.target = pass;
+	cmd.depth = depth;
+}
+
+void SoftWorkerContext::draw(TargetHandle outputs, PipelineHandle pipeline, ResourceSetHandle inputs, const DrawParams& params)
+{
+	bindTarget(outputs);
+	bindPipeline(pipeline);
+	bindResourceSet(inputs);
+	drawBound(params);
+}
+
+void SoftWorkerContext::bindTarget(TargetHandle outputs)
+{
+	record(CommandType::BIND_TARGET).target = outputs;
+}
+
+void SoftWorkerContext::bindPipeline(PipelineHandle pipeline)
+{
+	record(CommandType::BIND_PIPELINE).pipeline = pipeline;
+}
+
+void SoftWorkerContext::bindResourceSet(ResourceSetHandle inputs)
+{
+	record(CommandType::BIND_RESOURCE_SET).inputs = inputs;
+}
+
+void SoftWorkerContext::drawBound(const DrawParams& params)
+{
+	record(CommandType::DRAW).params = params;
+}
+
+void SoftWorkerContext::multiDrawIndirect(ResourceHandle args, uint32 offset, uint32 count, bool indexed)
+{
+	//Arguments are read when the commands are executed, so updates recorded before the draw are seen
+	Command& cmd = record(CommandType::DRAW_INDIRECT);
+	cmd.src = args;
+	cmd.offset = offset;
+	cmd.index = count;
+	cmd.indexed = indexed;
+}
+
+void SoftWorkerContext::dispatch(PipelineHandle pipeline, ResourceSetHandle inputs, const DispatchParams& params)
+{
+	Command& cmd = record(CommandType::DISPATCH);
+	cmd.pipeline = pipeline;
+	cmd.inputs = inputs;
+	cmd.dispatch = params;
+}
+
+void SoftWorkerContext::dispatchIndirect(PipelineHandle pipeline, ResourceSetHandle inputs, ResourceHandle args, uint32 offset)
+{
+	Command& cmd = record(CommandType::DISPATCH_INDIRECT);
+	cmd.pipeline = pipeline;
+	cmd.inputs = inputs;
+	cmd.src = args;
+	cmd.offset = offset;
+}
+
+void SoftWorkerContext::finish()
+{
+	m_finished = true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//	Execution
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SoftWorkerContext::execute(RenderContext* context)
+{
+	//Bound state doesn't carry over from commands executed before the worker's
+	context->finish();
+
+	for (const Command& cmd : m_commands)
+	{
+		switch (cmd.type)
+		{
+		case CommandType::UPDATE:
+			context->resourceUpdate(cmd.dest, m_data.data() + cmd.data, cmd.index);
+			break;
+		case CommandType::UPDATE_RANGE:
+			context->resourceUpdateRange(cmd.dest, m_data.data() + cmd.data, cmd.offset, cmd.size);
+			break;
+		case CommandType::COPY:
+			context->resourceCopy(cmd.src, cmd.dest);
+			break;
+		case CommandType::RESOLVE:
+			context->imageResolve(cmd.src, cmd.dest, cmd.index);
+			break;
+		case CommandType::CLEAR_COLOUR:
+			context->clearColourTarget(cmd.target, cmd.index);
+			break;
+		case CommandType::CLEAR_DEPTH:
+			context->clearDepthTarget(cmd.target, cmd.depth);
+			break;
+		case CommandType::BIND_TARGET:
+			context->bindTarget(cmd.target);
+			break;
+		case CommandType::BIND_PIPELINE:
+			context->bindPipeline(cmd.pipeline);
+			break;
+		case CommandType::BIND_RESOURCE_SET:
+			context->bindResourceSet(cmd.inputs);
+			break;
+		case CommandType::DRAW:
+			context->drawBound(cmd.params);
+			break;
+		case CommandType::DRAW_INDIRECT:
+			context->multiDrawIndirect(cmd.src, cmd.offset, cmd.index, cmd.indexed);
+			break;
+		case CommandType::DISPATCH:
+			context->dispatch(cmd.pipeline, cmd.inputs, cmd.dispatch);
+			break;
+		case CommandType::DISPATCH_INDIRECT:
+			context->dispatchIndirect(cmd.pipeline, cmd.inputs, cmd.src, cmd.offset);
+			break;
+		}
+	}
+
+	reset();
+}
+
+void SoftWorkerContext::reset()
+{
+	m_commands.clear();
+	m_data.clear();
+	m_finished = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
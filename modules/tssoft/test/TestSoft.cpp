@@ -0,0 +1,765 @@
+/*
+	Software device tests
+
+	-	Renders small scenes with the software rasteriser and checks the resulting pixels.
+	-	Pass a file path to write the rendered cube as a PNG: TestSoft cube.png
+*/
+
+#include <tssoft.h>
+
+#include <iostream>
+#include <memory>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace ts;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//Assertion helper
+void _assert(const char* func, const char* expr, bool eval)
+{
+	if (!eval)
+	{
+		cerr << "[" << func << "] Assertion failed: " << expr << endl;
+		exit(-1);
+	}
+}
+
+#define assert(expr) _assert(__FUNCTION__, #expr, (expr))
+
+//Software devices are destroyed directly as the module doesn't link to RenderDevice::destroy()
+struct SoftDeleter
+{
+	void operator()(RenderDevice* device) { destroySoftDevice(device); }
+};
+
+using SoftDevicePtr = unique_ptr<RenderDevice, SoftDeleter>;
+
+static SoftDevicePtr createDevice(uint32 w, uint32 h)
+{
+	RenderDeviceConfig cfg;
+	cfg.display.resolutionW = (uint16)w;
+	cfg.display.resolutionH = (uint16)h;
+	return SoftDevicePtr(createSoftDevice(cfg));
+}
+
+struct Pixels
+{
+	uint32 width;
+	uint32 height;
+	vector<uint8> rgba;
+
+	Pixels(RenderDevice* device, ResourceHandle image, uint32 w, uint32 h) :
+		width(w), height(h), rgba(w * h * 4)
+	{
+		assert(readSoftImage(device, image, 0, rgba.data()));
+	}
+
+	const uint8* at(uint32 x, uint32 y) const { return &rgba[(y * width + x) * 4]; }
+};
+
+//Row major matrix applied to row vectors
+struct Mat4
+{
+	float m[4][4];
+
+	static Mat4 identity()
+	{
+		Mat4 r = {};
+		for (int i = 0; i < 4; i++)
+			r.m[i][i] = 1.0f;
+		return r;
+	}
+
+	static Mat4 rotationY(float a)
+	{
+		Mat4 r = identity();
+		r.m[0][0] = cos(a); r.m[0][2] = -sin(a);
+		r.m[2][0] = sin(a); r.m[2][2] = cos(a);
+		return r;
+	}
+
+	static Mat4 rotationX(float a)
+	{
+		Mat4 r = identity();
+		r.m[1][1] = cos(a); r.m[1][2] = sin(a);
+		r.m[2][1] = -sin(a); r.m[2][2] = cos(a);
+		return r;
+	}
+
+	static Mat4 translation(float x, float y, float z)
+	{
+		Mat4 r = identity();
+		r.m[3][0] = x; r.m[3][1] = y; r.m[3][2] = z;
+		return r;
+	}
+
+	//Left handed perspective projection, depth in [0,1]
+	static Mat4 perspective(float fov, float aspect, float n, float f)
+	{
+		const float ys = 1.0f / tan(fov * 0.5f);
+		Mat4 r = {};
+		r.m[0][0] = ys / aspect;
+		r.m[1][1] = ys;
+		r.m[2][2] = f / (f - n);
+		r.m[2][3] = 1.0f;
+		r.m[3][2] = -n * f / (f - n);
+		return r;
+	}
+
+	Mat4 operator*(const Mat4& rhs) const
+	{
+		Mat4 r = {};
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				for (int k = 0; k < 4; k++)
+					r.m[i][j] += m[i][k] * rhs.m[k][j];
+		return r;
+	}
+
+	void transform(const float v[4], float out[4]) const
+	{
+		for (int j = 0; j < 4; j++)
+			out[j] = v[0] * m[0][j] + v[1] * m[1][j] + v[2] * m[2][j] + v[3] * m[3][j];
+	}
+};
+
+/*
+	Objects needed to draw to the display target
+*/
+struct Scene
+{
+	RenderDevice* device;
+
+	RPtr<ResourceHandle> depth;
+	RPtr<TargetHandle> target;
+	RPtr<ShaderHandle> shader;
+	RPtr<PipelineHandle> pipeline;
+
+	Scene(RenderDevice* device, const SoftProgram& program, bool enableDepth, bool enableBlend, CullMode cull) :
+		device(device)
+	{
+		DisplayConfig display;
+		device->getDisplayConfiguration(display);
+
+		ImageView colourView;
+		colourView.image = device->getDisplayTarget();
+
+		TargetCreateInfo targetInfo = {};
+		targetInfo.attachments = &colourView;
+		targetInfo.attachmentCount = 1;
+
+		if (enableDepth)
+		{
+			ImageResourceInfo depthInfo;
+			depthInfo.format = ImageFormat::DEPTH32;
+			depthInfo.usage = ImageUsage::DSV;
+			depthInfo.width = display.resolutionW;
+			depthInfo.height = display.resolutionH;
+			depth = device->createResourceImage(nullptr, depthInfo, ResourceHandle());
+			assert(depth);
+
+			targetInfo.depth.image = depth.handle();
+		}
+
+		target = device->createTarget(targetInfo, TargetHandle());
+		assert(target);
+
+		ShaderCreateInfo shaderInfo;
+		shaderInfo.stages[(size_t)ShaderStage::VERTEX].bytecode = &program;
+		shaderInfo.stages[(size_t)ShaderStage::VERTEX].size = sizeof(SoftProgram);
+		shader = device->createShader(shaderInfo);
+		assert(shader);
+
+		SamplerState sampler = {};
+		sampler.filtering = ImageFilterMode::POINT;
+		sampler.addressU = ImageAddressMode::WRAP;
+		sampler.addressV = ImageAddressMode::WRAP;
+
+		PipelineCreateInfo pipelineInfo;
+		pipelineInfo.depth.enableDepth = enableDepth;
+		pipelineInfo.blend.enable = enableBlend;
+		pipelineInfo.raster.cullMode = cull;
+		pipelineInfo.topology = VertexTopology::TRIANGLELIST;
+		pipelineInfo.samplers = &sampler;
+		pipelineInfo.samplerCount = 1;
+		pipeline = device->createPipeline(shader.handle(), pipelineInfo);
+		assert(pipeline);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tests
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Two triangles sharing an edge must cover each pixel exactly once,
+	half transparent white blended over black shows any pixel drawn twice
+*/
+void testSoftCoverage()
+{
+	const uint32 w = 37, h = 23;
+	SoftDevicePtr device = createDevice(w, h);
+
+	SoftProgram program;
+	program.varyingCount = 0;
+	program.vertex = [](const SoftVertexInput& in, const SoftShaderResources&, SoftVertexOutput& out) {
+		const float* p = reinterpret_cast<const float*>(in.buffers[0]);
+		out.position[0] = p[0];
+		out.position[1] = p[1];
+		out.position[2] = 0.5f;
+		out.position[3] = 1.0f;
+	};
+	program.pixel = [](const float*, const SoftShaderResources&, float colour[4]) {
+		colour[0] = colour[1] = colour[2] = 1.0f;
+		colour[3] = 0.5f;
+		return true;
+	};
+
+	Scene scene(device.get(), program, false, true, CullMode::NONE);
+
+	//Quad covering the whole target, the diagonal doesn't land on pixel centres
+	const float quad[] = { -1, 1, 1, 1, -1, -1, -1, -1, 1, 1, 1, -1 };
+
+	BufferResourceInfo vbInfo;
+	vbInfo.type = BufferType::VERTEX;
+	vbInfo.size = sizeof(quad);
+	ResourceData vbData;
+	vbData.memory = quad;
+	RPtr<ResourceHandle> vb = device->createResourceBuffer(vbData, vbInfo, ResourceHandle());
+
+	VertexBufferView view;
+	view.buffer = vb.handle();
+	view.stride = 2 * sizeof(float);
+
+	ResourceSetCreateInfo setInfo;
+	setInfo.vertexBuffers = &view;
+	setInfo.vertexBufferCount = 1;
+	RPtr<ResourceSetHandle> inputs = device->createResourceSet(setInfo, ResourceSetHandle());
+
+	RenderContext* context = device->context();
+	context->clearColourTarget(scene.target.handle(), 0xFF000000);
+
+	DrawParams params;
+	params.count = 6;
+	context->draw(scene.target.handle(), scene.pipeline.handle(), inputs.handle(), params);
+	context->finish();
+
+	Pixels pixels(device.get(), device->getDisplayTarget(), w, h);
+
+	for (uint32 y = 0; y < h; y++)
+	{
+		for (uint32 x = 0; x < w; x++)
+		{
+			assert(pixels.at(x, y)[0] == 128);
+		}
+	}
+
+	RenderStats stats;
+	device->queryStats(stats);
+	assert(stats.drawcalls == 1);
+	assert(stats.triangles == 2);
+	assert(stats.pipelineBinds == 1);
+	assert(stats.vertexBufferMemory == sizeof(quad));
+	assert(stats.targetMemory == w * h * 4);
+	assert(stats.contextTime > 0);
+
+	//Frame counters are reset by commit
+	device->commit();
+	device->queryStats(stats);
+	assert(stats.drawcalls == 0 && stats.contextTime == 0);
+	assert(stats.vertexBufferMemory == sizeof(quad));
+}
+
+/*
+	Textured, depth tested cube drawn from an index buffer
+*/
+void testSoftCube(const char* outputPath)
+{
+	const uint32 w = 256, h = 192;
+	SoftDevicePtr device = createDevice(w, h);
+
+	struct Vertex
+	{
+		float pos[3];
+		float uv[2];
+	};
+
+	//Each face has it's own vertices so texture coordinates aren't shared
+	vector<Vertex> vertices;
+	vector<uint32> indices;
+
+	const float faces[6][3][3] = {
+		//normal, u axis, v axis
+		{ { 0, 0, -1 }, { 1, 0, 0 }, { 0, -1, 0 } },
+		{ { 0, 0, 1 }, { -1, 0, 0 }, { 0, -1, 0 } },
+		{ { 1, 0, 0 }, { 0, 0, 1 }, { 0, -1, 0 } },
+		{ { -1, 0, 0 }, { 0, 0, -1 }, { 0, -1, 0 } },
+		{ { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+		{ { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, -1 } },
+	};
+
+	for (const auto& f : faces)
+	{
+		const uint32 base = (uint32)vertices.size();
+
+		for (int i = 0; i < 4; i++)
+		{
+			const float u = (i & 1) ? 1.0f : -1.0f;
+			const float v = (i & 2) ? 1.0f : -1.0f;
+
+			Vertex vtx;
+			for (int c = 0; c < 3; c++)
+				vtx.pos[c] = f[0][c] + f[1][c] * u + f[2][c] * v;
+			vtx.uv[0] = (u + 1.0f) * 0.5f;
+			vtx.uv[1] = (v + 1.0f) * 0.5f;
+			vertices.push_back(vtx);
+		}
+
+		//Clockwise when viewed from outside the cube
+		const uint32 quad[] = { 0, 1, 2, 2, 1, 3 };
+		for (uint32 i : quad)
+			indices.push_back(base + i);
+	}
+
+	const Mat4 world = Mat4::rotationY(0.6f) * Mat4::rotationX(0.4f);
+	const Mat4 wvp = world * Mat4::translation(0, 0, 5) * Mat4::perspective(1.0f, (float)w / h, 0.1f, 100.0f);
+
+	SoftProgram program;
+	program.varyingCount = 2;
+	program.vertex = [](const SoftVertexInput& in, const SoftShaderResources& res, SoftVertexOutput& out) {
+		const Vertex* v = reinterpret_cast<const Vertex*>(in.buffers[0]);
+		const Mat4* m = reinterpret_cast<const Mat4*>(res.constants[0]);
+		const float p[4] = { v->pos[0], v->pos[1], v->pos[2], 1.0f };
+		m->transform(p, out.position);
+		out.varyings[0] = v->uv[0];
+		out.varyings[1] = v->uv[1];
+	};
+	program.pixel = [](const float* varyings, const SoftShaderResources& res, float colour[4]) {
+		sampleSoftTexture(res.textures[0], res.samplers[0], varyings[0], varyings[1], colour);
+		return true;
+	};
+
+	Scene scene(device.get(), program, true, false, CullMode::BACK);
+
+	//2x2 checker texture
+	const uint32 texels[] = { 0xFF0000FF, 0xFF00FF00, 0xFF00FF00, 0xFF0000FF };
+	ImageResourceInfo texInfo;
+	texInfo.format = ImageFormat::RGBA;
+	texInfo.width = 2;
+	texInfo.height = 2;
+	ResourceData texData;
+	texData.memory = texels;
+	texData.memoryByteWidth = 2 * sizeof(uint32);
+	RPtr<ResourceHandle> texture = device->createResourceImage(&texData, texInfo, ResourceHandle());
+	assert(texture);
+
+	BufferResourceInfo info;
+	ResourceData data;
+
+	info.type = BufferType::VERTEX;
+	info.size = (uint32)(vertices.size() * sizeof(Vertex));
+	data.memory = vertices.data();
+	RPtr<ResourceHandle> vb = device->createResourceBuffer(data, info, ResourceHandle());
+
+	info.type = BufferType::INDEX;
+	info.size = (uint32)(indices.size() * sizeof(uint32));
+	data.memory = indices.data();
+	RPtr<ResourceHandle> ib = device->createResourceBuffer(data, info, ResourceHandle());
+
+	info.type = BufferType::CONSTANTS;
+	info.size = sizeof(Mat4);
+	data.memory = &wvp;
+	RPtr<ResourceHandle> cb = device->createResourceBuffer(data, info, ResourceHandle());
+
+	ImageView texView;
+	texView.image = texture.handle();
+	VertexBufferView vbView;
+	vbView.buffer = vb.handle();
+	vbView.stride = sizeof(Vertex);
+	ResourceHandle constants[] = { cb.handle() };
+
+	ResourceSetCreateInfo setInfo;
+	setInfo.resources = &texView;
+	setInfo.resourceCount = 1;
+	setInfo.constantBuffers = constants;
+	setInfo.constantBuffersCount = 1;
+	setInfo.vertexBuffers = &vbView;
+	setInfo.vertexBufferCount = 1;
+	setInfo.indexBuffer = ib.handle();
+	RPtr<ResourceSetHandle> inputs = device->createResourceSet(setInfo, ResourceSetHandle());
+
+	RenderContext* context = device->context();
+	context->clearColourTarget(scene.target.handle(), 0xFF402010);
+	context->clearDepthTarget(scene.target.handle(), 1.0f);
+
+	DrawParams params;
+	params.mode = DrawMode::INDEXED;
+	params.count = (uint32)indices.size();
+	context->draw(scene.target.handle(), scene.pipeline.handle(), inputs.handle(), params);
+	context->finish();
+
+	if (outputPath != nullptr)
+	{
+		assert(writeSoftImagePNG(device.get(), device->getDisplayTarget(), 0, outputPath));
+	}
+
+	Pixels pixels(device.get(), device->getDisplayTarget(), w, h);
+
+	//Corners are background
+	const uint8* corner = pixels.at(0, 0);
+	assert(corner[0] == 0x10 && corner[1] == 0x20 && corner[2] == 0x40);
+
+	//The centre is covered by the cube, which only contains texture colours
+	uint32 covered = 0;
+
+	for (uint32 y = 0; y < h; y++)
+	{
+		for (uint32 x = 0; x < w; x++)
+		{
+			const uint8* p = pixels.at(x, y);
+
+			if (p[0] == 0x10 && p[1] == 0x20 && p[2] == 0x40)
+				continue;
+
+			covered++;
+			assert(p[2] == 0 && p[0] + p[1] == 255);
+		}
+	}
+
+	const uint8* centre = pixels.at(w / 2, h / 2);
+	assert(centre[0] == 255 || centre[1] == 255);
+	assert(covered > (w * h) / 8);
+	assert(covered < (w * h) / 2);
+}
+
+/*
+	Workers record overlapping draws in parallel, each pixel shows the colour of the last worker submitted which covers it
+*/
+void testSoftParallelRecording()
+{
+	const uint32 w = 32, h = 8;
+	const uint32 workerCount = 4;
+	SoftDevicePtr device = createDevice(w, h);
+
+	SoftProgram program;
+	program.varyingCount = 0;
+	program.vertex = [](const SoftVertexInput& in, const SoftShaderResources&, SoftVertexOutput& out) {
+		const float* p = reinterpret_cast<const float*>(in.buffers[0]);
+		out.position[0] = p[0];
+		out.position[1] = p[1];
+		out.position[2] = 0.5f;
+		out.position[3] = 1.0f;
+	};
+	program.pixel = [](const float*, const SoftShaderResources& resources, float colour[4]) {
+		memcpy(colour, resources.constants[0], 4 * sizeof(float));
+		return true;
+	};
+
+	Scene scene(device.get(), program, false, false, CullMode::NONE);
+
+	//Worker i covers the bands from i to the right edge of the target
+	vector<RPtr<ResourceHandle>> vertices;
+	vector<RPtr<ResourceHandle>> constants;
+	vector<RPtr<ResourceSetHandle>> inputs;
+
+	for (uint32 i = 0; i < workerCount; i++)
+	{
+		const float x = -1.0f + 2.0f * i / workerCount;
+		const float quad[] = { x, 1, 1, 1, x, -1, x, -1, 1, 1, 1, -1 };
+
+		BufferResourceInfo vbInfo;
+		vbInfo.type = BufferType::VERTEX;
+		vbInfo.size = sizeof(quad);
+		ResourceData vbData;
+		vbData.memory = quad;
+		vertices.push_back(device->createResourceBuffer(vbData, vbInfo, ResourceHandle()));
+
+		const float zero[4] = {};
+		BufferResourceInfo cbInfo;
+		cbInfo.type = BufferType::CONSTANTS;
+		cbInfo.size = sizeof(zero);
+		ResourceData cbData;
+		cbData.memory = zero;
+		constants.push_back(device->createResourceBuffer(cbData, cbInfo, ResourceHandle()));
+
+		VertexBufferView view;
+		view.buffer = vertices.back().handle();
+		view.stride = 2 * sizeof(float);
+
+		const ResourceHandle cb = constants.back().handle();
+
+		ResourceSetCreateInfo setInfo;
+		setInfo.vertexBuffers = &view;
+		setInfo.vertexBufferCount = 1;
+		setInfo.constantBuffers = &cb;
+		setInfo.constantBuffersCount = 1;
+		inputs.push_back(device->createResourceSet(setInfo, ResourceSetHandle()));
+	}
+
+	RenderContext* workers[workerCount] = {};
+	assert(device->acquireContexts(workers, workerCount) == workerCount);
+
+	//Clears recorded on the main context execute before the workers
+	device->context()->clearColourTarget(scene.target.handle(), 0xFF000000);
+
+	vector<thread> threads;
+
+	for (uint32 i = 0; i < workerCount; i++)
+	{
+		threads.emplace_back([&, i]() {
+			//Update contents are copied when recorded
+			const float colour[4] = { (float)(i + 1) / workerCount, 0.0f, 0.0f, 1.0f };
+			workers[i]->resourceUpdate(constants[i].handle(), colour);
+
+			DrawParams params;
+			params.count = 6;
+			workers[i]->draw(scene.target.handle(), scene.pipeline.handle(), inputs[i].handle(), params);
+			workers[i]->finish();
+		});
+	}
+
+	for (thread& t : threads)
+		t.join();
+
+	const uint32 order[workerCount] = { 2, 0, 3, 1 };
+	RenderContext* submitted[workerCount] = {};
+
+	for (uint32 i = 0; i < workerCount; i++)
+		submitted[i] = workers[order[i]];
+
+	device->submitContexts(submitted, workerCount);
+	device->commit();
+
+	Pixels pixels(device.get(), device->getDisplayTarget(), w, h);
+
+	for (uint32 band = 0; band < workerCount; band++)
+	{
+		//Last worker in submission order which covers the band
+		uint32 expected = 0;
+
+		for (uint32 i = 0; i < workerCount; i++)
+		{
+			if (order[i] <= band)
+				expected = order[i];
+		}
+
+		const uint8* p = pixels.at(band * (w / workerCount) + 2, h / 2);
+		assert(abs((int)p[0] - (int)((expected + 1) * 255 / workerCount)) <= 1);
+		assert(p[1] == 0);
+	}
+}
+
+/*
+	Indirect draws read their arguments from an argument buffer, each argument draws one band of the target
+*/
+void testSoftDrawIndirect()
+{
+	const uint32 w = 32, h = 8;
+	const uint32 bands = 4;
+	SoftDevicePtr device = createDevice(w, h);
+
+	SoftProgram program;
+	program.varyingCount = 0;
+	program.vertex = [](const SoftVertexInput& in, const SoftShaderResources&, SoftVertexOutput& out) {
+		const float* p = reinterpret_cast<const float*>(in.buffers[0]);
+		out.position[0] = p[0];
+		out.position[1] = p[1];
+		out.position[2] = 0.5f;
+		out.position[3] = 1.0f;
+	};
+	program.pixel = [](const float*, const SoftShaderResources&, float colour[4]) {
+		colour[0] = colour[1] = colour[2] = colour[3] = 1.0f;
+		return true;
+	};
+
+	Scene scene(device.get(), program, false, false, CullMode::NONE);
+
+	//Six vertices per band
+	vector<float> quads;
+
+	for (uint32 i = 0; i < bands; i++)
+	{
+		const float l = -1.0f + 2.0f * i / bands;
+		const float r = -1.0f + 2.0f * (i + 1) / bands;
+		const float quad[] = { l, 1, r, 1, l, -1, l, -1, r, 1, r, -1 };
+		quads.insert(quads.end(), quad, quad + 12);
+	}
+
+	BufferResourceInfo vbInfo;
+	vbInfo.type = BufferType::VERTEX;
+	vbInfo.size = (uint32)(quads.size() * sizeof(float));
+	ResourceData vbData;
+	vbData.memory = quads.data();
+	RPtr<ResourceHandle> vb = device->createResourceBuffer(vbData, vbInfo, ResourceHandle());
+
+	VertexBufferView view;
+	view.buffer = vb.handle();
+	view.stride = 2 * sizeof(float);
+
+	ResourceSetCreateInfo setInfo;
+	setInfo.vertexBuffers = &view;
+	setInfo.vertexBufferCount = 1;
+	RPtr<ResourceSetHandle> inputs = device->createResourceSet(setInfo, ResourceSetHandle());
+
+	//Draw the first and third bands
+	DrawIndirectArgs args[2];
+	args[0].count = 6;
+	args[0].start = 0;
+	args[1].count = 6;
+	args[1].start = 12;
+
+	BufferResourceInfo argsInfo;
+	argsInfo.type = BufferType::INDIRECT;
+	argsInfo.size = sizeof(args);
+	ResourceData argsData;
+	argsData.memory = args;
+	RPtr<ResourceHandle> argsBuffer = device->createResourceBuffer(argsData, argsInfo, ResourceHandle());
+	assert(argsBuffer);
+
+	RenderContext* context = device->context();
+	context->clearColourTarget(scene.target.handle(), 0xFF000000);
+	context->bindTarget(scene.target.handle());
+	context->bindPipeline(scene.pipeline.handle());
+	context->bindResourceSet(inputs.handle());
+	context->multiDrawIndirect(argsBuffer.handle(), 0, 2, false);
+
+	//Arguments outside of the buffer draw nothing
+	context->multiDrawIndirect(argsBuffer.handle(), sizeof(DrawIndirectArgs), 2, false);
+	context->finish();
+
+	Pixels pixels(device.get(), device->getDisplayTarget(), w, h);
+
+	for (uint32 band = 0; band < bands; band++)
+	{
+		const uint8* p = pixels.at(band * (w / bands) + 2, h / 2);
+		assert(p[0] == ((band % 2 == 0) ? 255 : 0));
+	}
+
+	RenderStats stats;
+	device->queryStats(stats);
+	assert(stats.drawcalls == 2);
+	assert(stats.triangles == 4);
+}
+
+void testSoftCompute()
+{
+	const uint32 w = 16, h = 8;
+	SoftDevicePtr device = createDevice(w, h);
+
+	//The first program writes the arguments of the second, which fills the image with the coordinates of each thread
+	SoftProgram argsProgram;
+	argsProgram.compute = [](const SoftComputeInput&, const SoftShaderResources& resources) {
+		DispatchIndirectArgs args;
+		args.groupsX = 4;
+		args.groupsY = 2;
+		args.groupsZ = 1;
+		memcpy(resources.storageBuffers[0].data, &args, sizeof(args));
+	};
+
+	SoftProgram fillProgram;
+	fillProgram.groupSize[0] = 4;
+	fillProgram.groupSize[1] = 4;
+	fillProgram.compute = [](const SoftComputeInput& in, const SoftShaderResources& resources) {
+		const SoftStorageImage& image = resources.storageImages[0];
+		const uint32 x = in.dispatchThreadID[0];
+		const uint32 y = in.dispatchThreadID[1];
+
+		if (x < image.width && y < image.height)
+		{
+			uint8* p = image.data + y * image.rowPitch + x * 4;
+			p[0] = (uint8)x;
+			p[1] = (uint8)y;
+			p[2] = (uint8)in.groupID[0];
+			p[3] = 255;
+		}
+	};
+
+	auto createPipeline = [&](const SoftProgram& program, RPtr<ShaderHandle>& shader) {
+		ShaderCreateInfo shaderInfo;
+		shaderInfo.stages[(size_t)ShaderStage::COMPUTE].bytecode = &program;
+		shaderInfo.stages[(size_t)ShaderStage::COMPUTE].size = sizeof(SoftProgram);
+		shader = device->createShader(shaderInfo);
+		assert(shader);
+
+		return device->createPipeline(shader.handle(), PipelineCreateInfo());
+	};
+
+	RPtr<ShaderHandle> argsShader, fillShader;
+	RPtr<PipelineHandle> argsPipeline = createPipeline(argsProgram, argsShader);
+	RPtr<PipelineHandle> fillPipeline = createPipeline(fillProgram, fillShader);
+	assert(argsPipeline && fillPipeline);
+
+	BufferResourceInfo argsInfo;
+	argsInfo.type = BufferType::INDIRECT;
+	argsInfo.size = sizeof(DispatchIndirectArgs);
+	RPtr<ResourceHandle> argsBuffer = device->createResourceBuffer(ResourceData(), argsInfo, ResourceHandle());
+
+	ImageResourceInfo imageInfo;
+	imageInfo.format = ImageFormat::RGBA;
+	imageInfo.usage = ImageUsage::SRV | ImageUsage::UAV;
+	imageInfo.width = w;
+	imageInfo.height = h;
+	RPtr<ResourceHandle> image = device->createResourceImage(nullptr, imageInfo, ResourceHandle());
+	assert(argsBuffer && image);
+
+	ResourceHandle argsHandle = argsBuffer.handle();
+	ResourceSetCreateInfo argsSetInfo;
+	argsSetInfo.storageBuffers = &argsHandle;
+	argsSetInfo.storageBufferCount = 1;
+	RPtr<ResourceSetHandle> argsSet = device->createResourceSet(argsSetInfo, ResourceSetHandle());
+
+	ImageView imageView;
+	imageView.image = image.handle();
+	ResourceSetCreateInfo fillSetInfo;
+	fillSetInfo.storageImages = &imageView;
+	fillSetInfo.storageImageCount = 1;
+	RPtr<ResourceSetHandle> fillSet = device->createResourceSet(fillSetInfo, ResourceSetHandle());
+	assert(argsSet && fillSet);
+
+	RenderContext* context = device->context();
+	context->dispatch(argsPipeline.handle(), argsSet.handle(), DispatchParams());
+	context->dispatchIndirect(fillPipeline.handle(), fillSet.handle(), argsBuffer.handle(), 0);
+
+	//Arguments outside of the buffer dispatch nothing
+	context->dispatchIndirect(fillPipeline.handle(), fillSet.handle(), argsBuffer.handle(), 4);
+	context->finish();
+
+	Pixels pixels(device.get(), image.handle(), w, h);
+
+	for (uint32 y = 0; y < h; y++)
+	{
+		for (uint32 x = 0; x < w; x++)
+		{
+			const uint8* p = pixels.at(x, y);
+			assert(p[0] == x && p[1] == y && p[2] == x / 4 && p[3] == 255);
+		}
+	}
+
+	RenderStats stats;
+	device->queryStats(stats);
+	assert(stats.dispatches == 2);
+	assert(stats.drawcalls == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+	//Execute test cases
+	testSoftCoverage();
+	testSoftCube((argc > 1) ? argv[1] : nullptr);
+	testSoftParallelRecording();
+	testSoftDrawIndirect();
+	testSoftCompute();
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -59,10 +59,8 @@ ShaderHandle MaterialManager::selectShader(const Mesh& mesh, const PhongMaterial
 //	Pipeline creation methods
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-RPtr<PipelineHandle> MaterialManager::getForwardPipeline(const Mesh& mesh, const PhongMaterial& mat)
+PipelineRef MaterialManager::getForwardPipeline(const Mesh& mesh, const PhongMaterial& mat)
 {
-	RenderDevice* device = m_gfx->device();
-
 	//Image samplers
 	BindingSet<SamplerState> samplers;
 	samplers[0].filtering = ImageFilterMode::ANISOTROPIC;
@@ -102,13 +100,12 @@ RPtr<PipelineHandle> MaterialManager::getForwardPipeline(const Mesh& mesh, const
 	//Vertex topology
 	pso.topology = mesh.vertexTopology;
 
-	return device->createPipeline(selectShader(mesh, mat), pso);
+	//Meshes with equal layouts and materials share pipelines
+	return m_gfx->getPipelineCache()->get(selectShader(mesh, mat), pso);
 }
 
-RPtr<PipelineHandle> MaterialManager::getShadowPipeline(const Mesh& mesh, const PhongMaterial& material)
+PipelineRef MaterialManager::getShadowPipeline(const Mesh& mesh, const PhongMaterial& material)
 {
-	RenderDevice* device = m_gfx->device();
-
 	PipelineCreateInfo pso;
 	//States
 	pso.blend.enable = false;
@@ -134,7 +131,7 @@ RPtr<PipelineHandle> MaterialManager::getShadowPipeline(const Mesh& mesh, const
 	//Vertex topology
 	pso.topology = mesh.vertexTopology;
 
-	return device->createPipeline(m_shadowMapper.handle(), pso);
+	return m_gfx->getPipelineCache()->get(m_shadowMapper.handle(), pso);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
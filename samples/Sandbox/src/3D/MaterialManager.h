@@ -6,6 +6,7 @@
 
 #include <tsgraphics/Graphics.h>
 #include <tsgraphics/Shader.h>
+#include <tsgraphics/PipelineCache.h>
 #include "Material.h"
 
 namespace ts
@@ -24,9 +25,9 @@ namespace ts
 		MaterialManager(const MaterialManager&) = delete;
 		MaterialManager(MaterialManager&& rhs) = default;
 
-        RPtr<PipelineHandle> getForwardPipeline(const Mesh& mesh, const PhongMaterial& material);
+        PipelineRef getForwardPipeline(const Mesh& mesh, const PhongMaterial& material);
 
-        RPtr<PipelineHandle> getShadowPipeline(const Mesh& mesh, const PhongMaterial& material);
+        PipelineRef getShadowPipeline(const Mesh& mesh, const PhongMaterial& material);
 
     private:
 
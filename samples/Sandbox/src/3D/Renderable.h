@@ -5,20 +5,22 @@
 #pragma once
 
 #include <tsgraphics/BindingSet.h>
-#include <tsgraphics/Buffer.h>
+#include <tsgraphics/PipelineCache.h>
+#include <tsgraphics/ResourceSetCache.h>
 
 namespace ts
 {
 	struct Renderable
 	{
-		Buffer materialBuffer;
+		PipelineRef pso;
+		ResourceSetRef inputs;
 
-		RPtr<PipelineHandle> pso;
-		RPtr<ResourceSetHandle> inputs;
-
-		RPtr<PipelineHandle> shadowPso;
-		RPtr<ResourceSetHandle> shadowInputs;
+		PipelineRef shadowPso;
+		ResourceSetRef shadowInputs;
 
 		DrawParams params;
+
+		//Drawn after opaque renderables in back to front order
+		bool translucent = false;
 	};
 }
@@ -4,25 +4,36 @@
 
 #include <tscore/debug/assert.h>
 
+#include <cstring>
+
 #include "SceneRender.h"
 
 using namespace ts;
 
+//Maximum number of batches recorded per frame
+static const uint32 s_maxBatches = 8192;
+//Maximum number of batches recorded for static renderables
+static const uint32 s_maxStaticBatches = 8192;
+//Mesh constants are allocated once per renderable, which is drawn in both passes
+static const uint32 s_maxMeshConstants = (s_maxBatches / 2) * DrawParams::CONSTANT_OFFSET_ALIGNMENT;
+
 ///////////////////////////////////////////////////////////////////////////////
 
 SceneRender::SceneRender(
 	GraphicsSystem* graphics
 ) : m_gfx(graphics),
-	m_materialManager(graphics)
+	m_materialManager(graphics),
+	m_queue(s_maxBatches),
+	m_staticBatch(s_maxStaticBatches)
 {
 	tsassert(m_gfx);
 	RenderDevice* device = m_gfx->device();
 
 	m_perScene = Buffer::create(device, SceneConstants(), BufferType::CONSTANTS);
-	m_perMesh  = Buffer::create(device, MeshConstants(), BufferType::CONSTANTS);
+	m_meshConstants = DynamicBufferRing(device, BufferType::CONSTANTS, s_maxMeshConstants);
 
 	tsassert(m_perScene);
-	tsassert(m_perMesh);
+	tsassert(m_meshConstants.getBuffer() != ResourceHandle());
 
 	m_targets = RenderTargets<>(device);
 	m_targets.attach(0, m_gfx->getDisplayView());
@@ -44,35 +55,68 @@ void SceneRender::update()
 	
 	tsassert(m_targets.handle() != TargetHandle());
 
-	auto ctx = m_gfx->device()->context();
+	//The static batch is recorded again only if the target it draws to was recreated with a different handle
+	if (m_staticTarget != m_targets.handle())
+	{
+		m_staticBatch.invalidate(m_staticTarget);
+		m_staticTarget = m_targets.handle();
+	}
 
-	//Clear backbuffer
-	ctx->clearDepthTarget(m_targets.handle(), 1.0f);
-	ctx->clearColourTarget(m_targets.handle(), RGBA(80, 166, 100));
+	if (!m_staticBatch.isValid())
+	{
+		recordStaticBatch(
+			m_staticTarget,
+			m_staticRenderables
+		);
+	}
 
-	//Clear shadow buffer
-	ctx->clearDepthTarget(m_shadowPass.getTarget(), 1.0f);
-	ctx->clearColourTarget(m_shadowPass.getTarget(), RGBA(255, 255, 255));
+#ifdef _DEBUG
+	//The batch would draw with the objects it was recorded with, renderables which change must be drawn again
+	tsassert(!staticObjectsChanged());
+#endif
+
+	m_queue.submitStatic(&m_staticBatch);
+
+	//Write the mesh constants of each visible renderable
+	m_visibleOffsets.clear();
+
+	for (const auto& r : m_visibleRenderables)
+	{
+		MeshConstants constants;
+		constants.world = r.transform.transpose();
+
+		m_visibleOffsets.push_back(m_meshConstants.write(constants).offset);
+	}
 
 	//Shadow pass
-	executeShadowPass(
+	recordShadowPass(
 		m_visibleRenderables
 	);
 
 	//Colour pass
-	executeColourPass(
+	recordColourPass(
 		m_targets.handle(),
 		m_visibleRenderables
 	);
 
+	//Order batches by pass, then by state and depth, static batches are merged in key order
+	m_queue.sort();
+
+	//Mesh constants are uploaded together before they are drawn
+	m_meshConstants.upload(m_gfx->device()->context());
+	m_gfx->execute(&m_queue);
+	m_meshConstants.nextFrame();
+
 	m_visibleRenderables.clear();
 }
 
+/*
+	Each pass begins with a batch whose key only contains the pass,
+	draws which compare equal to it stay after it as the sort is stable.
+*/
 
-void SceneRender::executeColourPass(TargetHandle target, const RenderableList& renderables)
+void SceneRender::recordColourPass(TargetHandle target, const RenderableList& renderables)
 {
-	auto ctx = m_gfx->device()->context();
-
 	SceneConstants constants;
 
 	//Ambient light
@@ -101,30 +145,57 @@ void SceneRender::executeColourPass(TargetHandle target, const RenderableList& r
 	Matrix::transpose(constants.projection);
 	Matrix::transpose(constants.lightView);
 
-	//Update scene constants
-	ctx->resourceUpdate(m_perScene.handle(), &constants);
+	//Clear backbuffer and update scene constants
+	CommandBatch* batch = m_queue.createBatch();
+	m_queue.addCommand(batch, CommandTargetClear(target, Vector(RGBA(80, 166, 100)), 1.0f));
+	m_queue.addCommand(batch, CommandBufferUpdate(m_perScene.handle()), constants);
+	m_queue.submitBatch(OpaqueSortKey().set<SortKeyPass>(PASS_COLOUR), batch);
 
-	for (const auto& r : m_visibleRenderables)
-	{
-		//Update mesh constants
-		MeshConstants constants;
-		constants.world = r.transform.transpose();
+	uint32 index = 0;
 
-		ctx->resourceUpdate(m_perMesh.handle(), &constants);
-
-		ctx->draw(
+	for (const auto& r : renderables)
+	{
+		//View space depth of the renderable's origin
+		Vector origin = Matrix::transform4D(Vector(0, 0, 0, 1), r.transform);
+		float depth = Matrix::transform4D(origin, m_viewMatrix).z();
+
+		const uint64 pipeline = sortKeyId(r.item->pso->handle());
+		const uint64 material = sortKeyId(r.item->inputs->handle());
+
+		uint64 key = 0;
+
+		if (r.item->translucent)
+		{
+			key = TranslucentSortKey()
+				.set<SortKeyPass>(PASS_COLOUR)
+				.set<SortKeyTranslucent>(1)
+				.setDepth<SortKeyDepth>(depth, m_zNear, m_zFar, DepthOrder::BACK_TO_FRONT)
+				.set<SortKeyPipeline>(pipeline)
+				.set<SortKeyMaterial>(material);
+		}
+		else
+		{
+			key = OpaqueSortKey()
+				.set<SortKeyPass>(PASS_COLOUR)
+				.set<SortKeyPipeline>(pipeline)
+				.set<SortKeyMaterial>(material)
+				.setDepth<SortKeyDepth>(depth, m_zNear, m_zFar, DepthOrder::FRONT_TO_BACK);
+		}
+
+		recordDraw(
+			m_queue,
+			key,
+			m_visibleOffsets[index++],
 			target,
-			r.item->pso.handle(),
-			r.item->inputs.handle(),
+			r.item->pso->handle(),
+			r.item->inputs->handle(),
 			r.item->params
 		);
 	}
 }
 
-void SceneRender::executeShadowPass(const RenderableList& renderables)
+void SceneRender::recordShadowPass(const RenderableList& renderables)
 {
-	auto ctx = m_gfx->device()->context();
-
 	SceneConstants constants;
 
 	const float zFar = 150.0f;
@@ -142,23 +213,222 @@ void SceneRender::executeShadowPass(const RenderableList& renderables)
 	Matrix::transpose(constants.view);
 	Matrix::transpose(constants.projection);
 
-	//Update scene constants
-	ctx->resourceUpdate(m_perScene.handle(), &constants);
+	//Clear shadow buffer and update scene constants
+	CommandBatch* batch = m_queue.createBatch();
+	m_queue.addCommand(batch, CommandTargetClear(m_shadowPass.getTarget(), Vector(1, 1, 1, 1), 1.0f));
+	m_queue.addCommand(batch, CommandBufferUpdate(m_perScene.handle()), constants);
+	m_queue.submitBatch(OpaqueSortKey().set<SortKeyPass>(PASS_SHADOW), batch);
 
 	//shadow pass
-	for (const auto& r : m_visibleRenderables)
+	uint32 index = 0;
+
+	for (const auto& r : renderables)
 	{
-		MeshConstants constants;
-		constants.world = r.transform.transpose();
-		ctx->resourceUpdate(m_perMesh.handle(), &constants);
+		//Light space depth of the renderable's origin
+		Vector origin = Matrix::transform4D(Vector(0, 0, 0, 1), r.transform);
+		float depth = Matrix::transform4D(origin, m_lightView).z();
+
+		uint64 key = OpaqueSortKey()
+			.set<SortKeyPass>(PASS_SHADOW)
+			.set<SortKeyPipeline>(sortKeyId(r.item->shadowPso->handle()))
+			.set<SortKeyMaterial>(sortKeyId(r.item->shadowInputs->handle()))
+			.setDepth<SortKeyDepth>(depth, zNear, zFar, DepthOrder::FRONT_TO_BACK);
+
+		recordDraw(
+			m_queue,
+			key,
+			m_visibleOffsets[index++],
+			m_shadowPass.getTarget(),
+			r.item->shadowPso->handle(),
+			r.item->shadowInputs->handle(),
+			r.item->params
+		);
+	}
+}
+
+/*
+	Static renderables are opaque, their keys have no depth so they don't change when the camera moves.
+	Their mesh constants are written once into a buffer of their own, which their resource sets bind in place of the dynamic buffer.
+*/
+void SceneRender::recordStaticBatch(TargetHandle target, const RenderableList& renderables)
+{
+	const uint32 stride = DrawParams::CONSTANT_OFFSET_ALIGNMENT;
+
+	std::vector<uint8> constants;
+
+	for (const auto& r : renderables)
+	{
+		MeshConstants c;
+		c.world = r.transform.transpose();
+
+		const size_t offset = constants.size();
+		constants.resize(offset + stride);
+		memcpy(&constants[offset], &c, sizeof(MeshConstants));
+	}
+
+	m_staticSets.clear();
+	m_staticObjects.clear();
+	m_staticMeshConstants = Buffer();
+
+	if (!constants.empty())
+	{
+		m_staticMeshConstants = Buffer::create(m_gfx->device(), constants.data(), (uint32)constants.size(), BufferType::CONSTANTS);
+	}
+
+	//Get a set which binds the static mesh constants in place of the dynamic buffer
+	ResourceSetCache* sets = m_gfx->getResourceSetCache();
+	const ResourceSetUpdate bindStatic = ResourceSetUpdate::makeConstantBuffer(BIND_MESH_CONSTANTS, m_staticMeshConstants.handle(), true);
+
+	auto staticSet = [&](const ResourceSetRef& dynamicSet)
+	{
+		ResourceSetRef set = dynamicSet;
+		sets->update(set, &bindStatic, 1);
+		m_staticSets.push_back(set);
+		return set->handle();
+	};
+
+	m_staticBatch.begin();
+
+	m_staticBatch.addDependency(target);
+	m_staticBatch.addDependency(m_shadowPass.getTarget());
 
-		ctx->draw(
+	uint32 offset = 0;
+
+	for (const auto& r : renderables)
+	{
+		const ResourceSetHandle shadowInputs = staticSet(r.item->shadowInputs);
+		const ResourceSetHandle inputs = staticSet(r.item->inputs);
+
+		//Shadow pass
+		uint64 shadowKey = OpaqueSortKey()
+			.set<SortKeyPass>(PASS_SHADOW)
+			.set<SortKeyPipeline>(sortKeyId(r.item->shadowPso->handle()))
+			.set<SortKeyMaterial>(sortKeyId(shadowInputs));
+
+		recordDraw(
+			m_staticBatch,
+			shadowKey,
+			offset,
 			m_shadowPass.getTarget(),
-			r.item->shadowPso.handle(),
-			r.item->shadowInputs.handle(),
+			r.item->shadowPso->handle(),
+			shadowInputs,
 			r.item->params
 		);
+
+		//Colour pass
+		uint64 colourKey = OpaqueSortKey()
+			.set<SortKeyPass>(PASS_COLOUR)
+			.set<SortKeyPipeline>(sortKeyId(r.item->pso->handle()))
+			.set<SortKeyMaterial>(sortKeyId(inputs));
+
+		recordDraw(
+			m_staticBatch,
+			colourKey,
+			offset,
+			target,
+			r.item->pso->handle(),
+			inputs,
+			r.item->params
+		);
+
+		m_staticBatch.addDependency(r.item->shadowPso->handle());
+		m_staticBatch.addDependency(shadowInputs);
+		m_staticBatch.addDependency(r.item->pso->handle());
+		m_staticBatch.addDependency(inputs);
+
+		StaticObjects objects;
+		objects.pso = r.item->pso;
+		objects.shadowPso = r.item->shadowPso;
+		objects.inputs = r.item->inputs;
+		objects.shadowInputs = r.item->shadowInputs;
+		m_staticObjects.push_back(objects);
+
+		offset += stride;
+	}
+
+	m_staticBatch.end();
+}
+
+bool SceneRender::staticObjectsChanged() const
+{
+	size_t i = 0;
+
+	for (const auto& r : m_staticRenderables)
+	{
+		if (i >= m_staticObjects.size())
+			return true;
+
+		const StaticObjects& objects = m_staticObjects[i++];
+
+		if (objects.pso != r.item->pso ||
+			objects.shadowPso != r.item->shadowPso ||
+			objects.inputs != r.item->inputs ||
+			objects.shadowInputs != r.item->shadowInputs)
+		{
+			return true;
+		}
 	}
+
+	return false;
+}
+
+void SceneRender::drawStatic(const Renderable& item, const Matrix& transform)
+{
+	tsassert(!item.translucent);
+
+	m_staticRenderables.submit(transform, item);
+	m_staticBatch.invalidate();
+}
+
+void SceneRender::clearStatic()
+{
+	m_staticRenderables.clear();
+	m_staticBatch.invalidate();
+}
+
+void SceneRender::recordDraw(
+	CommandRecorder& rec,
+	uint64 key,
+	uint32 constantOffset,
+	TargetHandle target,
+	PipelineHandle pipeline,
+	ResourceSetHandle inputs,
+	const DrawParams& params
+)
+{
+	CommandDraw draw;
+	draw.outputs = target;
+	draw.pipeline = pipeline;
+	draw.inputs = inputs;
+	draw.params = params;
+	draw.params.constantOffset = constantOffset;
+
+	CommandBatch* batch = rec.createBatch();
+	rec.addCommand(batch, draw);
+	rec.submitBatch(key, batch);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+ResourceHandle SceneRender::getMaterialBuffer(const MaterialConstants& constants)
+{
+	//Key on each field so padding isn't included
+	std::string key;
+	auto append = [&key](const auto& v) { key.append((const char*)&v, sizeof(v)); };
+	append(constants.diffuseColour);
+	append(constants.ambientColour);
+	append(constants.specularColour);
+	append(constants.emissiveColour);
+	append(constants.specularPower);
+
+	Buffer& buffer = m_materialBuffers[key];
+
+	if (buffer.null())
+	{
+		buffer = Buffer::create(m_gfx->device(), constants, BufferType::CONSTANTS);
+	}
+
+	return buffer.handle();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -167,8 +437,6 @@ Renderable SceneRender::createRenderable(const Mesh& mesh, const PhongMaterial&
 {
 	tsassert(m_gfx);
 
-	RenderDevice* device = m_gfx->device();
-
 	Renderable item;
 
 	/*
@@ -201,8 +469,6 @@ Renderable SceneRender::createRenderable(const Mesh& mesh, const PhongMaterial&
 	matConstants.specularColour = phong.specularColour;
 	matConstants.specularPower = phong.specularPower;
 
-	item.materialBuffer = Buffer::create(device, matConstants, BufferType::CONSTANTS);
-
 	/*
 		Resource Set
 	*/
@@ -211,11 +477,12 @@ Renderable SceneRender::createRenderable(const Mesh& mesh, const PhongMaterial&
 	//Constant buffer resources
 	BindingSet<ResourceHandle> constantBuffers;
 	constantBuffers[BIND_SCENE_CONSTANTS] = m_perScene.handle();
-	constantBuffers[BIND_MESH_CONSTANTS] = m_perMesh.handle();
-	constantBuffers[BIND_MAT_CONSTANTS] = item.materialBuffer.handle();
+	constantBuffers[BIND_MESH_CONSTANTS] = m_meshConstants.getBuffer();
+	constantBuffers[BIND_MAT_CONSTANTS] = getMaterialBuffer(matConstants);
 
 	info.constantBuffers = constantBuffers.data();
 	info.constantBuffersCount = (uint32)constantBuffers.count();
+	info.dynamicConstants = 1u << BIND_MESH_CONSTANTS;
 
 	//Image resources
 	info.resources = images.data();
@@ -226,21 +493,25 @@ Renderable SceneRender::createRenderable(const Mesh& mesh, const PhongMaterial&
 	info.vertexBufferCount = 1;
 	info.indexBuffer = mesh.indices;
 
-	//Colour pass resources
-	item.inputs = device->createResourceSet(info);
+	//Renderables with equal meshes and materials share resource sets
+	ResourceSetCache* sets = m_gfx->getResourceSetCache();
+
+	//Colour pass
+	item.inputs = sets->get(info);
 	item.pso = m_materialManager.getForwardPipeline(mesh, phong);
 
-	//Unbind shadow map for now
-	images[BIND_SHADOW_MAP] = ImageView();
+	//Shadow pass, the colour pass resources with the shadow map unbound for now
+	const ResourceSetUpdate unbindShadowMap = ResourceSetUpdate::makeResource(BIND_SHADOW_MAP, ImageView());
+	item.shadowInputs = item.inputs;
+	sets->update(item.shadowInputs, &unbindShadowMap, 1);
 
-	//Shadow pass
-	item.shadowInputs = device->createResourceSet(info);
 	item.shadowPso = m_materialManager.getShadowPipeline(mesh, phong);
 
 	/*
 		Mesh
 	*/
 	item.params = mesh.getParams();
+	item.translucent = phong.enableAlpha;
 
 	return std::move(item);
 }
@@ -6,6 +6,13 @@
 
 #include <tsgraphics/Graphics.h>
 #include <tsgraphics/Buffer.h>
+#include <tsgraphics/CommandQueue.h>
+#include <tsgraphics/DynamicBuffer.h>
+#include <tsgraphics/SortKey.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "RenderableList.h"
 #include "ShaderConstants.h"
@@ -24,6 +31,13 @@ namespace ts
 		LIGHT3
 	};
 
+	//Passes in the order they are executed
+	enum ScenePass
+	{
+		PASS_SHADOW = 1,
+		PASS_COLOUR = 2,
+	};
+
 	class SceneRender
 	{
 	private:
@@ -31,20 +45,49 @@ namespace ts
 		GraphicsSystem* m_gfx;
 		MaterialManager m_materialManager;
 
+		CommandQueue m_queue;
+
+		//Renderables which do not change between frames, recorded once into a static batch
+		RenderableList m_staticRenderables;
+		StaticCommandBatch m_staticBatch;
+		TargetHandle m_staticTarget = TargetHandle();
+
+		//Mesh constants of static renderables and the resource sets which bind them
+		Buffer m_staticMeshConstants;
+		std::vector<ResourceSetRef> m_staticSets;
+
+		//Objects each static renderable was recorded with, referenced so their handles stay alive while the batch uses them
+		struct StaticObjects
+		{
+			PipelineRef pso;
+			PipelineRef shadowPso;
+			ResourceSetRef inputs;
+			ResourceSetRef shadowInputs;
+		};
+
+		std::vector<StaticObjects> m_staticObjects;
+
 		RenderTargets<> m_targets;
 
-		Buffer m_perMesh;
+		//Mesh constants of each draw are allocated per frame and bound at the draw's constant offset
+		DynamicBufferRing m_meshConstants;
 		Buffer m_perScene;
 
+		//Material constant buffers shared between materials with equal constants
+		std::unordered_map<std::string, Buffer> m_materialBuffers;
+
 		ShadowPass m_shadowPass;
 
 		RenderableList m_visibleRenderables;
+		//Offset of the mesh constants of each visible renderable
+		std::vector<uint32> m_visibleOffsets;
 
 		/*
 			Properties
 		*/
 		Vector m_ambientColour;
 		Matrix m_viewMatrix, m_projMatrix;
+		float m_zNear = 0.1f, m_zFar = 1000.0f;
 		RGBA m_directLightColour;
 		Vector m_directLightDir;
 		DynamicLight m_dynamicLights[MAX_LIGHTS];
@@ -66,6 +109,8 @@ namespace ts
 		void setCameraView(const Matrix& view) { m_viewMatrix = view; }
 		void setCameraProjection(const Matrix& proj) { m_projMatrix = proj; }
 		void setCamera(const Matrix& view, const Matrix& proj) { setCameraView(view); setCameraProjection(proj); }
+		//View depth range used to order draws
+		void setCameraDepthRange(float zNear, float zFar) { m_zNear = zNear; m_zFar = zFar; }
 		void setAmbientColour(const Vector& ambient) { m_ambientColour = ambient; }
 
 		void setDirectionalLightColour(RGBA colour) { m_directLightColour = colour; }
@@ -93,11 +138,38 @@ namespace ts
 			m_visibleRenderables.submit(transform, item);
 		}
 
+		/*
+			Draw a renderable every frame until the static renderables are cleared,
+			static renderables are only recorded again when they or the objects they use change.
+			Changes to a renderable's pipelines or resource sets are not detected, the renderables must be cleared and drawn again.
+			Translucent renderables are ordered by depth every frame so they must be drawn with draw().
+		*/
+		void drawStatic(const Renderable& item, const Matrix& transform);
+		void clearStatic();
+
 		void update();
 
 	private:
 
-		void executeColourPass(TargetHandle target, const RenderableList& renderables);
-		void executeShadowPass(const RenderableList& renderables);
+		void recordColourPass(TargetHandle target, const RenderableList& renderables);
+		void recordShadowPass(const RenderableList& renderables);
+		void recordStaticBatch(TargetHandle target, const RenderableList& renderables);
+
+		//Check if a static renderable uses different objects than it was recorded with
+		bool staticObjectsChanged() const;
+
+		//Get a constant buffer for a material, materials with equal constants share a buffer
+		ResourceHandle getMaterialBuffer(const MaterialConstants& constants);
+
+		//Record a batch which draws a renderable with the mesh constants at a given offset
+		void recordDraw(
+			CommandRecorder& rec,
+			uint64 key,
+			uint32 constantOffset,
+			TargetHandle target,
+			PipelineHandle pipeline,
+			ResourceSetHandle inputs,
+			const DrawParams& params
+		);
 	};
 }
@@ -59,6 +59,9 @@ namespace ts
 		void setSpeed(float speed) { m_camSpeed = speed; }
 		float getSpeed() const { return m_camSpeed; }
 
+		float getNearPlane() const { return m_nearplane; }
+		float getFarPlane() const { return m_farplane; }
+
 		void update(double deltatime);
 		
 		Matrix getViewMatrix() const { return (Matrix::rotationX(m_camAngleV) * Matrix::rotationY(m_camAngleH) * Matrix::translation(m_camPosition)).inverse(); }
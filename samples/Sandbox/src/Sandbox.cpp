@@ -96,6 +96,17 @@ int Sandbox::onInit()
 		m_transforms.setComponent(m_boxEntity, Matrix::translation(Vector(0, 1, 0)));
 	}
 
+	//The model doesn't move so it is recorded once as static geometry
+	{
+		const TransformComponent& tcomp(m_transforms.getComponent(m_modelEntity));
+		const RenderComponent& rcomp(m_renderables.getComponent(m_modelEntity));
+
+		for (const Renderable& item : rcomp.items)
+		{
+			m_render.drawStatic(item, tcomp.getMatrix());
+		}
+	}
+
 	//////////////////////////////////////////////////////////////////////////////
 
 	return 0;
@@ -150,9 +161,10 @@ void Sandbox::onUpdate(double deltatime)
 
 	m_render.setCameraView(m_camera.getViewMatrix());
 	m_render.setCameraProjection(m_camera.getProjectionMatrix());
+	m_render.setCameraDepthRange(m_camera.getNearPlane(), m_camera.getFarPlane());
 
-	// Submit entities for rendering
-	for (Entity e : { m_modelEntity, m_boxEntity })
+	// Submit dynamic entities for rendering
+	for (Entity e : { m_boxEntity })
 	{
 		if (m_transforms.hasComponent(e))
 		{
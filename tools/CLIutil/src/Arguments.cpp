@@ -96,7 +96,7 @@ int ArgumentReader::parse(int argc, char** argv)
 				//Otherwise just pass an empty string
 				else
 				{
-					it->second.callback(String());
+					{ String e; it->second.callback(e); }
 				}
 			}
 		}
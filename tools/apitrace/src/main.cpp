@@ -0,0 +1,178 @@
+/*
+	API Trace:
+
+	Loads a trace recorded by a TraceDevice and prints a summary of it:
+	a histogram of the calls made, the cost of each frame and redundant call patterns.
+
+	Usage:
+
+	apitrace [OPTIONS] FILE
+
+	apitrace frames.tstrace
+	apitrace --frames frames.tstrace
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include <cli/Arguments.h>
+#include <cli/Constants.h>
+
+#include <tsgraphics/ApiTrace.h>
+
+using namespace std;
+using namespace ts;
+using namespace ts::cli;
+
+static double toMs(uint64 ns) { return (double)ns / 1000000.0; }
+static double toUs(uint64 ns) { return (double)ns / 1000.0; }
+
+static void printCalls(const TraceReader::Summary& summary)
+{
+	cout << "calls:\n";
+	cout << "  " << left << setw(26) << "call" << right << setw(10) << "count" << setw(14) << "total (ms)" << setw(12) << "avg (us)" << setw(12) << "max (us)" << "\n";
+
+	//Most expensive calls first
+	vector<size_t> order;
+
+	for (size_t i = 0; i < (size_t)TraceCall::MAX_CALLS; i++)
+	{
+		if (summary.calls[i].count > 0)
+			order.push_back(i);
+	}
+
+	sort(order.begin(), order.end(), [&](size_t a, size_t b) { return summary.calls[a].totalTime > summary.calls[b].totalTime; });
+
+	for (size_t i : order)
+	{
+		const TraceReader::CallStats& stats = summary.calls[i];
+
+		cout << "  " << left << setw(26) << TraceReader::callName((TraceCall)i) << right
+			<< setw(10) << stats.count
+			<< setw(14) << fixed << setprecision(3) << toMs(stats.totalTime)
+			<< setw(12) << toUs(stats.totalTime / stats.count)
+			<< setw(12) << toUs(stats.maxTime) << "\n";
+	}
+}
+
+static void printFrames(const TraceReader::Summary& summary, bool all)
+{
+	//The last frame is the calls made after the final commit
+	const size_t count = (summary.frames.size() > 1) ? summary.frames.size() - 1 : summary.frames.size();
+
+	if (count == 0)
+		return;
+
+	if (all)
+	{
+		cout << "frames:\n";
+		cout << "  " << left << setw(8) << "frame" << right << setw(10) << "calls" << setw(10) << "draws" << setw(14) << "call (ms)" << setw(14) << "wall (ms)" << "\n";
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const TraceReader::FrameStats& f = summary.frames[i];
+
+			cout << "  " << left << setw(8) << i << right
+				<< setw(10) << f.calls
+				<< setw(10) << f.draws
+				<< setw(14) << fixed << setprecision(3) << toMs(f.callTime)
+				<< setw(14) << toMs(f.wallTime) << "\n";
+		}
+	}
+
+	TraceReader::FrameStats lo = summary.frames[0];
+	TraceReader::FrameStats hi = summary.frames[0];
+	TraceReader::FrameStats sum;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const TraceReader::FrameStats& f = summary.frames[i];
+
+		lo.calls = min(lo.calls, f.calls);
+		lo.draws = min(lo.draws, f.draws);
+		lo.callTime = min(lo.callTime, f.callTime);
+		lo.wallTime = min(lo.wallTime, f.wallTime);
+
+		hi.calls = max(hi.calls, f.calls);
+		hi.draws = max(hi.draws, f.draws);
+		hi.callTime = max(hi.callTime, f.callTime);
+		hi.wallTime = max(hi.wallTime, f.wallTime);
+
+		sum.calls += f.calls;
+		sum.draws += f.draws;
+		sum.callTime += f.callTime;
+		sum.wallTime += f.wallTime;
+	}
+
+	cout << "frames: " << count << "\n";
+	cout << "  " << left << setw(8) << "" << right << setw(10) << "calls" << setw(10) << "draws" << setw(14) << "call (ms)" << setw(14) << "wall (ms)" << "\n";
+
+	auto row = [](const char* name, double calls, double draws, uint64 callTime, uint64 wallTime) {
+		cout << "  " << left << setw(8) << name << right << fixed << setprecision(1)
+			<< setw(10) << calls
+			<< setw(10) << draws
+			<< setw(14) << setprecision(3) << toMs(callTime)
+			<< setw(14) << toMs(wallTime) << "\n";
+	};
+
+	row("avg", (double)sum.calls / count, (double)sum.draws / count, sum.callTime / count, sum.wallTime / count);
+	row("min", lo.calls, lo.draws, lo.callTime, lo.wallTime);
+	row("max", hi.calls, hi.draws, hi.callTime, hi.wallTime);
+}
+
+static void printRedundancy(const TraceReader::Summary& summary)
+{
+	cout << "redundant:\n";
+	cout << "  duplicate pipelines:      " << summary.duplicatePipelines << "\n";
+	cout << "  duplicate shaders:        " << summary.duplicateShaders << "\n";
+	cout << "  duplicate resource sets:  " << summary.duplicateResourceSets << "\n";
+	cout << "  repeated updates:         " << summary.repeatedUpdates << " (" << summary.repeatedUpdateBytes << " bytes)\n";
+	cout << "  redundant binds:          " << summary.redundantBinds << "\n";
+}
+
+int main(int argc, char** argv)
+{
+	bool showFrames = false;
+	bool showHelp = false;
+	ArgumentReader::ParameterList fileList;
+
+	ArgumentReader cliArgs;
+	cliArgs.addOption("frames", showFrames, "Print the cost of every frame");
+	cliArgs.addOption("help", showHelp, "Show help information");
+	cliArgs.setUnused(fileList);
+
+	if (cliArgs.parse(argc, argv) || fileList.size() != 1)
+	{
+		cerr << "Usage:\n";
+		cerr << "apitrace [OPTIONS] FILE\n";
+		cliArgs.print(cerr);
+		return CLI_EXIT_INVALID_ARGUMENT;
+	}
+
+	if (showHelp)
+	{
+		cout << "Usage:\n";
+		cout << "apitrace [OPTIONS] FILE\n";
+		cliArgs.print(cout);
+		return CLI_EXIT_SUCCESS;
+	}
+
+	TraceReader reader;
+
+	if (!reader.load(Path(fileList[0])))
+	{
+		cerr << "ERROR: Unable to load trace \"" << fileList[0] << "\"\n";
+		return CLI_EXIT_FAILURE;
+	}
+
+	TraceReader::Summary summary = reader.summarize();
+
+	cout << fileList[0] << ": " << reader.records().size() << " calls\n";
+
+	printCalls(summary);
+	printFrames(summary, showFrames);
+	printRedundancy(summary);
+
+	return CLI_EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+/*
+	Frame Capture Replay:
+
+	Loads a frame capture, recreates it's objects on a device and times the submission of the captured calls.
+
+	Usage:
+
+	capreplay [OPTIONS] FILE
+
+	capreplay --driver dx11 --iterations 100 frame.tsfc
+	capreplay --driver null frame.tsfc
+	capreplay --trace replay.tstrace frame.tsfc
+*/
+
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+#include <cli/Arguments.h>
+#include <cli/Constants.h>
+
+#include <tsgraphics/FrameCapture.h>
+#include <tsgraphics/ApiTrace.h>
+#include <tsnull.h>
+
+#include <tsconfig.h>
+
+using namespace std;
+using namespace ts;
+using namespace ts::cli;
+
+static bool parseDriver(const String& name, RenderDriverID& id)
+{
+	if (name == "dx11")
+	{
+		id = RenderDriverID::DX11;
+		return true;
+	}
+
+	if (name == "null")
+	{
+		id = RenderDriverID::NULLDEVICE;
+		return true;
+	}
+
+	if (name == "soft")
+	{
+		id = RenderDriverID::SOFTWARE;
+		return true;
+	}
+
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	//The dx11 driver is only available on Windows
+#ifdef WIN32
+	String driverName = "dx11";
+#else
+	String driverName = "null";
+#endif
+	String iterationsArg = "10";
+	String traceFile;
+	bool showHelp = false;
+	ArgumentReader::ParameterList fileList;
+
+	ArgumentReader cliArgs;
+	cliArgs.addParameter("driver", driverName, "Render driver to replay on");
+	cliArgs.addParameter("iterations", iterationsArg, "Number of times to execute the captured frame");
+	cliArgs.addParameter("trace", traceFile, "Record an API trace of the replay to a file");
+	cliArgs.addOption("help", showHelp, "Show help information");
+	cliArgs.setUnused(fileList);
+
+	if (cliArgs.parse(argc, argv) || fileList.size() != 1)
+	{
+		cerr << "Usage:\n";
+		cerr << "capreplay [OPTIONS] FILE\n";
+		cliArgs.print(cerr);
+		return CLI_EXIT_INVALID_ARGUMENT;
+	}
+
+	if (showHelp)
+	{
+		cout << "Usage:\n";
+		cout << "capreplay [OPTIONS] FILE\n";
+		cliArgs.print(cout);
+		return CLI_EXIT_SUCCESS;
+	}
+
+	RenderDriverID driver;
+
+	if (!parseDriver(driverName, driver))
+	{
+		cerr << "ERROR: Unknown driver \"" << driverName << "\"\n";
+		return CLI_EXIT_INVALID_ARGUMENT;
+	}
+
+	const uint32 iterations = max(atoi(iterationsArg.c_str()), 1);
+
+	//The device and trace are declared first so they outlive the objects the replay creates on them
+	RenderDevice::Ptr device;
+	std::unique_ptr<TraceDevice> trace;
+
+	FrameReplay replay;
+
+	if (!replay.load(Path(fileList[0])))
+	{
+		cerr << "ERROR: Unable to load capture \"" << fileList[0] << "\"\n";
+		return CLI_EXIT_FAILURE;
+	}
+
+	FrameReplay::Stats stats = replay.getStats();
+
+	cout << fileList[0] << "\n";
+	cout << "  objects: " << stats.objects << "\n";
+	cout << "  batches: " << stats.batches << "\n";
+	cout << "  calls:   " << stats.calls << "\n";
+	cout << "  draws:   " << stats.draws << "\n";
+	cout << "  payload: " << stats.payloadSize << " bytes\n";
+
+	RenderDeviceConfig config;
+	device = RenderDevice::create(driver, config);
+
+	if (!device)
+	{
+		cerr << "ERROR: Unable to create device\n";
+		return CLI_EXIT_FAILURE;
+	}
+
+	//Optionally record the replayed calls
+	RenderDevice* target = device.get();
+
+	if (traceFile != "")
+	{
+		trace.reset(new TraceDevice(device.get(), Path(traceFile)));
+
+		if (!trace->isOpen())
+		{
+			cerr << "ERROR: Unable to open trace \"" << traceFile << "\"\n";
+			return CLI_EXIT_FAILURE;
+		}
+
+		target = trace.get();
+	}
+
+	if (!replay.create(target))
+	{
+		cerr << "ERROR: Unable to create captured objects\n";
+		return CLI_EXIT_FAILURE;
+	}
+
+	typedef chrono::high_resolution_clock Clock;
+
+	double total = 0.0;
+	double best = 0.0;
+
+	for (uint32 i = 0; i < iterations; i++)
+	{
+		auto start = Clock::now();
+
+		replay.execute(target->context());
+		target->commit();
+
+		double dt = chrono::duration<double, milli>(Clock::now() - start).count();
+
+		total += dt;
+		best = (i == 0) ? dt : min(best, dt);
+	}
+
+	cout << "  submit:  " << (total / iterations) << "ms avg, " << best << "ms min (" << iterations << " iterations)\n";
+
+	NullDeviceStats nullStats;
+
+	if (queryNullDeviceStats(device.get(), &nullStats))
+	{
+		cout << "  memory:  " << nullStats.bufferMemory << " buffer bytes, " << nullStats.imageMemory << " image bytes\n";
+		cout << "  errors:  " << nullStats.errors << "\n";
+	}
+
+	replay.release();
+
+	return CLI_EXIT_SUCCESS;
+}
@@ -9,13 +9,23 @@
 #include <istream>
 #include <vector>
 #include <memory>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
 
 /*
 	Macros
 */
+#ifdef _MSC_VER
 #define RCS_BEGIN_DATA __pragma(pack(push, 1))
 #define RCS_END_DATA   __pragma(pack(pop))
 #define RCS_DATA_STRUCT __declspec(align(1)) struct
+#else
+#define RCS_BEGIN_DATA _Pragma("pack(push, 1)")
+#define RCS_END_DATA   _Pragma("pack(pop)")
+#define RCS_DATA_STRUCT struct
+#endif
 #define RCS_SEALED final
 
 namespace rc
@@ -62,12 +72,12 @@ namespace rc
 			offset(o)
 		{}
 
-		template<typename OtherType, typename = std::enable_if<IsCastable<OtherType, Type>::value>::type>
+		template<typename OtherType, typename = typename std::enable_if<IsCastable<OtherType, Type>::value>::type>
 		inline Ref(const Ref<OtherType>& other) :
 			Ref((OffsetType)other)
 		{}
 
-		template<typename OtherType, typename = std::enable_if<IsCastable<OtherType, Type>::value>::type>
+		template<typename OtherType, typename = typename std::enable_if<IsCastable<OtherType, Type>::value>::type>
 		inline Ref<Type>& operator=(const Ref<OtherType>& other)
 		{
 			offset = other.offset;
@@ -274,7 +284,7 @@ namespace rc
 		inline ConstElementType operator[](OffsetType index) const { return at(index); }
 
 		//todo: use proper iterators to handle indirections
-		template<typename = std::enable_if<std::is_same<Type, std::remove_reference<ElementType>::type>::value>::type>
+		template<typename T = Type, typename = typename std::enable_if<std::is_same<T, typename std::remove_reference<ElementType>::type>::value>::type>
 		std::vector<Type> toVector() const { return std::vector<Type>(data(), data() + length()); }
 	};
 
@@ -379,6 +389,12 @@ namespace rc
 			return *this;
 		}
 
+		ResourceStream& operator=(ResourceStream&& other)
+		{
+			std::swap(m_streamBuf, other.m_streamBuf);
+			return *this;
+		}
+
 		//Push binary data into the pool
 		inline OffsetType write(const void* bytes, SizeType bytesLength)
 		{
@@ -447,7 +463,7 @@ namespace rc
 		{
 			if (isBuilt())
 			{
-				throw std::exception("ResourceBuiler::build() has already been called");
+				throw std::runtime_error("ResourceBuiler::build() has already been called");
 			}
 		}
 
@@ -512,7 +528,7 @@ namespace rc
 		/*
 			Allocate an array of basic types
 		*/
-		template<typename Type, typename = std::enable_if<IsBasicType<Type>::value>::type>
+		template<typename Type, typename = typename std::enable_if<IsBasicType<Type>::value>::type>
 		Ref<ArrayView<Type>> createArray(const Type* data, SizeType dataLength)
 		{
 			//Assert that the resource can be modified
@@ -585,7 +601,7 @@ namespace rc
 		/*
 			Allocate array from given iterators
 		*/
-		template<typename Iterator, typename ValueType = std::iterator_traits<Iterator>::value_type>
+		template<typename Iterator, typename ValueType = typename std::iterator_traits<Iterator>::value_type>
 		inline Ref<ArrayView<ValueType>> createArray(Iterator beg, Iterator end)
 		{
 			return createArray(std::vector<ValueType>(beg, end));
@@ -695,6 +711,9 @@ namespace rc
 		{
 			load(in);
 		}
+
+		//Load from a temporary stream, eg. a file stream opened in place
+		ResourceLoader(std::istream&& in) : ResourceLoader(in) {}
 		
 		/*
 			Read in binary data from stream
@@ -720,6 +739,8 @@ namespace rc
 			m_success = in.good();
 		}
 
+		void load(std::istream&& in) { load(in); }
+
 		/*
 			Get loader state
 		*/
@@ -730,13 +751,13 @@ namespace rc
 		/*
 			Deserialize resource of given type
 		*/
-		template<typename View, typename = std::enable_if<std::is_base_of<ResourceView, View>::value>::type>
+		template<typename View, typename = typename std::enable_if<std::is_base_of<ResourceView, View>::value>::type>
 		View& deserialize()
 		{
 			return *reinterpret_cast<View*>(m_data.pointer());
 		}
 		
-		template<typename View, typename = std::enable_if<std::is_base_of<ResourceView, View>::value>::type>
+		template<typename View, typename = typename std::enable_if<std::is_base_of<ResourceView, View>::value>::type>
 		const View& deserialize() const
 		{
 			return *reinterpret_cast<const View*>(m_data.pointer());
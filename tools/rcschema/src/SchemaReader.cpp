@@ -51,7 +51,7 @@ public:
 		m_msg = format("[line: %] Unexpected token \"%\" expected \"%\"", tokenUnexpect.line, tokenUnexpect.data, tokenExpect);
 	}
 
-	const char* what() const override
+	const char* what() const noexcept override
 	{
 		return m_msg.c_str();
 	}
@@ -78,7 +78,7 @@ void test0()
 
 	Test0& reader = loader.deserialize<Test0>();
 	
-	assert(reader.field0() == (byte)'\xff');
+	assert(reader.field0() == (ts::byte)0xff);
 	assert(reader.field1() == true);
 	assert(reader.field2() == -1);
 	assert(reader.field3() == -1);
@@ -95,7 +95,7 @@ void test1()
 	stringstream data(ios::binary | ios::out | ios::in);
 
 	uint32 array0[] = { 1, 3, 2, 5, 4 };
-	byte array1[] = { 0, 3, 127, 255, 1 };
+	ts::byte array1[] = { 0, 3, 127, 255, 1 };
 
 	vector<String> arrayOfStrings = { "abc", "123", "def", "456", "*&^$$%$7637GGyugy" };
 